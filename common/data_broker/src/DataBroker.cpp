@@ -50,6 +50,7 @@
 
 #include <cstdio>
 #include <cerrno>
+#include <functional>
 
 
 
@@ -60,14 +61,109 @@ namespace mars {
 
     // Helper struct
     /// \cond HIDDEN_SYMBOLS
-    struct DeferredCallback {
-      std::list<Receiver> receivers;
-      DataInfo info;
-      DataPackage package;
-      const ReceiverInterface *producer;
+    struct DispatchItem {
+      Receiver receiver;
+      DataElement *element;
+      PackageSnapshot *snapshot;
+    };
+
+    /**
+     * Calls the async receivers that are assigned to this thread. Every
+     * receiver is always handled by the same thread, thus a receiver is
+     * never called concurrently and gets its packages in order.
+     */
+    class DispatchThread : public mars::utils::Thread {
+    public:
+      DispatchThread() : busy(false), quit(false) {}
+
+      // the items have to hold a reference to their snapshot
+      void queue(const DispatchItem &item) {
+        mutex.lock();
+        items.push_back(item);
+        condition.wakeAll();
+        mutex.unlock();
+      }
+
+      // blocks until all queued items are handled
+      void flush(void) {
+        mutex.lock();
+        while(busy || !items.empty()) condition.wait(&mutex);
+        mutex.unlock();
+      }
+
+      void stop(void) {
+        mutex.lock();
+        quit = true;
+        condition.wakeAll();
+        mutex.unlock();
+        wait();
+      }
+
+    protected:
+      void run(void) {
+        std::vector<DispatchItem>::iterator it;
+        mutex.lock();
+        while(true) {
+          while(items.empty() && !quit) condition.wait(&mutex);
+          if(items.empty() && quit) break;
+          // both vectors keep their capacity
+          items.swap(handled);
+          busy = true;
+          mutex.unlock();
+          for(it=handled.begin(); it!=handled.end(); ++it) {
+            it->receiver.receiver->receiveData(it->element->info,
+                                               it->snapshot->package,
+                                               it->receiver.callbackParam);
+            it->snapshot->refCount.fetch_sub(1, std::memory_order_acq_rel);
+          }
+          handled.clear();
+          mutex.lock();
+          busy = false;
+          condition.wakeAll();
+        }
+        mutex.unlock();
+      }
+
+    private:
+      std::vector<DispatchItem> items, handled;
+      bool busy, quit;
+      Mutex mutex;
+      WaitCondition condition;
     };
     /// \endcond
 
+    // copies the value of an item but keeps its name
+    static void copyItemValue(DataItem *dst, const DataItem &src) {
+      if(src.type == STRING_TYPE) {
+        // explicitly copy the characters, see DataItem::operator=
+        dst->s.assign(src.s.c_str(), src.s.size());
+      } else {
+        dst->l = src.l;
+        dst->d = src.d;
+      }
+      dst->type = src.type;
+    }
+
+    // If the element has a fixed layout and the package matches it only the
+    // values are copied. Otherwise the whole package is copied. Both ways
+    // reuse the memory of the destination package.
+    static void copyPackage(DataPackage *dst, const DataPackage &src,
+                            bool fixedLayout) {
+      size_t i;
+      if(fixedLayout && dst->size() == src.size()) {
+        for(i=0; i<src.size(); ++i) {
+          if((*dst)[i].type != src[i].type) break;
+        }
+        if(i == src.size()) {
+          for(i=0; i<src.size(); ++i) {
+            copyItemValue(&(*dst)[i], src[i]);
+          }
+          return;
+        }
+      }
+      *dst = src;
+    }
+
 
     // C-function to be called by pthreads to start the thread
     static void* createDataBrokerThread(void *theObject) {
@@ -93,10 +189,11 @@ namespace mars {
       DataBrokerInterface(theManager),
       mars::utils::Thread(),
       next_id(1), thread_running(false), stop_thread(false),
-      realtimeThreadRunning(false), startingRealtimeThread(false) {
+      realtimeThreadRunning(false), startingRealtimeThread(false),
+      dispatchWindow(0), havePriorities(false) {
 
-      updatedElementsBackBuffer = new std::set<DataElement*>;
-      updatedElementsFrontBuffer = new std::set<DataElement*>;
+      updatedElementsBackBuffer = new std::vector<DataElement*>;
+      updatedElementsFrontBuffer = new std::vector<DataElement*>;
 
       DataElement *e;
       e = createDataElement("data_broker", "newStream", DATA_PACKAGE_READ_FLAG);
@@ -138,13 +235,14 @@ namespace mars {
     DataBroker::~DataBroker() {
       stopRealtimeThread = true;
       stop_thread = true;
-      if(wakeupMutex.tryLock() == MUTEX_ERROR_NO_ERROR) {
-        wakeupCondition.wakeOne();
-        wakeupMutex.unlock();
-      }
+      updatedElementsLock.lock();
+      wakeupCondition.wakeAll();
+      updatedElementsLock.unlock();
       while(thread_running || realtimeThreadRunning) {
         msleep(10);
       }
+      // the dispatch threads hold references to snapshots of the elements
+      setDispatchOptions(dispatchWindow, 0);
       std::map<unsigned long, DataElement*>::iterator elementIt;
       std::map<std::string, Timer>::iterator timerIt;
       std::map<std::string, Trigger>::iterator triggerIt;
@@ -172,7 +270,12 @@ namespace mars {
         //destroyLock(&element->receiverLock);
         //destroyLock(&element->bufferLock);
         delete element->backBuffer;
-        delete element->frontBuffer;
+        PackageSnapshot *snapshot = element->snapshots.load();
+        while(snapshot) {
+          PackageSnapshot *next = snapshot->next;
+          delete snapshot;
+          snapshot = next;
+        }
         delete element;
       }
       elementsById.clear();
@@ -288,10 +391,8 @@ namespace mars {
 
     bool DataBroker::stepTimer(const std::string &timerName, long step) {
       std::map<std::string, Timer>::iterator timerIt, endIt;
-      std::list<DeferredCallback> deferredCallbacks;
-      std::set<DataItemConnection> activeConnections;
-      std::set<DataElement*> connectionActivatedElements;
-      DataItem currentItem;
+      std::vector<std::pair<DataElement*, PackageSnapshot*> > produced;
+      std::vector<std::pair<DataElement*, PackageSnapshot*> >::iterator producedIt;
 
       //bool ok = false;
       timersLock.lockForRead();
@@ -307,7 +408,6 @@ namespace mars {
       timerIt->second.lock->lockForWrite();
       timerIt->second.t += step;
       // call all producers
-      DeferredCallback deferredCallback;
       std::list<TimedProducer>::iterator producerIt;
       for(producerIt = timerIt->second.producers.begin();
           producerIt != timerIt->second.producers.end();
@@ -319,8 +419,6 @@ namespace mars {
           }
           DataElement *element = producerIt->element;
 
-          deferredCallback.receivers.clear();
-
           element->bufferLock->lockForWrite();
           // we skip the update if we have no receivers
           if(element->timedReceivers.empty() and
@@ -331,37 +429,20 @@ namespace mars {
             element->bufferLock->unlock();
             continue;
           }
-          producerIt->producer->produceData(element->info,
-                                            element->backBuffer,
-                                            producerIt->callbackParam);
-          std::swap(element->backBuffer, element->frontBuffer);
-          element->receiverLock->lockForRead();
-          if(!element->syncReceivers.empty()) {
-            deferredCallback.package = *element->frontBuffer;
-            deferredCallback.info = element->info;
-            deferredCallback.producer = NULL;
-            deferredCallback.receivers = element->syncReceivers;
-          }
-          std::list<DataItemConnection>::iterator connectionIt;
-          for(connectionIt = element->connections.begin();
-              connectionIt != element->connections.end(); ++connectionIt) {
-            long fromIdx = connectionIt->fromDataItemIndex;
-            long toIdx = connectionIt->toDataItemIndex;
-            currentItem = (*connectionIt->fromElement->frontBuffer)[fromIdx];
-            currentItem.setName((*connectionIt->toElement->backBuffer)[toIdx].getName());
-            (*connectionIt->toElement->frontBuffer)[toIdx] = currentItem;
-            connectionActivatedElements.insert(connectionIt->toElement);
+          PackageSnapshot *snapshot;
+          if(producerIt->producer->produceChangedData(element->info,
+                                                      element->backBuffer,
+                                                      producerIt->callbackParam) ||
+             !element->currentIsBackBuffer.load()) {
+            snapshot = publishPackage(element, *element->backBuffer);
+          } else {
+            // nothing changed, the receivers get the last package again
+            snapshot = acquireSnapshot(element);
           }
-          element->receiverLock->unlock();
           element->bufferLock->unlock();
 
-          updatedElementsLock.lock();
-          updatedElementsBackBuffer->insert(element);
-          updatedElementsLock.unlock();
-
           // defer synchronous callbacks until we do not hold any locks anymore
-          if(!deferredCallback.receivers.empty())
-            deferredCallbacks.push_back(deferredCallback);
+          produced.push_back(std::make_pair(element, snapshot));
         }
       }
 
@@ -394,35 +475,18 @@ namespace mars {
           timedReceiverIt != deferredReceivers.end();
           ++timedReceiverIt) {
         DataElement *element = timedReceiverIt->element;
-        element->bufferLock->lockForRead();
+        PackageSnapshot *snapshot = acquireSnapshot(element);
         timedReceiverIt->receiver->receiveData(element->info,
-                                               *element->frontBuffer,
+                                               snapshot->package,
                                                timedReceiverIt->callbackParam);
-        element->bufferLock->unlock();
+        releaseSnapshot(snapshot);
       }
 
-      // connections
-      std::set<DataElement*>::iterator toElementIt;
-      fflush(stderr);
-      for(toElementIt = connectionActivatedElements.begin();
-          toElementIt != connectionActivatedElements.end(); ++toElementIt) {
-        DataElement *toElement = *toElementIt;
-        //      std::swap(toElement->frontBuffer, toElement->backBuffer);
-        pushData(toElement->info.dataId, *toElement->frontBuffer);
-      }
-      // call deferred sync callbacks
-      std::list<DeferredCallback>::iterator callbackIt;
-      std::list<Receiver>::iterator receiverIt;
-      for(callbackIt = deferredCallbacks.begin();
-          callbackIt != deferredCallbacks.end();
-          ++callbackIt) {
-        for(receiverIt = callbackIt->receivers.begin();
-            receiverIt != callbackIt->receivers.end();
-            ++receiverIt) {
-          receiverIt->receiver->receiveData(callbackIt->info,
-                                            callbackIt->package,
-                                            receiverIt->callbackParam);
-        }
+      // call deferred sync callbacks and connections
+      for(producedIt = produced.begin(); producedIt != produced.end();
+          ++producedIt) {
+        distributeSnapshot(producedIt->first, producedIt->second, NULL);
+        releaseSnapshot(producedIt->second);
       }
 
       return true;
@@ -694,11 +758,11 @@ namespace mars {
             receiverIt != triggerIt->second.receivers.end();
             ++receiverIt) {
           DataElement *element = receiverIt->element;
-          element->bufferLock->lockForRead();
+          PackageSnapshot *snapshot = acquireSnapshot(element);
           receiverIt->receiver->receiveData(element->info,
-                                            *element->frontBuffer,
+                                            snapshot->package,
                                             receiverIt->callbackParam);
-          element->bufferLock->unlock();
+          releaseSnapshot(snapshot);
         }
         triggerIt->second.lock->unlock();
         ok = true;
@@ -807,6 +871,7 @@ namespace mars {
         DataElement *element = *elementIt;
         Receiver r = { receiver, callbackParam };
         element->syncReceivers.locked_push_back(r);
+        updateReceiverLists(element);
       }
       if(wildcards || elements.empty()) {
         PendingRegistration tmp = { receiver, groupName.c_str(),
@@ -840,6 +905,7 @@ namespace mars {
           }
         }
         element->receiverLock->unlock();
+        updateReceiverLists(element);
       }
       // remove from pending list
       pendingRegistrationLock.lock();
@@ -871,6 +937,7 @@ namespace mars {
         DataElement *element = *elementIt;
         Receiver r = { receiver, callbackParam };
         element->asyncReceivers.locked_push_back(r);
+        updateReceiverLists(element);
       }
       if(wildcards || elements.empty()) {
         PendingRegistration tmp = { receiver, groupName.c_str(),
@@ -904,6 +971,7 @@ namespace mars {
           }
         }
         element->receiverLock->unlock();
+        updateReceiverLists(element);
       }
       // remove from pending list
       pendingAsyncRegistrations.lock();
@@ -941,7 +1009,9 @@ namespace mars {
 
       pushData(element->info.dataId, dataPackage, producer);
       // hack to solve empty backBuffer problem while using producerCallbacks
+      element->bufferLock->lockForWrite();
       *element->backBuffer = dataPackage;
+      element->bufferLock->unlock();
 
       return element->info.dataId;
     }
@@ -949,11 +1019,7 @@ namespace mars {
     unsigned long DataBroker::pushData(unsigned long id,
                                        const DataPackage &dataPackage,
                                        const ReceiverInterface *producer) {
-      std::list<Receiver>::iterator syncReceiverIt;
       std::map<unsigned long, DataElement*>::iterator elementIt;
-      std::set<DataElement*> connectionActivatedElements;
-      std::list<Receiver> syncReceivers;
-      DataInfo info;
       DataElement *element = NULL;
       elementsLock.lockForRead();
       elementIt = elementsById.find(id);
@@ -961,57 +1027,115 @@ namespace mars {
         // ERROR: id not found!
         elementsLock.unlock();
         return 0;
-      } else {
+      }
+      element = elementIt->second;
+      elementsLock.unlock();
+
+      PackageSnapshot *snapshot = publishPackage(element, dataPackage);
+      distributeSnapshot(element, snapshot, producer);
+      releaseSnapshot(snapshot);
+      return id;
+    }
+
+    unsigned long DataBroker::registerPackage(const std::string &groupName,
+                                              const std::string &dataName,
+                                              const DataPackage &layout,
+                                              PackageFlag flags) {
+      std::map<std::pair<std::string, std::string>, DataElement*>::iterator elementIt;
+      DataElement *element = NULL;
+      elementsLock.lockForWrite();
+      elementIt = elementsByName.find(std::make_pair(groupName, dataName));
+      if(elementIt != elementsByName.end()) {
         element = elementIt->second;
-        *element->backBuffer = dataPackage;
-        element->bufferLock->lockForWrite();
-        std::swap(element->backBuffer, element->frontBuffer);
-        element->lastProducer = producer;
-        element->bufferLock->unlock();
+        element->fixedLayout = true;
+      } else {
+        element = createDataElement(groupName, dataName, flags);
+        element->fixedLayout = true;
+        publishDataElement(element);
+      }
+      elementsLock.unlock();
 
-        updatedElementsLock.lock();
-        updatedElementsBackBuffer->insert(element);
-        updatedElementsLock.unlock();
+      element->bufferLock->lockForWrite();
+      *element->backBuffer = layout;
+      element->bufferLock->unlock();
+      pushData(element->info.dataId, layout);
+      return element->info.dataId;
+    }
 
-        element->receiverLock->lockForRead();
-        // defer synchronous callbacks until we do not hold any locks anymore
-        syncReceivers = element->syncReceivers;
-        info = element->info;
-        element->receiverLock->unlock();
-        for(std::list<DataItemConnection>::iterator connectionIt = element->connections.begin(); connectionIt != element->connections.end(); ++connectionIt) {
+    /**
+     * \brief Publishes the snapshot to all receivers that are called
+     * immediately and forwards the connected items.
+     *
+     * The caller keeps its reference to the snapshot.
+     */
+    void DataBroker::distributeSnapshot(DataElement *element,
+                                        PackageSnapshot *snapshot,
+                                        const ReceiverInterface *producer) {
+      std::vector<std::pair<DataElement*, PackageSnapshot*> > connected;
+      std::vector<std::pair<DataElement*, PackageSnapshot*> >::iterator connectedIt;
+      std::vector<Receiver>::const_iterator receiverIt;
+      ReceiverList receivers;
+
+      element->lastProducer = producer;
+      markUpdated(element);
+
+      element->receiverLock->lockForRead();
+      // defer synchronous callbacks until we do not hold any locks anymore
+      receivers = element->syncReceiverList;
+      element->receiverLock->unlock();
+
+      elementsLock.lockForRead();
+      if(!element->connections.empty()) {
+        std::list<DataItemConnection>::iterator connectionIt;
+        for(connectionIt = element->connections.begin();
+            connectionIt != element->connections.end(); ++connectionIt) {
+          DataElement *toElement = connectionIt->toElement;
           long fromIdx = connectionIt->fromDataItemIndex;
           long toIdx = connectionIt->toDataItemIndex;
-          DataItem currentItem;
-          currentItem = (*connectionIt->fromElement->frontBuffer)[fromIdx];
-          currentItem.setName((*connectionIt->toElement->frontBuffer)[toIdx].getName());
-          (*connectionIt->toElement->frontBuffer)[toIdx] = currentItem;
-          connectionActivatedElements.insert(connectionIt->toElement);
+          PackageSnapshot *target = NULL;
+          // all connections to one element go into the same new snapshot
+          for(connectedIt = connected.begin(); connectedIt != connected.end();
+              ++connectedIt) {
+            if(connectedIt->first == toElement) {
+              target = connectedIt->second;
+              break;
+            }
+          }
+          if(!target) {
+            PackageSnapshot *source = acquireSnapshot(toElement);
+            target = createSnapshot(toElement);
+            target->package = source->package;
+            releaseSnapshot(source);
+            connected.push_back(std::make_pair(toElement, target));
+          }
+          if(fromIdx < 0 || fromIdx >= (long)snapshot->package.size() ||
+             toIdx < 0 || toIdx >= (long)target->package.size()) {
+            continue;
+          }
+          copyItemValue(&target->package[toIdx], snapshot->package[fromIdx]);
+        }
+        for(connectedIt = connected.begin(); connectedIt != connected.end();
+            ++connectedIt) {
+          publishSnapshot(connectedIt->first, connectedIt->second);
         }
       }
       elementsLock.unlock();
 
       // do the synchronous callbacks
-      for(syncReceiverIt = syncReceivers.begin();
-          syncReceiverIt != syncReceivers.end();
-          ++syncReceiverIt) {
-        if(syncReceiverIt->receiver != producer)
-          syncReceiverIt->receiver->receiveData(info, dataPackage,
-                                                syncReceiverIt->callbackParam);
-      }
-
-      for(std::set<DataElement*>::iterator toElementIt = connectionActivatedElements.begin(); toElementIt != connectionActivatedElements.end(); ++toElementIt) {
-        DataElement *toElement = *toElementIt;
-        pushData(toElement->info.dataId, *toElement->frontBuffer);
+      if(receivers) {
+        for(receiverIt = receivers->begin(); receiverIt != receivers->end();
+            ++receiverIt) {
+          if(receiverIt->receiver != producer)
+            receiverIt->receiver->receiveData(element->info, snapshot->package,
+                                              receiverIt->callbackParam);
+        }
       }
 
-      // The main thread only releases the wakeupMutex when it goes to sleep.
-      // So if we can lock it, we wake up the main thread so it can process the
-      // data we just pushed. Otherwise it is still running and will process it.
-      if(wakeupMutex.tryLock() == MUTEX_ERROR_NO_ERROR) {
-        wakeupCondition.wakeOne();
-        wakeupMutex.unlock();
+      for(connectedIt = connected.begin(); connectedIt != connected.end();
+          ++connectedIt) {
+        distributeSnapshot(connectedIt->first, connectedIt->second, NULL);
+        releaseSnapshot(connectedIt->second);
       }
-      return id;
     }
 
     void DataBroker::pushMessage(MessageType messageType,
@@ -1079,65 +1203,160 @@ namespace mars {
     }
 
     void DataBroker::run() {
-      std::set<DataElement*>::iterator updatedElementsIt;
-      std::list<Receiver>::iterator receiverIt;
-      std::list<DeferredCallback> deferredCallbacks;
-      std::list<DeferredCallback>::iterator callbackIt;
-
-      wakeupMutex.lock();
+      thread_running = true;
+      updatedElementsLock.lock();
       while(!stop_thread) {
-        elementsLock.lockForRead();
-        updatedElementsLock.lock();
+        // sleep until pushData() queues an element
+        while(!stop_thread && updatedElementsBackBuffer->empty()) {
+          wakeupCondition.wait(&updatedElementsLock);
+        }
+        if(stop_thread) break;
+
+        // collect more updates within the coalescing window
+        if(dispatchWindow > 0) {
+          updatedElementsLock.unlock();
+          msleep(dispatchWindow);
+          updatedElementsLock.lock();
+        }
         std::swap(updatedElementsBackBuffer, updatedElementsFrontBuffer);
         updatedElementsLock.unlock();
 
-        for(updatedElementsIt = updatedElementsFrontBuffer->begin();
-            updatedElementsIt != updatedElementsFrontBuffer->end();
-            ++updatedElementsIt) {
-          DataElement *element = *updatedElementsIt;
-
-          element->bufferLock->lockForRead();
-          element->receiverLock->lockForRead();
-          // defer callbacks until we do not hold any lock anymore
-          if(!element->asyncReceivers.empty()) {
-            DeferredCallback deferred;
-            deferred.receivers = element->asyncReceivers;
-            deferred.info = element->info;
-            deferred.package = *element->frontBuffer;
-            deferred.producer = element->lastProducer;
-            deferredCallbacks.push_back(deferred);
+        dispatchCallbacks();
+
+        updatedElementsLock.lock();
+      }
+      updatedElementsLock.unlock();
+      thread_running = false;
+    }
+
+    /**
+     * \brief Calls the async receivers of all elements in the front buffer.
+     *
+     * Elements with a higher priority are handled first. If dispatch threads
+     * are configured the callbacks are handed to them.
+     */
+    void DataBroker::dispatchCallbacks(void) {
+      std::vector<DataElement*>::iterator updatedElementsIt;
+      std::vector<Receiver>::const_iterator receiverIt;
+      std::vector<DeferredCallback>::iterator callbackIt;
+
+      elementsLock.lockForRead();
+      if(havePriorities) {
+        // stable insertion sort, the buffer is reused and should not allocate
+        std::vector<DataElement*> &elements = *updatedElementsFrontBuffer;
+        for(size_t i=1; i<elements.size(); ++i) {
+          DataElement *element = elements[i];
+          size_t k = i;
+          while(k > 0 && elements[k-1]->priority < element->priority) {
+            elements[k] = elements[k-1];
+            --k;
           }
-          element->receiverLock->unlock();
-          element->bufferLock->unlock();
+          elements[k] = element;
         }
-        updatedElementsFrontBuffer->clear();
-        elementsLock.unlock();
+      }
+      for(updatedElementsIt = updatedElementsFrontBuffer->begin();
+          updatedElementsIt != updatedElementsFrontBuffer->end();
+          ++updatedElementsIt) {
+        DataElement *element = *updatedElementsIt;
+        // reset the flag first so that a new push queues the element again
+        element->updated.store(false);
 
-        // make the callbacks
-        //pushError("DataBroker::deferredCallbacks %d", deferredCallbacks.size());
-        for(callbackIt = deferredCallbacks.begin();
-            callbackIt != deferredCallbacks.end(); ++callbackIt) {
-          for(receiverIt = callbackIt->receivers.begin();
-              receiverIt != callbackIt->receivers.end();
-              ++receiverIt) {
-            if(receiverIt->receiver != callbackIt->producer)
-              receiverIt->receiver->receiveData(callbackIt->info,
-                                                callbackIt->package,
-                                                receiverIt->callbackParam);
+        element->receiverLock->lockForRead();
+        // defer callbacks until we do not hold any lock anymore
+        if(element->asyncReceiverList && !element->asyncReceiverList->empty()) {
+          DeferredCallback deferred;
+          deferred.receivers = element->asyncReceiverList;
+          deferred.element = element;
+          deferred.snapshot = acquireSnapshot(element);
+          deferred.producer = element->lastProducer;
+          deferredCallbacks.push_back(deferred);
+        }
+        element->receiverLock->unlock();
+      }
+      updatedElementsFrontBuffer->clear();
+      elementsLock.unlock();
+
+      // make the callbacks
+      dispatchLock.lock();
+      size_t numThreads = dispatchThreads.size();
+      for(callbackIt = deferredCallbacks.begin();
+          callbackIt != deferredCallbacks.end(); ++callbackIt) {
+        for(receiverIt = callbackIt->receivers->begin();
+            receiverIt != callbackIt->receivers->end();
+            ++receiverIt) {
+          if(receiverIt->receiver == callbackIt->producer) continue;
+          if(numThreads) {
+            DispatchItem item = {*receiverIt, callbackIt->element,
+                                 callbackIt->snapshot};
+            size_t n = std::hash<ReceiverInterface*>()(receiverIt->receiver) % numThreads;
+            callbackIt->snapshot->refCount.fetch_add(1, std::memory_order_acq_rel);
+            dispatchThreads[n]->queue(item);
+          } else {
+            receiverIt->receiver->receiveData(callbackIt->element->info,
+                                              callbackIt->snapshot->package,
+                                              receiverIt->callbackParam);
           }
         }
-        deferredCallbacks.clear();
+        releaseSnapshot(callbackIt->snapshot);
+      }
+      dispatchLock.unlock();
+      // the capacity is kept to avoid allocations in the next round
+      deferredCallbacks.clear();
+    }
 
-        // If there is no data to process go to sleep. pushData() will wake us up.
-        updatedElementsLock.lock();
-        bool bufferIsEmpty = updatedElementsBackBuffer->empty();
-        updatedElementsLock.unlock();
-        if(bufferIsEmpty) {
-          wakeupCondition.wait(&wakeupMutex);
+    /**
+     * \brief Configures the dispatching of the async receivers.
+     *
+     * \param coalescingWindow Time in ms the main thread waits after the
+     *        first update to collect further updates before it calls the
+     *        receivers. With 0 the receivers are called immediately.
+     * \param numThreads Number of threads that call the async receivers.
+     *        With 0 the receivers are called from the main thread.
+     */
+    void DataBroker::setDispatchOptions(long coalescingWindow, int numThreads) {
+      dispatchWindow = coalescingWindow > 0 ? coalescingWindow : 0;
+      if(numThreads < 0) numThreads = 0;
+      dispatchLock.lock();
+      if((int)dispatchThreads.size() != numThreads) {
+        // the assignment of receivers to threads changes, so the old
+        // threads are drained completely
+        std::vector<DispatchThread*>::iterator it;
+        for(it=dispatchThreads.begin(); it!=dispatchThreads.end(); ++it) {
+          (*it)->flush();
+          (*it)->stop();
+          delete *it;
+        }
+        dispatchThreads.clear();
+        for(int i=0; i<numThreads; ++i) {
+          dispatchThreads.push_back(new DispatchThread());
+          dispatchThreads.back()->start();
         }
-        msleep(10);
       }
-      wakeupMutex.unlock();
+      dispatchLock.unlock();
+    }
+
+    /**
+     * \brief Sets the dispatch priority of all matching elements.
+     *
+     * The names may contain wildcards. The priority is also applied to
+     * matching elements that are created later.
+     */
+    void DataBroker::setPriority(const std::string &groupName,
+                                 const std::string &dataName,
+                                 int priority) {
+      std::vector<DataElement*> elements;
+      std::vector<DataElement*>::iterator elementIt;
+      elementsLock.lockForWrite();
+      getElementsByName(groupName, dataName, &elements);
+      for(elementIt = elements.begin(); elementIt != elements.end();
+          ++elementIt) {
+        (*elementIt)->priority = priority;
+      }
+      PendingPriority pending = {groupName.c_str(), dataName.c_str(),
+                                 priority};
+      pendingPriorities.push_back(pending);
+      havePriorities = true;
+      elementsLock.unlock();
     }
 
 
@@ -1161,10 +1380,9 @@ namespace mars {
       elementsLock.lockForRead();
       elementIt = elementsById.find(id);
       if(elementIt != elementsById.end()) {
-        DataElement *element = elementIt->second;
-        element->bufferLock->lockForRead();
-        dataPackage = *elementIt->second->frontBuffer;
-        element->bufferLock->unlock();
+        PackageSnapshot *snapshot = acquireSnapshot(elementIt->second);
+        dataPackage = snapshot->package;
+        releaseSnapshot(snapshot);
       }
       elementsLock.unlock();
       return dataPackage;
@@ -1210,17 +1428,134 @@ namespace mars {
       element->info.groupName = groupName.c_str();
       element->info.dataName = dataName.c_str();
       element->info.flags = flags;
+      element->updated.store(false);
+      element->priority = 0;
+      // the latest matching setPriority() call wins
+      std::list<PendingPriority>::const_iterator priorityIt;
+      for(priorityIt = pendingPriorities.begin();
+          priorityIt != pendingPriorities.end(); ++priorityIt) {
+        if(matchPattern(priorityIt->groupName, groupName) &&
+           matchPattern(priorityIt->dataName, dataName)) {
+          element->priority = priorityIt->priority;
+        }
+      }
+      element->fixedLayout = false;
       element->backBuffer = new DataPackage;
-      element->frontBuffer = new DataPackage;
+      element->snapshots.store(NULL);
+      element->currentIsBackBuffer.store(false);
+      // start with an empty package so there always is a current snapshot
+      element->current.store(createSnapshot(element));
       element->bufferLock = new ReadWriteLock;
       element->receiverLock = new ReadWriteLock;
       elementsByName[std::make_pair(groupName.c_str(),
                                     dataName.c_str())] = element;
       elementsById[element->info.dataId] = element;
       updatePendingRegistrations(element);
+      updateReceiverLists(element);
       return element;
     }
 
+    /**
+     * \brief Returns a free snapshot of the element with one reference.
+     *
+     * A snapshot is free if nobody holds a reference to it. New snapshots
+     * are only allocated if all existing ones are in use.
+     */
+    PackageSnapshot *DataBroker::createSnapshot(DataElement *element) {
+      PackageSnapshot *snapshot;
+      for(snapshot = element->snapshots.load(std::memory_order_acquire);
+          snapshot; snapshot = snapshot->next) {
+        int expected = 0;
+        if(snapshot->refCount.compare_exchange_strong(expected, 1,
+                                                      std::memory_order_acq_rel)) {
+          return snapshot;
+        }
+      }
+      snapshot = new PackageSnapshot;
+      snapshot->refCount.store(1);
+      snapshot->next = element->snapshots.load(std::memory_order_acquire);
+      while(!element->snapshots.compare_exchange_weak(snapshot->next, snapshot,
+                                                      std::memory_order_acq_rel));
+      return snapshot;
+    }
+
+    /**
+     * \brief Returns the current snapshot of the element with an additional
+     * reference. The snapshot is not modified until it is released.
+     */
+    PackageSnapshot *DataBroker::acquireSnapshot(const DataElement *element) const {
+      PackageSnapshot *snapshot;
+      while(true) {
+        snapshot = element->current.load(std::memory_order_acquire);
+        snapshot->refCount.fetch_add(1, std::memory_order_acq_rel);
+        // the snapshot might have been replaced and reused before we got
+        // our reference
+        if(snapshot == element->current.load(std::memory_order_acquire)) {
+          return snapshot;
+        }
+        releaseSnapshot(snapshot);
+      }
+    }
+
+    void DataBroker::releaseSnapshot(PackageSnapshot *snapshot) const {
+      snapshot->refCount.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    /**
+     * \brief Makes the snapshot the current one of the element.
+     *
+     * The element takes its own reference, the caller keeps its reference.
+     */
+    void DataBroker::publishSnapshot(DataElement *element,
+                                     PackageSnapshot *snapshot) {
+      snapshot->refCount.fetch_add(1, std::memory_order_acq_rel);
+      releaseSnapshot(element->current.exchange(snapshot,
+                                                std::memory_order_acq_rel));
+    }
+
+    PackageSnapshot *DataBroker::publishPackage(DataElement *element,
+                                                const DataPackage &dataPackage) {
+      PackageSnapshot *snapshot = createSnapshot(element);
+      copyPackage(&snapshot->package, dataPackage, element->fixedLayout);
+      publishSnapshot(element, snapshot);
+      element->currentIsBackBuffer.store(&dataPackage == element->backBuffer);
+      return snapshot;
+    }
+
+    void DataBroker::markUpdated(DataElement *element) {
+      // every element is only queued once until the main thread handled it
+      if(!element->updated.exchange(true)) {
+        updatedElementsLock.lock();
+        // the main thread only waits if the queue is empty
+        if(updatedElementsBackBuffer->empty()) {
+          wakeupCondition.wakeAll();
+        }
+        updatedElementsBackBuffer->push_back(element);
+        updatedElementsLock.unlock();
+      }
+    }
+
+    /**
+     * \brief Copies the receiver lists that are handed to the callbacks.
+     *
+     * The copies are shared by the callbacks, so that pushing data does not
+     * have to copy the lists.
+     */
+    void DataBroker::updateReceiverLists(DataElement *element) {
+      element->syncReceivers.lock();
+      ReceiverList syncList(new std::vector<Receiver>(element->syncReceivers.begin(),
+                                                      element->syncReceivers.end()));
+      element->syncReceivers.unlock();
+      element->asyncReceivers.lock();
+      ReceiverList asyncList(new std::vector<Receiver>(element->asyncReceivers.begin(),
+                                                       element->asyncReceivers.end()));
+      element->asyncReceivers.unlock();
+      element->receiverLock->lockForWrite();
+      element->syncReceiverList = syncList;
+      element->asyncReceiverList = asyncList;
+      element->receiverLock->unlock();
+    }
+
     void DataBroker::publishDataElement(const DataElement *element)
     {
       // Inform receivers about new Stream.
@@ -1393,7 +1728,9 @@ namespace mars {
         }
         element = elementIt->second;
         connection.fromElement = element;
-        connection.fromDataItemIndex = element->frontBuffer->getIndexByName(fromItemName);
+        PackageSnapshot *snapshot = acquireSnapshot(element);
+        connection.fromDataItemIndex = snapshot->package.getIndexByName(fromItemName);
+        releaseSnapshot(snapshot);
       }
 
       // to element handling
@@ -1408,7 +1745,9 @@ namespace mars {
         }
         element = elementIt->second;
         connection.toElement = element;
-        connection.toDataItemIndex = element->frontBuffer->getIndexByName(toItemName);
+        PackageSnapshot *snapshot = acquireSnapshot(element);
+        connection.toDataItemIndex = snapshot->package.getIndexByName(toItemName);
+        releaseSnapshot(snapshot);
       }
 
       connection.fromElement->connections.push_back(connection);
@@ -1438,20 +1777,20 @@ namespace mars {
         element = elementIt->second;
         for(jt=element->connections.begin();
             jt!=element->connections.end(); ++jt) {
-          jt->toElement->bufferLock->lockForWrite();
-          if(jt->toDataItemIndex >= (int)jt->toElement->frontBuffer->size()) {
+          PackageSnapshot *snapshot = acquireSnapshot(jt->toElement);
+          if(jt->toDataItemIndex >= (int)snapshot->package.size()) {
             pushError("DataBroker::disconnectDataItems : connection index does not match!");
           }
           else {
             if(jt->toElement->info.groupName == toGroupName &&
                jt->toElement->info.dataName == toDataName &&
-               (*jt->toElement->frontBuffer)[jt->toDataItemIndex].getName() == toItemName) {
-              jt->toElement->bufferLock->unlock();
+               snapshot->package[jt->toDataItemIndex].getName() == toItemName) {
+              releaseSnapshot(snapshot);
               element->connections.erase(jt);
               break;
             }
           }
-          jt->toElement->bufferLock->unlock();
+          releaseSnapshot(snapshot);
         }
       }
     }
@@ -1466,21 +1805,21 @@ namespace mars {
       for(it=elementsById.begin(); it!=elementsById.end(); ++it) {
         for(jt=it->second->connections.begin();
             jt!=it->second->connections.end(); ++jt) {
-          jt->toElement->bufferLock->lockForWrite();
-          if(jt->toDataItemIndex >= (int)jt->toElement->frontBuffer->size()) {
+          PackageSnapshot *snapshot = acquireSnapshot(jt->toElement);
+          if(jt->toDataItemIndex >= (int)snapshot->package.size()) {
             pushError("DataBroker::disconnectDataItems : connection index does not match!");
           }
           else {
             if(jt->toElement->info.groupName == toGroupName &&
                jt->toElement->info.dataName == toDataName &&
-               (*jt->toElement->frontBuffer)[jt->toDataItemIndex].getName() == toItemName) {
-              jt->toElement->bufferLock->unlock();
+               snapshot->package[jt->toDataItemIndex].getName() == toItemName) {
+              releaseSnapshot(snapshot);
               it->second->connections.erase(jt);
               //jt = it->second->connections.begin();
               break;
             }
           }
-          jt->toElement->bufferLock->unlock();
+          releaseSnapshot(snapshot);
         }
       }
       elementsLock.unlock();
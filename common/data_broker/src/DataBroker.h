@@ -41,6 +41,8 @@
 #include <list>
 #include <map>
 #include <set>
+#include <atomic>
+#include <memory>
 
 #include <pthread.h>
 
@@ -50,6 +52,7 @@ namespace mars {
 
     class ReceiverInterface;
     class ProducerInterface;
+    class DispatchThread;
     struct DataElement;
 
     inline bool hasWildcards(const std::string &str) {
@@ -82,6 +85,12 @@ namespace mars {
       int callbackParam;
     };
 
+    struct PendingPriority {
+      std::string groupName;
+      std::string dataName;
+      int priority;
+    };
+
     struct PendingTriggeredRegistration {
       ReceiverInterface *receiver;
       std::string groupName;
@@ -130,13 +139,36 @@ namespace mars {
       int callbackParam;
     };
 
+    /**
+     * An immutable copy of a pushed DataPackage. The snapshots of an element
+     * are pooled and reused as soon as nobody holds a reference anymore.
+     */
+    struct PackageSnapshot {
+      DataPackage package;
+      std::atomic<int> refCount;
+      PackageSnapshot *next;
+    };
+
+    typedef std::shared_ptr<const std::vector<Receiver> > ReceiverList;
+
     struct DataElement {
       DataInfo info;
-      //    bool updated;
+      std::atomic<bool> updated;
+      // elements with a higher priority are dispatched first
+      int priority;
+      // true if the names and types of the items never change
+      bool fixedLayout;
       DataPackage *backBuffer;
-      DataPackage *frontBuffer;
+      // all snapshots of the element, the list only grows
+      std::atomic<PackageSnapshot*> snapshots;
+      // the latest pushed snapshot, the element holds one reference on it
+      std::atomic<PackageSnapshot*> current;
+      // true if the current snapshot is a copy of the backBuffer
+      std::atomic<bool> currentIsBackBuffer;
       LockableContainer<std::list<Receiver> > syncReceivers;
       LockableContainer<std::list<Receiver> > asyncReceivers;
+      // copies of the receiver lists that are handed to the callbacks
+      ReceiverList syncReceiverList, asyncReceiverList;
       std::list<ReceiverInterface*> timedReceivers;
       std::list<ReceiverInterface*> triggeredReceivers;
       mars::utils::ReadWriteLock *bufferLock;
@@ -144,6 +176,13 @@ namespace mars {
       const ReceiverInterface *lastProducer;
       std::list<DataItemConnection> connections;
     };
+
+    struct DeferredCallback {
+      ReceiverList receivers;
+      DataElement *element;
+      PackageSnapshot *snapshot;
+      const ReceiverInterface *producer;
+    };
     /// \endcond
 
     /**
@@ -219,6 +258,15 @@ namespace mars {
       unsigned long pushData(unsigned long id,
                              const DataPackage &dataPackage,
                              const ReceiverInterface *producer=NULL);
+      unsigned long registerPackage(const std::string &groupName,
+                                    const std::string &dataName,
+                                    const DataPackage &layout,
+                                    PackageFlag flags);
+
+      void setDispatchOptions(long coalescingWindow, int numThreads);
+      void setPriority(const std::string &groupName,
+                       const std::string &dataName,
+                       int priority);
 
       unsigned long getDataID(const std::string &groupName,
                               const std::string &dataName) const;
@@ -277,6 +325,17 @@ namespace mars {
                                      PackageFlag flags);
       void publishDataElement(const DataElement *element);
       void updatePendingRegistrations(DataElement *newElement);
+      void updateReceiverLists(DataElement *element);
+      PackageSnapshot *createSnapshot(DataElement *element);
+      PackageSnapshot *acquireSnapshot(const DataElement *element) const;
+      void releaseSnapshot(PackageSnapshot *snapshot) const;
+      void publishSnapshot(DataElement *element, PackageSnapshot *snapshot);
+      PackageSnapshot *publishPackage(DataElement *element,
+                                      const DataPackage &dataPackage);
+      void distributeSnapshot(DataElement *element, PackageSnapshot *snapshot,
+                              const ReceiverInterface *producer);
+      void markUpdated(DataElement *element);
+      void dispatchCallbacks(void);
       unsigned long createId();
       //void destroyLock(pthread_rwlock_t *rwlock);
       //void destroyLock(pthread_mutex_t *mutex);
@@ -293,8 +352,8 @@ namespace mars {
                              const std::string &dataName,
                              std::vector<DataElement*> *elements) const;
 
-      std::set<DataElement*> *updatedElementsBackBuffer;
-      std::set<DataElement*> *updatedElementsFrontBuffer;
+      std::vector<DataElement*> *updatedElementsBackBuffer;
+      std::vector<DataElement*> *updatedElementsFrontBuffer;
 
       unsigned long next_id;
       pthread_t theThread;
@@ -319,8 +378,16 @@ namespace mars {
       mars::utils::Mutex updatedElementsLock;
       mars::utils::Mutex pendingRegistrationLock;
 
+      // signaled with the updatedElementsLock when the first element is
+      // queued or the thread should stop
       mars::utils::WaitCondition wakeupCondition;
-      mars::utils::Mutex wakeupMutex;
+      long dispatchWindow;
+      bool havePriorities;
+      std::list<PendingPriority> pendingPriorities;
+      std::vector<DispatchThread*> dispatchThreads;
+      // reused by the main thread to avoid allocations
+      std::vector<DeferredCallback> deferredCallbacks;
+      mars::utils::Mutex dispatchLock;
       std::map<std::string, Timer> timers;
       unsigned long newStreamId;
       unsigned long pushMessageIds[__DB_MESSAGE_TYPE_COUNT];
@@ -494,6 +494,59 @@ namespace mars {
                                      const DataPackage &dataPackage,
                                      const ReceiverInterface *producer=NULL) =0;
 
+      /**
+       * \brief registers a stream whose DataPackages keep a fixed layout
+       * \param groupName The groupName of the stream.
+       * \param dataName The dataName of the stream.
+       * \param layout A DataPackage with the items of the stream. The number,
+       *               the names and the types of the items must not change
+       *               in subsequent pushes.
+       * \param flags This is used to indicate the nature of the data.
+       * \return The pushId of the stream.
+       *
+       * Subsequent calls to
+       * \ref pushData(unsigned long,const DataPackage&,const ReceiverInterface*) "pushData(unsigned long,...)"
+       * with the returned pushId only copy the values of the items and don't
+       * allocate memory. If a pushed package does not match the layout it is
+       * copied completely. If the stream already exists its pushId is
+       * returned and the layout is pushed as the current package.
+       */
+      virtual unsigned long registerPackage(const std::string &groupName,
+                                            const std::string &dataName,
+                                            const DataPackage &layout,
+                                            PackageFlag flags) = 0;
+
+      /**
+       * \brief configures how the asynchronous receivers are called
+       * \param coalescingWindow Time in milliseconds the DataBroker waits
+       *                         after the first pushed package to collect
+       *                         further pushes before it calls the
+       *                         receivers. Packages of a stream that is
+       *                         pushed several times within the window are
+       *                         only delivered once. The default of 0 calls
+       *                         the receivers as soon as possible.
+       * \param numThreads Number of threads that call the asynchronous
+       *                   receivers. A receiver is always called from the
+       *                   same thread. With the default of 0 all receivers
+       *                   are called from the DataBroker thread.
+       */
+      virtual void setDispatchOptions(long coalescingWindow,
+                                      int numThreads) = 0;
+
+      /**
+       * \brief sets the order in which updated streams are dispatched
+       * \param groupName The groupName of the streams, may contain wildcards.
+       * \param dataName The dataName of the streams, may contain wildcards.
+       * \param priority Streams with a higher priority are delivered to the
+       *                 asynchronous receivers first. The default is 0.
+       *
+       * The priority is also applied to matching streams that are created
+       * later on.
+       */
+      virtual void setPriority(const std::string &groupName,
+                               const std::string &dataName,
+                               int priority) = 0;
+
       /**
        * \brief get the unique dataId assosiated with a given groupName and 
        *        dataName
@@ -25,7 +25,7 @@ namespace mars {
   namespace data_broker {
     
     DataPackageMapping::DataPackageMapping()
-      : first(true)
+      : first(true), lastPackage(NULL), lastPackageSize(0), changed(false)
     {}
 
     DataPackageMapping::~DataPackageMapping() {
@@ -58,15 +58,28 @@ namespace mars {
        * For perfomance reasons we abandon the "Look Before You Leap" style in
        * favour of the "Easier to Ask for Forgiveness Than Permission" style.
        * Only when setting a DataItem fails do we try to create it.
+       * If we wrote the same package last time, it still holds the values
+       * of the shadow buffer and only the changed items have to be set.
        */
       bool ret = true;
+      bool writeAll = (package != lastPackage ||
+                       package->size() != lastPackageSize);
+      changed = false;
       for(std::vector<DataItemAccessorBase*>::iterator it = accessors.begin();
           it != accessors.end(); ++it) {
+        // always store the value to keep the shadow buffer up to date
+        if(!(*it)->storeValue(&shadow[0]) && !writeAll) {
+          continue;
+        }
+        changed = true;
         bool tmp = (*it)->setValue(package);
         if(!tmp) {
           ret = (ret && (*it)->createValue(package));
         }
       }
+      // after a failed write the package does not match the shadow buffer
+      lastPackage = ret ? package : NULL;
+      lastPackageSize = package->size();
       return ret;
     }
 
@@ -76,6 +89,8 @@ namespace mars {
         delete *it;
       }
       accessors.clear();
+      shadow.clear();
+      lastPackage = NULL;
       first = true;
     }
 
@@ -35,6 +35,7 @@
 #include <vector>
 #include <string>
 #include <cstdio>
+#include <cstring>
 
 namespace mars {
 
@@ -42,13 +43,37 @@ namespace mars {
 
     // exclude these internal classed from doxygen 
     /// \cond DEBUG
+
+    // Copies the value to the shadow buffer and returns true if it differs
+    // from the value stored there. The values are compared bitwise.
+    template<typename T> inline bool storeShadowValue(char *shadow,
+                                                      const T &value) {
+      if(memcmp(shadow, &value, sizeof(T)) == 0) {
+        return false;
+      }
+      memcpy(shadow, &value, sizeof(T));
+      return true;
+    }
+
+    // strings are not plain data, they are always written
+    template<> inline bool storeShadowValue(char * /*shadow*/,
+                                            const std::string & /*value*/) {
+      return true;
+    }
+
     class DataItemAccessorBase {
     public:
+      DataItemAccessorBase() : offset(0) {}
       virtual ~DataItemAccessorBase() {}
       virtual bool getValue(const DataPackage &package) = 0;
       virtual bool setValue(DataPackage *package) const = 0;
       virtual bool createValue(DataPackage *package) = 0;
       virtual bool getIndex(const DataPackage &package) = 0;
+      virtual size_t getSize() const = 0;
+      virtual bool storeValue(char *shadow) const = 0;
+
+      // the position of the value in the shadow buffer of the mapping
+      size_t offset;
     };
 
     template<typename T> class DataItemAccessor : public DataItemAccessorBase {
@@ -74,6 +99,12 @@ namespace mars {
         id = package->getIndexByName(itemName);
         return id != -1;
       }
+      inline size_t getSize() const {
+        return sizeof(T);
+      }
+      inline bool storeValue(char *shadow) const {
+        return storeShadowValue(shadow + offset, *var);
+      }
 
     private:
       T *var;
@@ -96,6 +127,12 @@ namespace mars {
      * When a new DataPackage is received it can be passed to the 
      * DataPackageMapping's update method and it will retrieve the values from 
      * the DataPackage and write them to the variables.
+     *
+     * A \link ProducerInterface Producer \endlink uses writePackage to
+     * write the variables to its package. The mapping keeps a copy of the
+     * last written values in a flat buffer and only sets the DataItems whose
+     * value changed since the last call with the same package. Thus the
+     * package must not be modified by anyone else in between.
      */
     class DataPackageMapping {
     private:
@@ -115,7 +152,11 @@ namespace mars {
        *            valid during the lifetime of the DataPackageMapping object.
        */
       template<typename T> void add(const std::string &itemName, T *var) {
-        accessors.push_back(new DataItemAccessor<T>(itemName, var));
+        DataItemAccessor<T> *accessor = new DataItemAccessor<T>(itemName, var);
+        accessor->offset = shadow.size();
+        shadow.resize(shadow.size() + accessor->getSize());
+        accessors.push_back(accessor);
+        lastPackage = NULL;
       }
 
       /**
@@ -125,13 +166,34 @@ namespace mars {
        * write the value to the corresponding variable.
        */
       bool readPackage(const DataPackage &package);
+
+      /**
+       * \brief Writes the values of the mapped variables to the package.
+       * \param package The DataPackage whose DataItems should be set.
+       * Missing DataItems are added to the package. If the same package
+       * was written by the last call only the changed values are set.
+       * \return \c false if a DataItem could not be written.
+       */
       bool writePackage(DataPackage *package);
 
+      /**
+       * \brief Returns true if the last call to writePackage modified the
+       *        package.
+       */
+      bool hasChanged() const {
+        return changed;
+      }
+
       void clear();
 
     private:
       bool first;
       std::vector<DataItemAccessorBase*> accessors;
+      // the values of the last writePackage call, packed in add() order
+      std::vector<char> shadow;
+      const DataPackage *lastPackage;
+      size_t lastPackageSize;
+      bool changed;
     }; // end of class DataPackageMapping
     
   } // end of namespace data_broker
@@ -53,6 +53,20 @@ namespace mars {
                                DataPackage *package,
                                int callbackParam) = 0;
 
+      /**
+       * Called by the DataBroker instead of produceData. A producer that
+       * knows whether its values changed returns false if it left the
+       * package untouched since the last call. The DataBroker then passes
+       * the last published package to the receivers instead of copying it
+       * again.
+       */
+      virtual bool produceChangedData(const DataInfo &info,
+                                      DataPackage *package,
+                                      int callbackParam) {
+        produceData(info, package, callbackParam);
+        return true;
+      }
+
     }; // end of class ProducerInterface
 
   } // end of namespace data_broker
@@ -7,6 +7,7 @@
 #include<QSplitter>
 #include<QPushButton>
 #include <QFileDialog>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 
@@ -14,7 +15,7 @@ namespace data_broker_plotter2 {
 
   using namespace configmaps;
 
-  enum { CALLBACK_OTHER=0, CALLBACK_NEW_STREAM=-1 };
+  enum { CALLBACK_OTHER=0, CALLBACK_NEW_STREAM=-1, CALLBACK_SIM_TIME=-2 };
 
   DataBrokerPlotter::DataBrokerPlotter(DataBrokerPlotterLib *_mainLib,
                                        lib_manager::LibManager* theManager,
@@ -24,7 +25,7 @@ namespace data_broker_plotter2 {
     mars::main_gui::BaseWidget(parent, cfg, _name),
     libManager(theManager), dataBroker(_dataBroker), mainLib(_mainLib),
     name(_name), nextPlotId(1), updateMap(false), needReplot(false), inReceive(false), exit(false),
-    threadRunning(false), simTime(0) {
+    threadRunning(false), clearPlots(false), simTime(0) {
 
       //setStyleSheet("background-color:#eeeeee;");
     configPath = cfg->getOrCreateProperty("Config", "config_path", string(".")).sValue;
@@ -71,6 +72,7 @@ namespace data_broker_plotter2 {
     updateFilterTicks = 0;
 
     map["Properties"]["X-Range in ms"] = 10000UL;
+    map["Properties"]["Buffer Size"] = 20000UL;
     map["Properties"]["Data Update Rate"] = 40.0;
     map["Properties"]["Pen Size"] = 1.0;
     map["Properties"]["Filter"] = "*/Motors/:*root:";
@@ -82,6 +84,7 @@ namespace data_broker_plotter2 {
       }
     }
     xRange = map["Properties"]["X-Range in ms"];
+    bufferSize = map["Properties"]["Buffer Size"];
     dataUpdateRate = map["Properties"]["Data Update Rate"];
     penSize = map["Properties"]["Pen Size"];
     filter = mars::utils::explodeString(':', map["Properties"]["Filter"]);
@@ -91,7 +94,8 @@ namespace data_broker_plotter2 {
     dataBroker->registerSyncReceiver(this, "data_broker", "newStream",
                                      CALLBACK_NEW_STREAM);
     dataBroker->registerTimedReceiver(this, "mars_sim", "simTime",
-                                      "mars_sim/simTimer", 0);
+                                      "mars_sim/simTimer", 0,
+                                      CALLBACK_SIM_TIME);
     std::vector<mars::data_broker::DataInfo> infoList;
     std::vector<mars::data_broker::DataInfo>::iterator it;
     infoList = dataBroker->getDataList();
@@ -129,6 +133,12 @@ namespace data_broker_plotter2 {
     while(inReceive || threadRunning) {
       msleep(10);
     }
+    for(auto it: streams) {
+      delete it.second;
+    }
+    for(auto stream: retiredStreams) {
+      delete stream;
+    }
   }
 
   void DataBrokerPlotter::update() {
@@ -142,6 +152,9 @@ namespace data_broker_plotter2 {
     for(auto it: plotMap) {
       if(it.second->curve) {
         if(it.second->gotData) {
+          // at most two points per pixel column are drawn
+          it.second->data.decimate(qcPlot->width(), &it.second->xValues,
+                                   &it.second->yValues);
           it.second->curve->setData(it.second->xValues, it.second->yValues);
           it.second->gotData = 0;
         }
@@ -178,29 +191,94 @@ namespace data_broker_plotter2 {
         }
       }
     }
+    else if(callbackParam == CALLBACK_SIM_TIME) {
+      double v;
+      package.get(0, &v);
+      if(v < simTime) {
+        // the plot thread clears the plots
+        packageList.clear();
+        valueList.clear();
+        clearPlots = true;
+      }
+      simTime = v;
+    }
     else {
-      std::string label = info.groupName + "/" + info.dataName;
-      if(label == "mars_sim/simTime") {
-        double v;
-        package.get(0, &v);
-        if(v < simTime) {
-          for(auto it: plotMap) {
-            it.second->xValues.clear();
-            it.second->yValues.clear();
-          }
-        }
-        simTime = v;
+      queuePackage(info, package);
+    }
+    dataLock.unlock();
+    inReceive = false;
+  }
+
+  /**
+   * Stores the values of the package for the plot thread. The labels of the
+   * items are only built when a stream is new or changes its layout, i.e.
+   * the number, names or order of its items.
+   */
+  void DataBrokerPlotter::queuePackage(const mars::data_broker::DataInfo &info,
+                                       const mars::data_broker::DataPackage &package) {
+    StreamData *&stream = streams[info.dataId];
+    if(stream) {
+      bool layoutChanged = package.size() != stream->itemNames.size();
+      for(size_t i=0; !layoutChanged && i<package.size(); ++i) {
+        layoutChanged = package[i].getName() != stream->itemNames[i];
+      }
+      if(layoutChanged) {
+        // queued packages of the old layout keep their stream until the
+        // plot thread handled them
+        retiredStreams.push_back(stream);
+        stream = NULL;
+      }
+    }
+    if(!stream) {
+      stream = new StreamData;
+      stream->label = info.groupName + "/" + info.dataName;
+      stream->info = info;
+      stream->itemNames.resize(package.size());
+      for(size_t i=0; i<package.size(); ++i) {
+        stream->itemNames[i] = package[i].getName();
+      }
+      unresolvedStreams.push_back(stream);
+    }
+
+    PackageData p = {stream, simTime, valueList.size(), package.size()};
+    double x;
+    int ix;
+    for(size_t i=0; i<package.size(); ++i) {
+      // items that cannot be plotted are marked with NaN
+      if(package[i].type == mars::data_broker::DOUBLE_TYPE) {
+        package.get(i, &x);
+      }
+      else if(package[i].type == mars::data_broker::INT_TYPE) {
+        package.get(i, &ix);
+        x = (double)ix;
       }
       else {
-        packageList.push_back({label, simTime, info, package});
+        x = NAN;
       }
+      valueList.push_back(x);
+    }
+    packageList.push_back(p);
+  }
+
+  /**
+   * Assigns the plots to the items of the stream and creates the missing
+   * plots. The dataLock and the plotLock have to be held.
+   */
+  void DataBrokerPlotter::resolvePlots(StreamData *stream) {
+    stream->plots.resize(stream->itemNames.size());
+    for(size_t i=0; i<stream->itemNames.size(); ++i) {
+      std::string label2 = stream->label + "/" + stream->itemNames[i];
+      auto it = plotMap.find(label2);
+      if(it == plotMap.end()) {
+        createNewPlot(label2, stream->info);
+        it = plotMap.find(label2);
+      }
+      stream->plots[i] = it->second;
     }
-    dataLock.unlock();
-    inReceive = false;
   }
 
   void DataBrokerPlotter::createNewPlot(std::string label, const mars::data_broker::DataInfo &info) {
-    Plot *newPlot = new Plot;
+    Plot *newPlot = new Plot(bufferSize);
 
     newPlot->name = label;
     newPlot->gotData = 0;
@@ -288,6 +366,17 @@ namespace data_broker_plotter2 {
           }
         }
       }
+      else if(key.find("Buffer") != std::string::npos) {
+        plotLock.lock();
+        bufferSize = atoi(value.c_str());
+        for(auto it: plotMap) {
+          it.second->data.setCapacity(bufferSize);
+          it.second->gotData = true;
+        }
+        needReplot = true;
+        plotLock.unlock();
+        map["Properties"]["Buffer Size"] = bufferSize;
+      }
       else if(key.find("Data") != std::string::npos) {
         plotLock.lock();
         // todo: change already registerd data
@@ -440,63 +529,59 @@ namespace data_broker_plotter2 {
 
   void DataBrokerPlotter::run() {
     threadRunning = true;
-    double x, xmin;
-    int ix;
+    double xmin;
 
     while(!exit) {
       // first handle panding dataPackages
       dataLock.lock();
-      std::vector<PackageData> packageList_;
-      packageList.swap(packageList_);
-
       while(!pendingIDs.empty()) {
         std::map<std::string, mars::data_broker::DataInfo>::iterator it = pendingIDs.begin();
         mars::data_broker::DataPackage package = dataBroker->getDataPackage(it->second.dataId);
-        packageList_.push_back({it->first, simTime, it->second, package});
+        queuePackage(it->second, package);
         pendingIDs.erase(it);
       }
-      dataLock.unlock();
+      // the lists keep their capacity
+      packageList.swap(packageList_);
+      valueList.swap(valueList_);
+      packageList.clear();
+      valueList.clear();
+      bool clear = clearPlots;
+      clearPlots = false;
+      std::vector<StreamData*> retired;
+      retired.swap(retiredStreams);
 
       plotLock.lock();
+      for(auto stream: unresolvedStreams) {
+        resolvePlots(stream);
+      }
+      unresolvedStreams.clear();
+      dataLock.unlock();
 
-      for(auto p: packageList_) {
-        mars::data_broker::DataInfo &info = p.di;
-        mars::data_broker::DataPackage &package = p.dp;
-        if(p.label == "mars_sim/simTime") {
-
+      if(clear) {
+        for(auto it: plotMap) {
+          it.second->data.clear();
+          it.second->gotData = true;
         }
-        else {
-          for(size_t i=0; i<package.size(); ++i) {
-            std::string label2 = p.label + "/" + package[i].getName();
-
-            auto it = plotMap.find(label2);
-            if(it == plotMap.end()) {
-              createNewPlot(label2, info);
-              it = plotMap.find(label2);
-            }
-            if(package[i].type == mars::data_broker::DOUBLE_TYPE) {
-              package.get(i, &x);
-            }
-            else if(package[i].type == mars::data_broker::INT_TYPE) {
-              package.get(i, &ix);
-              x = (double)ix;
-            }
-            else {
-              continue;
-            }
-            xmin = simTime-xRange;
-            it->second->xValues.push_back(p.simTime);
-            it->second->yValues.push_back(x);
-            while(!it->second->xValues.empty() && it->second->xValues.front() < xmin) {
-              it->second->xValues.pop_front();
-              it->second->yValues.pop_front();
-            }
-            needReplot = true;
-            it->second->gotData = true;
-          }
+        needReplot = true;
+      }
+      xmin = simTime-xRange;
+      for(auto &p: packageList_) {
+        std::vector<Plot*> &plots = p.stream->plots;
+        size_t count = std::min(p.count, plots.size());
+        for(size_t i=0; i<count; ++i) {
+          double x = valueList_[p.first+i];
+          if(std::isnan(x)) continue;
+          Plot *plot = plots[i];
+          plot->data.push(p.simTime, x);
+          plot->data.dropBefore(xmin);
+          plot->gotData = true;
         }
+        needReplot = true;
       }
       plotLock.unlock();
+      for(auto stream: retired) {
+        delete stream;
+      }
       msleep(10);
     }
     threadRunning = false;
@@ -523,8 +608,8 @@ namespace data_broker_plotter2 {
         fprintf(stderr, "Error open File: %s\n", filePath.c_str());
         continue;
       }
-      for(long i=0; i<p.second->xValues.size(); ++i) {
-        fprintf(file, "%g %g\n", p.second->xValues[i], p.second->yValues[i]);
+      for(size_t i=0; i<p.second->data.size(); ++i) {
+        fprintf(file, "%g %g\n", p.second->data.x(i), p.second->data.y(i));
       }
       fclose(file);
     }
@@ -8,6 +8,7 @@
 #define DATA_BROKER_PLOTTER_HPP
 
 #include "qcustomplot.h"
+#include "PlotBuffer.hpp"
 #include <QPainter>
 #include <QCloseEvent>
 #include <QMutex>
@@ -45,9 +46,12 @@ namespace data_broker_plotter2 {
 
   class Plot {
   public:
+    Plot(size_t capacity) : data(capacity) {}
     std::string name;
     QCPGraph *curve;
     mars::data_broker::DataInfo dataInfo;
+    PlotBuffer data;
+    // the decimated points handed to the curve
     QVector<double> xValues;
     QVector<double> yValues;
     bool gotData, show;
@@ -55,12 +59,22 @@ namespace data_broker_plotter2 {
     configmaps::ConfigMap options;
   };
 
-  class PackageData {
+  // a stream the plotter received data from
+  class StreamData {
   public:
     std::string label;
+    mars::data_broker::DataInfo info;
+    std::vector<std::string> itemNames;
+    // the plots of the items, set by the plot thread
+    std::vector<Plot*> plots;
+  };
+
+  // the values of one received package, stored in a shared value list
+  class PackageData {
+  public:
+    StreamData *stream;
     double simTime;
-    mars::data_broker::DataInfo di;
-    mars::data_broker::DataPackage dp;
+    size_t first, count;
   };
 
   class DataBrokerPlotter : public mars::main_gui::BaseWidget,
@@ -103,9 +117,16 @@ namespace data_broker_plotter2 {
     QCustomPlot *qcPlot;
     QMutex dataLock, plotLock;
     std::string name, configPath, exportPath;
-    std::vector<PackageData> packageList;
+    // the received packages and their values, swapped by the plot thread
+    std::vector<PackageData> packageList, packageList_;
+    std::vector<double> valueList, valueList_;
+    std::map<unsigned long, StreamData*> streams;
+    // streams whose items have to be assigned to plots
+    std::vector<StreamData*> unresolvedStreams;
+    // streams replaced after a layout change, deleted by the plot thread
+    std::vector<StreamData*> retiredStreams;
     std::vector<std::string> filter;
-    unsigned long xRange;
+    unsigned long xRange, bufferSize;
     int updateFilterTicks;
 
     std::map<unsigned long, int> registerMap;
@@ -115,11 +136,14 @@ namespace data_broker_plotter2 {
     std::map<mars::cfg_manager::cfgParamId, Plot*> cfgParamIdToPlot;
 
     int nextPlotId;
-    bool updateMap, needReplot, inReceive, exit, threadRunning;
+    bool updateMap, needReplot, inReceive, exit, threadRunning, clearPlots;
     double penSize, dataUpdateRate, simTime;
     std::default_random_engine generator;
 
     void createNewPlot(std::string label, const mars::data_broker::DataInfo &info);
+    void queuePackage(const mars::data_broker::DataInfo &info,
+                      const mars::data_broker::DataPackage &package);
+    void resolvePlots(StreamData *stream);
     void shiftDown( QRect &rect, int offset ) const;
     void showPlot(Plot* plot);
     void hidePlot(Plot* plot);
@@ -0,0 +1,140 @@
+/**
+ * \file PlotBuffer.hpp
+ * \brief A ring buffer of the points of a curve with a fixed capacity.
+ **/
+
+#ifndef PLOT_BUFFER_HPP
+#define PLOT_BUFFER_HPP
+
+#include <QVector>
+
+#include <algorithm>
+#include <vector>
+
+namespace data_broker_plotter2 {
+
+  /**
+   * Stores the newest points of a curve in x order. The storage grows up to
+   * the capacity, after that every new point replaces the oldest one.
+   */
+  class PlotBuffer {
+  public:
+    explicit PlotBuffer(size_t capacity) : capacity(capacity), start(0),
+                                           count(0) {}
+
+    size_t size() const {return count;}
+    double x(size_t i) const {return xs[(start+i) % xs.size()];}
+    double y(size_t i) const {return ys[(start+i) % ys.size()];}
+
+    void clear() {
+      start = count = 0;
+    }
+
+    void push(double x, double y) {
+      if(count == capacity) {
+        // replace the oldest point
+        if(!capacity) return;
+        xs[start] = x;
+        ys[start] = y;
+        start = (start+1) % xs.size();
+        return;
+      }
+      if(count == xs.size()) {
+        // grow the storage, the points have to be in order for push_back
+        std::rotate(xs.begin(), xs.begin()+start, xs.end());
+        std::rotate(ys.begin(), ys.begin()+start, ys.end());
+        start = 0;
+        xs.push_back(x);
+        ys.push_back(y);
+      }
+      else {
+        size_t i = (start+count) % xs.size();
+        xs[i] = x;
+        ys[i] = y;
+      }
+      ++count;
+    }
+
+    /** Removes the points in front of xMin. */
+    void dropBefore(double xMin) {
+      while(count && xs[start] < xMin) {
+        start = (start+1) % xs.size();
+        --count;
+      }
+    }
+
+    /** Keeps the newest points that fit into the new capacity. */
+    void setCapacity(size_t newCapacity) {
+      size_t first = count > newCapacity ? count-newCapacity : 0;
+      std::vector<double> newXs, newYs;
+      newXs.reserve(count-first);
+      newYs.reserve(count-first);
+      for(size_t i=first; i<count; ++i) {
+        newXs.push_back(x(i));
+        newYs.push_back(y(i));
+      }
+      xs.swap(newXs);
+      ys.swap(newYs);
+      start = 0;
+      count = xs.size();
+      capacity = newCapacity;
+    }
+
+    /**
+     * \brief Writes the points to draw with at most two points per bucket.
+     *
+     * The x range of the buffer is split into the given number of buckets,
+     * e.g. one per pixel column. Of every bucket the points with the
+     * minimal and maximal y value are kept in their original order, so
+     * peaks remain visible.
+     */
+    void decimate(size_t buckets, QVector<double> *xOut,
+                  QVector<double> *yOut) const {
+      xOut->resize(0);
+      yOut->resize(0);
+      if(count <= 2*buckets || buckets == 0) {
+        for(size_t i=0; i<count; ++i) {
+          xOut->append(x(i));
+          yOut->append(y(i));
+        }
+        return;
+      }
+      double x0 = x(0);
+      double range = x(count-1) - x0;
+      double scale = range > 0.0 ? buckets / range : 0.0;
+      size_t bucket = 0, minI = 0, maxI = 0;
+      for(size_t i=0; i<count; ++i) {
+        size_t b = (size_t)((x(i) - x0) * scale);
+        if(b >= buckets) b = buckets-1;
+        if(i == 0 || b != bucket) {
+          if(i) appendMinMax(minI, maxI, xOut, yOut);
+          bucket = b;
+          minI = maxI = i;
+        }
+        else {
+          if(y(i) < y(minI)) minI = i;
+          if(y(i) > y(maxI)) maxI = i;
+        }
+      }
+      appendMinMax(minI, maxI, xOut, yOut);
+    }
+
+  private:
+    std::vector<double> xs, ys;
+    size_t capacity, start, count;
+
+    void appendMinMax(size_t minI, size_t maxI, QVector<double> *xOut,
+                      QVector<double> *yOut) const {
+      size_t first = std::min(minI, maxI), last = std::max(minI, maxI);
+      xOut->append(x(first));
+      yOut->append(y(first));
+      if(last != first) {
+        xOut->append(x(last));
+        yOut->append(y(last));
+      }
+    }
+  };
+
+} // end of namespace: data_broker_plotter2
+
+#endif // PLOT_BUFFER_HPP
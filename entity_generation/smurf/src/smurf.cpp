@@ -42,6 +42,9 @@
 //#define DEBUG_PARSE_SENSOR 1
 //#define DEBUG_SCENE_MAP
 
+// changes if the lists stored in the scene cache change
+#define SMURF_CACHE_KEY "mars_smurf 1"
+
 /*
  * remarks:
  *
@@ -92,6 +95,7 @@ namespace mars {
       nextControllerID = 1;
       // TODO: this needs checking for potential doubling (see above nextGroupID)
       groupID = control->nodes->getMaxGroupID() + 1;
+      firstGroupID = groupID;
 
       nodeList.clear();
       jointList.clear();
@@ -112,6 +116,8 @@ namespace mars {
       visualNameMap.clear();
 
       robotname = "";
+      rootLinkName = "";
+      sourceFiles.clear();
       model.reset();
 
       entity = NULL;
@@ -123,6 +129,7 @@ namespace mars {
     }
 
     void SMURF::handleURI(ConfigMap *map, std::string uri) {
+      sourceFiles.push_back(uri);
       ConfigMap map2 = ConfigMap::fromYamlFile(uri);
       handleURIs(&map2);
       map->append(map2);
@@ -189,7 +196,26 @@ namespace mars {
       entityconfig["abs_path"] = pathJoin(getCurrentWorkingDir(), path);
       std::string filename = (std::string)entityconfig["file"];
       fprintf(stderr, "SMURF::createEntity: Creating entity of type %s\n", ((std::string)entityconfig["type"]).c_str());
-      if((std::string)entityconfig["type"] == "smurf" || entityconfig["type"].getString() == "particle") {
+
+      // the parsed entity depends on the given config, e.g. on its pose,
+      // thus every config gets its own cache entry
+      std::string cacheDir;
+      if(control->cfg) {
+        cacheDir = control->cfg->getOrCreateProperty("Config",
+                                                     "scene_cache_path",
+                                                     "").sValue;
+      }
+      std::string sourceFile = pathJoin((std::string)entityconfig["abs_path"],
+                                        filename);
+      ConfigMap cacheName = config;
+      SceneCache cache(cacheDir, sourceFile + "\n" + cacheName.toYamlString());
+      uint64_t cacheKey = SceneCache::hashString(SMURF_CACHE_KEY);
+      bool fromCache = cache.open(cacheKey) && readCache(cache);
+      if(fromCache) {
+        fprintf(stderr, "  ...loading entity from cache.\n");
+        entity = new sim::SimEntity(control, entityconfig);
+      }
+      else if((std::string)entityconfig["type"] == "smurf" || entityconfig["type"].getString() == "particle") {
         model = smurf_parser::parseFile(&entityconfig, path, filename, true);
 #ifdef DEBUG_SCENE_MAP
         debugMap.append(entityconfig);
@@ -234,6 +260,9 @@ namespace mars {
         entity = new sim::SimEntity(control, entityconfig);
         createModel(false);
       }
+      if(!fromCache) {
+        writeCache(&cache, sourceFile);
+      }
 
       // node mapping and name checking
       std::string robotname = (std::string)entityconfig["name"];
@@ -972,6 +1001,94 @@ namespace mars {
       materialList.push_back(config);
     }
 
+    bool SMURF::readCache(const SceneCache &cache) {
+      std::vector<ConfigMap> entityList, infoList;
+      std::vector<ConfigMap>* lists[] = {
+        &entityList, &infoList, &materialList, &nodeList, &jointList,
+        &motorList, &sensorList, &controllerList, &lightList, &graphicList};
+      const char* names[] = {"entity", "info", "materials", "nodes", "joints",
+                             "motors", "sensors", "controllers", "lights",
+                             "graphics"};
+      bool valid = true;
+      for(size_t i=0; valid && i<sizeof(names)/sizeof(names[0]); ++i) {
+        valid = cache.readList(names[i], lists[i]);
+      }
+      if(!valid || entityList.size() != 1 || infoList.size() != 1) {
+        for(size_t i=0; i<sizeof(names)/sizeof(names[0]); ++i) {
+          lists[i]->clear();
+        }
+        return false;
+      }
+      entityconfig = entityList[0];
+      robotname = (std::string)infoList[0]["robotname"];
+      rootLinkName = (std::string)infoList[0]["rootNode"];
+
+      // the group ids are given relative to the nodes already loaded
+      int groupOffset = firstGroupID - (int)infoList[0]["firstGroupID"];
+      std::vector<ConfigMap>::iterator nIt = nodeList.begin();
+      for(; nIt != nodeList.end(); ++nIt) {
+        if(nIt->hasKey("groupid")) {
+          (*nIt)["groupid"] = (int)(*nIt)["groupid"] + groupOffset;
+        }
+      }
+      return true;
+    }
+
+    void SMURF::writeCache(SceneCache *cache, const std::string &sourceFile) {
+      if(!cache->isEnabled()) return;
+      std::vector<ConfigMap> entityList(1, entityconfig), infoList(1);
+      infoList[0]["robotname"] = robotname;
+      infoList[0]["rootNode"] = rootLinkName;
+      infoList[0]["firstGroupID"] = firstGroupID;
+
+      // the files of a smurf are given relative to the smurf file
+      std::vector<std::string> files(1, sourceFile);
+      if(entityconfig.hasKey("files")) {
+        std::string smurfPath = getPathOfFile(sourceFile);
+        ConfigVector::iterator it = entityconfig["files"].begin();
+        for(; it != entityconfig["files"].end(); ++it) {
+          files.push_back(pathJoin(smurfPath, (std::string)*it));
+        }
+      }
+      for(size_t i=0; i<files.size(); ++i) {
+        std::string suffix = getFilenameSuffix(files[i]);
+        if(suffix == ".smurf" || suffix == ".yml" || suffix == ".yaml") {
+          // the includes are resolved by the smurf parser and cannot be
+          // checked by the cache
+          ConfigMap map = ConfigMap::fromYamlFile(files[i]);
+          if(SceneCache::hasIncludes(map)) {
+            fprintf(stderr, "  ...%s has includes, the entity is not cached.\n",
+                    files[i].c_str());
+            return;
+          }
+        }
+        cache->addSource(files[i]);
+      }
+      for(size_t i=0; i<sourceFiles.size(); ++i) {
+        cache->addSource(pathJoin(getCurrentWorkingDir(), sourceFiles[i]));
+      }
+      // the mesh files are read again on every load, but a changed mesh
+      // invalidates the entry as well
+      std::vector<ConfigMap>::iterator nIt = nodeList.begin();
+      for(; nIt != nodeList.end(); ++nIt) {
+        std::string meshFile = trim(nIt->get("filename", std::string()));
+        if(meshFile.empty() || meshFile == "PRIMITIVE") continue;
+        handleFilenamePrefix(&meshFile, tmpPath);
+        cache->addSource(pathJoin(getCurrentWorkingDir(), meshFile));
+      }
+      cache->addList("entity", entityList);
+      cache->addList("info", infoList);
+      cache->addList("materials", materialList);
+      cache->addList("nodes", nodeList);
+      cache->addList("joints", jointList);
+      cache->addList("motors", motorList);
+      cache->addList("sensors", sensorList);
+      cache->addList("controllers", controllerList);
+      cache->addList("lights", lightList);
+      cache->addList("graphics", graphicList);
+      cache->write(SceneCache::hashString(SMURF_CACHE_KEY));
+    }
+
     unsigned int SMURF::parseURDF(std::string filename) {
       if(!utils::pathExists(filename)) {
         fprintf(stderr, "ERROR: SMURF:parseURDF no such file: %s\n",
@@ -998,6 +1115,7 @@ namespace mars {
         createMaterial(it->second);
       }
 
+      rootLinkName = model->root_link_->name;
       translateLink(model->root_link_, fixed);
     }
 
@@ -1053,7 +1171,7 @@ namespace mars {
 
       // set model pose
       ConfigMap map;
-      map["rootNode"] = model->root_link_->name;
+      map["rootNode"] = rootLinkName;
       entity->appendConfig(map);
       entity->setInitialPose();
 
@@ -32,6 +32,7 @@
 #include <configmaps/ConfigData.h>
 #include <mars/interfaces/sensor_bases.h>
 #include <mars/interfaces/MaterialData.h>
+#include <mars/interfaces/SceneCache.h>
 
 #include <mars/interfaces/sim/MarsPluginTemplate.h>
 #include <mars/entity_generation/entity_factory/EntityFactoryInterface.h>
@@ -87,6 +88,7 @@ namespace mars {
 
     private:
       int groupID;
+      int firstGroupID;
       unsigned int mapIndex; // index to map nodes of a single entity
       unsigned long nextNodeID;
       unsigned long nextGroupID;
@@ -108,9 +110,21 @@ namespace mars {
       configmaps::ConfigMap debugMap;
       configmaps::ConfigMap entityconfig;
       std::string robotname;
+      std::string rootLinkName;
+      // the files read besides the smurf and urdf files
+      std::vector<std::string> sourceFiles;
       urdf::ModelInterfaceSharedPtr model;
       sim::SimEntity* entity;
 
+      /**
+       * The parsed lists of an entity are stored in the scene cache, see
+       * interfaces::SceneCache. Loading an unchanged entity again skips the
+       * smurf and urdf parsing.
+       */
+      bool readCache(const interfaces::SceneCache &cache);
+      void writeCache(interfaces::SceneCache *cache,
+                      const std::string &sourceFile);
+
       void handleURI(configmaps::ConfigMap *map, std::string uri);
       void handleURIs(configmaps::ConfigMap *map);
       void getSensorIDList(configmaps::ConfigMap *map);
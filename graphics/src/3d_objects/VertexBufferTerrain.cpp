@@ -72,9 +72,10 @@ namespace mars {
         for(int j=0; j<ts->width; ++j) {
           if(i==0 || j==0 || i==ts->height-1 || j==ts->width-1) offset = -0.1;
           else offset = 0.0;
-          mrhmr->setHeight(j, i, offset+ts->scale*ts->pixelData[i*ts->width+j]);
-          if(ts->pixelData[i*ts->width+j]*ts->scale > maxHeight) {
-            maxHeight = ts->pixelData[i*ts->width+j]*ts->scale;
+          double h = ts->scale*ts->getPixel(j, i);
+          mrhmr->setHeight(j, i, offset+h);
+          if(h > maxHeight) {
+            maxHeight = h;
           }
         }
 
@@ -67,6 +67,7 @@
 
 #include <iostream>
 #include <cassert>
+#include <algorithm>
 #include <stdexcept>
 
 #define SINGLE_THREADED
@@ -152,6 +153,10 @@ namespace mars {
           loadFile.append("/mars_Graphics.yaml");
           cfg->loadConfig(loadFile.c_str());
 
+          // the triangles extracted from the mesh files are cached in here
+          GuiHelper::setMeshCachePath(cfg->getOrCreateProperty("Config", "scene_cache_path",
+                                                               configPath.sValue + "/scene_cache/").sValue);
+
           // have to handle multisampling here
           multisamples.propertyType = cfg_manager::intProperty;
           multisamples.propertyIndex = 0;
@@ -485,55 +490,49 @@ namespace mars {
     }
 
     void GraphicsManager::update(){
+      std::string font_path = resources_path.sValue;
+      font_path.append("/Fonts");
+
       //update drawElements
       for (unsigned int i=0; i<draws.size(); i++) {
         drawMapper &draw = draws[i];
-        vector<draw_item> tmp_ditem;
-        vector<osg::Node*> tmp_nodes;
+        vector<draw_item> &items = draw.ds.drawItems;
         //update draws
-        draw.ds.ptr_draw->update(&(draw.ds.drawItems));
+        draw.ds.ptr_draw->update(&items);
 
-        for (unsigned int j=0; j<draw.ds.drawItems.size(); j++) {
-          draw_item &di = draw.ds.drawItems[j];
+        // items are only touched if their state is set, erased items are
+        // closed up in place by moving the following ones forward
+        size_t n = 0;
+        for (size_t j=0; j<items.size(); j++) {
+          draw_item &di = items[j];
 
           if(di.draw_state == DRAW_STATE_ERASE) {
             scene->removeChild(draw.nodes[j]);
+            continue;
           }
-          else if (di.draw_state == DRAW_STATE_CREATE) {
-            std::string font_path = resources_path.sValue;
-            font_path.append("/Fonts");
-            osg::ref_ptr<osg::Group> osgNode = new OSGDrawItem(osgWidget, di,
-                                                               font_path);
+          if (di.draw_state == DRAW_STATE_CREATE) {
+            // new items are appended by the interface
+            assert(draw.nodes.size() == j);
+            osg::ref_ptr<OSGDrawItem> osgNode = new OSGDrawItem(osgWidget, di,
+                                                                font_path);
             osgNode->setNodeMask(1);
             scene->addChild(osgNode.get());
-
-            di.draw_state = DRAW_UNKNOWN;
-            tmp_ditem.push_back(di);
-            tmp_nodes.push_back(osgNode.get());
+            draw.nodes.push_back(osgNode.get());
           }
           else if (di.draw_state == DRAW_STATE_UPDATE) {
-            assert(draws[i].nodes.size() > j);
-            osg::Node *n = draws[i].nodes[j];
-            OSGDrawItem *diWrapper = dynamic_cast<OSGDrawItem*>(n->asGroup()); // TODO: asGroup unneeded?
-            assert(diWrapper != NULL); // TODO: handle this case better
-
-            diWrapper->update(di);
-
-            di.draw_state = DRAW_UNKNOWN;
-            tmp_ditem.push_back(di);
-            tmp_nodes.push_back(n);
+            assert(draw.nodes.size() > j);
+            draw.nodes[j]->update(di);
           }
-          else { // invalid draw state!
-            di.draw_state = DRAW_UNKNOWN;
-            tmp_ditem.push_back(di);
-            tmp_nodes.push_back(draws[i].nodes[j]);
+          di.draw_state = DRAW_UNKNOWN;
+
+          if(n != j) {
+            std::swap(items[n], di);
+            draw.nodes[n] = draw.nodes[j];
           }
+          ++n;
         }
-
-        draws[i].ds.drawItems.clear();
-        draws[i].ds.drawItems = tmp_ditem;
-        draws[i].nodes.clear();
-        draws[i].nodes = tmp_nodes;
+        items.resize(n);
+        draw.nodes.resize(n);
       }
     }
 
@@ -757,37 +756,21 @@ namespace mars {
       getLights(&lightList);
       if(lightList.size() == 0) lightList.push_back(&defaultLight.lStruct);
 
-      map<unsigned long, osg::ref_ptr<OSGNodeStruct> >::iterator drawIter;
-
-      for (unsigned int i=0; i<myLights.size(); i++) {
-        //return only the used lights
-        if (!myLights[i].free) {
-          if(myLights[i].lStruct.drawID != 0) {
-            for(drawIter=drawObjects_.begin(); drawIter!=drawObjects_.end(); ++drawIter) {
-              if(drawIter->first == myLights[i].lStruct.drawID) {
-                Vector pos = drawIter->second->object()->getPosition();
-                Quaternion q = drawIter->second->object()->getQuaternion();
-                myLights[i].lStruct.pos = pos;
-                myLights[i].light->setPosition(osg::Vec4(pos.x(), pos.y(),
-                                                         pos.z()+0.1, 1.0));
-                pos = q*Vector(1, 0, 0);
-                myLights[i].lStruct.lookAt = pos;
-                myLights[i].light->setDirection(osg::Vec3(pos.x(), pos.y(),
-                                                          pos.z()));
-                break;
-              }
-            }
-          }
-          else if(myLights[i].lStruct.node != "") {
-            for(drawIter=drawObjects_.begin(); drawIter!=drawObjects_.end(); ++drawIter) {
-              if(drawIter->second->name() == myLights[i].lStruct.node) {
-                myLights[i].lStruct.drawID = drawIter->first;
-                break;
-              }
-            }
-          }
-        }
-      }
+      // only the lights whose draw object moved are updated
+      for (size_t i=0; i<movedLights.size(); i++) {
+        lightmanager &lm = myLights[movedLights[i]];
+        if(lm.free) continue;
+        OSGNodeStruct *ns = findDrawObject(lm.lStruct.drawID);
+        if(ns == NULL) continue;
+        Vector pos = ns->object()->getPosition();
+        Quaternion q = ns->object()->getQuaternion();
+        lm.lStruct.pos = pos;
+        lm.light->setPosition(osg::Vec4(pos.x(), pos.y(), pos.z()+0.1, 1.0));
+        pos = q*Vector(1, 0, 0);
+        lm.lStruct.lookAt = pos;
+        lm.light->setDirection(osg::Vec3(pos.x(), pos.y(), pos.z()));
+      }
+      movedLights.clear();
 
       if(materialManager) {
         materialManager->updateLights(lightList);
@@ -910,6 +893,14 @@ namespace mars {
 
       DrawCoreIds.insert(pair<unsigned long int, unsigned long int>(id, snode.index));
       drawObjects_[id] = drawObject;
+      for (unsigned int i=0; i<myLights.size(); i++) {
+        if(!myLights[i].free && myLights[i].lStruct.drawID == 0 &&
+           !myLights[i].lStruct.node.empty() &&
+           myLights[i].lStruct.node == drawObject->name()) {
+          myLights[i].lStruct.drawID = id;
+          markDrawObjectMoved(id);
+        }
+      }
       ConfigMap config = snode.map;
       if(config.hasKey("createFrame") and (bool)config["createFrame"] == true) {
         drawObject->object()->frame = framesFactory->createFrame();
@@ -998,6 +989,13 @@ namespace mars {
         delete drawObject;
       }
       drawObjects_.erase(id);
+      // lights following the node by name wait for its next draw object
+      for (unsigned int i=0; i<myLights.size(); i++) {
+        if(!myLights[i].free && myLights[i].lStruct.drawID == id &&
+           !myLights[i].lStruct.node.empty()) {
+          myLights[i].lStruct.drawID = 0;
+        }
+      }
     }
 
     void GraphicsManager::exportDrawObject(unsigned long id,
@@ -1044,11 +1042,50 @@ namespace mars {
 
     void GraphicsManager::setDrawObjectPos(unsigned long id, const Vector &pos) {
       OSGNodeStruct *ns = findDrawObject(id);
-      if(ns != NULL) ns->object()->setPosition(pos);
+      if(ns == NULL) return;
+      ns->object()->setPosition(pos);
+      markDrawObjectMoved(id);
     }
     void GraphicsManager::setDrawObjectRot(unsigned long id, const Quaternion &q) {
       OSGNodeStruct *ns = findDrawObject(id);
-      if(ns != NULL) ns->object()->setQuaternion(q);
+      if(ns == NULL) return;
+      ns->object()->setQuaternion(q);
+      markDrawObjectMoved(id);
+    }
+
+    /**
+     * \brief Adds the lights that follow the draw object to the lights
+     * updated with the next frame.
+     */
+    void GraphicsManager::markDrawObjectMoved(unsigned long id) {
+      for (unsigned int i=0; i<myLights.size(); i++) {
+        if(!myLights[i].free && myLights[i].lStruct.drawID == id &&
+           find(movedLights.begin(), movedLights.end(), i) == movedLights.end()) {
+          movedLights.push_back(i);
+        }
+      }
+    }
+
+    /**
+     * \brief Looks up the draw object of the node the light follows and
+     * places the light there with the next frame.
+     *
+     * If the node is not drawn yet, the light is attached when its draw
+     * object is added.
+     */
+    void GraphicsManager::attachLight(unsigned int index) {
+      lightmanager &lm = myLights[index];
+      if(!lm.lStruct.node.empty()) {
+        lm.lStruct.drawID = 0;
+        for(DrawObjects::iterator it=drawObjects_.begin();
+            it!=drawObjects_.end(); ++it) {
+          if(it->second->name() == lm.lStruct.node) {
+            lm.lStruct.drawID = it->first;
+            break;
+          }
+        }
+      }
+      if(lm.lStruct.drawID != 0) markDrawObjectMoved(lm.lStruct.drawID);
     }
     void GraphicsManager::setDrawObjectScale(unsigned long id, const Vector &ext) {
       OSGNodeStruct *ns = findDrawObject(id);
@@ -1149,7 +1186,7 @@ namespace mars {
       for (it = draws.begin(); it != draws.end(); it++) {
         if (it->ds.ptr_draw != iface) continue;
 
-        for(vector<osg::Node*>::iterator jt = it->nodes.begin();
+        for(vector<OSGDrawItem*>::iterator jt = it->nodes.begin();
             jt != it->nodes.end(); ++jt) {
           scene->removeChild(*jt);
         }
@@ -1211,22 +1248,14 @@ namespace mars {
           }
         }
         if(ls.map.hasKey("nodeName")) {
-          // todo: if we don't find the node name the camera should ask for
-          // it on update
           lm.lStruct.node << ls.map["nodeName"];
-          map<unsigned long, osg::ref_ptr<OSGNodeStruct> >::iterator it;
-          for(it=drawObjects_.begin(); it!=drawObjects_.end(); ++it) {
-            if(it->second->name() == lm.lStruct.node) {
-              lm.lStruct.drawID = it->first;
-              break;
-            }
-          }
         }
         lightGroup->addChild( myLightSource.get() );
         globalStateset->setMode(GL_LIGHT0+lightIndex, osg::StateAttribute::ON);
         myLightSource->setStateSetModes(*globalStateset, osg::StateAttribute::ON);
 
         myLights[lm.lStruct.index] = lm;
+        attachLight(lm.lStruct.index);
 
         // light changed for every draw object
         //getLights(&lightList);
@@ -1330,13 +1359,7 @@ namespace mars {
           }
           else if(utils::matchPattern("*/nodeName", key)) {
             myLights[i].lStruct.node = value;
-            map<unsigned long, osg::ref_ptr<OSGNodeStruct> >::iterator it;
-            for(it=drawObjects_.begin(); it!=drawObjects_.end(); ++it) {
-              if(it->second->name() == value) {
-                myLights[i].lStruct.drawID = it->first;
-                break;
-              }
-            }
+            attachLight(i);
           }
           updateLight(i);
           break;
@@ -79,12 +79,17 @@ namespace mars {
     class OSGNodeStruct;
     class OSGHudElementStruct;
     class HUDElement;
+    class OSGDrawItem;
 
 
     //mapping and control structs
+    /**
+     * nodes[i] is the scene node of ds.drawItems[i], the items are updated
+     * in place and erased items are removed without copying the others.
+     */
     struct drawMapper {
       interfaces::drawStruct ds;
-      std::vector<osg::Node*> nodes;
+      std::vector<OSGDrawItem*> nodes;
     };
 
     /**
@@ -332,6 +337,8 @@ namespace mars {
 
       // includes osg::lights, osg::lightsource, lightstruct and flag to check if full
       std::vector<lightmanager> myLights;
+      // the lights whose draw object moved since the last frame
+      std::vector<unsigned int> movedLights;
 
       //static objects
       osg::ref_ptr<osg::Group> scene;
@@ -394,6 +401,8 @@ namespace mars {
       int createPreviewNode(const std::vector<mars::interfaces::NodeData> &allNodes);
 
       OSGNodeStruct* findDrawObject(unsigned long id) const;
+      void markDrawObjectMoved(unsigned long id);
+      void attachLight(unsigned int index);
       HUDElement* findHUDElement(unsigned long id) const;
 
       // config stuff
@@ -37,6 +37,11 @@
 #include <opencv2/opencv.hpp>
 
 #include <mars/utils/mathUtils.h>
+#include <mars/utils/misc.h>
+#include <mars/interfaces/SceneCache.h>
+
+#define MESH_CACHE_MAGIC 0x48534d4d // "MMSH"
+#define MESH_CACHE_VERSION 1
 
 namespace mars {
   namespace graphics {
@@ -47,7 +52,9 @@ namespace mars {
     using mars::utils::Quaternion;
     using mars::interfaces::snmesh;
 
-    vector<nodeFileStruct> GuiHelper::nodeFiles;
+    unordered_map<string, osg::ref_ptr<osg::Node> > GuiHelper::nodeFiles;
+    unordered_map<string, meshFileStruct> GuiHelper::meshFiles;
+    string GuiHelper::meshCachePath;
     vector<textureFileStruct> GuiHelper::textureFiles;
     vector<imageFileStruct> GuiHelper::imageFiles;
 
@@ -159,9 +166,17 @@ namespace mars {
                                                double scaleY, double scaleZ,
                                                double pivotX, double pivotY,
                                                double pivotZ) {
-        vector<int> indices;
         vector<osg::Vec3> OSGvertices;
-        snmesh mesh;
+        getTriangles(node, &OSGvertices);
+        return createSnMesh(OSGvertices, scaleX, scaleY, scaleZ,
+                            pivotX, pivotY, pivotZ);
+      }
+
+      /**
+       * collects the triangles of the drawables of the node
+       */
+      void GuiHelper::getTriangles(osg::Node *node,
+                                   vector<osg::Vec3> *vertices) {
         //visitor for getting drawables inside node
         GeodeVisitor visitor("PLACEHOLDER");
         osg::Geode* geode;
@@ -169,10 +184,10 @@ namespace mars {
         osg::ref_ptr<osg::Group> osgGroupFromRead = NULL;
         if ((osgGroupFromRead = node->asGroup()) == 0) {
           fprintf(stderr, "error\n");
+          return;
         }
         // todo: parse the tree recursive and search for drawables
         //get geometries of node
-        int indexcounter = 0;
         for (size_t m = 0; m < osgGroupFromRead->getNumChildren(); m++) {
           tmpNode = osgGroupFromRead->getChild(m);
 
@@ -188,13 +203,18 @@ namespace mars {
 
             //Here we get the triangles
             vector<osg::Vec3>& OSGverticestemp = triangleFunctor_.getVertices();
-            for (unsigned int i = 0; i < OSGverticestemp.size(); i++) {
-              OSGvertices.push_back(OSGverticestemp[i]);
-              indices.push_back(indexcounter);
-              indexcounter++;
-            }
+            vertices->insert(vertices->end(), OSGverticestemp.begin(),
+                             OSGverticestemp.end());
           }
         }
+      }
+
+      snmesh GuiHelper::createSnMesh(const vector<osg::Vec3> &OSGvertices,
+                                     double scaleX, double scaleY,
+                                     double scaleZ, double pivotX,
+                                     double pivotY, double pivotZ) {
+        snmesh mesh;
+        int indexcounter = OSGvertices.size();
 
         //store vertices in a mydVector3 structure
         mars::interfaces::mydVector3 *vertices = 0;
@@ -203,8 +223,8 @@ namespace mars {
         }
         //  dVector3 *normals = new dVector3[normals_x.size()];
         int *indexarray = 0;
-        if(indices.size() > 0){
-          indexarray = new int[indices.size()];
+        if(indexcounter > 0){
+          indexarray = new int[indexcounter];
         }
 
         //convert osg vertice vector to standard array
@@ -214,9 +234,9 @@ namespace mars {
           vertices[i][2] = (OSGvertices[i][2] - pivotZ) * scaleZ;
         }
 
-        //construct an appropriate index array
+        //every vertex belongs to exactly one triangle
         for (int i = 0; i < indexcounter; i++) {
-          indexarray[i] = indices[i];
+          indexarray[i] = i;
         }
 
         mesh.vertices = vertices;
@@ -259,25 +279,98 @@ namespace mars {
       }
 
       void GuiHelper::getPhysicsFromMesh(mars::interfaces::NodeData* node) {
-        if(node->filename.substr(node->filename.size()-5, 5) == ".bobj") {
-          getPhysicsFromNode(node, GuiHelper::readBobjFromFile(node->filename));
+        const meshFileStruct *meshFile = getMeshFile(node->filename,
+                                                     node->origName);
+        if(!meshFile) {
+          throw std::runtime_error("cannot read node from file");
         }
-        else {
-          getPhysicsFromNode(node, GuiHelper::readNodeFromFile(node->filename));
+        const osg::BoundingBox &bb = meshFile->bb;
+        Vector ex;
+        // compute bounding box has to be done in this way
+        (fabs(bb.xMax()) > fabs(bb.xMin())) ? ex.x() = fabs(bb.xMax() - bb.xMin())
+          : ex.x() = fabs(bb.xMin() - bb.xMax());
+        (fabs(bb.yMax()) > fabs(bb.yMin())) ? ex.y() = fabs(bb.yMax() - bb.yMin())
+          : ex.y() = fabs(bb.yMin() - bb.yMax());
+        (fabs(bb.zMax()) > fabs(bb.zMin())) ? ex.z() = fabs(bb.zMax() - bb.zMin())
+          : ex.z() = fabs(bb.zMin() - bb.zMax());
+
+        if (node->map.find("loadSizeFromMesh") != node->map.end()) {
+          if (node->map["loadSizeFromMesh"]) {
+            Vector physicalScale;
+            utils::vectorFromConfigItem(&(node->map["physicalScale"][0]), &physicalScale);
+            node->ext=Vector(ex.x()*physicalScale.x(), ex.y()*physicalScale.y(), ex.z()*physicalScale.z());
+          }
+        }
+
+        //compute scale factor
+        double scaleX = 1, scaleY = 1, scaleZ = 1;
+        if (ex.x() != 0) scaleX = node->ext.x() / ex.x();
+        if (ex.y() != 0) scaleY = node->ext.y() / ex.y();
+        if (ex.z() != 0) scaleZ = node->ext.z() / ex.z();
+
+        node->mesh = createSnMesh(meshFile->vertices, scaleX, scaleY, scaleZ,
+                                  node->pivot.x(), node->pivot.y(),
+                                  node->pivot.z());
+      }
+
+      /**
+       * \brief Returns the triangles of the part origName of the file. The
+       *  triangles are extracted once per part and stored in the mesh cache
+       *  path if it is set.
+       *
+       * post:
+       *     - returns 0 if the file cannot be read
+       */
+      const meshFileStruct* GuiHelper::getMeshFile(const std::string &filename,
+                                                   const std::string &origName) {
+        std::string key = filename + "\n" + origName;
+        unordered_map<string, meshFileStruct>::iterator it = meshFiles.find(key);
+        if(it != meshFiles.end()) return &it->second;
+
+        std::string cacheFile;
+        if(!meshCachePath.empty()) {
+          // the file name is part of the hash
+          uint64_t hash = interfaces::SceneCache::hashFile(filename);
+          if(hash) {
+            char name[32];
+            hash = interfaces::SceneCache::hashString(origName, hash);
+            snprintf(name, sizeof(name), "%016llx.msh", (unsigned long long)hash);
+            cacheFile = utils::pathJoin(meshCachePath, std::string("meshes/") + name);
+          }
         }
+
+        meshFileStruct meshFile;
+        if(cacheFile.empty() || !readMeshCache(cacheFile, &meshFile)) {
+          osg::ref_ptr<osg::Node> completeNode;
+          if(filename.size() > 5 &&
+             filename.substr(filename.size()-5, 5) == ".bobj") {
+            completeNode = GuiHelper::readBobjFromFile(filename);
+          }
+          else {
+            completeNode = GuiHelper::readNodeFromFile(filename);
+          }
+          if(!completeNode.valid()) return 0;
+          osg::ref_ptr<osg::Group> group = getMeshGroup(completeNode, origName);
+          if(!group.valid()) return 0;
+
+          osg::ComputeBoundsVisitor cbbv;
+          group->accept(cbbv);
+          meshFile.bb = cbbv.getBoundingBox();
+          getTriangles(group.get(), &meshFile.vertices);
+          if(!cacheFile.empty()) writeMeshCache(cacheFile, meshFile);
+        }
+        meshFileStruct &result = meshFiles[key];
+        result.vertices.swap(meshFile.vertices);
+        result.bb = meshFile.bb;
+        return &result;
       }
 
-      void GuiHelper::getPhysicsFromNode(mars::interfaces::NodeData* node,
-                                         osg::ref_ptr<osg::Node> completeNode) {
+      osg::ref_ptr<osg::Group> GuiHelper::getMeshGroup(osg::ref_ptr<osg::Node> completeNode,
+                                                       const std::string &origName) {
         osg::ref_ptr<osg::Group> myCreatedGroup;
         osg::ref_ptr<osg::Group> myGroupFromRead;
         osg::ref_ptr<osg::Geode> myGeodeFromRead;
-        nodemanager tempnode;
         bool found = false;
-        // check whether it is a osg::Group (.obj file)
-        if(!completeNode.valid()){
-          throw std::runtime_error("cannot read node from file");
-        }
 
         if((myGeodeFromRead = completeNode->asGeode()) != 0) {
           //if the node was read from a .stl-file it read as geode not as group
@@ -294,9 +387,9 @@ namespace mars {
           for (unsigned int i = 0; i < myGroupFromRead->getNumChildren(); i ++) {
             osg::ref_ptr<osg::Node> myTestingNode = myGroupFromRead->getChild(i);
             if (myTestingNode == 0) {
-              return;
+              return 0;
             }
-            if (myTestingNode->getName() == node->origName or node->origName.size() == 0) {
+            if (myTestingNode->getName() == origName or origName.size() == 0) {
               myTestingNode->setStateSet(stateset.get());
               myCreatedGroup->addChild(myTestingNode.get());
               found = true;
@@ -308,95 +401,72 @@ namespace mars {
             }
           }
         }
+        return myCreatedGroup;
+      }
 
-        osg::ComputeBoundsVisitor cbbv;
-        myCreatedGroup.get()->accept(cbbv);
-        osg::BoundingBox bb = cbbv.getBoundingBox();
-        Vector ex;
-        // compute bounding box has to be done in this way
-        (fabs(bb.xMax()) > fabs(bb.xMin())) ? ex.x() = fabs(bb.xMax() - bb.xMin())
-          : ex.x() = fabs(bb.xMin() - bb.xMax());
-        (fabs(bb.yMax()) > fabs(bb.yMin())) ? ex.y() = fabs(bb.yMax() - bb.yMin())
-          : ex.y() = fabs(bb.yMin() - bb.yMax());
-        (fabs(bb.zMax()) > fabs(bb.zMin())) ? ex.z() = fabs(bb.zMax() - bb.zMin())
-          : ex.z() = fabs(bb.zMin() - bb.zMax());
-
-        if (node->map.find("loadSizeFromMesh") != node->map.end()) {
-          if (node->map["loadSizeFromMesh"]) {
-            Vector physicalScale;
-            utils::vectorFromConfigItem(&(node->map["physicalScale"][0]), &physicalScale);
-            node->ext=Vector(ex.x()*physicalScale.x(), ex.y()*physicalScale.y(), ex.z()*physicalScale.z());
-          }
-        }
+      void GuiHelper::setMeshCachePath(const std::string &path) {
+        meshCachePath = path;
+      }
 
-        //compute scale factor
-        double scaleX = 1, scaleY = 1, scaleZ = 1;
-        if (ex.x() != 0) scaleX = node->ext.x() / ex.x();
-        if (ex.y() != 0) scaleY = node->ext.y() / ex.y();
-        if (ex.z() != 0) scaleZ = node->ext.z() / ex.z();
+      bool GuiHelper::readMeshCache(const std::string &filename,
+                                    meshFileStruct *mesh) {
+        FILE *file = fopen(filename.c_str(), "rb");
+        if(!file) return false;
+        uint32_t header[3];
+        float bb[6];
+        bool ok = (fread(header, sizeof(header), 1, file) == 1 &&
+                   header[0] == MESH_CACHE_MAGIC &&
+                   header[1] == MESH_CACHE_VERSION &&
+                   fread(bb, sizeof(bb), 1, file) == 1);
+        if(ok) {
+          mesh->bb.set(bb[0], bb[1], bb[2], bb[3], bb[4], bb[5]);
+          mesh->vertices.resize(header[2]);
+          // osg::Vec3 is three packed floats
+          ok = (header[2] == 0 ||
+                fread(&mesh->vertices[0], sizeof(osg::Vec3), header[2], file) == header[2]);
+        }
+        fclose(file);
+        if(!ok) mesh->vertices.clear();
+        return ok;
+      }
 
-        // create transform and group Node for the actual node
-        osg::ref_ptr<osg::PositionAttitudeTransform> transform;
-        osg::ref_ptr<osg::MatrixTransform> tx;
-
-        transform = new osg::PositionAttitudeTransform();
-        tx = new osg::MatrixTransform;
-        tx->setMatrix(osg::Matrix::scale(scaleX, scaleY, scaleZ));
-        tx->setDataVariance(osg::Node::STATIC);
-        tx->addChild(myCreatedGroup.get());
-
-        //add the node to a transformation to make him movable
-        transform->addChild(tx.get());
-        transform->setPivotPoint(osg::Vec3(node->pivot.x()*scaleX,
-                                           node->pivot.y()*scaleY,
-                                           node->pivot.z()*scaleZ));
-        transform->setPosition(osg::Vec3(node->pos.x() + node->visual_offset_pos.x(),
-                                         node->pos.y() + node->visual_offset_pos.y(),
-                                         node->pos.z() + node->visual_offset_pos.z()));
-        //set rotation
-        osg::Quat oquat;
-        Quaternion qrot = node->rot * node->visual_offset_rot;
-        oquat.set(qrot.x(), qrot.y(), qrot.z(), qrot.w());
-        transform->setAttitude(oquat);
-
-        tempnode.transform = transform.get();
-        tempnode.node = myCreatedGroup.get();
-        tempnode.matrix = tx.get();
-        tempnode.offset = node->visual_offset_pos;
-        tempnode.r_off = node->visual_offset_rot;
-
-        node->mesh = GuiHelper::convertOsgNodeToSnMesh(tempnode.node.get(),
-                                                       scaleX, scaleY, scaleZ,
-                                                       node->pivot.x(),
-                                                       node->pivot.y(),
-                                                       node->pivot.z());
+      void GuiHelper::writeMeshCache(const std::string &filename,
+                                     const meshFileStruct &mesh) {
+        if(!utils::createDirectory(utils::getPathOfFile(filename))) return;
+        std::string tmpFilename = filename + ".tmp";
+        FILE *file = fopen(tmpFilename.c_str(), "wb");
+        if(!file) return;
+        uint32_t header[3] = {MESH_CACHE_MAGIC, MESH_CACHE_VERSION,
+                              (uint32_t)mesh.vertices.size()};
+        float bb[6] = {mesh.bb.xMin(), mesh.bb.yMin(), mesh.bb.zMin(),
+                       mesh.bb.xMax(), mesh.bb.yMax(), mesh.bb.zMax()};
+        bool ok = (fwrite(header, sizeof(header), 1, file) == 1 &&
+                   fwrite(bb, sizeof(bb), 1, file) == 1 &&
+                   (mesh.vertices.empty() ||
+                    fwrite(&mesh.vertices[0], sizeof(osg::Vec3),
+                           mesh.vertices.size(), file) == mesh.vertices.size()));
+        if(fclose(file) != 0) ok = false;
+        if(!ok || rename(tmpFilename.c_str(), filename.c_str()) != 0) {
+          remove(tmpFilename.c_str());
+        }
       }
 
       osg::ref_ptr<osg::Node> GuiHelper::readNodeFromFile(string fileName) {
-        std::vector<nodeFileStruct>::iterator iter;
+        unordered_map<string, osg::ref_ptr<osg::Node> >::iterator iter;
+        iter = GuiHelper::nodeFiles.find(fileName);
+        if(iter != GuiHelper::nodeFiles.end()) return iter->second;
 
-        for(iter = GuiHelper::nodeFiles.begin();
-            iter != GuiHelper::nodeFiles.end(); iter++) {
-          if((*iter).fileName == fileName) return (*iter).node;
-        }
-        nodeFileStruct newNodeFile;
-        newNodeFile.fileName = fileName;
-        newNodeFile.node = osgDB::readNodeFile(fileName);
-        GuiHelper::nodeFiles.push_back(newNodeFile);
-        return newNodeFile.node;
+        osg::ref_ptr<osg::Node> node = osgDB::readNodeFile(fileName);
+        GuiHelper::nodeFiles[fileName] = node;
+        return node;
       }
 
 
       osg::ref_ptr<osg::Node> GuiHelper::readBobjFromFile(const std::string &filename) {
 
-        std::vector<nodeFileStruct>::iterator iter;
-
-        for(iter = GuiHelper::nodeFiles.begin();
-            iter != GuiHelper::nodeFiles.end(); iter++) {
-          if((*iter).fileName == filename) return (*iter).node;
-        }
-        nodeFileStruct newNodeFile;
-        newNodeFile.fileName = filename;
+        unordered_map<string, osg::ref_ptr<osg::Node> >::iterator iter;
+        iter = GuiHelper::nodeFiles.find(filename);
+        if(iter != GuiHelper::nodeFiles.end()) return iter->second;
 
         FILE* input = fopen(filename.c_str(), "rb");
         if(!input) {
@@ -593,9 +663,8 @@ namespace mars {
         osgUtil::Optimizer optimizer;
         //optimizer.optimize( geode );
 
-        newNodeFile.node = geode;
-        GuiHelper::nodeFiles.push_back(newNodeFile);
-        return newNodeFile.node;
+        GuiHelper::nodeFiles[filename] = geode;
+        return geode;
       }
 
       // TODO: should not be in graphics!
@@ -603,6 +672,17 @@ namespace mars {
       // maybe move to NodeFactory ??
       void GuiHelper::readPixelData(mars::interfaces::terrainStruct *terrain) {
 
+        if(mars::interfaces::TerrainTiles::isTileFile(terrain->srcname)) {
+          // tiled terrains are mapped and not copied into pixelData
+          std::shared_ptr<mars::interfaces::TerrainTiles> tiles(new mars::interfaces::TerrainTiles());
+          if(tiles->open(terrain->srcname)) {
+            terrain->width = tiles->getWidth();
+            terrain->height = tiles->getHeight();
+            terrain->tiles = tiles;
+          }
+          return;
+        }
+
         cv::Mat img;
 
         img=cv::imread(terrain->srcname, cv::IMREAD_ANYDEPTH);
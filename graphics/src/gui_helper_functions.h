@@ -31,9 +31,11 @@
 #include <osg/Geometry>
 #include <osg/Texture2D>
 #include <osg/PositionAttitudeTransform>
+#include <osg/BoundingBox>
 
 #include <vector>
 #include <sstream>
+#include <unordered_map>
 
 #include <mars/interfaces/sim_common.h>
 #include <mars/interfaces/terrainStruct.h>
@@ -62,10 +64,14 @@ namespace mars {
       mars::interfaces::NodeData snode;
     }; // end of struct nodemanager
 
-    struct nodeFileStruct {
-      std::string fileName;
-      osg::ref_ptr<osg::Node> node;
-    }; // end of struct nodeFileStruct
+    /**
+     * The triangles of a mesh part as used by the physics, i.e. three
+     * vertices per triangle, and their bounding box.
+     */
+    struct meshFileStruct {
+      std::vector<osg::Vec3> vertices;
+      osg::BoundingBox bb;
+    }; // end of struct meshFileStruct
 
     struct textureFileStruct {
       std::string fileName;
@@ -125,6 +131,12 @@ namespace mars {
       static osg::ref_ptr<osg::Node> readBobjFromFile(const std::string &filename);
       static osg::ref_ptr<osg::Texture2D> loadTexture(std::string filename);
       static osg::ref_ptr<osg::Image> loadImage(std::string filename);
+      /**
+       * Sets the directory the triangles of the meshes are stored in, so
+       * they are not extracted again in later runs. An empty path disables
+       * the storage.
+       */
+      static void setMeshCachePath(const std::string &path);
 
     private:
       osg::Geometry *my_geo;
@@ -133,13 +145,29 @@ namespace mars {
       //GraphicsWidget *gw;
       //for compatibility
       mars::interfaces::GraphicData gs;
-      static std::vector<nodeFileStruct> nodeFiles;
+      // the loaded files by file name
+      static std::unordered_map<std::string, osg::ref_ptr<osg::Node> > nodeFiles;
+      // the triangles by file name and name of the part
+      static std::unordered_map<std::string, meshFileStruct> meshFiles;
+      static std::string meshCachePath;
       // vector to prevent double load of textures
       static std::vector<textureFileStruct> textureFiles;
       // vector to prevent double load of images
       static std::vector<imageFileStruct> imageFiles;
-      void getPhysicsFromNode(mars::interfaces::NodeData* node,
-                              osg::ref_ptr<osg::Node> completeNode);
+      static const meshFileStruct* getMeshFile(const std::string &filename,
+                                               const std::string &origName);
+      static osg::ref_ptr<osg::Group> getMeshGroup(osg::ref_ptr<osg::Node> completeNode,
+                                                   const std::string &origName);
+      static void getTriangles(osg::Node *node,
+                               std::vector<osg::Vec3> *vertices);
+      static mars::interfaces::snmesh createSnMesh(const std::vector<osg::Vec3> &vertices,
+                                                   double scaleX, double scaleY,
+                                                   double scaleZ, double pivotX,
+                                                   double pivotY, double pivotZ);
+      static bool readMeshCache(const std::string &filename,
+                                meshFileStruct *mesh);
+      static void writeMeshCache(const std::string &filename,
+                                 const meshFileStruct &mesh);
     }; // end of class GuiHelper
 
   } // end of namespace graphics
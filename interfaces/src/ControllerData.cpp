@@ -36,6 +36,7 @@ namespace mars {
 
     ControllerData::ControllerData() {
       rate = 20;
+      lock_step = false;
     }
 
     bool ControllerData::fromConfigMap(ConfigMap *config,
@@ -51,6 +52,8 @@ namespace mars {
       GET_VALUE("index", id, ULong);
       GET_VALUE("rate", rate, Double);
       dylib_path = config->get("dylib_path", dylib_path);
+      shm_name = config->get("shm_name", shm_name);
+      lock_step = config->get("lock_step", lock_step);
 
       if((it = config->find("sensorid")) != config->end()) {
         ConfigVector _ids = (*config)["sensorid"];
@@ -99,6 +102,10 @@ namespace mars {
       SET_VALUE("index", id);
       SET_VALUE("rate", rate);
       SET_VALUE("dylib_path", dylib_path);
+      if(!shm_name.empty()) {
+        SET_VALUE("shm_name", shm_name);
+        SET_VALUE("lock_step", lock_step);
+      }
 
       for(it=sensors.begin(); it!=sensors.end(); ++it) {
         (*config)["sensorid"] << *it;
@@ -49,6 +49,9 @@ namespace mars {
       std::vector<unsigned long> sensors;
       std::vector<unsigned long> sNodes;
       std::string dylib_path;
+      // name of the shared memory segment used instead of the socket
+      std::string shm_name;
+      bool lock_step;
     }; // end of class ControllerData
 
   } // end of namespace interfaces
@@ -0,0 +1,455 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SceneCache.h"
+#include "sim/ControlCenter.h"
+#include "Logging.hpp"
+
+#include <mars/utils/misc.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mars {
+  namespace interfaces {
+
+    using namespace configmaps;
+
+    enum SceneCacheItemType {
+      SCENE_CACHE_MAP = 0,
+      SCENE_CACHE_VECTOR = 1,
+      SCENE_CACHE_ATOM = 2,
+      SCENE_CACHE_EMPTY = 3
+    };
+
+    static void writeBytes(std::string *out, const void *data, size_t size) {
+      out->append((const char*)data, size);
+    }
+
+    template <typename T>
+    static void writeValue(std::string *out, T value) {
+      writeBytes(out, &value, sizeof(T));
+    }
+
+    static void writeString(std::string *out, const std::string &s) {
+      writeValue<uint32_t>(out, s.size());
+      writeBytes(out, s.data(), s.size());
+    }
+
+    static void writeItem(std::string *out, ConfigItem &item);
+
+    static void writeMap(std::string *out, ConfigMap &map) {
+      writeValue<uint8_t>(out, SCENE_CACHE_MAP);
+      writeValue<uint32_t>(out, map.size());
+      for(ConfigMap::iterator it=map.begin(); it!=map.end(); ++it) {
+        writeString(out, it->first);
+        writeItem(out, it->second);
+      }
+    }
+
+    static void writeItem(std::string *out, ConfigItem &item) {
+      if(item.isMap()) {
+        writeMap(out, item);
+      }
+      else if(item.isVector()) {
+        ConfigVector &v = item;
+        writeValue<uint8_t>(out, SCENE_CACHE_VECTOR);
+        writeValue<uint32_t>(out, v.size());
+        for(size_t i=0; i<v.size(); ++i) {
+          writeItem(out, v[i]);
+        }
+      }
+      else if(item.isAtom()) {
+        ConfigAtom &atom = item;
+        ConfigAtom::ItemType type = atom.getType();
+        writeValue<uint8_t>(out, SCENE_CACHE_ATOM);
+        writeValue<uint8_t>(out, type);
+        switch(type) {
+        case ConfigAtom::INT_TYPE:
+          writeValue<int32_t>(out, atom.getInt());
+          break;
+        case ConfigAtom::UINT_TYPE:
+          writeValue<uint32_t>(out, atom.getUInt());
+          break;
+        case ConfigAtom::ULONG_TYPE:
+          writeValue<uint64_t>(out, atom.getULong());
+          break;
+        case ConfigAtom::DOUBLE_TYPE:
+          writeValue<double>(out, atom.getDouble());
+          break;
+        case ConfigAtom::BOOL_TYPE:
+          writeValue<uint8_t>(out, atom.getBool());
+          break;
+        case ConfigAtom::STRING_TYPE:
+          writeString(out, atom.getString());
+          break;
+        default:
+          // values read from a file are kept unparsed until they are used
+          writeString(out, atom.getUnparsedString());
+          break;
+        }
+      }
+      else {
+        writeValue<uint8_t>(out, SCENE_CACHE_EMPTY);
+      }
+    }
+
+    /**
+     * Reads from the mapped file, every read is checked against the end of
+     * the file and fails from then on.
+     */
+    struct SceneCacheReader {
+      const char *p, *end;
+      bool ok;
+
+      SceneCacheReader(const char *p, const char *end) : p(p), end(end), ok(true) {}
+
+      bool readBytes(void *data, size_t size) {
+        if(!ok || (size_t)(end - p) < size) return ok = false;
+        memcpy(data, p, size);
+        p += size;
+        return true;
+      }
+
+      template <typename T>
+      T read(void) {
+        T value = T();
+        readBytes(&value, sizeof(T));
+        return value;
+      }
+
+      std::string readString(void) {
+        uint32_t length = read<uint32_t>();
+        if(!ok || (size_t)(end - p) < length) {
+          ok = false;
+          return std::string();
+        }
+        std::string s(p, length);
+        p += length;
+        return s;
+      }
+
+      void readMapContent(ConfigMap *map) {
+        uint32_t n = read<uint32_t>();
+        for(uint32_t i=0; ok && i<n; ++i) {
+          std::string key = readString();
+          readItem(&(*map)[key]);
+        }
+      }
+
+      void readItem(ConfigItem *item) {
+        uint8_t type = read<uint8_t>();
+        if(!ok) return;
+        if(type == SCENE_CACHE_MAP) {
+          ConfigMap map;
+          readMapContent(&map);
+          *item = map;
+        }
+        else if(type == SCENE_CACHE_VECTOR) {
+          ConfigVector v;
+          uint32_t n = read<uint32_t>();
+          for(uint32_t i=0; ok && i<n; ++i) {
+            ConfigItem child;
+            readItem(&child);
+            v.push_back(child);
+          }
+          *item = v;
+        }
+        else if(type == SCENE_CACHE_ATOM) {
+          uint8_t atomType = read<uint8_t>();
+          switch(atomType) {
+          case ConfigAtom::INT_TYPE:
+            *item = (int)read<int32_t>();
+            break;
+          case ConfigAtom::UINT_TYPE:
+            *item = (unsigned int)read<uint32_t>();
+            break;
+          case ConfigAtom::ULONG_TYPE:
+            *item = (unsigned long)read<uint64_t>();
+            break;
+          case ConfigAtom::DOUBLE_TYPE:
+            *item = read<double>();
+            break;
+          case ConfigAtom::BOOL_TYPE:
+            *item = (bool)read<uint8_t>();
+            break;
+          case ConfigAtom::STRING_TYPE:
+            *item = readString();
+            break;
+          default: {
+            ConfigAtom atom;
+            atom.setUnparsedString(readString());
+            *item = atom;
+            break;
+          }
+          }
+        }
+        else if(type != SCENE_CACHE_EMPTY) {
+          ok = false;
+        }
+      }
+    };
+
+    SceneCache::SceneCache(const std::string &cacheDir,
+                           const std::string &name) : fd(-1), size(0),
+                                                      mem(0), numLists(0) {
+#ifndef WIN32
+      // the cache files are mapped, see open()
+      if(!cacheDir.empty()) {
+        char entry[32];
+        snprintf(entry, sizeof(entry), "%016llx/",
+                 (unsigned long long)hashString(name));
+        entryDir = utils::pathJoin(cacheDir, entry);
+        filename = entryDir + SCENE_CACHE_FILENAME;
+      }
+#endif
+    }
+
+    SceneCache::~SceneCache() {
+      close();
+    }
+
+    uint64_t SceneCache::hash(const void *data, size_t size, uint64_t seed) {
+      // FNV-1a
+      const unsigned char *p = (const unsigned char*)data;
+      uint64_t h = seed;
+      for(size_t i=0; i<size; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+      }
+      return h;
+    }
+
+    uint64_t SceneCache::hashString(const std::string &s, uint64_t seed) {
+      return hash(s.data(), s.size(), seed);
+    }
+
+    uint64_t SceneCache::hashFile(const std::string &filename) {
+      FILE *file = fopen(filename.c_str(), "rb");
+      if(!file) return 0;
+      std::vector<char> buffer(1 << 16);
+      uint64_t h = hashString(filename);
+      size_t n;
+      while((n = fread(&buffer[0], 1, buffer.size(), file)) > 0) {
+        h = hash(&buffer[0], n, h);
+      }
+      fclose(file);
+      return h ? h : 1;
+    }
+
+    static bool itemHasIncludes(ConfigItem &item) {
+      if(item.isMap()) {
+        return SceneCache::hasIncludes(item);
+      }
+      if(item.isVector()) {
+        ConfigVector &v = item;
+        for(size_t i=0; i<v.size(); ++i) {
+          if(itemHasIncludes(v[i])) return true;
+        }
+      }
+      return false;
+    }
+
+    bool SceneCache::hasIncludes(ConfigMap &map) {
+      for(ConfigMap::iterator it=map.begin(); it!=map.end(); ++it) {
+        if(it->first == "URI" || it->first == "URIs" ||
+           itemHasIncludes(it->second)) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+     * \brief Maps the cache file of the entry.
+     *
+     * post:
+     *     - returns false if the file is missing, damaged, was written for
+     *       another key or any source file changed
+     */
+    bool SceneCache::open(uint64_t key) {
+      close();
+#ifdef WIN32
+      return false;
+#else
+      if(filename.empty()) return false;
+      fd = ::open(filename.c_str(), O_RDONLY);
+      if(fd < 0) return false;
+      struct stat st;
+      void *m = MAP_FAILED;
+      if(fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(scene_cache_header)) {
+        size = st.st_size;
+        m = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      }
+      if(m == MAP_FAILED) {
+        close();
+        return false;
+      }
+      mem = (char*)m;
+
+      const scene_cache_header *header = (const scene_cache_header*)mem;
+      if(header->magic != SCENE_CACHE_MAGIC ||
+         header->version != SCENE_CACHE_VERSION ||
+         header->key != key || header->size != size) {
+        close();
+        return false;
+      }
+      SceneCacheReader reader(mem + sizeof(scene_cache_header), mem + size);
+      for(uint32_t i=0; i<header->num_sources; ++i) {
+        std::string source = reader.readString();
+        uint64_t h = reader.read<uint64_t>();
+        if(!reader.ok || hashFile(source) != h) {
+          LOG_INFO("SceneCache: \"%s\" changed, the scene is parsed again",
+                   source.c_str());
+          close();
+          return false;
+        }
+      }
+      return true;
+#endif
+    }
+
+    void SceneCache::close(void) {
+#ifndef WIN32
+      if(mem) munmap(mem, size);
+      if(fd >= 0) ::close(fd);
+#endif
+      fd = -1;
+      mem = 0;
+      size = 0;
+    }
+
+    bool SceneCache::readList(const std::string &name,
+                              std::vector<ConfigMap> *list) const {
+      if(!mem) return false;
+      const scene_cache_header *header = (const scene_cache_header*)mem;
+      SceneCacheReader reader(mem + sizeof(scene_cache_header), mem + size);
+      for(uint32_t i=0; i<header->num_sources; ++i) {
+        reader.readString();
+        reader.read<uint64_t>();
+      }
+      for(uint32_t i=0; reader.ok && i<header->num_lists; ++i) {
+        std::string listName = reader.readString();
+        uint64_t listSize = reader.read<uint64_t>();
+        if(!reader.ok || (uint64_t)(reader.end - reader.p) < listSize) break;
+        if(listName != name) {
+          reader.p += listSize;
+          continue;
+        }
+        SceneCacheReader listReader(reader.p, reader.p + listSize);
+        uint32_t n = listReader.read<uint32_t>();
+        for(uint32_t k=0; listReader.ok && k<n; ++k) {
+          ConfigMap map;
+          if(listReader.read<uint8_t>() != SCENE_CACHE_MAP) {
+            listReader.ok = false;
+            break;
+          }
+          listReader.readMapContent(&map);
+          list->push_back(map);
+        }
+        if(!listReader.ok) {
+          LOG_ERROR("SceneCache: \"%s\" is damaged", filename.c_str());
+        }
+        return listReader.ok;
+      }
+      return false;
+    }
+
+    void SceneCache::addSource(const std::string &filename) {
+      sources.push_back(filename);
+    }
+
+    void SceneCache::addList(const std::string &name,
+                             const std::vector<ConfigMap> &list) {
+      std::string data;
+      writeValue<uint32_t>(&data, list.size());
+      for(size_t i=0; i<list.size(); ++i) {
+        ConfigMap map = list[i];
+        writeMap(&data, map);
+      }
+      writeString(&listData, name);
+      writeValue<uint64_t>(&listData, data.size());
+      listData += data;
+      ++numLists;
+    }
+
+    bool SceneCache::write(uint64_t key) {
+      if(filename.empty()) return false;
+      close();
+      if(!utils::createDirectory(entryDir)) return false;
+
+      std::string data;
+      scene_cache_header header;
+      memset(&header, 0, sizeof(header));
+      header.magic = SCENE_CACHE_MAGIC;
+      header.version = SCENE_CACHE_VERSION;
+      header.key = key;
+      header.num_sources = sources.size();
+      header.num_lists = numLists;
+      writeBytes(&data, &header, sizeof(header));
+      for(size_t i=0; i<sources.size(); ++i) {
+        uint64_t h = hashFile(sources[i]);
+        if(!h) {
+          LOG_WARN("SceneCache: cannot read source \"%s\", the scene is not cached",
+                   sources[i].c_str());
+          return false;
+        }
+        writeString(&data, sources[i]);
+        writeValue<uint64_t>(&data, h);
+      }
+      data += listData;
+      ((scene_cache_header*)&data[0])->size = data.size();
+
+      // a concurrent load either sees the old or the complete new file
+      char suffix[32];
+#ifdef WIN32
+      snprintf(suffix, sizeof(suffix), ".tmp");
+#else
+      snprintf(suffix, sizeof(suffix), ".%d", (int)getpid());
+#endif
+      std::string tmpFilename = filename + suffix;
+      FILE *file = fopen(tmpFilename.c_str(), "wb");
+      if(!file) {
+        LOG_WARN("SceneCache: cannot write \"%s\": %s", tmpFilename.c_str(),
+                 strerror(errno));
+        return false;
+      }
+      bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+      if(fclose(file) != 0) ok = false;
+      if(ok) ok = rename(tmpFilename.c_str(), filename.c_str()) == 0;
+      if(!ok) {
+        LOG_WARN("SceneCache: writing \"%s\" failed", filename.c_str());
+        remove(tmpFilename.c_str());
+        return false;
+      }
+      LOG_INFO("SceneCache: wrote \"%s\"", filename.c_str());
+      return true;
+    }
+
+  } // end of namespace interfaces
+} // end of namespace mars
@@ -0,0 +1,142 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+ /**
+ * \file SceneCache.h
+ * \brief A binary cache of the parsed configuration lists of a scene.
+ *
+ */
+
+#ifndef MARS_INTERFACES_SCENE_CACHE_H
+#define MARS_INTERFACES_SCENE_CACHE_H
+
+#ifdef _PRINT_HEADER_
+  #warning "SceneCache.h"
+#endif
+
+#include <configmaps/ConfigData.h>
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#define SCENE_CACHE_MAGIC 0x4e43534d // "MSCN"
+#define SCENE_CACHE_VERSION 1
+#define SCENE_CACHE_FILENAME "scene.msc"
+
+namespace mars {
+  namespace interfaces {
+
+    /**
+     * The header of a scene cache file. It is followed by num_sources
+     * entries of the source file name and the hash of its content and by
+     * num_lists named lists of configuration maps. All strings are stored
+     * with a uint32_t length prefix.
+     */
+    struct scene_cache_header {
+      uint32_t magic;
+      uint32_t version;
+      uint64_t key;
+      uint32_t num_sources;
+      uint32_t num_lists;
+      uint64_t size;
+    };
+
+    /**
+     * Stores the configuration lists a loader creates from a scene, e.g. the
+     * node, joint, motor and sensor configs, in a binary file. Every scene
+     * gets its own directory below the cache directory, which also serves
+     * as persistent location for files unpacked from an archive. The entry
+     * is valid as long as the content of all registered source files and
+     * the key given by the loader are unchanged. On a valid entry the loader
+     * reads the lists from the mapped file instead of parsing the scene.
+     */
+    class SceneCache {
+    public:
+      /**
+       * \param cacheDir The root directory of the cache, an empty string
+       *                 disables the cache.
+       * \param name Identifies the entry, usually the absolute path of the
+       *             scene file.
+       */
+      SceneCache(const std::string &cacheDir, const std::string &name);
+      ~SceneCache();
+
+      bool isEnabled(void) const {return !entryDir.empty();}
+      /** The directory of this entry, ends with a '/'. */
+      const std::string& getEntryDir(void) const {return entryDir;}
+
+      /**
+       * Maps the cache file and checks it against the given key and the
+       * content of the source files stored in the file.
+       */
+      bool open(uint64_t key);
+      void close(void);
+      bool isOpen(void) const {return mem != 0;}
+
+      /**
+       * Appends the list with the given name of the opened file to list.
+       * Returns false if the list is missing or the file is damaged.
+       */
+      bool readList(const std::string &name,
+                    std::vector<configmaps::ConfigMap> *list) const;
+
+      /**
+       * The source files and lists are collected and written with write().
+       * The file is replaced atomically.
+       */
+      void addSource(const std::string &filename);
+      void addList(const std::string &name,
+                   const std::vector<configmaps::ConfigMap> &list);
+      bool write(uint64_t key);
+
+      static uint64_t hash(const void *data, size_t size,
+                           uint64_t seed = 14695981039346656037ULL);
+      static uint64_t hashString(const std::string &s,
+                                 uint64_t seed = 14695981039346656037ULL);
+      /** Returns 0 if the file cannot be read. */
+      static uint64_t hashFile(const std::string &filename);
+      /**
+       * Returns true if the map contains a "URI" or "URIs" key at any
+       * level. The files included by them are resolved by the yaml loaders
+       * and are not known as sources.
+       */
+      static bool hasIncludes(configmaps::ConfigMap &map);
+
+    private:
+      std::string entryDir;
+      std::string filename;
+      int fd;
+      size_t size;
+      char *mem;
+      std::vector<std::string> sources;
+      std::string listData;
+      uint32_t numLists;
+
+      // the mapping is not copied
+      SceneCache(const SceneCache &other);
+      SceneCache& operator=(const SceneCache &other);
+    };
+
+  } // end of namespace interfaces
+} // end of namespace mars
+
+#endif // MARS_INTERFACES_SCENE_CACHE_H
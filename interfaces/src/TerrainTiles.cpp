@@ -0,0 +1,251 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "TerrainTiles.h"
+#include "sim/ControlCenter.h"
+#include "Logging.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mars {
+  namespace interfaces {
+
+    static size_t alignTerrainTiles(size_t size) {
+      return (size + TERRAIN_TILES_ALIGN - 1) & ~(size_t)(TERRAIN_TILES_ALIGN - 1);
+    }
+
+    TerrainTiles::TerrainTiles() : fd(-1), size(0), mem(0), data(0),
+                                   width(0), height(0), tileSize(0),
+                                   tilesX(0), tilesY(0),
+                                   sampleType(TERRAIN_SAMPLE_FLOAT),
+                                   tileBytes(0), numLoaded(0) {
+    }
+
+    TerrainTiles::~TerrainTiles() {
+      close();
+    }
+
+    bool TerrainTiles::isTileFile(const std::string &filename) {
+      const std::string ext = TERRAIN_TILES_EXTENSION;
+      return (filename.size() > ext.size() &&
+              filename.compare(filename.size()-ext.size(), ext.size(), ext) == 0);
+    }
+
+    /**
+     * \brief Maps the file and checks the header.
+     *
+     * post:
+     *     - no tile is read yet
+     *     - returns false if the file is missing or not a tiled terrain
+     */
+    bool TerrainTiles::open(const std::string &filename) {
+      close();
+#ifdef WIN32
+      LOG_ERROR("TerrainTiles: tiled terrains are not supported on this platform");
+      return false;
+#else
+      fd = ::open(filename.c_str(), O_RDONLY);
+      if(fd < 0) {
+        LOG_ERROR("TerrainTiles: cannot open \"%s\": %s", filename.c_str(),
+                  strerror(errno));
+        return false;
+      }
+      struct stat st;
+      void *m = MAP_FAILED;
+      if(fstat(fd, &st) == 0 && (size_t)st.st_size >= TERRAIN_TILES_ALIGN) {
+        size = st.st_size;
+        m = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+      }
+      if(m == MAP_FAILED) {
+        LOG_ERROR("TerrainTiles: cannot map \"%s\"", filename.c_str());
+        close();
+        return false;
+      }
+      mem = (char*)m;
+
+      const terrain_tiles_header *header = (const terrain_tiles_header*)mem;
+      if(header->magic != TERRAIN_TILES_MAGIC ||
+         header->version != TERRAIN_TILES_VERSION ||
+         header->tile_size == 0 || header->width == 0 || header->height == 0 ||
+         header->sample_type > TERRAIN_SAMPLE_UINT16) {
+        LOG_ERROR("TerrainTiles: \"%s\" is no valid tiled terrain",
+                  filename.c_str());
+        close();
+        return false;
+      }
+      // getSample() trusts the tile grid and the tile size, thus they have
+      // to cover the whole terrain and the file has to hold all tiles
+      size_t sampleBytes = (header->sample_type == TERRAIN_SAMPLE_UINT16 ?
+                            sizeof(uint16_t) : sizeof(float));
+      if(header->tiles_x != ((uint64_t)header->width + header->tile_size - 1) /
+         header->tile_size ||
+         header->tiles_y != ((uint64_t)header->height + header->tile_size - 1) /
+         header->tile_size ||
+         header->tile_bytes < (uint64_t)header->tile_size *
+         header->tile_size * sampleBytes ||
+         (size - TERRAIN_TILES_ALIGN) / header->tile_bytes <
+         (uint64_t)header->tiles_x * header->tiles_y) {
+        LOG_ERROR("TerrainTiles: \"%s\" has an inconsistent tile layout",
+                  filename.c_str());
+        close();
+        return false;
+      }
+      width = header->width;
+      height = header->height;
+      tileSize = header->tile_size;
+      tilesX = header->tiles_x;
+      tilesY = header->tiles_y;
+      sampleType = header->sample_type;
+      tileBytes = header->tile_bytes;
+      tileStates.assign((size_t)tilesX*tilesY, TILE_UNLOADED);
+      numLoaded = 0;
+      data = mem + TERRAIN_TILES_ALIGN;
+      // the access pattern follows the robots, not the file
+      madvise(mem, size, MADV_RANDOM);
+      LOG_INFO("TerrainTiles: mapped \"%s\" with %dx%d samples in %dx%d tiles",
+               filename.c_str(), width, height, tilesX, tilesY);
+      return true;
+#endif
+    }
+
+    void TerrainTiles::close(void) {
+#ifndef WIN32
+      if(mem) munmap(mem, size);
+      if(fd >= 0) ::close(fd);
+#endif
+      fd = -1;
+      mem = 0;
+      data = 0;
+      size = 0;
+      tileStates.clear();
+      numLoaded = 0;
+    }
+
+    void TerrainTiles::requestRegion(int x0, int y0, int x1, int y1) {
+      if(!data) return;
+      if(x0 < 0) x0 = 0;
+      if(y0 < 0) y0 = 0;
+      if(x1 >= width) x1 = width-1;
+      if(y1 >= height) y1 = height-1;
+      if(x0 > x1 || y0 > y1) return;
+
+      for(int ty=y0/tileSize; ty<=y1/tileSize; ++ty) {
+        for(int tx=x0/tileSize; tx<=x1/tileSize; ++tx) {
+          unsigned char &state = tileStates[(size_t)ty*tilesX+tx];
+#ifndef WIN32
+          if(state == TILE_UNLOADED) {
+            madvise((void*)(data + ((size_t)ty*tilesX+tx)*tileBytes),
+                    tileBytes, MADV_WILLNEED);
+            ++numLoaded;
+          }
+#endif
+          state = TILE_REQUESTED;
+        }
+      }
+    }
+
+    void TerrainTiles::releaseTiles(void) {
+      for(size_t i=0; i<tileStates.size(); ++i) {
+        if(tileStates[i] == TILE_REQUESTED) {
+          tileStates[i] = TILE_LOADED;
+        }
+        else if(tileStates[i] == TILE_LOADED) {
+#ifndef WIN32
+          // the pages of a read only file mapping are read again on access
+          madvise((void*)(data + i*tileBytes), tileBytes, MADV_DONTNEED);
+#endif
+          tileStates[i] = TILE_UNLOADED;
+          --numLoaded;
+        }
+      }
+    }
+
+    bool TerrainTiles::write(const std::string &filename,
+                             const double *pixelData, int width, int height,
+                             int tileSize, TerrainSampleType sampleType) {
+      if(!pixelData || width <= 0 || height <= 0 || tileSize <= 0) return false;
+      FILE *file = fopen(filename.c_str(), "wb");
+      if(!file) {
+        LOG_ERROR("TerrainTiles: cannot write \"%s\": %s", filename.c_str(),
+                  strerror(errno));
+        return false;
+      }
+
+      size_t sampleBytes = (sampleType == TERRAIN_SAMPLE_UINT16 ?
+                            sizeof(uint16_t) : sizeof(float));
+      terrain_tiles_header header;
+      memset(&header, 0, sizeof(header));
+      header.magic = TERRAIN_TILES_MAGIC;
+      header.version = TERRAIN_TILES_VERSION;
+      header.width = width;
+      header.height = height;
+      header.tile_size = tileSize;
+      header.sample_type = sampleType;
+      header.tiles_x = (width + tileSize - 1) / tileSize;
+      header.tiles_y = (height + tileSize - 1) / tileSize;
+      header.tile_bytes = alignTerrainTiles((size_t)tileSize*tileSize*sampleBytes);
+
+      std::vector<char> buffer(TERRAIN_TILES_ALIGN, 0);
+      memcpy(&buffer[0], &header, sizeof(header));
+      bool ok = fwrite(&buffer[0], 1, buffer.size(), file) == buffer.size();
+
+      buffer.resize(header.tile_bytes);
+      for(uint32_t ty=0; ok && ty<header.tiles_y; ++ty) {
+        for(uint32_t tx=0; ok && tx<header.tiles_x; ++tx) {
+          std::fill(buffer.begin(), buffer.end(), 0);
+          for(int y=0; y<tileSize; ++y) {
+            int sy = std::min((int)(ty*tileSize)+y, height-1);
+            for(int x=0; x<tileSize; ++x) {
+              // the padding repeats the border samples
+              int sx = std::min((int)(tx*tileSize)+x, width-1);
+              double v = pixelData[(size_t)sy*width+sx];
+              size_t i = (size_t)y*tileSize+x;
+              if(sampleType == TERRAIN_SAMPLE_UINT16) {
+                v = v < 0.0 ? 0.0 : (v > 1.0 ? 1.0 : v);
+                ((uint16_t*)&buffer[0])[i] = (uint16_t)(v*65535.0+0.5);
+              }
+              else {
+                ((float*)&buffer[0])[i] = (float)v;
+              }
+            }
+          }
+          ok = fwrite(&buffer[0], 1, buffer.size(), file) == buffer.size();
+        }
+      }
+      if(fclose(file) != 0) ok = false;
+      if(!ok) {
+        LOG_ERROR("TerrainTiles: writing \"%s\" failed", filename.c_str());
+        remove(filename.c_str());
+      }
+      return ok;
+    }
+
+  } // end of namespace interfaces
+} // end of namespace mars
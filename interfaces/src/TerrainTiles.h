@@ -0,0 +1,156 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+ /**
+ * \file TerrainTiles.h
+ * \brief A memory mapped height map that is stored in square tiles.
+ *
+ */
+
+#ifndef MARS_INTERFACES_TERRAIN_TILES_H
+#define MARS_INTERFACES_TERRAIN_TILES_H
+
+#ifdef _PRINT_HEADER_
+  #warning "TerrainTiles.h"
+#endif
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#define TERRAIN_TILES_MAGIC 0x4d54544c // "MTTL"
+#define TERRAIN_TILES_VERSION 1
+#define TERRAIN_TILES_EXTENSION ".mtt"
+// the header and every tile start at a multiple of this size in the file
+#define TERRAIN_TILES_ALIGN 4096
+#define TERRAIN_TILES_DEFAULT_SIZE 256
+
+namespace mars {
+  namespace interfaces {
+
+    enum TerrainSampleType {
+      TERRAIN_SAMPLE_FLOAT = 0,  // the height as float
+      TERRAIN_SAMPLE_UINT16 = 1  // the height normalized to [0, 65535]
+    };
+
+    /**
+     * The header of a tiled terrain file. It is followed by tiles_y rows of
+     * tiles_x tiles, each tile holds tile_size x tile_size samples in row
+     * order. The tiles at the right and upper border are padded. The samples
+     * have the order and range of terrainStruct::pixelData, i.e. they are
+     * scaled with terrainStruct::scale.
+     */
+    struct terrain_tiles_header {
+      uint32_t magic;
+      uint32_t version;
+      uint32_t width;
+      uint32_t height;
+      uint32_t tile_size;
+      uint32_t sample_type;
+      uint32_t tiles_x;
+      uint32_t tiles_y;
+      uint64_t tile_bytes;
+    };
+
+    /**
+     * Maps a tiled terrain file read only into memory. The operating system
+     * reads a tile when it is accessed for the first time. The physics
+     * requests the tiles around the active bodies with requestRegion() and
+     * drops all others with releaseTiles(), thus only the neighbourhood of
+     * the robots stays in memory. getSample() is thread safe, the tile
+     * management is only called by the physics thread.
+     */
+    class TerrainTiles {
+    public:
+      TerrainTiles();
+      ~TerrainTiles();
+
+      bool open(const std::string &filename);
+      void close(void);
+      bool isOpen(void) const {return data != 0;}
+
+      /**
+       * Writes a height map in the layout of terrainStruct::pixelData as
+       * tiled terrain file.
+       */
+      static bool write(const std::string &filename, const double *pixelData,
+                        int width, int height,
+                        int tileSize = TERRAIN_TILES_DEFAULT_SIZE,
+                        TerrainSampleType sampleType = TERRAIN_SAMPLE_FLOAT);
+      static bool isTileFile(const std::string &filename);
+
+      int getWidth(void) const {return width;}
+      int getHeight(void) const {return height;}
+      int getTileSize(void) const {return tileSize;}
+      size_t getNumLoadedTiles(void) const {return numLoaded;}
+
+      /**
+       * Returns the sample at the given position, the position is clamped
+       * to the map.
+       */
+      double getSample(int x, int y) const {
+        if(x < 0) x = 0;
+        else if(x >= width) x = width-1;
+        if(y < 0) y = 0;
+        else if(y >= height) y = height-1;
+        const char *tile = data + ((size_t)(y / tileSize) * tilesX +
+                                   x / tileSize) * tileBytes;
+        size_t i = (size_t)(y % tileSize) * tileSize + x % tileSize;
+        if(sampleType == TERRAIN_SAMPLE_UINT16) {
+          return ((const uint16_t*)tile)[i] / 65535.0;
+        }
+        return ((const float*)tile)[i];
+      }
+
+      /**
+       * Marks the tiles covering the samples [x0, x1] x [y0, y1] as used in
+       * the current update and asks the system to read the ones that are
+       * not loaded yet.
+       */
+      void requestRegion(int x0, int y0, int x1, int y1);
+      /**
+       * Frees the memory of all loaded tiles that were not requested since
+       * the last call and starts the next update.
+       */
+      void releaseTiles(void);
+
+    private:
+      enum TileState {TILE_UNLOADED, TILE_LOADED, TILE_REQUESTED};
+
+      int fd;
+      size_t size;
+      char *mem;
+      const char *data;
+      int width, height, tileSize, tilesX, tilesY;
+      int sampleType;
+      size_t tileBytes;
+      std::vector<unsigned char> tileStates;
+      size_t numLoaded;
+
+      // the mapping is shared by copying the pointer to the object
+      TerrainTiles(const TerrainTiles &other);
+      TerrainTiles& operator=(const TerrainTiles &other);
+    };
+
+  } // end of namespace interfaces
+} // end of namespace mars
+
+#endif // MARS_INTERFACES_TERRAIN_TILES_H
@@ -0,0 +1,126 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+ /**
+ * \file PoseChannel.h
+ * \brief Passes the poses of the draw objects from the simulation to the
+ *        graphics without a lock.
+ *
+ */
+
+#ifndef MARS_INTERFACES_POSE_CHANNEL_H
+#define MARS_INTERFACES_POSE_CHANNEL_H
+
+#ifdef _PRINT_HEADER_
+  #warning "PoseChannel.h"
+#endif
+
+#include <mars/utils/Vector.h>
+#include <mars/utils/Quaternion.h>
+
+#include <atomic>
+#include <vector>
+
+// set in the index of the middle buffer if it holds an unread frame
+#define POSE_CHANNEL_NEW_FRAME 4
+
+namespace mars {
+  namespace interfaces {
+
+    /**
+     * The poses of the draw objects after one simulation step. Entry i of
+     * the arrays belongs to draw object ids[i]. Frames with the same layout
+     * number have the same ids in the same order.
+     */
+    struct pose_frame {
+      std::vector<unsigned long> ids;
+      std::vector<utils::Vector> pos;
+      std::vector<utils::Quaternion> rot;
+      unsigned long layout;
+      // the wall clock time in ms the frame was published at
+      long long time;
+
+      pose_frame() : layout(0), time(0) {}
+
+      void resize(size_t n) {
+        ids.resize(n);
+        pos.resize(n);
+        rot.resize(n);
+      }
+
+      size_t size() const {
+        return ids.size();
+      }
+    }; // end of struct pose_frame
+
+    /**
+     * A triple buffer with one writer and one reader. The writer fills the
+     * frame returned by getWriteFrame() and swaps it with the middle buffer
+     * in publish(). The reader swaps its buffer with the middle buffer in
+     * update() if a new frame was published. Neither side ever waits for
+     * the other and both keep their buffer until the next swap, so the
+     * arrays keep their capacity.
+     */
+    class PoseChannel {
+    public:
+      PoseChannel() : writeIndex(0), middleIndex(1), readIndex(2) {}
+
+      pose_frame* getWriteFrame() {
+        return &frames[writeIndex];
+      }
+
+      void publish() {
+        writeIndex = middleIndex.exchange(writeIndex | POSE_CHANNEL_NEW_FRAME,
+                                          std::memory_order_acq_rel);
+        writeIndex &= ~POSE_CHANNEL_NEW_FRAME;
+      }
+
+      /**
+       * Makes the newest published frame the read frame.
+       * Returns false if no frame was published since the last call.
+       */
+      bool update() {
+        if(!(middleIndex.load(std::memory_order_relaxed) &
+             POSE_CHANNEL_NEW_FRAME)) {
+          return false;
+        }
+        readIndex = middleIndex.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex &= ~POSE_CHANNEL_NEW_FRAME;
+        return true;
+      }
+
+      const pose_frame& getReadFrame() const {
+        return frames[readIndex];
+      }
+
+    private:
+      pose_frame frames[3];
+      int writeIndex;
+      std::atomic<int> middleIndex;
+      int readIndex;
+
+      PoseChannel(const PoseChannel &other);
+      PoseChannel& operator=(const PoseChannel &other);
+    }; // end of class PoseChannel
+
+  } // end of namespace interfaces
+} // end of namespace mars
+
+#endif // MARS_INTERFACES_POSE_CHANNEL_H
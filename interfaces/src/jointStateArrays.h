@@ -0,0 +1,100 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MARS_INTERFACES_JOINT_STATE_ARRAYS_H
+#define MARS_INTERFACES_JOINT_STATE_ARRAYS_H
+
+#include "MARSDefs.h"
+#include <mars/utils/Vector.h>
+
+#include <vector>
+
+namespace mars {
+
+  namespace interfaces {
+
+    class JointInterface;
+
+    /**
+     * \brief The state of a set of joints in packed arrays.
+     *
+     * Entry i of every array belongs to joints[i]. The arrays are filled by
+     * PhysicsInterface::getJointStates() in one pass after a simulation step.
+     * The forces and torques of the joint feedback and the axis torques and
+     * joint load derived from them are only read for joints with feedback[i]
+     * set, for all other joints these entries keep their old values.
+     */
+    struct jointStateArrays {
+      std::vector<JointInterface*> joints;
+      // a char instead of a bool to be able to address single entries
+      std::vector<char> feedback;
+      std::vector<sReal> position1;
+      std::vector<sReal> position2;
+      std::vector<sReal> velocity1;
+      std::vector<sReal> velocity2;
+      std::vector<sReal> motor_torque;
+      std::vector<utils::Vector> anchor;
+      std::vector<utils::Vector> axis1;
+      std::vector<utils::Vector> axis2;
+      // only valid if feedback is set
+      std::vector<utils::Vector> f1;
+      std::vector<utils::Vector> f2;
+      std::vector<utils::Vector> t1;
+      std::vector<utils::Vector> t2;
+      std::vector<utils::Vector> axis1_torque;
+      std::vector<utils::Vector> axis2_torque;
+      std::vector<utils::Vector> joint_load;
+
+      size_t size() const {
+        return joints.size();
+      }
+
+      // resizes the state arrays to the size of the joint array
+      void resize() {
+        size_t n = joints.size();
+        feedback.resize(n, 0);
+        position1.resize(n);
+        position2.resize(n);
+        velocity1.resize(n);
+        velocity2.resize(n);
+        motor_torque.resize(n);
+        anchor.resize(n);
+        axis1.resize(n);
+        axis2.resize(n);
+        f1.resize(n, utils::Vector(0, 0, 0));
+        f2.resize(n, utils::Vector(0, 0, 0));
+        t1.resize(n, utils::Vector(0, 0, 0));
+        t2.resize(n, utils::Vector(0, 0, 0));
+        axis1_torque.resize(n, utils::Vector(0, 0, 0));
+        axis2_torque.resize(n, utils::Vector(0, 0, 0));
+        joint_load.resize(n, utils::Vector(0, 0, 0));
+      }
+
+      void clear() {
+        joints.clear();
+        resize();
+      }
+    }; // end of struct jointStateArrays
+
+  } // end of namespace interfaces
+
+} // end of namespace mars
+
+#endif /* MARS_INTERFACES_JOINT_STATE_ARRAYS_H */
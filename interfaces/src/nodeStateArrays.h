@@ -0,0 +1,83 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MARS_INTERFACES_NODE_STATE_ARRAYS_H
+#define MARS_INTERFACES_NODE_STATE_ARRAYS_H
+
+#include "MARSDefs.h"
+#include <mars/utils/Vector.h>
+#include <mars/utils/Quaternion.h>
+
+#include <vector>
+
+namespace mars {
+
+  namespace interfaces {
+
+    class NodeInterface;
+
+    /**
+     * \brief The physical state of a set of nodes in packed arrays.
+     *
+     * Entry i of every array belongs to nodes[i]. The arrays are filled by
+     * PhysicsInterface::getNodeStates() in one pass after a simulation step,
+     * thus reading the state of many nodes does not need a lock per value.
+     * The arrays keep their capacity to avoid allocations in every step.
+     */
+    struct nodeStateArrays {
+      std::vector<NodeInterface*> nodes;
+      std::vector<utils::Vector> pos;
+      std::vector<utils::Quaternion> rot;
+      std::vector<utils::Vector> l_vel;
+      std::vector<utils::Vector> a_vel;
+      std::vector<utils::Vector> f;
+      std::vector<utils::Vector> t;
+      // a char instead of a bool to be able to address single entries
+      std::vector<char> ground_contact;
+      std::vector<sReal> ground_contact_force;
+
+      size_t size() const {
+        return nodes.size();
+      }
+
+      // resizes the state arrays to the size of the node array
+      void resize() {
+        size_t n = nodes.size();
+        pos.resize(n);
+        rot.resize(n);
+        l_vel.resize(n);
+        a_vel.resize(n);
+        f.resize(n);
+        t.resize(n);
+        ground_contact.resize(n);
+        ground_contact_force.resize(n);
+      }
+
+      void clear() {
+        nodes.clear();
+        resize();
+      }
+    }; // end of struct nodeStateArrays
+
+  } // end of namespace interfaces
+
+} // end of namespace mars
+
+#endif /* MARS_INTERFACES_NODE_STATE_ARRAYS_H */
@@ -104,6 +104,34 @@ namespace mars {
         return configmaps::ConfigMap();
       }
 
+      /**
+       * Sensors that depend on previous steps, e.g. accumulated scans,
+       * store and restore this state here. Used for snapshots of the
+       * simulation.
+       */
+      virtual void saveState(std::vector<double> *state) const {
+      }
+
+      virtual void restoreState(const std::vector<double> &state) {
+      }
+
+      /**
+       * Sensors with an expensive update only copy their input in
+       * receiveData, which is still called by the DataBroker timer with the
+       * updateRate of the sensor, and return true here until the update is
+       * done. The SensorManager then calls updateSensor() after the step,
+       * concurrently with the updates of the other sensors. updateSensor()
+       * may only read the simulation and write the sensor itself. Producers
+       * of the results register on "mars_sim/sensorTimer", which is stepped
+       * after the updates, to publish the data of the current step.
+       */
+      virtual bool isUpdatePending() const {
+        return false;
+      }
+
+      virtual void updateSensor(void) {
+      }
+
       //Should be proteted due to compability of old code currently direct accessable
       unsigned long id;
       std::string name; //Todo naming bei mehreren robotern
@@ -0,0 +1,178 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+ /**
+ * \file ControllerSharedMemory.h
+ * \brief The layout of the shared memory segment that is used to exchange
+ *        sensor and motor values with a controller on the same machine.
+ *
+ */
+
+#ifndef MARS_INTERFACES_CONTROLLER_SHARED_MEMORY_H
+#define MARS_INTERFACES_CONTROLLER_SHARED_MEMORY_H
+
+#ifdef _PRINT_HEADER_
+  #warning "ControllerSharedMemory.h"
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+#define CONTROLLER_SHM_MAGIC 0x4d415253 // "MARS"
+#define CONTROLLER_SHM_VERSION 1
+#define CONTROLLER_SHM_ALIGN 64
+
+// flags of a command
+#define CONTROLLER_SHM_RESET 1
+
+namespace mars {
+  namespace interfaces {
+
+    /**
+     * The segment is created by the simulation with shm_open under the name
+     * given as "shm_name" in the controller config and consists of:
+     *   - the header
+     *   - the command mailbox with num_motors doubles
+     *   - the sensor ring with num_frames frames of num_sensors doubles
+     * each part starts at a multiple of CONTROLLER_SHM_ALIGN bytes.
+     *
+     * The sensor ring is a single producer single consumer queue: the
+     * simulation writes frame_head, the client writes frame_tail. If the
+     * ring is full the simulation drops the new frame and increments
+     * dropped_frames instead of waiting.
+     *
+     * The command mailbox only holds the newest command. It is written by
+     * the client under a sequence lock: command_lock is odd while the
+     * command is written. Afterwards the client increments command_seq.
+     *
+     * frame_seq and command_seq are futex words. A side that wants to sleep
+     * sets its waiters word and waits on the sequence, the other side only
+     * makes the wake syscall if the waiters word is set.
+     *
+     * In lock step mode the simulation waits after every frame until the
+     * client answered it with a command whose step is the step of the frame.
+     * The simulation only waits while client_attached is set. The client
+     * sets it after mapping the segment and clears it before unmapping.
+     */
+    struct controller_shm_header {
+      uint32_t magic;
+      uint32_t version;
+      uint32_t num_sensors;
+      uint32_t num_motors;
+      uint32_t num_frames;
+      uint32_t lock_step;
+      std::atomic<uint32_t> client_attached;
+      std::atomic<uint32_t> frame_head;
+      std::atomic<uint32_t> frame_tail;
+      std::atomic<uint32_t> dropped_frames;
+      std::atomic<uint32_t> frame_seq;
+      std::atomic<uint32_t> frame_waiters;
+      std::atomic<uint32_t> command_seq;
+      std::atomic<uint32_t> command_waiters;
+      std::atomic<uint32_t> command_lock;
+      uint32_t command_flags;
+      uint64_t command_step;
+    };
+
+    /**
+     * A sensor frame, followed by num_sensors doubles.
+     */
+    struct controller_shm_frame {
+      uint64_t step;
+      double time_ms;
+    };
+
+    inline size_t controllerShmAlign(size_t size) {
+      return (size + CONTROLLER_SHM_ALIGN - 1) & ~(size_t)(CONTROLLER_SHM_ALIGN - 1);
+    }
+
+    inline size_t controllerShmFrameSize(uint32_t num_sensors) {
+      return controllerShmAlign(sizeof(controller_shm_frame) +
+                                num_sensors*sizeof(double));
+    }
+
+    inline size_t controllerShmSize(uint32_t num_sensors, uint32_t num_motors,
+                                    uint32_t num_frames) {
+      return (controllerShmAlign(sizeof(controller_shm_header)) +
+              controllerShmAlign(num_motors*sizeof(double)) +
+              num_frames*controllerShmFrameSize(num_sensors));
+    }
+
+    inline double* controllerShmCommand(controller_shm_header *header) {
+      return (double*)((char*)header +
+                       controllerShmAlign(sizeof(controller_shm_header)));
+    }
+
+    inline controller_shm_frame* controllerShmFrame(controller_shm_header *header,
+                                                    uint32_t index) {
+      char *ring = ((char*)controllerShmCommand(header) +
+                    controllerShmAlign(header->num_motors*sizeof(double)));
+      return (controller_shm_frame*)(ring + (index % header->num_frames) *
+                                     controllerShmFrameSize(header->num_sensors));
+    }
+
+    inline double* controllerShmValues(controller_shm_frame *frame) {
+      return (double*)(frame+1);
+    }
+
+    /**
+     * Sleeps while the word has the expected value, at most timeout_us
+     * microseconds. Returns early on a wake or a spurious wake up.
+     */
+    inline void controllerShmWait(std::atomic<uint32_t> *word, uint32_t expected,
+                                  long timeout_us) {
+#ifdef __linux__
+      struct timespec timeout;
+      timeout.tv_sec = timeout_us / 1000000;
+      timeout.tv_nsec = (timeout_us % 1000000) * 1000;
+      syscall(SYS_futex, (uint32_t*)word, FUTEX_WAIT, expected, &timeout,
+              NULL, 0);
+#else
+      // without futexes we poll the word
+      if(word->load(std::memory_order_acquire) == expected) {
+        std::this_thread::sleep_for(std::chrono::microseconds(timeout_us < 50 ? timeout_us : 50));
+      }
+#endif
+    }
+
+    inline void controllerShmWake(std::atomic<uint32_t> *word) {
+#ifdef __linux__
+      syscall(SYS_futex, (uint32_t*)word, FUTEX_WAKE, 0x7fffffff, NULL,
+              NULL, 0);
+#else
+      (void)word;
+#endif
+    }
+
+  } // end of namespace interfaces
+} // end of namespace mars
+
+#endif // MARS_INTERFACES_CONTROLLER_SHARED_MEMORY_H
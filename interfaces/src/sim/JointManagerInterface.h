@@ -222,6 +222,14 @@ namespace mars {
                                 interfaces::sReal highStop2) = 0;
       virtual void edit(interfaces::JointId id, const std::string &key,
                         const std::string &value) = 0;
+
+      /**
+       * \brief Stores, restores and removes the state of all joints with
+       * the given snapshot id. \sa SimulatorInterface::saveState()
+       */
+      virtual void saveState(unsigned long snapshotId) = 0;
+      virtual bool restoreState(unsigned long snapshotId) = 0;
+      virtual void removeState(unsigned long snapshotId) = 0;
     };
 
   } // end of namespace interfaces
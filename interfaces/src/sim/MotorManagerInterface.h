@@ -325,6 +325,15 @@ namespace mars {
       virtual void setOfflinePosition(MotorId id, sReal pos) = 0;
       virtual void edit(MotorId id, const std::string &key,
                         const std::string &value) = 0;
+
+      /**
+       * \brief Stores, restores and removes the state of all motors and of
+       * their controllers with the given snapshot id.
+       * \sa SimulatorInterface::saveState()
+       */
+      virtual void saveState(unsigned long snapshotId) = 0;
+      virtual bool restoreState(unsigned long snapshotId) = 0;
+      virtual void removeState(unsigned long snapshotId) = 0;
     }; // class MotorManagerInterface
 
   } // end of namespace interfaces
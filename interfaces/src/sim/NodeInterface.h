@@ -41,6 +41,17 @@
 namespace mars {
   namespace interfaces {
 
+    /**
+     * The complete state of a rigid body including the forces that are
+     * applied in the next step. Used to restore a simulation in place.
+     */
+    struct bodyState {
+      utils::Vector pos;
+      utils::Quaternion rot;
+      utils::Vector l_vel, a_vel;
+      utils::Vector f, t;
+    };
+
     /**
      * Interface class for the physical layer.
      *
@@ -82,6 +93,12 @@ namespace mars {
       virtual const utils::Vector getContactForce(void) const = 0;
       virtual sReal getCollisionDepth(void) const = 0;
       virtual void addContact(utils::Vector &point, utils::Vector &normal, sReal depth, contact_params &c_params_other) = 0;
+      /** Reads the state of the body of the node, returns false if the
+       *  node has no body */
+      virtual bool getBodyState(bodyState *state) const = 0;
+      /** Sets the state of the body directly, the geometries follow the
+       *  body and nothing is recreated */
+      virtual void setBodyState(const bodyState &state) = 0;
     };
 
   } // end of namespace interfaces
@@ -826,6 +826,18 @@ namespace mars {
 
       virtual void addContact(NodeId id, utils::Vector &point, utils::Vector &normal,
                               sReal depth, contact_params &c_params_other) = 0;
+
+      /**
+       * \brief Stores the state of all nodes and of their bodies under the
+       * given snapshot id. Used by SimulatorInterface::saveState().
+       */
+      virtual void saveState(unsigned long snapshotId) = 0;
+      /**
+       * \brief Sets the nodes of the snapshot back to the stored state
+       * without recreating them.
+       */
+      virtual bool restoreState(unsigned long snapshotId) = 0;
+      virtual void removeState(unsigned long snapshotId) = 0;
 };
 
   } // end of namespace interfaces
@@ -32,11 +32,14 @@
 #endif
 
 #include "../MARSDefs.h"
+#include "../nodeStateArrays.h"
+#include "../jointStateArrays.h"
 #include "PluginInterface.h"
 
 #include <mars/utils/Vector.h>
 
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace mars {
@@ -58,8 +61,21 @@ namespace mars {
       sReal step_size; /**< Step size in seconds */
       utils::Vector world_gravity;
       bool fast_step;
+      /** Seed of the random numbers of the physics, e.g. the constraint
+       *  reordering of the fast step. Applied when the world is created. */
+      unsigned long random_seed;
       bool draw_contact_points;
       sReal world_cfm, world_erp;
+      int ray_cast_threads; /**< Worker threads used for batched ray casts */
+      int step_threads; /**< Worker threads used to step independent islands */
+      /** Broadphase of the dynamic and of the static collision space:
+       *  "hash", "sap", "quadtree" or "simple" */
+      std::string broadphase, static_broadphase;
+      int hash_min_level, hash_max_level; /**< Cell sizes 2^level of hash spaces */
+      int quadtree_depth;
+      /** Durations of the collision detection and of the solver of the last
+       *  step in seconds, used to profile the simulation step */
+      double collision_time, solver_time;
 
       virtual ~PhysicsInterface() {}
       virtual void setPhysicsPlugins(std::vector<mars::interfaces::pluginStruct> physicsPlugins) = 0;
@@ -74,6 +90,24 @@ namespace mars {
                                       const double r,
                                       std::vector<utils::Vector> &contacts,
                                       std::vector<double> &depths) const = 0;
+      /** Batch variants of getVectorCollision and getSphereCollision. The
+       *  whole batch is queried under one lock of the physics and with one
+       *  pass over the collision spaces. Query i uses pos[i] and rays[i]
+       *  or radii[i], the results are written to the i-th element. */
+      virtual void getVectorCollisions(const std::vector<utils::Vector> &pos,
+                                       const std::vector<utils::Vector> &rays,
+                                       std::vector<sReal> *depths) const = 0;
+      virtual void getSphereCollisions(const std::vector<utils::Vector> &pos,
+                                       const std::vector<double> &radii,
+                                       std::vector<std::vector<utils::Vector> > *contacts,
+                                       std::vector<std::vector<double> > *depths) const = 0;
+      /** Copies the state of all states->nodes into the state arrays. The
+       *  whole batch is read under one lock of the physics. */
+      virtual void getNodeStates(nodeStateArrays *states) const = 0;
+      /** Copies the state of all states->joints into the state arrays
+       *  under one lock of the physics. The feedback of a joint is only
+       *  evaluated if states->feedback is set for it. */
+      virtual void getJointStates(jointStateArrays *states) const = 0;
 
     };
 
@@ -70,6 +70,8 @@ namespace mars {
       pDestroyPlugin *p_destroy;
       double timer, timer_gui;
       int t_count, t_count_gui;
+      // the phase of the plugin in the step profiler, -1 until resolved
+      int profile_phase;
     };
 
     void destroy_plugin(PluginInterface *sp);
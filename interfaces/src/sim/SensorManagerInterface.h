@@ -189,6 +189,27 @@ namespace mars {
        */
       virtual void reloadSensors(void) = 0;
 
+      /**
+       * \brief Stores, restores and removes the state of all sensors with
+       * the given snapshot id. \sa BaseSensor::saveState()
+       */
+      virtual void saveState(unsigned long snapshotId) = 0;
+      virtual bool restoreState(unsigned long snapshotId) = 0;
+      virtual void removeState(unsigned long snapshotId) = 0;
+
+      /**
+       * \brief Runs the pending updates of the sensors, see
+       * BaseSensor::isUpdatePending(). Called by the simulation thread after
+       * every step with the step size in ms.
+       */
+      virtual void updateSensors(sReal calc_ms) = 0;
+
+      /**
+       * \brief Sets the number of additional threads used by updateSensors().
+       * With zero threads the updates run in the simulation thread.
+       */
+      virtual void setSensorThreads(int numThreads) = 0;
+
       /**
        * Adds an sensor to the known sensors list
        */
@@ -64,6 +64,19 @@ namespace mars {
       virtual bool startStopTrigger() = 0;
       virtual void singleStep(void) = 0;
       virtual void newWorld(bool clear_all=false) = 0;
+      /**
+       * Saves the dynamic state of the simulation: the body states, the
+       * joint, motor and sensor states and the simulation time. Returns the
+       * id of the snapshot.
+       */
+      virtual unsigned long saveState(void) = 0;
+      /**
+       * Restores a snapshot in place without recreating any object of the
+       * scene. Objects that were added after the snapshot keep their state.
+       * Returns false if the snapshot does not exist.
+       */
+      virtual bool restoreState(unsigned long id) = 0;
+      virtual void removeState(unsigned long id) = 0;
       virtual void exitMars(void) = 0;
       virtual void readArguments(int argc, char **argv) = 0;
       virtual ControlCenter* getControlCenter(void) const = 0;      
@@ -22,6 +22,8 @@
 #define MARS_CORE_TERRAIN_STRUCT_H
 
 #include "MaterialData.h"
+#include "TerrainTiles.h"
+#include <memory>
 #include <string>
 
 namespace mars {
@@ -51,8 +53,14 @@ namespace mars {
       double scale;
       double texScaleX, texScaleY; // texture scaling - a value of 0 will fit the complete terrain
       double *pixelData;
+      // a tiled terrain is shared by all copies instead of pixelData
+      std::shared_ptr<TerrainTiles> tiles;
       int mesh;
 
+      double getPixel(int x, int y) const {
+        return tiles ? tiles->getSample(x, y) : pixelData[y*width+x];
+      }
+
     }; // end of struct terrainStruct
 
   } // end of namespace interfaces
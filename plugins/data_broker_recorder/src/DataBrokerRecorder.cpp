@@ -0,0 +1,382 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file DataBrokerRecorder.cpp
+ * \brief Records DataBroker streams to a binary file and replays them.
+ *
+ * Version 0.1
+ */
+
+
+#include "DataBrokerRecorder.h"
+#include <mars/data_broker/DataBrokerInterface.h>
+#include <mars/data_broker/DataPackage.h>
+#include <mars/utils/MutexLocker.h>
+#include <mars/interfaces/Logging.hpp>
+
+// the callback parameters of the registrations
+#define RECORD_DATA 0
+#define RECORD_TIMER 1
+
+namespace mars {
+  namespace plugins {
+    namespace data_broker_recorder {
+
+      using namespace mars::utils;
+      using namespace mars::interfaces;
+      using namespace mars::data_broker;
+
+      // appends an empty record header that is filled by finishRecord
+      static void startRecord(std::vector<char> *record) {
+        record_header header;
+        memset(&header, 0, sizeof(header));
+        record->clear();
+        appendBytes(record, &header, sizeof(header));
+      }
+
+      static void finishRecord(std::vector<char> *record, RecordType type,
+                               uint32_t stream) {
+        record_header header;
+        header.type = type;
+        header.stream = stream;
+        header.size = record->size() - sizeof(header);
+        memcpy(&(*record)[0], &header, sizeof(header));
+      }
+
+      DataBrokerRecorder::DataBrokerRecorder(lib_manager::LibManager *theManager)
+        : MarsPluginTemplate(theManager, "DataBrokerRecorder"),
+          replayer(NULL), recording(false), rowsPerBlock(1), time(0),
+          numRows(0) {
+      }
+
+      void DataBrokerRecorder::init() {
+        patterns = control->cfg->getOrCreateProperty("DataBrokerRecorder",
+                                                     "patterns",
+                                                     std::string("mars_sim/*"),
+                                                     this);
+        file = control->cfg->getOrCreateProperty("DataBrokerRecorder", "file",
+                                                 std::string("recording.mdbr"),
+                                                 this);
+        record = control->cfg->getOrCreateProperty("DataBrokerRecorder",
+                                                   "record", false, this);
+        replay = control->cfg->getOrCreateProperty("DataBrokerRecorder",
+                                                   "replay", false, this);
+        replaySpeed = control->cfg->getOrCreateProperty("DataBrokerRecorder",
+                                                        "replay_speed", 1.0,
+                                                        this);
+        timer = control->cfg->getOrCreateProperty("DataBrokerRecorder", "timer",
+                                                  std::string("mars_sim/simTimer"),
+                                                  this);
+        blockRows = control->cfg->getOrCreateProperty("DataBrokerRecorder",
+                                                      "block_rows", 256, this);
+        bufferSize = control->cfg->getOrCreateProperty("DataBrokerRecorder",
+                                                       "buffer_size", 4096,
+                                                       this);
+        queueSize = control->cfg->getOrCreateProperty("DataBrokerRecorder",
+                                                      "queue_size", 65536,
+                                                      this);
+        replayer = new RecordReplayer(control->dataBroker);
+
+        if(record.bValue) {
+          startRecording();
+        }
+        else if(replay.bValue) {
+          startReplay();
+        }
+      }
+
+      void DataBrokerRecorder::reset() {
+      }
+
+      DataBrokerRecorder::~DataBrokerRecorder() {
+        stopReplay();
+        stopRecording();
+        delete replayer;
+      }
+
+      void DataBrokerRecorder::update(sReal time_ms) {
+      }
+
+      /**
+       * \brief Registers for the streams and the timer and opens the file.
+       *
+       * post:
+       *     - a running replay is stopped
+       *     - streams that are created later and match a pattern are
+       *       recorded as well
+       */
+      bool DataBrokerRecorder::startRecording(void) {
+        stopReplay();
+        stopRecording();
+        if(!control->dataBroker) return false;
+
+        size_t size = bufferSize.iValue > 0 ? (size_t)bufferSize.iValue*1024 : 0;
+        size_t maxQueued = queueSize.iValue > 0 ? (size_t)queueSize.iValue*1024 : 0;
+        if(!writer.open(file.sValue, size, maxQueued)) {
+          return false;
+        }
+        mutex.lock();
+        recording = true;
+        rowsPerBlock = blockRows.iValue > 0 ? blockRows.iValue : 1;
+        time = 0;
+        numRows = 0;
+        mutex.unlock();
+
+        registrations.clear();
+        const std::string &s = patterns.sValue;
+        size_t start = 0;
+        while(start < s.size()) {
+          size_t end = s.find(';', start);
+          if(end == std::string::npos) end = s.size();
+          std::string pattern = s.substr(start, end-start);
+          start = end + 1;
+          size_t first = pattern.find_first_not_of(" \t");
+          if(first == std::string::npos) continue;
+          pattern = pattern.substr(first, pattern.find_last_not_of(" \t")-first+1);
+          size_t slash = pattern.find('/');
+          if(slash == std::string::npos) {
+            registrations.push_back(std::make_pair(pattern, std::string("*")));
+          }
+          else {
+            registrations.push_back(std::make_pair(pattern.substr(0, slash),
+                                                   pattern.substr(slash+1)));
+          }
+        }
+        for(size_t i=0; i<registrations.size(); ++i) {
+          control->dataBroker->registerSyncReceiver(this, registrations[i].first,
+                                                    registrations[i].second,
+                                                    RECORD_DATA);
+        }
+        timerDataName = "timers/" + timer.sValue;
+        control->dataBroker->registerSyncReceiver(this, "data_broker",
+                                                  timerDataName, RECORD_TIMER);
+        LOG_INFO("DataBrokerRecorder: recording to \"%s\"", file.sValue.c_str());
+        return true;
+      }
+
+      void DataBrokerRecorder::stopRecording(void) {
+        if(!writer.isOpen()) return;
+        for(size_t i=0; i<registrations.size(); ++i) {
+          control->dataBroker->unregisterSyncReceiver(this,
+                                                      registrations[i].first,
+                                                      registrations[i].second);
+        }
+        control->dataBroker->unregisterSyncReceiver(this, "data_broker",
+                                                    timerDataName);
+        registrations.clear();
+
+        mutex.lock();
+        recording = false;
+        std::map<unsigned long, RecordStream*>::iterator it;
+        for(it=streams.begin(); it!=streams.end(); ++it) {
+          writeBlock(it->second);
+          delete it->second;
+        }
+        streams.clear();
+        mutex.unlock();
+
+        writer.close();
+        LOG_INFO("DataBrokerRecorder: recorded %lu packages with %llu bytes",
+                 numRows, writer.getBytesWritten());
+      }
+
+      bool DataBrokerRecorder::startReplay(void) {
+        stopRecording();
+        if(!replayer) return false;
+        return replayer->replay(file.sValue, replaySpeed.dValue);
+      }
+
+      void DataBrokerRecorder::stopReplay(void) {
+        if(replayer) replayer->stop();
+      }
+
+      void DataBrokerRecorder::receiveData(const data_broker::DataInfo& info,
+                                           const data_broker::DataPackage& package,
+                                           int callbackParam) {
+        if(callbackParam == RECORD_TIMER) {
+          long t;
+          if(package.get(0, &t)) {
+            MutexLocker locker(&mutex);
+            time = t;
+          }
+          return;
+        }
+
+        MutexLocker locker(&mutex);
+        if(!recording) return;
+        RecordStream *stream;
+        bool layoutChanged = false;
+        std::map<unsigned long, RecordStream*>::iterator it;
+        it = streams.find(info.dataId);
+        if(it == streams.end()) {
+          stream = new RecordStream;
+          stream->index = streams.size();
+          streams[info.dataId] = stream;
+          layoutChanged = true;
+        }
+        else {
+          stream = it->second;
+          layoutChanged = package.size() != stream->types.size();
+          for(size_t i=0; !layoutChanged && i<package.size(); ++i) {
+            layoutChanged = (package[i].type != stream->types[i] ||
+                             package[i].getName() != stream->names[i]);
+          }
+        }
+        if(layoutChanged) {
+          // the rows of the old layout are written first
+          writeBlock(stream);
+          stream->types.resize(package.size());
+          stream->names.resize(package.size());
+          for(size_t i=0; i<package.size(); ++i) {
+            stream->types[i] = package[i].type;
+            stream->names[i] = package[i].getName();
+          }
+          stream->columns.resize(package.size());
+          writeSchema(*stream, info, package);
+        }
+        appendRow(stream, package);
+        ++numRows;
+        if(stream->times.size() >= rowsPerBlock) {
+          writeBlock(stream);
+        }
+      }
+
+      void DataBrokerRecorder::writeSchema(const RecordStream &stream,
+                                           const data_broker::DataInfo &info,
+                                           const data_broker::DataPackage &package) {
+        uint32_t flags = info.flags;
+        uint32_t numItems = package.size();
+        startRecord(&recordBuffer);
+        appendBytes(&recordBuffer, &flags, sizeof(flags));
+        appendBytes(&recordBuffer, &numItems, sizeof(numItems));
+        appendString(&recordBuffer, info.groupName);
+        appendString(&recordBuffer, info.dataName);
+        for(size_t i=0; i<package.size(); ++i) {
+          uint8_t type = package[i].type;
+          appendBytes(&recordBuffer, &type, sizeof(type));
+          appendString(&recordBuffer, package[i].getName());
+        }
+        finishRecord(&recordBuffer, RECORD_STREAM, stream.index);
+        writer.queue(&recordBuffer);
+      }
+
+      void DataBrokerRecorder::writeBlock(RecordStream *stream) {
+        if(stream->times.empty()) return;
+        uint32_t rows = stream->times.size();
+        startRecord(&recordBuffer);
+        appendBytes(&recordBuffer, &rows, sizeof(rows));
+        appendBytes(&recordBuffer, &stream->times[0], rows*sizeof(int64_t));
+        for(size_t i=0; i<stream->columns.size(); ++i) {
+          std::vector<char> &column = stream->columns[i];
+          uint64_t size = column.size();
+          appendBytes(&recordBuffer, &size, sizeof(size));
+          if(size) appendBytes(&recordBuffer, &column[0], size);
+          // the column keeps its capacity for the next block
+          column.clear();
+        }
+        stream->times.clear();
+        finishRecord(&recordBuffer, RECORD_BLOCK, stream->index);
+        writer.queue(&recordBuffer);
+      }
+
+      void DataBrokerRecorder::appendRow(RecordStream *stream,
+                                         const data_broker::DataPackage &package) {
+        uint8_t b;
+        int64_t i64;
+        stream->times.push_back(time);
+        for(size_t i=0; i<package.size(); ++i) {
+          const DataItem &item = package[i];
+          std::vector<char> *column = &stream->columns[i];
+          switch(item.type) {
+          case BOOL_TYPE:
+            b = item.b;
+            appendBytes(column, &b, sizeof(b));
+            break;
+          case INT_TYPE:
+            appendBytes(column, &item.i, sizeof(int32_t));
+            break;
+          case UINT_TYPE:
+            appendBytes(column, &item.ui, sizeof(int32_t));
+            break;
+          case LONG_TYPE:
+            i64 = item.l;
+            appendBytes(column, &i64, sizeof(i64));
+            break;
+          case ULONG_TYPE:
+            i64 = (int64_t)item.ul;
+            appendBytes(column, &i64, sizeof(i64));
+            break;
+          case FLOAT_TYPE:
+            appendBytes(column, &item.f, sizeof(float));
+            break;
+          case DOUBLE_TYPE:
+            appendBytes(column, &item.d, sizeof(double));
+            break;
+          case STRING_TYPE:
+            appendString(column, item.s);
+            break;
+          default:
+            break;
+          }
+        }
+      }
+
+      void DataBrokerRecorder::cfgUpdateProperty(cfg_manager::cfgPropertyStruct _property) {
+
+        if(_property.paramId == record.paramId) {
+          record.bValue = _property.bValue;
+          if(record.bValue) startRecording();
+          else stopRecording();
+        }
+        else if(_property.paramId == replay.paramId) {
+          replay.bValue = _property.bValue;
+          if(replay.bValue) startReplay();
+          else stopReplay();
+        }
+        else if(_property.paramId == patterns.paramId) {
+          patterns.sValue = _property.sValue;
+        }
+        else if(_property.paramId == file.paramId) {
+          file.sValue = _property.sValue;
+        }
+        else if(_property.paramId == replaySpeed.paramId) {
+          replaySpeed.dValue = _property.dValue;
+        }
+        else if(_property.paramId == timer.paramId) {
+          timer.sValue = _property.sValue;
+        }
+        else if(_property.paramId == blockRows.paramId) {
+          blockRows.iValue = _property.iValue;
+        }
+        else if(_property.paramId == bufferSize.paramId) {
+          bufferSize.iValue = _property.iValue;
+        }
+        else if(_property.paramId == queueSize.paramId) {
+          queueSize.iValue = _property.iValue;
+        }
+      }
+
+    } // end of namespace data_broker_recorder
+  } // end of namespace plugins
+} // end of namespace mars
+
+DESTROY_LIB(mars::plugins::data_broker_recorder::DataBrokerRecorder);
+CREATE_LIB(mars::plugins::data_broker_recorder::DataBrokerRecorder);
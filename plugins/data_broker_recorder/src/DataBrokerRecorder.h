@@ -0,0 +1,141 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file DataBrokerRecorder.h
+ * \brief Records DataBroker streams to a binary file and replays them.
+ *
+ * The plugin is controlled by the properties of the cfg_manager group
+ * "DataBrokerRecorder":
+ *   - patterns: the streams to record as "groupName/dataName" patterns
+ *     separated by ';', the group name ends at the first '/'
+ *   - file: the recording to write or replay
+ *   - record: starts and stops the recording
+ *   - replay: starts and stops the replay
+ *   - replay_speed: the replay speed, 0 replays as fast as possible
+ *   - timer: the DataBroker timer whose time stamps the recorded rows
+ *   - block_rows: the number of rows of a stream written in one block
+ *   - buffer_size: the size of the file buffer in KiB
+ *   - queue_size: the KiB of blocks that may wait for the disk, further
+ *     blocks are dropped, 0 does not limit the queue
+ */
+
+#ifndef MARS_PLUGINS_DATA_BROKER_RECORDER_H
+#define MARS_PLUGINS_DATA_BROKER_RECORDER_H
+
+#ifdef _PRINT_HEADER_
+  #warning "DataBrokerRecorder.h"
+#endif
+
+#include "RecordWriter.h"
+#include "RecordReplayer.h"
+
+#include <mars/interfaces/sim/MarsPluginTemplate.h>
+#include <mars/interfaces/MARSDefs.h>
+#include <mars/data_broker/ReceiverInterface.h>
+#include <mars/cfg_manager/CFGManagerInterface.h>
+#include <mars/utils/Mutex.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mars {
+
+  namespace plugins {
+    namespace data_broker_recorder {
+
+      /** The recording state of one stream. */
+      struct RecordStream {
+        uint32_t index;
+        std::vector<data_broker::DataType> types;
+        std::vector<std::string> names;
+        std::vector<int64_t> times;
+        // the values of the rows of the current block, one buffer per item
+        std::vector<std::vector<char> > columns;
+      };
+
+      class DataBrokerRecorder: public mars::interfaces::MarsPluginTemplate,
+                                public mars::data_broker::ReceiverInterface,
+                                public mars::cfg_manager::CFGClient {
+
+      public:
+        DataBrokerRecorder(lib_manager::LibManager *theManager);
+        ~DataBrokerRecorder();
+
+        // LibInterface methods
+        int getLibVersion() const
+        { return 1; }
+        const std::string getLibName() const
+        { return std::string("data_broker_recorder"); }
+        CREATE_MODULE_INFO();
+
+        // MarsPlugin methods
+        void init();
+        void reset();
+        void update(mars::interfaces::sReal time_ms);
+
+        // DataBrokerReceiver methods
+        virtual void receiveData(const data_broker::DataInfo &info,
+                                 const data_broker::DataPackage &package,
+                                 int callbackParam);
+        // CFGClient methods
+        virtual void cfgUpdateProperty(cfg_manager::cfgPropertyStruct _property);
+
+        // DataBrokerRecorder methods
+        bool startRecording(void);
+        void stopRecording(void);
+        bool startReplay(void);
+        void stopReplay(void);
+
+      private:
+        cfg_manager::cfgPropertyStruct patterns, file, record, replay;
+        cfg_manager::cfgPropertyStruct replaySpeed, timer, blockRows;
+        cfg_manager::cfgPropertyStruct bufferSize, queueSize;
+
+        // the registered patterns as pairs of group and data name
+        std::vector<std::pair<std::string, std::string> > registrations;
+        std::string timerDataName;
+        // the streams by their data id
+        std::map<unsigned long, RecordStream*> streams;
+        RecordWriter writer;
+        RecordReplayer *replayer;
+        // the buffer of the record that is assembled next
+        std::vector<char> recordBuffer;
+        utils::Mutex mutex;
+        bool recording;
+        size_t rowsPerBlock;
+        long long time;
+        unsigned long numRows;
+
+        void writeSchema(const RecordStream &stream,
+                         const data_broker::DataInfo &info,
+                         const data_broker::DataPackage &package);
+        void writeBlock(RecordStream *stream);
+        void appendRow(RecordStream *stream,
+                       const data_broker::DataPackage &package);
+
+      }; // end of class definition DataBrokerRecorder
+
+    } // end of namespace data_broker_recorder
+  } // end of namespace plugins
+} // end of namespace mars
+
+#endif // MARS_PLUGINS_DATA_BROKER_RECORDER_H
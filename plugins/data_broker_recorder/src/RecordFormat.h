@@ -0,0 +1,148 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file RecordFormat.h
+ * \brief The binary file format of the DataBroker recordings.
+ *
+ * A recording starts with a record_file_header followed by records. Every
+ * record starts with a record_header. A stream record describes the layout
+ * of a DataBroker stream once:
+ *   - uint32_t flags, uint32_t number of items
+ *   - the group and data name
+ *   - for every item a uint8_t DataType and the item name
+ * A block record holds the following rows of a stream column by column:
+ *   - uint32_t number of rows
+ *   - int64_t time in ms of every row
+ *   - for every item a uint64_t byte size followed by the values of all
+ *     rows, strings are stored one after the other
+ * Strings are stored with a uint32_t length prefix. A stream record that
+ * follows blocks of the same stream replaces its layout for the following
+ * blocks.
+ */
+
+#ifndef MARS_PLUGINS_DATA_BROKER_RECORDER_RECORD_FORMAT_H
+#define MARS_PLUGINS_DATA_BROKER_RECORDER_RECORD_FORMAT_H
+
+#ifdef _PRINT_HEADER_
+  #warning "RecordFormat.h"
+#endif
+
+#include <mars/data_broker/DataItem.h>
+
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define DB_RECORD_MAGIC 0x5242444d // "MDBR"
+#define DB_RECORD_VERSION 1
+
+namespace mars {
+  namespace plugins {
+    namespace data_broker_recorder {
+
+      enum RecordType {
+        RECORD_STREAM = 1,
+        RECORD_BLOCK = 2
+      };
+
+      struct record_file_header {
+        uint32_t magic;
+        uint32_t version;
+      };
+
+      struct record_header {
+        uint32_t type;
+        uint32_t stream;
+        // the size of the record without this header
+        uint64_t size;
+      };
+
+      /** The layout of a recorded stream. */
+      struct record_schema {
+        uint32_t stream;
+        uint32_t flags;
+        std::string groupName, dataName;
+        std::vector<data_broker::DataType> types;
+        std::vector<std::string> names;
+      };
+
+      /** Returns the size of a value in a column, 0 for strings. */
+      inline size_t getValueSize(data_broker::DataType type) {
+        switch(type) {
+        case data_broker::BOOL_TYPE:
+          return sizeof(uint8_t);
+        case data_broker::INT_TYPE:
+        case data_broker::UINT_TYPE:
+        case data_broker::FLOAT_TYPE:
+          return sizeof(int32_t);
+        case data_broker::LONG_TYPE:
+        case data_broker::ULONG_TYPE:
+        case data_broker::DOUBLE_TYPE:
+          return sizeof(int64_t);
+        default:
+          return 0;
+        }
+      }
+
+      inline void appendBytes(std::vector<char> *buffer, const void *data,
+                              size_t size) {
+        size_t offset = buffer->size();
+        buffer->resize(offset + size);
+        if(size) memcpy(&(*buffer)[offset], data, size);
+      }
+
+      inline void appendString(std::vector<char> *buffer,
+                               const std::string &s) {
+        uint32_t size = s.size();
+        appendBytes(buffer, &size, sizeof(size));
+        appendBytes(buffer, s.data(), size);
+      }
+
+      /**
+       * Reads size bytes at *offset from buffer and advances the offset.
+       * Returns false if the buffer is too short.
+       */
+      inline bool readBytes(const std::vector<char> &buffer, size_t *offset,
+                            void *data, size_t size) {
+        if(*offset + size > buffer.size()) return false;
+        if(size) memcpy(data, &buffer[*offset], size);
+        *offset += size;
+        return true;
+      }
+
+      inline bool readString(const std::vector<char> &buffer, size_t *offset,
+                             std::string *s) {
+        uint32_t size;
+        if(!readBytes(buffer, offset, &size, sizeof(size)) ||
+           *offset + size > buffer.size()) {
+          return false;
+        }
+        s->assign(buffer.data() + *offset, size);
+        *offset += size;
+        return true;
+      }
+
+    } // end of namespace data_broker_recorder
+  } // end of namespace plugins
+} // end of namespace mars
+
+#endif // MARS_PLUGINS_DATA_BROKER_RECORDER_RECORD_FORMAT_H
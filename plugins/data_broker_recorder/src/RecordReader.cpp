@@ -0,0 +1,227 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RecordReader.h"
+
+#include <mars/interfaces/Logging.hpp>
+#include <mars/interfaces/sim/ControlCenter.h>
+
+#include <cerrno>
+
+// marks streams whose layout was not read yet
+#define NO_SCHEMA ((size_t)-1)
+
+namespace mars {
+  namespace plugins {
+    namespace data_broker_recorder {
+
+      using namespace mars::data_broker;
+
+      bool RecordBlock::init(const record_schema *schema) {
+        size_t offset = 0;
+        uint64_t columnSize;
+        this->schema = schema;
+        row = rows = 0;
+        if(!readBytes(data, &offset, &rows, sizeof(rows))) return false;
+        times.resize(rows);
+        if(rows && !readBytes(data, &offset, &times[0], rows*sizeof(int64_t))) {
+          return false;
+        }
+        columns.resize(schema->types.size());
+        for(size_t i=0; i<columns.size(); ++i) {
+          if(!readBytes(data, &offset, &columnSize, sizeof(columnSize)) ||
+             offset + columnSize > data.size()) {
+            return false;
+          }
+          size_t valueSize = getValueSize(schema->types[i]);
+          if(valueSize && columnSize != (uint64_t)valueSize*rows) return false;
+          columns[i] = offset;
+          offset += columnSize;
+        }
+        return true;
+      }
+
+      bool RecordBlock::readRow(DataPackage *package) {
+        bool ok = true;
+        uint8_t b;
+        int32_t i32;
+        int64_t i64;
+        float f;
+        double d;
+        std::string s;
+        for(size_t i=0; i<columns.size(); ++i) {
+          size_t *offset = &columns[i];
+          switch(schema->types[i]) {
+          case BOOL_TYPE:
+            ok &= readBytes(data, offset, &b, sizeof(b));
+            package->set(i, (bool)b);
+            break;
+          case INT_TYPE:
+            ok &= readBytes(data, offset, &i32, sizeof(i32));
+            package->set(i, (int)i32);
+            break;
+          case UINT_TYPE:
+            ok &= readBytes(data, offset, &i32, sizeof(i32));
+            package->set(i, (unsigned int)i32);
+            break;
+          case LONG_TYPE:
+            ok &= readBytes(data, offset, &i64, sizeof(i64));
+            package->set(i, (long)i64);
+            break;
+          case ULONG_TYPE:
+            ok &= readBytes(data, offset, &i64, sizeof(i64));
+            package->set(i, (unsigned long)i64);
+            break;
+          case FLOAT_TYPE:
+            ok &= readBytes(data, offset, &f, sizeof(f));
+            package->set(i, f);
+            break;
+          case DOUBLE_TYPE:
+            ok &= readBytes(data, offset, &d, sizeof(d));
+            package->set(i, d);
+            break;
+          case STRING_TYPE:
+            ok &= readString(data, offset, &s);
+            package->set(i, s);
+            break;
+          default:
+            break;
+          }
+        }
+        ++row;
+        return ok;
+      }
+
+      RecordReader::RecordReader() : file(NULL) {
+      }
+
+      RecordReader::~RecordReader() {
+        close();
+      }
+
+      /**
+       * \brief Reads the layouts of the streams and the positions of the
+       *        blocks.
+       *
+       * post:
+       *     - returns false if the file is missing or no recording
+       *     - a truncated last record is ignored
+       */
+      bool RecordReader::open(const std::string &filename) {
+        close();
+        file = fopen(filename.c_str(), "rb");
+        if(!file) {
+          LOG_ERROR("DataBrokerRecorder: cannot open \"%s\": %s",
+                    filename.c_str(), strerror(errno));
+          return false;
+        }
+        this->filename = filename;
+        record_file_header fileHeader;
+        if(fread(&fileHeader, sizeof(fileHeader), 1, file) != 1 ||
+           fileHeader.magic != DB_RECORD_MAGIC ||
+           fileHeader.version != DB_RECORD_VERSION) {
+          LOG_ERROR("DataBrokerRecorder: \"%s\" is no recording",
+                    filename.c_str());
+          close();
+          return false;
+        }
+
+        // the current layout of every stream
+        std::vector<size_t> streamSchemas;
+        record_header header;
+        while(fread(&header, sizeof(header), 1, file) == 1) {
+          if(header.type == RECORD_STREAM) {
+            if(!readSchema(header)) break;
+            if(header.stream >= streamSchemas.size()) {
+              streamSchemas.resize(header.stream+1, NO_SCHEMA);
+              blocks.resize(header.stream+1);
+            }
+            streamSchemas[header.stream] = schemas.size()-1;
+            continue;
+          }
+          record_block_entry entry;
+          entry.offset = ftell(file);
+          entry.size = header.size;
+          if(header.type != RECORD_BLOCK ||
+             header.stream >= streamSchemas.size() ||
+             streamSchemas[header.stream] == NO_SCHEMA ||
+             fread(&entry.rows, sizeof(entry.rows), 1, file) != 1 ||
+             fseek(file, entry.offset + header.size, SEEK_SET) != 0) {
+            break;
+          }
+          entry.schema = streamSchemas[header.stream];
+          blocks[header.stream].push_back(entry);
+        }
+        LOG_INFO("DataBrokerRecorder: opened \"%s\" with %lu streams",
+                 filename.c_str(), (unsigned long)blocks.size());
+        return true;
+      }
+
+      void RecordReader::close(void) {
+        if(file) fclose(file);
+        file = NULL;
+        schemas.clear();
+        blocks.clear();
+      }
+
+      bool RecordReader::readSchema(const record_header &header) {
+        std::vector<char> data(header.size);
+        size_t offset = 0;
+        uint32_t numItems;
+        record_schema schema;
+        schema.stream = header.stream;
+        if(data.empty() || fread(&data[0], 1, data.size(), file) != data.size() ||
+           !readBytes(data, &offset, &schema.flags, sizeof(schema.flags)) ||
+           !readBytes(data, &offset, &numItems, sizeof(numItems)) ||
+           !readString(data, &offset, &schema.groupName) ||
+           !readString(data, &offset, &schema.dataName) ||
+           numItems > data.size()) {
+          return false;
+        }
+        schema.types.resize(numItems);
+        schema.names.resize(numItems);
+        for(uint32_t i=0; i<numItems; ++i) {
+          uint8_t type;
+          if(!readBytes(data, &offset, &type, sizeof(type)) ||
+             !readString(data, &offset, &schema.names[i])) {
+            return false;
+          }
+          schema.types[i] = (DataType)type;
+        }
+        schemas.push_back(schema);
+        return true;
+      }
+
+      bool RecordReader::readBlock(const record_block_entry &entry,
+                                   RecordBlock *block) {
+        block->data.resize(entry.size);
+        if(!file || fseek(file, entry.offset, SEEK_SET) != 0 ||
+           (entry.size &&
+            fread(&block->data[0], 1, entry.size, file) != entry.size) ||
+           !block->init(&schemas[entry.schema])) {
+          LOG_ERROR("DataBrokerRecorder: \"%s\" is damaged", filename.c_str());
+          return false;
+        }
+        return true;
+      }
+
+    } // end of namespace data_broker_recorder
+  } // end of namespace plugins
+} // end of namespace mars
@@ -0,0 +1,124 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file RecordReader.h
+ * \brief Reads a recording block by block.
+ */
+
+#ifndef MARS_PLUGINS_DATA_BROKER_RECORDER_RECORD_READER_H
+#define MARS_PLUGINS_DATA_BROKER_RECORDER_RECORD_READER_H
+
+#ifdef _PRINT_HEADER_
+  #warning "RecordReader.h"
+#endif
+
+#include "RecordFormat.h"
+
+#include <mars/data_broker/DataPackage.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace mars {
+  namespace plugins {
+    namespace data_broker_recorder {
+
+      /** The position of a block record in the file. */
+      struct record_block_entry {
+        // the index of the layout in RecordReader::getSchemas()
+        size_t schema;
+        long offset;
+        uint64_t size;
+        uint32_t rows;
+      };
+
+      /**
+       * A block of one stream that is read row by row. The values are read
+       * from the columns in place.
+       */
+      class RecordBlock {
+      public:
+        RecordBlock() : schema(NULL), rows(0), row(0) {}
+
+        /** Checks the record and sets up the columns. */
+        bool init(const record_schema *schema);
+
+        bool atEnd(void) const {return row >= rows;}
+        int64_t getTime(void) const {return times[row];}
+
+        /**
+         * \brief Writes the values of the current row to the package and
+         *        moves to the next row.
+         *
+         * pre:
+         *     - the package has the layout of the schema
+         */
+        bool readRow(data_broker::DataPackage *package);
+
+        std::vector<char> data;
+
+      private:
+        const record_schema *schema;
+        uint32_t rows, row;
+        std::vector<int64_t> times;
+        // the read position in data of every column
+        std::vector<size_t> columns;
+      };
+
+      /**
+       * Scans a recording for the layouts of its streams and the positions of
+       * the blocks. The blocks are read on demand.
+       */
+      class RecordReader {
+      public:
+        RecordReader();
+        ~RecordReader();
+
+        bool open(const std::string &filename);
+        void close(void);
+
+        /** The number of streams in the recording. */
+        size_t getNumStreams(void) const {return blocks.size();}
+        const std::vector<record_schema>& getSchemas(void) const {
+          return schemas;
+        }
+        /** The blocks of the stream in the order they were recorded. */
+        const std::vector<record_block_entry>& getBlocks(size_t stream) const {
+          return blocks[stream];
+        }
+
+        bool readBlock(const record_block_entry &entry, RecordBlock *block);
+
+      private:
+        FILE *file;
+        std::string filename;
+        std::vector<record_schema> schemas;
+        std::vector<std::vector<record_block_entry> > blocks;
+
+        bool readSchema(const record_header &header);
+      };
+
+    } // end of namespace data_broker_recorder
+  } // end of namespace plugins
+} // end of namespace mars
+
+#endif // MARS_PLUGINS_DATA_BROKER_RECORDER_RECORD_READER_H
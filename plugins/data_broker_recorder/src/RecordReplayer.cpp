@@ -0,0 +1,169 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RecordReplayer.h"
+
+#include <mars/data_broker/DataBrokerInterface.h>
+#include <mars/utils/misc.h>
+#include <mars/interfaces/Logging.hpp>
+#include <mars/interfaces/sim/ControlCenter.h>
+
+#include <functional>
+#include <queue>
+
+// the longest sleep before the stop flag is checked again
+#define REPLAY_MAX_SLEEP 100
+
+namespace mars {
+  namespace plugins {
+    namespace data_broker_recorder {
+
+      using namespace mars::data_broker;
+
+      // creates an item with a default value for every item of the layout
+      static void createPackage(const record_schema &schema,
+                                DataPackage *package) {
+        package->clear();
+        for(size_t i=0; i<schema.types.size(); ++i) {
+          const std::string &name = schema.names[i];
+          switch(schema.types[i]) {
+          case BOOL_TYPE: package->add(name, false); break;
+          case INT_TYPE: package->add(name, (int)0); break;
+          case UINT_TYPE: package->add(name, (unsigned int)0); break;
+          case LONG_TYPE: package->add(name, (long)0); break;
+          case ULONG_TYPE: package->add(name, (unsigned long)0); break;
+          case FLOAT_TYPE: package->add(name, 0.0f); break;
+          case DOUBLE_TYPE: package->add(name, 0.0); break;
+          case STRING_TYPE: package->add(name, std::string()); break;
+          default: package->add(name, (long)0); break;
+          }
+        }
+      }
+
+      RecordReplayer::RecordReplayer(DataBrokerInterface *dataBroker)
+        : dataBroker(dataBroker), speed(1.0), quit(false) {
+      }
+
+      RecordReplayer::~RecordReplayer() {
+        stop();
+      }
+
+      bool RecordReplayer::replay(const std::string &filename, double speed) {
+        stop();
+        if(!reader.open(filename)) return false;
+        this->speed = speed;
+        quit = false;
+        start();
+        return true;
+      }
+
+      void RecordReplayer::stop(void) {
+        quit = true;
+        if(isRunning()) wait();
+        reader.close();
+      }
+
+      bool RecordReplayer::loadBlock(size_t stream, Cursor *cursor) {
+        const std::vector<record_block_entry> &blocks = reader.getBlocks(stream);
+        for(; cursor->block < blocks.size(); ++cursor->block) {
+          if(!reader.readBlock(blocks[cursor->block], &cursor->data)) {
+            return false;
+          }
+          if(!cursor->data.atEnd()) return true;
+        }
+        return false;
+      }
+
+      bool RecordReplayer::waitUntil(long long wallTime) {
+        long long now;
+        while(!quit && (now = utils::getTime()) < wallTime) {
+          long long sleep = wallTime - now;
+          utils::msleep(sleep < REPLAY_MAX_SLEEP ? sleep : REPLAY_MAX_SLEEP);
+        }
+        return !quit;
+      }
+
+      /**
+       * \brief Merges the streams by time and pushes every row.
+       *
+       * Every stream keeps one block in memory, the next block is read when
+       * the current one is exhausted.
+       */
+      void RecordReplayer::run(void) {
+        typedef std::pair<int64_t, size_t> QueueEntry;
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+                            std::greater<QueueEntry> > queue;
+        const std::vector<record_schema> &schemas = reader.getSchemas();
+        std::vector<Cursor> cursors(reader.getNumStreams());
+        std::vector<DataPackage> packages(schemas.size());
+        std::vector<unsigned long> pushIds(schemas.size(), 0);
+        unsigned long numRows = 0;
+
+        for(size_t i=0; i<cursors.size(); ++i) {
+          cursors[i].block = 0;
+          if(loadBlock(i, &cursors[i])) {
+            queue.push(QueueEntry(cursors[i].data.getTime(), i));
+          }
+        }
+        long long startWallTime = utils::getTime();
+        int64_t startTime = queue.empty() ? 0 : queue.top().first;
+
+        while(!queue.empty() && !quit) {
+          QueueEntry entry = queue.top();
+          queue.pop();
+          if(speed > 0.0 &&
+             !waitUntil(startWallTime +
+                        (long long)((entry.first - startTime) / speed))) {
+            break;
+          }
+          Cursor &cursor = cursors[entry.second];
+          size_t schema = reader.getBlocks(entry.second)[cursor.block].schema;
+          DataPackage &package = packages[schema];
+          if(!pushIds[schema]) {
+            createPackage(schemas[schema], &package);
+          }
+          if(!cursor.data.readRow(&package)) {
+            LOG_ERROR("DataBrokerRecorder: stream %s/%s is damaged",
+                      schemas[schema].groupName.c_str(),
+                      schemas[schema].dataName.c_str());
+            continue;
+          }
+          if(pushIds[schema]) {
+            dataBroker->pushData(pushIds[schema], package);
+          } else {
+            pushIds[schema] = dataBroker->pushData(schemas[schema].groupName,
+                                                   schemas[schema].dataName,
+                                                   package, NULL,
+                                                   (PackageFlag)schemas[schema].flags);
+          }
+          ++numRows;
+
+          if(cursor.data.atEnd()) {
+            ++cursor.block;
+            if(!loadBlock(entry.second, &cursor)) continue;
+          }
+          queue.push(QueueEntry(cursor.data.getTime(), entry.second));
+        }
+        LOG_INFO("DataBrokerRecorder: replayed %lu packages", numRows);
+      }
+
+    } // end of namespace data_broker_recorder
+  } // end of namespace plugins
+} // end of namespace mars
@@ -0,0 +1,91 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file RecordReplayer.h
+ * \brief Pushes a recording back into the DataBroker.
+ */
+
+#ifndef MARS_PLUGINS_DATA_BROKER_RECORDER_RECORD_REPLAYER_H
+#define MARS_PLUGINS_DATA_BROKER_RECORDER_RECORD_REPLAYER_H
+
+#ifdef _PRINT_HEADER_
+  #warning "RecordReplayer.h"
+#endif
+
+#include "RecordReader.h"
+
+#include <mars/utils/Thread.h>
+
+#include <atomic>
+#include <string>
+
+namespace mars {
+
+  namespace data_broker {
+    class DataBrokerInterface;
+  }
+
+  namespace plugins {
+    namespace data_broker_recorder {
+
+      /**
+       * Replays a recording in its own thread. The rows of all streams are
+       * pushed in the order of their time stamps under the recorded group
+       * and data names.
+       */
+      class RecordReplayer : public utils::Thread {
+      public:
+        explicit RecordReplayer(data_broker::DataBrokerInterface *dataBroker);
+        ~RecordReplayer();
+
+        /**
+         * \brief Opens the recording and starts the replay.
+         * \param speed The factor between the recorded and the replay time,
+         *              0 replays as fast as possible.
+         */
+        bool replay(const std::string &filename, double speed);
+
+        /** Stops the replay and waits for the thread. */
+        void stop(void);
+
+      protected:
+        void run(void);
+
+      private:
+        struct Cursor {
+          size_t block;
+          RecordBlock data;
+        };
+
+        data_broker::DataBrokerInterface *dataBroker;
+        RecordReader reader;
+        double speed;
+        std::atomic<bool> quit;
+
+        bool loadBlock(size_t stream, Cursor *cursor);
+        bool waitUntil(long long wallTime);
+      };
+
+    } // end of namespace data_broker_recorder
+  } // end of namespace plugins
+} // end of namespace mars
+
+#endif // MARS_PLUGINS_DATA_BROKER_RECORDER_RECORD_REPLAYER_H
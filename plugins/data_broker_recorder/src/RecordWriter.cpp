@@ -0,0 +1,176 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RecordWriter.h"
+
+#include <mars/utils/MutexLocker.h>
+#include <mars/interfaces/Logging.hpp>
+#include <mars/interfaces/sim/ControlCenter.h>
+
+#include <cerrno>
+#include <cstring>
+
+// the number of written record buffers that are kept for reuse
+#define RECORD_WRITER_FREE_RECORDS 64
+
+namespace mars {
+  namespace plugins {
+    namespace data_broker_recorder {
+
+      using namespace mars::utils;
+
+      RecordWriter::RecordWriter() : file(NULL), bytesWritten(0),
+                                     queuedBytes(0), maxQueuedBytes(0),
+                                     droppedRecords(0), quit(false),
+                                     failed(false) {
+      }
+
+      RecordWriter::~RecordWriter() {
+        close();
+      }
+
+      bool RecordWriter::open(const std::string &filename,
+                              size_t bufferSize, size_t maxQueued) {
+        close();
+        file = fopen(filename.c_str(), "wb");
+        if(!file) {
+          LOG_ERROR("DataBrokerRecorder: cannot write \"%s\": %s",
+                    filename.c_str(), strerror(errno));
+          return false;
+        }
+        buffer.resize(bufferSize);
+        if(bufferSize) {
+          setvbuf(file, &buffer[0], _IOFBF, bufferSize);
+        }
+        record_file_header header;
+        header.magic = DB_RECORD_MAGIC;
+        header.version = DB_RECORD_VERSION;
+        if(fwrite(&header, sizeof(header), 1, file) != 1) {
+          LOG_ERROR("DataBrokerRecorder: writing \"%s\" failed",
+                    filename.c_str());
+          fclose(file);
+          file = NULL;
+          return false;
+        }
+        bytesWritten = sizeof(header);
+        queuedBytes = 0;
+        maxQueuedBytes = maxQueued;
+        droppedRecords = 0;
+        quit = false;
+        failed = false;
+        start();
+        return true;
+      }
+
+      void RecordWriter::close(void) {
+        if(!file) return;
+        mutex.lock();
+        quit = true;
+        condition.wakeAll();
+        mutex.unlock();
+        wait();
+        if(fclose(file) != 0) failed = true;
+        file = NULL;
+        if(failed) {
+          LOG_ERROR("DataBrokerRecorder: the recording is incomplete");
+        }
+        if(droppedRecords) {
+          LOG_WARN("DataBrokerRecorder: %lu blocks were dropped, the disk was too slow",
+                   droppedRecords);
+        }
+        records.clear();
+        freeRecords.clear();
+        buffer.clear();
+      }
+
+      bool RecordWriter::queue(std::vector<char> *record) {
+        MutexLocker locker(&mutex);
+        record_header header;
+        if(maxQueuedBytes && queuedBytes + record->size() > maxQueuedBytes &&
+           record->size() >= sizeof(header)) {
+          // the reader skips missing blocks, a missing layout would make
+          // the following blocks of the stream unreadable
+          memcpy(&header, &(*record)[0], sizeof(header));
+          if(header.type == RECORD_BLOCK) {
+            if(!droppedRecords++) {
+              LOG_WARN("DataBrokerRecorder: the write queue is full, dropping blocks");
+            }
+            record->clear();
+            return false;
+          }
+        }
+        queuedBytes += record->size();
+        records.push_back(std::vector<char>());
+        records.back().swap(*record);
+        if(!freeRecords.empty()) {
+          record->swap(freeRecords.back());
+          freeRecords.pop_back();
+        }
+        condition.wakeAll();
+        return true;
+      }
+
+      unsigned long long RecordWriter::getBytesWritten(void) {
+        MutexLocker locker(&mutex);
+        return bytesWritten;
+      }
+
+      unsigned long RecordWriter::getDroppedRecords(void) {
+        MutexLocker locker(&mutex);
+        return droppedRecords;
+      }
+
+      void RecordWriter::run(void) {
+        std::vector<std::vector<char> >::iterator it;
+        size_t size;
+        mutex.lock();
+        while(true) {
+          while(records.empty() && !quit) condition.wait(&mutex);
+          if(records.empty() && quit) break;
+          // both vectors keep their capacity
+          records.swap(writing);
+          mutex.unlock();
+          size = 0;
+          for(it=writing.begin(); it!=writing.end(); ++it) {
+            if(!failed && !it->empty() &&
+               fwrite(&(*it)[0], 1, it->size(), file) != it->size()) {
+              LOG_ERROR("DataBrokerRecorder: writing the recording failed: %s",
+                        strerror(errno));
+              failed = true;
+            }
+            size += it->size();
+            it->clear();
+          }
+          mutex.lock();
+          bytesWritten += size;
+          queuedBytes -= size;
+          for(it=writing.begin(); it!=writing.end() &&
+                freeRecords.size() < RECORD_WRITER_FREE_RECORDS; ++it) {
+            freeRecords.push_back(std::vector<char>());
+            freeRecords.back().swap(*it);
+          }
+          writing.clear();
+        }
+        mutex.unlock();
+      }
+
+    } // end of namespace data_broker_recorder
+  } // end of namespace plugins
+} // end of namespace mars
@@ -0,0 +1,109 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file RecordWriter.h
+ * \brief Writes the records of a recording in its own thread.
+ */
+
+#ifndef MARS_PLUGINS_DATA_BROKER_RECORDER_RECORD_WRITER_H
+#define MARS_PLUGINS_DATA_BROKER_RECORDER_RECORD_WRITER_H
+
+#ifdef _PRINT_HEADER_
+  #warning "RecordWriter.h"
+#endif
+
+#include "RecordFormat.h"
+
+#include <mars/utils/Thread.h>
+#include <mars/utils/Mutex.h>
+#include <mars/utils/WaitCondition.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace mars {
+  namespace plugins {
+    namespace data_broker_recorder {
+
+      /**
+       * The records are queued by the recording thread and written by the
+       * writer thread through a large stdio buffer. Queueing only swaps the
+       * record buffer into the queue, so the recording thread never waits
+       * for the disk. If the disk cannot keep up, the blocks that do not fit
+       * into the queue are dropped and counted.
+       */
+      class RecordWriter : public utils::Thread {
+      public:
+        RecordWriter();
+        ~RecordWriter();
+
+        /**
+         * \brief Creates the file, writes the file header and starts the
+         *        thread.
+         * \param bufferSize The size of the stdio buffer in bytes.
+         * \param maxQueued The number of bytes that may wait for the disk,
+         *                  0 does not limit the queue.
+         */
+        bool open(const std::string &filename, size_t bufferSize,
+                  size_t maxQueued);
+
+        /** Writes all queued records and closes the file. */
+        void close(void);
+
+        bool isOpen(void) const {return file != NULL;}
+
+        /**
+         * \brief Queues the record for writing.
+         *
+         * post:
+         *     - record holds an empty buffer, if possible one of an already
+         *       written record to keep its capacity
+         *     - returns false if the record is a block that did not fit into
+         *       the queue, stream layouts are always queued
+         */
+        bool queue(std::vector<char> *record);
+
+        /** The number of bytes written so far. */
+        unsigned long long getBytesWritten(void);
+        /** The number of blocks dropped because the queue was full. */
+        unsigned long getDroppedRecords(void);
+
+      protected:
+        void run(void);
+
+      private:
+        FILE *file;
+        std::vector<char> buffer;
+        std::vector<std::vector<char> > records, writing, freeRecords;
+        unsigned long long bytesWritten;
+        size_t queuedBytes, maxQueuedBytes;
+        unsigned long droppedRecords;
+        bool quit, failed;
+        utils::Mutex mutex;
+        utils::WaitCondition condition;
+      };
+
+    } // end of namespace data_broker_recorder
+  } // end of namespace plugins
+} // end of namespace mars
+
+#endif // MARS_PLUGINS_DATA_BROKER_RECORDER_RECORD_WRITER_H
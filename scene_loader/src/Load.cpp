@@ -39,9 +39,13 @@
 #include <mars/interfaces/sim/LoadSceneInterface.h>
 #include <mars/utils/misc.h>
 #include <mars/interfaces/Logging.hpp>
+#include <mars/cfg_manager/CFGManagerInterface.h>
 
 //#define DEBUG_PARSE 1
 
+// changes if the lists stored in the scene cache change
+#define SCENE_LOAD_CACHE_KEY "mars_scene_loader 1"
+
 namespace mars {
   namespace scene_loader {
 
@@ -51,10 +55,15 @@ namespace mars {
     Load::Load(std::string fileName, ControlCenter *c,
                std::string tmpPath_, const std::string &robotname) :
       mFileName(fileName), mRobotName(robotname),
-      control(c), tmpPath(tmpPath_) {
+      control(c), tmpPath(tmpPath_), cache(NULL), cacheHit(false),
+      cacheable(true) {
       mFileSuffix = utils::getFilenameSuffix(mFileName);
     }
 
+    Load::~Load() {
+      delete cache;
+    }
+
     unsigned int Load::load() {
 
       if(!prepareLoad()) return 0;
@@ -76,9 +85,27 @@ namespace mars {
         control->entities->addEntity(mRobotName);
       }
 
+      std::string cacheDir;
+      if(control->cfg) {
+        cacheDir = control->cfg->getOrCreateProperty("Config",
+                                                     "scene_cache_path",
+                                                     "").sValue;
+      }
+      std::string sourceFile = utils::pathJoin(utils::getCurrentWorkingDir(),
+                                               mFileName);
+      cache = new interfaces::SceneCache(cacheDir, sourceFile);
+      cache->addSource(sourceFile);
+      cacheHit = cache->open(interfaces::SceneCache::hashString(SCENE_LOAD_CACHE_KEY));
+
       // need to unzip into a temporary directory
       if (mFileSuffix == ".scn" || mFileSuffix == ".zip") {
-        if(unzip(tmpPath, mFileName) == 0)
+        if(cache->isEnabled()) {
+          // the archive is unpacked once into the cache entry, thus the
+          // meshes referenced by the cached scene stay available
+          tmpPath = cache->getEntryDir() + "files/";
+          if(!utils::pathExists(tmpPath)) cacheHit = false;
+        }
+        if(!cacheHit && unzip(tmpPath, mFileName) == 0)
           return 0;
       }
       else {
@@ -118,8 +145,63 @@ namespace mars {
     }
 
     unsigned int Load::parseScene() {
-      if(useYAML) return parseYamlScene();
+      if(cacheHit) {
+        if(readCache()) return 1;
+        cacheHit = false;
+      }
+
+      unsigned int valid = useYAML ? parseYamlScene() : parseXmlScene();
+      if(valid) writeCache();
+      return valid;
+    }
 
+    bool Load::readCache() {
+      LOG_INFO("Load: loading scene from cache: %s", mFileName.c_str());
+      std::vector<configmaps::ConfigMap>* lists[] = {
+        &materialList, &nodeList, &jointList, &motorList, &lightList,
+        &sensorList, &controllerList, &graphicList};
+      const char* names[] = {"materials", "nodes", "joints", "motors",
+                             "lights", "sensors", "controllers", "graphics"};
+      for(size_t i=0; i<sizeof(names)/sizeof(names[0]); ++i) {
+        if(!cache->readList(names[i], lists[i])) {
+          for(size_t k=0; k<sizeof(names)/sizeof(names[0]); ++k) {
+            lists[k]->clear();
+          }
+          return false;
+        }
+      }
+      return true;
+    }
+
+    void Load::writeCache() {
+      if(!cache || !cache->isEnabled()) return;
+      if(!cacheable) {
+        LOG_INFO("Load: scene has includes and is not cached: %s",
+                 mFileName.c_str());
+        return;
+      }
+      // the mesh files are read again on every load, but a changed mesh
+      // invalidates the entry as well
+      std::vector<configmaps::ConfigMap>::iterator it;
+      for(it=nodeList.begin(); it!=nodeList.end(); ++it) {
+        std::string meshFile = utils::trim(it->get("filename", std::string()));
+        if(meshFile.empty() || meshFile == "PRIMITIVE") continue;
+        utils::handleFilenamePrefix(&meshFile, tmpPath);
+        cache->addSource(utils::pathJoin(utils::getCurrentWorkingDir(),
+                                         meshFile));
+      }
+      cache->addList("materials", materialList);
+      cache->addList("nodes", nodeList);
+      cache->addList("joints", jointList);
+      cache->addList("motors", motorList);
+      cache->addList("lights", lightList);
+      cache->addList("sensors", sensorList);
+      cache->addList("controllers", controllerList);
+      cache->addList("graphics", graphicList);
+      cache->write(interfaces::SceneCache::hashString(SCENE_LOAD_CACHE_KEY));
+    }
+
+    unsigned int Load::parseXmlScene() {
       checkEncodings();
       //  HandleFileNames h_filenames;
       vector<string> v_filesToLoad;
@@ -229,7 +311,13 @@ namespace mars {
       LOG_INFO("Load: loading scene: %s", sceneFilename.c_str());
       configmaps::ConfigMap map;
       configmaps::ConfigVector::iterator it;
-      map = configmaps::ConfigMap::fromYamlFile(sceneFilename, true);
+      map = configmaps::ConfigMap::fromYamlFile(sceneFilename, false);
+      if(interfaces::SceneCache::hasIncludes(map)) {
+        // the included files are opened by configmaps and cannot be
+        // checked by the cache
+        map = configmaps::ConfigMap::fromYamlFile(sceneFilename, true);
+        cacheable = false;
+      }
 
       for(it=map["nodelist"].begin(); it!=map["nodelist"].end(); ++it) {
         nodeList.push_back(*it);
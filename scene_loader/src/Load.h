@@ -31,6 +31,7 @@
 #include <configmaps/ConfigData.h>
 #include <mars/interfaces/sensor_bases.h>
 #include <mars/interfaces/MaterialData.h>
+#include <mars/interfaces/SceneCache.h>
 
 class QDomElement;
 
@@ -41,6 +42,7 @@ namespace mars {
     public:
       Load(std::string fileName, interfaces::ControlCenter *control,
            std::string tmpPath_, const std::string &robotname="");
+      ~Load();
 
       /**
        * @return 0 on error.
@@ -76,8 +78,16 @@ namespace mars {
       void getGenericConfig(configmaps::ConfigMap *config,
                             const QDomElement &elementNode);
 
+      unsigned int parseXmlScene();
       unsigned int parseYamlScene();
 
+      /**
+       * The parsed lists are stored in the scene cache after the first load
+       * of a scene. Later loads read them from there and skip the parsing
+       * and, for archives, the unpacking.
+       */
+      bool readCache();
+      void writeCache();
 
       /**
        * Name of the file which should be opened (including the extension .smurf).
@@ -97,6 +107,8 @@ namespace mars {
       std::string tmpPath;
       std::string sceneFilename;
       unsigned int mapIndex;
+      interfaces::SceneCache *cache;
+      bool cacheHit, cacheable;
 
       unsigned int loadMaterial(configmaps::ConfigMap config);
       unsigned int loadNode(configmaps::ConfigMap config);
@@ -0,0 +1,545 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file sim_benchmark.cpp
+ * \brief Runs canonical scenes without graphics and reports the step rate,
+ * the duration of the step phases and the allocations per step.
+ *
+ * The scenes are created procedurally from a fixed seed, thus every run
+ * simulates exactly the same world. Each scene is run with and without
+ * the fast step of ODE (dWorldQuickStep vs. dWorldStep) and a checksum of
+ * the final state of all dynamic nodes is printed to compare runs.
+ *
+ * Usage: mars_sim_benchmark [options]
+ *   -s, --scene NAME        all, boxes, terrain, laser or robots (default all)
+ *   -n, --steps N           measured steps per run (default 2000)
+ *   -w, --warmup N          steps before the measurement (default 200)
+ *   -f, --faststep MODE     both, on or off (default both)
+ *   -t, --step-threads N    value of the "step threads" property
+ *   -o, --trace FILE        writes a Chrome trace of the last run
+ */
+
+#include <lib_manager/LibManager.hpp>
+#include <mars/cfg_manager/CFGManagerInterface.h>
+#include <mars/data_broker/DataBrokerInterface.h>
+#include <mars/data_broker/ReceiverInterface.h>
+#include <mars/data_broker/DataPackage.h>
+#include <mars/interfaces/sim/ControlCenter.h>
+#include <mars/interfaces/sim/SimulatorInterface.h>
+#include <mars/interfaces/sim/NodeManagerInterface.h>
+#include <mars/interfaces/sim/JointManagerInterface.h>
+#include <mars/interfaces/sim/MotorManagerInterface.h>
+#include <mars/interfaces/sim/SensorManagerInterface.h>
+#include <mars/interfaces/NodeData.h>
+#include <mars/interfaces/JointData.h>
+#include <mars/interfaces/MotorData.h>
+#include <mars/interfaces/terrainStruct.h>
+#include <mars/utils/mathUtils.h>
+#include <configmaps/ConfigData.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <getopt.h>
+#include <new>
+#include <string>
+#include <vector>
+
+// counts the allocations of all threads to report allocations per step
+static std::atomic<unsigned long> numAllocations(0);
+
+void* operator new(size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  void *p = malloc(size ? size : 1);
+  if(!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+namespace mars {
+  namespace sim {
+
+    using namespace interfaces;
+    using namespace utils;
+
+    // seed of all procedurally created scenes
+    static const unsigned int BENCHMARK_SEED = 42;
+
+    /**
+     * A small linear congruential generator. In contrast to rand() its
+     * sequence is the same on every platform.
+     */
+    class Lcg {
+    public:
+      explicit Lcg(unsigned int seed) : state(seed) {}
+      // returns a value in [min, max)
+      double uniform(double min, double max) {
+        state = state * 1664525u + 1013904223u;
+        return min + (max - min) * ((state >> 8) / 16777216.0);
+      }
+    private:
+      unsigned int state;
+    };
+
+    struct scene {
+      std::vector<NodeId> dynamicNodes;
+      std::vector<unsigned long> wheelMotors;
+    };
+
+    /**
+     * Keeps the last statistics of the step profiler.
+     */
+    class ProfileReceiver : public data_broker::ReceiverInterface {
+    public:
+      void receiveData(const data_broker::DataInfo &,
+                       const data_broker::DataPackage &dataPackage,
+                       int) {
+        package = dataPackage;
+      }
+      data_broker::DataPackage package;
+    };
+
+    /**
+     * A group of robots that exchange their state over the DataBroker in
+     * every step. Each robot publishes its position when the simulation
+     * time is pushed and steers away from the robots it receives.
+     */
+    class RobotTraffic : public data_broker::ReceiverInterface {
+    public:
+      RobotTraffic(ControlCenter *control) : control(control) {}
+
+      void addRobot(NodeId chassis, unsigned long leftMotor,
+                    unsigned long rightMotor) {
+        robot r;
+        char name[32];
+        r.chassis = chassis;
+        r.leftMotor = leftMotor;
+        r.rightMotor = rightMotor;
+        r.package.add("x", 0.0);
+        r.package.add("y", 0.0);
+        r.package.add("z", 0.0);
+        r.package.add("steps", 0);
+        snprintf(name, sizeof(name), "robot%d/state", (int)robots.size());
+        r.packageId = control->dataBroker->registerPackage("benchmark", name,
+                                                           r.package);
+        robots.push_back(r);
+      }
+
+      void connect() {
+        control->dataBroker->registerSyncReceiver(this, "mars_sim", "simTime",
+                                                  -1);
+        for(size_t i=0; i<robots.size(); ++i) {
+          char name[32];
+          snprintf(name, sizeof(name), "robot%d/state", (int)i);
+          control->dataBroker->registerSyncReceiver(this, "benchmark", name,
+                                                    (int)i);
+        }
+      }
+
+      void disconnect() {
+        control->dataBroker->unregisterSyncReceiver(this, "mars_sim",
+                                                    "simTime");
+        for(size_t i=0; i<robots.size(); ++i) {
+          char name[32];
+          snprintf(name, sizeof(name), "robot%d/state", (int)i);
+          control->dataBroker->unregisterSyncReceiver(this, "benchmark", name);
+        }
+        robots.clear();
+      }
+
+      void receiveData(const data_broker::DataInfo &,
+                       const data_broker::DataPackage &dataPackage,
+                       int callbackParam) {
+        if(callbackParam < 0) {
+          publish();
+          return;
+        }
+        double x, y;
+        dataPackage.get(0, &x);
+        dataPackage.get(1, &y);
+        // every other robot reacts on the received position
+        for(size_t i=0; i<robots.size(); ++i) {
+          if((int)i == callbackParam) continue;
+          robot &r = robots[i];
+          double dx = r.package[0].d - x;
+          double dy = r.package[1].d - y;
+          double d2 = dx*dx + dy*dy;
+          if(d2 < 4.0 && d2 > 1e-6) {
+            r.turn += dy > 0 ? 0.5 : -0.5;
+          }
+        }
+      }
+
+    private:
+      struct robot {
+        NodeId chassis;
+        unsigned long leftMotor, rightMotor;
+        unsigned long packageId;
+        data_broker::DataPackage package;
+        double turn;
+        robot() : turn(0.0) {}
+      };
+
+      ControlCenter *control;
+      std::vector<robot> robots;
+
+      void publish() {
+        for(size_t i=0; i<robots.size(); ++i) {
+          robot &r = robots[i];
+          Vector pos = control->nodes->getPosition(r.chassis);
+          control->motors->setMotorValue(r.leftMotor, 4.0 - r.turn);
+          control->motors->setMotorValue(r.rightMotor, 4.0 + r.turn);
+          r.turn = 0.0;
+          r.package[0].d = pos.x();
+          r.package[1].d = pos.y();
+          r.package[2].d = pos.z();
+          r.package[3].i++;
+          control->dataBroker->pushData(r.packageId, r.package);
+        }
+      }
+    };
+
+    static NodeId addPrimitive(ControlCenter *control, const std::string &name,
+                               NodeType type, const Vector &pos,
+                               const Vector &ext, sReal mass, bool movable,
+                               const Quaternion &rot=Quaternion::Identity()) {
+      NodeData node(name, pos, rot);
+      node.initPrimitive(type, ext, mass);
+      node.movable = movable;
+      // the nodes are not kept for a reset, the world is cleared after a run
+      return control->nodes->addNode(&node, true, false);
+    }
+
+    static void addGround(ControlCenter *control) {
+      addPrimitive(control, "ground", NODE_TYPE_PLANE, Vector(0, 0, 0),
+                   Vector(100, 100, 0), 0, false);
+    }
+
+    /**
+     * Creates a four wheeled robot with velocity controlled hinge joints.
+     *
+     * post:
+     *     - the chassis is appended to the dynamic nodes
+     *     - the motors of the left and the right wheels are appended to the
+     *       wheel motors in this order
+     */
+    static void addRobot(ControlCenter *control, const std::string &name,
+                         const Vector &pos, scene *s) {
+      const double length = 0.6, width = 0.4, radius = 0.12;
+      NodeId chassis = addPrimitive(control, name + "_chassis", NODE_TYPE_BOX,
+                                    pos, Vector(length, width, 0.15), 10.0,
+                                    true);
+      s->dynamicNodes.push_back(chassis);
+      // cylinders are aligned with the z axis
+      Quaternion wheelRot = eulerToQuaternion(Vector(90, 0, 0));
+      unsigned long motors[4];
+      for(int i=0; i<4; ++i) {
+        double side = (i & 1) ? -1.0 : 1.0;
+        Vector wheelPos = pos + Vector((i < 2 ? 0.5 : -0.5) * length,
+                                       side * (0.5 * width + 0.06),
+                                       -0.05);
+        char wheelName[16];
+        snprintf(wheelName, sizeof(wheelName), "_wheel%d", i);
+        NodeId wheel = addPrimitive(control, name + wheelName,
+                                    NODE_TYPE_CYLINDER, wheelPos,
+                                    Vector(radius, 0.08, 0), 1.0, true,
+                                    wheelRot);
+        s->dynamicNodes.push_back(wheel);
+
+        JointData joint(name + wheelName + "_joint", JOINT_TYPE_HINGE,
+                        chassis, wheel);
+        joint.anchor = wheelPos;
+        joint.anchorPos = ANCHOR_CUSTOM;
+        joint.axis1 = Vector(0, 1, 0);
+        unsigned long jointId = control->joints->addJoint(&joint, true);
+
+        MotorData motor(name + wheelName + "_motor", MOTOR_TYPE_VELOCITY);
+        motor.jointIndex = jointId;
+        motor.maxEffort = 20.0;
+        motor.maxSpeed = 10.0;
+        motors[i] = control->motors->addMotor(&motor, true);
+      }
+      s->wheelMotors.push_back(motors[0]);
+      s->wheelMotors.push_back(motors[2]);
+      s->wheelMotors.push_back(motors[1]);
+      s->wheelMotors.push_back(motors[3]);
+    }
+
+    // a pile of boxes that is dropped onto the ground
+    static void createBoxPile(ControlCenter *control, Lcg *rng, scene *s) {
+      addGround(control);
+      for(int i=0; i<512; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "box%d", i);
+        Vector pos(rng->uniform(-1.0, 1.0), rng->uniform(-1.0, 1.0),
+                   0.5 + i * 0.12);
+        Vector ext(rng->uniform(0.1, 0.3), rng->uniform(0.1, 0.3),
+                   rng->uniform(0.1, 0.3));
+        s->dynamicNodes.push_back(addPrimitive(control, name, NODE_TYPE_BOX,
+                                               pos, ext, 1.0, true));
+      }
+    }
+
+    // a heightfield with rolling hills and a robot driving over it
+    static void createTerrain(ControlCenter *control, Lcg *rng, scene *s) {
+      NodeData node("terrain", Vector(0, 0, 0));
+      node.physicMode = NODE_TYPE_TERRAIN;
+      node.terrain = new terrainStruct;
+      node.terrain->name = "terrain";
+      node.terrain->width = 257;
+      node.terrain->height = 257;
+      node.terrain->targetWidth = 64.0;
+      node.terrain->targetHeight = 64.0;
+      node.terrain->scale = 2.0;
+      // the SimNode frees the pixel data with the terrain
+      node.terrain->pixelData = (double*)calloc(257*257, sizeof(double));
+      double phaseX = rng->uniform(0, 2*M_PI), phaseY = rng->uniform(0, 2*M_PI);
+      for(int y=0; y<257; ++y) {
+        for(int x=0; x<257; ++x) {
+          double h = 0.5 + 0.25*sin(x*0.11 + phaseX) + 0.25*cos(y*0.07 + phaseY);
+          node.terrain->pixelData[y*257+x] = h + rng->uniform(-0.02, 0.02);
+        }
+      }
+      control->nodes->addNode(&node, true, false);
+      addRobot(control, "rover", Vector(0, 0, 2.6), s);
+      for(size_t i=0; i<s->wheelMotors.size(); ++i) {
+        control->motors->setMotorValue(s->wheelMotors[i], 3.0);
+      }
+    }
+
+    // a 64 beam rotating laser scanner between randomly placed obstacles
+    static void createLaserScene(ControlCenter *control, Lcg *rng, scene *s) {
+      addGround(control);
+      for(int i=0; i<200; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "obstacle%d", i);
+        double angle = rng->uniform(0, 2*M_PI);
+        double distance = rng->uniform(2.0, 20.0);
+        Vector pos(cos(angle)*distance, sin(angle)*distance, 1.0);
+        NodeType type = (i & 1) ? NODE_TYPE_BOX : NODE_TYPE_CYLINDER;
+        Vector ext = type == NODE_TYPE_BOX ?
+          Vector(rng->uniform(0.2, 1.0), rng->uniform(0.2, 1.0), 2.0) :
+          Vector(rng->uniform(0.1, 0.5), 2.0, 0);
+        addPrimitive(control, name, type, pos, ext, 0, false);
+      }
+      NodeId base = addPrimitive(control, "scanner", NODE_TYPE_BOX,
+                                 Vector(0, 0, 0.5), Vector(0.2, 0.2, 0.2),
+                                 2.0, true);
+      s->dynamicNodes.push_back(base);
+
+      configmaps::ConfigMap config;
+      config["type"] = "RotatingRaySensor";
+      config["name"] = "scanner_laser";
+      config["attached_node"] = (unsigned long)base;
+      config["bands"] = 64;
+      config["lasers"] = 64;
+      config["opening_width"] = 2*M_PI;
+      config["opening_height"] = 0.5;
+      config["max_distance"] = 30.0;
+      config["horizontal_resolution"] = 0.01;
+      config["rate"] = 10;
+      control->sensors->createAndAddSensor(&config);
+    }
+
+    // ten robots that exchange their state over the DataBroker
+    static void createRobots(ControlCenter *control, Lcg *rng, scene *s,
+                             RobotTraffic *traffic) {
+      addGround(control);
+      for(int i=0; i<10; ++i) {
+        char name[16];
+        snprintf(name, sizeof(name), "robot%d", i);
+        Vector pos((i % 5) * 2.0 - 4.0 + rng->uniform(-0.2, 0.2),
+                   (i / 5) * 2.0 - 1.0 + rng->uniform(-0.2, 0.2), 0.2);
+        size_t first = s->wheelMotors.size();
+        addRobot(control, name, pos, s);
+        traffic->addRobot(s->dynamicNodes[s->dynamicNodes.size()-5],
+                          s->wheelMotors[first], s->wheelMotors[first+2]);
+      }
+      traffic->connect();
+    }
+
+    struct benchmark_options {
+      int steps, warmup;
+      std::string trace;
+    };
+
+    // prints the phases of the step profiler sorted by their creation
+    static void printProfile(const data_broker::DataPackage &package) {
+      for(size_t i=1; i+2<package.size(); i+=3) {
+        std::string name = package[i].getName();
+        name = name.substr(0, name.rfind('/'));
+        fprintf(stdout, "    %-26s p50 %9.4f ms  p99 %9.4f ms  max %9.4f ms\n",
+                name.c_str(), package[i].d, package[i+1].d, package[i+2].d);
+      }
+    }
+
+    static void runScene(ControlCenter *control, const std::string &name,
+                         bool fastStep, const benchmark_options &options,
+                         ProfileReceiver *profile) {
+      SimulatorInterface *sim = control->sim;
+      Lcg rng(BENCHMARK_SEED);
+      RobotTraffic traffic(control);
+      scene s;
+
+      control->cfg->setPropertyValue("Simulator", "faststep", "value",
+                                     fastStep);
+      sim->newWorld(true);
+      if(name == "boxes") createBoxPile(control, &rng, &s);
+      else if(name == "terrain") createTerrain(control, &rng, &s);
+      else if(name == "laser") createLaserScene(control, &rng, &s);
+      else createRobots(control, &rng, &s, &traffic);
+
+      for(int i=0; i<options.warmup; ++i) sim->step();
+
+      // the profiler publishes its statistics after the last step
+      control->cfg->setPropertyValue("Simulator", "profile window", "value",
+                                     options.steps);
+      control->cfg->setPropertyValue("Simulator", "profile trace file",
+                                     "value", options.trace);
+      control->cfg->setPropertyValue("Simulator", "profile step", "value",
+                                     true);
+      profile->package.clear();
+
+      unsigned long allocations = numAllocations.load();
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      for(int i=0; i<options.steps; ++i) sim->step();
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      allocations = numAllocations.load() - allocations;
+
+      control->cfg->setPropertyValue("Simulator", "profile step", "value",
+                                     false);
+      control->cfg->setPropertyValue("Simulator", "profile trace file",
+                                     "value", "");
+      // applies the settings and closes the trace
+      sim->step();
+
+      double checksum = 0.0;
+      for(size_t i=0; i<s.dynamicNodes.size(); ++i) {
+        Vector pos = control->nodes->getPosition(s.dynamicNodes[i]);
+        checksum += pos.x() + pos.y() + pos.z();
+      }
+
+      fprintf(stdout, "%-8s faststep %-3s  %10.1f steps/s  %8.1f allocs/step"
+              "  checksum %.9g\n", name.c_str(), fastStep ? "on" : "off",
+              options.steps / seconds, (double)allocations / options.steps,
+              checksum);
+      printProfile(profile->package);
+      traffic.disconnect();
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
+
+int main(int argc, char **argv) {
+  using namespace mars;
+  static struct option long_options[] = {
+    {"scene", required_argument, 0, 's'},
+    {"steps", required_argument, 0, 'n'},
+    {"warmup", required_argument, 0, 'w'},
+    {"faststep", required_argument, 0, 'f'},
+    {"step-threads", required_argument, 0, 't'},
+    {"trace", required_argument, 0, 'o'},
+    {0, 0, 0, 0}
+  };
+  std::string sceneName = "all", fastStepMode = "both";
+  int stepThreads = 0;
+  sim::benchmark_options options;
+  options.steps = 2000;
+  options.warmup = 200;
+  int c, option_index = 0;
+  while((c = getopt_long(argc, argv, "s:n:w:f:t:o:", long_options,
+                         &option_index)) != -1) {
+    switch(c) {
+    case 's': sceneName = optarg; break;
+    case 'n': options.steps = atoi(optarg); break;
+    case 'w': options.warmup = atoi(optarg); break;
+    case 'f': fastStepMode = optarg; break;
+    case 't': stepThreads = atoi(optarg); break;
+    case 'o': options.trace = optarg; break;
+    default:
+      fprintf(stderr, "usage: %s [-s scene] [-n steps] [-w warmup] "
+              "[-f both|on|off] [-t step threads] [-o trace file]\n", argv[0]);
+      return 1;
+    }
+  }
+  if(options.steps < 1) options.steps = 1;
+
+  std::vector<std::string> scenes;
+  if(sceneName == "all") {
+    scenes.push_back("boxes");
+    scenes.push_back("terrain");
+    scenes.push_back("laser");
+    scenes.push_back("robots");
+  } else if(sceneName == "boxes" || sceneName == "terrain" ||
+            sceneName == "laser" || sceneName == "robots") {
+    scenes.push_back(sceneName);
+  } else {
+    fprintf(stderr, "unknown scene: %s\n", sceneName.c_str());
+    return 1;
+  }
+
+  lib_manager::LibManager *libManager = new lib_manager::LibManager();
+  libManager->loadLibrary("cfg_manager");
+  libManager->loadLibrary("data_broker");
+  libManager->loadLibrary("mars_sim");
+  interfaces::SimulatorInterface *marsSim;
+  marsSim = libManager->getLibraryAs<interfaces::SimulatorInterface>("mars_sim");
+  if(!marsSim) {
+    fprintf(stderr, "mars_sim_benchmark: could not load mars_sim\n");
+    return 2;
+  }
+  interfaces::ControlCenter *control = marsSim->getControlCenter();
+  if(!control->cfg || !control->dataBroker) {
+    fprintf(stderr, "mars_sim_benchmark: cfg_manager and data_broker are required\n");
+    return 2;
+  }
+  // creates the managers and the physics without starting the sim thread
+  marsSim->runSimulation(false);
+  control->cfg->setPropertyValue("Simulator", "step threads", "value",
+                                 stepThreads);
+
+  sim::ProfileReceiver profile;
+  control->dataBroker->registerSyncReceiver(&profile, "mars_sim",
+                                            "stepProfile");
+  for(size_t i=0; i<scenes.size(); ++i) {
+    if(fastStepMode != "on") {
+      sim::runScene(control, scenes[i], false, options, &profile);
+    }
+    if(fastStepMode != "off") {
+      sim::runScene(control, scenes[i], true, options, &profile);
+    }
+  }
+  control->dataBroker->unregisterSyncReceiver(&profile, "mars_sim",
+                                              "stepProfile");
+
+  marsSim->newWorld(true);
+  marsSim->exitMars();
+  libManager->releaseLibrary("mars_sim");
+  libManager->releaseLibrary("data_broker");
+  libManager->releaseLibrary("cfg_manager");
+  delete libManager;
+  return 0;
+}
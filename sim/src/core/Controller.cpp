@@ -26,6 +26,8 @@
  */
 
 #define PACKAGE_SIZE 2048
+// maximum time to wait for a lock step client in ms
+#define SHM_LOCK_STEP_TIMEOUT 1000
 
 
 #include "Controller.h"
@@ -86,6 +88,8 @@ namespace mars {
       dy = 0;
       dylibController = 0;
       count_ms = 0;
+      shm_step = 0;
+      shm_time = 0;
 #ifdef WIN32
       if(!Controller::sock_init) {
         /* Initialisiere TCP f�r Windows ("winsock") */
@@ -409,6 +413,9 @@ namespace mars {
               (*jter)->setControlValue((sReal)*pt_motors);
           }
         }
+        else if(shm.isOpen()) {
+          updateSharedMemory();
+        }
         else if(connected) {
           // here we can communicate
 #ifdef WIN32
@@ -773,6 +780,71 @@ namespace mars {
       }
     }
 
+    /**
+     * \brief Publishes the sensor values as a new frame and applies the
+     * newest motor values of the client.
+     *
+     * post:
+     *     - in lock step mode the motor values are the answer to this frame
+     *       unless the client did not answer in time
+     */
+    void Controller::updateSharedMemory(void) {
+      std::vector<BaseSensor*>::iterator iter;
+      std::vector<SimMotor*>::iterator jter;
+      sReal *sens_val;
+      unsigned int flags = 0;
+      int count_val;
+
+      shm_sensors.clear();
+      for(iter = sensors.begin(); iter != sensors.end(); iter++) {
+        count_val = (*iter)->getSensorData(&sens_val);
+        shm_sensors.insert(shm_sensors.end(), sens_val, sens_val+count_val);
+        free(sens_val);
+      }
+      shm_time += sController.rate;
+      shm.pushFrame(++shm_step, shm_time, shm_sensors);
+      if(shm.isLockStep()) {
+        shm.waitCommand(shm_step, SHM_LOCK_STEP_TIMEOUT);
+      }
+
+      if(!shm.readCommand(&shm_motors, &flags)) return;
+      if(flags & CONTROLLER_SHM_RESET) {
+        control->sim->resetSim();
+        return;
+      }
+      size_t i = 0;
+      for(jter = motors.begin(); jter != motors.end() && i < shm_motors.size();
+          jter++, i++) {
+        (*jter)->setControlValue((sReal)shm_motors[i]);
+      }
+    }
+
+    /**
+     * \brief Creates the shared memory segment of the controller.
+     *
+     * The number of sensor values per frame is taken from the current
+     * sensor data. The socket connection is closed and not reopened.
+     */
+    bool Controller::setSharedMemory(const std::string &name, bool lockStep) {
+      std::vector<BaseSensor*>::iterator iter;
+      sReal *sens_val;
+      unsigned int numSensors = 0;
+
+      for(iter = sensors.begin(); iter != sensors.end(); iter++) {
+        numSensors += (*iter)->getSensorData(&sens_val);
+        free(sens_val);
+      }
+      if(!shm.open(name, numSensors, (unsigned int)motors.size(), lockStep)) {
+        return false;
+      }
+      auto_connect = false;
+      disconnect();
+      connected = 0;
+      shm_step = 0;
+      shm_time = 0;
+      return true;
+    }
+
     int Controller::getSReal(const char *data, sReal *value) const {
       size_t d=0, i=0;
       const size_t BUFFER_SIZE = 50;
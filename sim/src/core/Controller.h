@@ -33,6 +33,7 @@
 #endif
 
 #include "SimMotor.h"
+#include "ControllerShm.h"
 
 #ifdef WIN32
 #include <windows.h>
@@ -91,6 +92,12 @@ namespace mars {
       int getPort(void) const;
       void connect(void);
       void disconnect(void);
+      /**
+       * Exchanges the values with a local client over the shared memory
+       * segment with the given name instead of the socket. In lock step
+       * mode every controller update waits for the answer of the client.
+       */
+      bool setSharedMemory(const std::string &name, bool lockStep);
 
 #ifdef WIN32
       static bool sock_init;
@@ -120,12 +127,17 @@ namespace mars {
       std::vector<SimMotor*> motors;
       std::vector<interfaces::BaseSensor*> sensors;
       std::vector<interfaces::NodeData*> sNodes;
+      ControllerShm shm;
+      unsigned long shm_step;
+      double shm_time;
+      std::vector<double> shm_sensors, shm_motors;
       int initServer(int port);
       void getClient(void);
       int openClient(const char *host, int port);
       int connectClient(void);
       int getSReal(const char *data, interfaces::sReal *value) const;
       int getChar(const char *data, char *c) const;
+      void updateSharedMemory(void);
       void run(void);
     };
 
@@ -350,6 +350,9 @@ namespace mars {
       newController = new Controller(controller.rate, vmotor, vsensor, nodes,
                                      control, std_port);
       newController->setDylibPath(controller.dylib_path);
+      if(!controller.shm_name.empty()) {
+        newController->setSharedMemory(controller.shm_name, controller.lock_step);
+      }
       newController->setID(id);
       iMutex.lock();
       simController[id] = newController;
@@ -0,0 +1,237 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file ControllerShm.cpp
+ * \brief "ControllerShm" is the simulation side of the shared memory
+ *        transport of a Controller.
+ *
+ */
+
+#include "ControllerShm.h"
+
+#include <mars/interfaces/Logging.hpp>
+#include <mars/interfaces/sim/ControlCenter.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+// the longest time a command is read while the client writes it
+#define CONTROLLER_SHM_READ_TIMEOUT_US 1000
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mars {
+  namespace sim {
+
+    using namespace interfaces;
+
+    ControllerShm::ControllerShm(void) : fd(-1), size(0), header(0),
+                                         lastCommandSeq(0) {
+    }
+
+    ControllerShm::~ControllerShm(void) {
+      close();
+    }
+
+    /**
+     * \brief Creates the shared memory segment.
+     *
+     * post:
+     *     - a stale segment with the same name is replaced
+     *     - returns false if the segment could not be created
+     */
+    bool ControllerShm::open(const std::string &name, unsigned int numSensors,
+                             unsigned int numMotors, bool lockStep,
+                             unsigned int numFrames) {
+      close();
+#ifdef WIN32
+      LOG_ERROR("ControllerShm: shared memory transport is not supported on this platform");
+      return false;
+#else
+      this->name = (!name.empty() && name[0] == '/') ? name : "/" + name;
+      if(numFrames < 2) numFrames = 2;
+
+      shm_unlink(this->name.c_str());
+      fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+      if(fd < 0) {
+        LOG_ERROR("ControllerShm: cannot create shared memory \"%s\": %s",
+                  this->name.c_str(), strerror(errno));
+        return false;
+      }
+      size = controllerShmSize(numSensors, numMotors, numFrames);
+      void *mem = MAP_FAILED;
+      if(ftruncate(fd, size) == 0) {
+        mem = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      }
+      if(mem == MAP_FAILED) {
+        LOG_ERROR("ControllerShm: cannot map shared memory \"%s\": %s",
+                  this->name.c_str(), strerror(errno));
+        ::close(fd);
+        fd = -1;
+        shm_unlink(this->name.c_str());
+        return false;
+      }
+
+      // the new segment is zero filled, the magic is written last so that a
+      // client never sees an incomplete header
+      header = (controller_shm_header*)mem;
+      header->version = CONTROLLER_SHM_VERSION;
+      header->num_sensors = numSensors;
+      header->num_motors = numMotors;
+      header->num_frames = numFrames;
+      header->lock_step = lockStep;
+      lastCommandSeq = 0;
+      std::atomic_thread_fence(std::memory_order_release);
+      header->magic = CONTROLLER_SHM_MAGIC;
+      LOG_INFO("ControllerShm: created \"%s\" with %u sensor and %u motor values",
+               this->name.c_str(), numSensors, numMotors);
+      return true;
+#endif
+    }
+
+    void ControllerShm::close(void) {
+#ifndef WIN32
+      if(header) {
+        // tell a waiting client that the segment is gone
+        header->magic = 0;
+        header->frame_seq.fetch_add(1);
+        controllerShmWake(&header->frame_seq);
+        munmap(header, size);
+        header = 0;
+      }
+      if(fd >= 0) {
+        ::close(fd);
+        fd = -1;
+        shm_unlink(name.c_str());
+      }
+#endif
+    }
+
+    void ControllerShm::pushFrame(unsigned long step, double time_ms,
+                                  const std::vector<double> &values) {
+      if(!header) return;
+      uint32_t head = header->frame_head.load(std::memory_order_relaxed);
+      uint32_t tail = header->frame_tail.load(std::memory_order_acquire);
+      if(head - tail >= header->num_frames) {
+        header->dropped_frames.fetch_add(1, std::memory_order_relaxed);
+      }
+      else {
+        controller_shm_frame *frame = controllerShmFrame(header, head);
+        double *frameValues = controllerShmValues(frame);
+        size_t num = values.size() < header->num_sensors ? values.size() : header->num_sensors;
+        frame->step = step;
+        frame->time_ms = time_ms;
+        if(num) memcpy(frameValues, &values[0], num*sizeof(double));
+        for(size_t i=num; i<header->num_sensors; ++i) frameValues[i] = 0.0;
+        header->frame_head.store(head+1, std::memory_order_release);
+      }
+      header->frame_seq.fetch_add(1);
+      if(header->frame_waiters.load()) {
+        controllerShmWake(&header->frame_seq);
+      }
+    }
+
+    bool ControllerShm::waitCommand(unsigned long step, long timeout_ms) {
+      if(!header) return false;
+      std::chrono::steady_clock::time_point deadline;
+      deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+      while(header->client_attached.load()) {
+        uint32_t seq = header->command_seq.load();
+        // the step is written under the sequence lock of the mailbox
+        uint32_t lock = header->command_lock.load(std::memory_order_acquire);
+        uint64_t commandStep = header->command_step;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(!(lock & 1) && lock == header->command_lock.load(std::memory_order_relaxed) &&
+           commandStep >= step) {
+          return true;
+        }
+
+        long remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if(remaining <= 0) {
+          LOG_WARN("ControllerShm: no answer of the client on \"%s\", continue without lock step",
+                   name.c_str());
+          header->client_attached.store(0);
+          return false;
+        }
+        // announce the waiter before the check to not miss a wake up
+        header->command_waiters.store(1);
+        if(header->command_seq.load() == seq) {
+          controllerShmWait(&header->command_seq, seq, remaining);
+        }
+        header->command_waiters.store(0);
+      }
+      return false;
+    }
+
+    bool ControllerShm::readCommand(std::vector<double> *values,
+                                    unsigned int *flags) {
+      if(!header) return false;
+      uint32_t seq = header->command_seq.load(std::memory_order_acquire);
+      if(seq == lastCommandSeq) return false;
+      lastCommandSeq = seq;
+
+      const double *command = controllerShmCommand(header);
+      std::chrono::steady_clock::time_point deadline;
+      deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(CONTROLLER_SHM_READ_TIMEOUT_US);
+      commandBuffer.resize(header->num_motors);
+      unsigned int commandFlags;
+      while(true) {
+        uint32_t lock = header->command_lock.load(std::memory_order_acquire);
+        if(!(lock & 1)) {
+          if(!commandBuffer.empty()) {
+            memcpy(&commandBuffer[0], command, commandBuffer.size()*sizeof(double));
+          }
+          commandFlags = header->command_flags;
+          std::atomic_thread_fence(std::memory_order_acquire);
+          if(lock == header->command_lock.load(std::memory_order_relaxed)) break;
+        }
+        if(std::chrono::steady_clock::now() >= deadline) {
+          // the client stalled or died while writing, keep the previous
+          // command, regard the client as detached like waitCommand does
+          // and try again with the next call
+          if(header->client_attached.exchange(0)) {
+            LOG_WARN("ControllerShm: command on \"%s\" is locked, keep the previous command",
+                     name.c_str());
+          }
+          lastCommandSeq = seq - 1;
+          return false;
+        }
+        std::this_thread::yield();
+      }
+      values->swap(commandBuffer);
+      *flags = commandFlags;
+      // a client that timed out in lock step is back
+      if(header->lock_step && !header->client_attached.load()) {
+        header->client_attached.store(1);
+      }
+      return true;
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
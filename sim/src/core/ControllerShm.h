@@ -0,0 +1,92 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+ /**
+ * \file ControllerShm.h
+ * \brief "ControllerShm" is the simulation side of the shared memory
+ *        transport of a Controller.
+ *
+ */
+
+#ifndef CONTROLLER_SHM_H
+#define CONTROLLER_SHM_H
+
+#ifdef _PRINT_HEADER_
+  #warning "ControllerShm.h"
+#endif
+
+#include <mars/interfaces/sim/ControllerSharedMemory.h>
+
+#include <string>
+#include <vector>
+
+namespace mars {
+  namespace sim {
+
+    /**
+     * Creates the shared memory segment described in
+     * ControllerSharedMemory.h, publishes the sensor frames and reads the
+     * commands of the client. All methods are called by the physics thread
+     * and never block, except waitCommand() in lock step mode.
+     */
+    class ControllerShm {
+    public:
+      ControllerShm(void);
+      ~ControllerShm(void);
+
+      bool open(const std::string &name, unsigned int numSensors,
+                unsigned int numMotors, bool lockStep,
+                unsigned int numFrames = 64);
+      void close(void);
+      bool isOpen(void) const {return header != 0;}
+      bool isLockStep(void) const {return header && header->lock_step;}
+
+      /**
+       * Appends a frame to the sensor ring and wakes the client if it
+       * sleeps. Missing values are set to zero, surplus values are cut.
+       */
+      void pushFrame(unsigned long step, double time_ms,
+                     const std::vector<double> &values);
+      /**
+       * Waits until the client answered the given step, at most timeout_ms.
+       * Returns false on a timeout, the client is then regarded as
+       * detached until it sends the next command.
+       */
+      bool waitCommand(unsigned long step, long timeout_ms);
+      /**
+       * Copies the newest command if the client sent one since the last
+       * call. Returns false otherwise, or if the client does not finish
+       * writing the command in time. values is kept in that case.
+       */
+      bool readCommand(std::vector<double> *values, unsigned int *flags);
+
+    private:
+      std::string name;
+      int fd;
+      size_t size;
+      interfaces::controller_shm_header *header;
+      uint32_t lastCommandSeq;
+      std::vector<double> commandBuffer;
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif  // CONTROLLER_SHM_H
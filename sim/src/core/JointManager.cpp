@@ -61,6 +61,7 @@ namespace mars {
     JointManager::JointManager(ControlCenter *c) {
       control = c;
       next_joint_id = 1;
+      jointsChanged = true;
     }
 
     unsigned long JointManager::addJoint(JointData *jointS, bool reload) {
@@ -137,6 +138,7 @@ namespace mars {
         //    newJoint->setSJoint(*jointS);
         newJoint->setPhysicalJoint(newJointInterface);
         simJoints[jointS->index] = newJoint;
+        jointsChanged = true;
         iMutex.unlock();
         control->sim->sceneHasChanged(false);
         return jointS->index;
@@ -211,6 +213,7 @@ namespace mars {
       if (iter != simJoints.end()) {
         tmpJoint = iter->second;
         simJoints.erase(iter);
+        jointsChanged = true;
       }
 
       control->motors->removeJointFromMotors(index);
@@ -266,12 +269,44 @@ namespace mars {
         addJoint(&(*iter), true);
     }
 
+    /**
+     *\brief Updates the joints from the physics. The state of all joints is
+     * read with one lock of the physics, the joint feedback only for the
+     * joints whose forces and torques are used.
+     */
     void JointManager::updateJoints(sReal calc_ms) {
       MutexLocker locker(&iMutex);
+      if(jointsChanged) {
+        rebuildJointStates();
+      }
+      for(size_t i=0; i<stateJoints.size(); ++i) {
+        jointStates.feedback[i] = stateJoints[i]->needsFeedback();
+      }
+      control->sim->getPhysics()->getJointStates(&jointStates);
+      for(size_t i=0; i<stateJoints.size(); ++i) {
+        stateJoints[i]->update(calc_ms, jointStates, i);
+      }
+    }
+
+    /**
+     *\brief Collects the joints that have a physical representation into
+     * the packed state arrays.
+     *
+     * pre:
+     *     - the iMutex is locked
+     */
+    void JointManager::rebuildJointStates(void) {
       map<unsigned long, std::shared_ptr<SimJoint>>::iterator iter;
+      stateJoints.clear();
+      jointStates.joints.clear();
       for(iter = simJoints.begin(); iter != simJoints.end(); iter++) {
-        iter->second->update(calc_ms);
+        JointInterface *joint = iter->second->getPhysicalJoint();
+        if(!joint) continue;
+        stateJoints.push_back(iter->second.get());
+        jointStates.joints.push_back(joint);
       }
+      jointStates.resize();
+      jointsChanged = false;
     }
 
     void JointManager::clearAllJoints(bool clear_all) {
@@ -284,7 +319,9 @@ namespace mars {
         simJoints.begin()->second.reset();
         simJoints.erase(simJoints.begin());
       }
+      jointsChanged = true;
       control->sim->sceneHasChanged(false);
+      snapshots.clear();
 
       next_joint_id = 1;
     }
@@ -587,5 +624,36 @@ namespace mars {
       }
     }
 
+    void JointManager::saveState(unsigned long snapshotId) {
+      MutexLocker locker(&iMutex);
+      JointStates &states = snapshots[snapshotId];
+      states.resize(simJoints.size());
+      size_t i = 0;
+      map<unsigned long, std::shared_ptr<SimJoint>>::const_iterator iter;
+      for(iter = simJoints.begin(); iter != simJoints.end(); ++iter, ++i) {
+        states[i].first = iter->first;
+        iter->second->saveState(&states[i].second);
+      }
+    }
+
+    bool JointManager::restoreState(unsigned long snapshotId) {
+      MutexLocker locker(&iMutex);
+      map<unsigned long, JointStates>::const_iterator it;
+      it = snapshots.find(snapshotId);
+      if(it == snapshots.end()) return false;
+      map<unsigned long, std::shared_ptr<SimJoint>>::const_iterator iter;
+      for(JointStates::const_iterator state = it->second.begin();
+          state != it->second.end(); ++state) {
+        iter = simJoints.find(state->first);
+        if(iter != simJoints.end()) iter->second->restoreState(state->second);
+      }
+      return true;
+    }
+
+    void JointManager::removeState(unsigned long snapshotId) {
+      MutexLocker locker(&iMutex);
+      snapshots.erase(snapshotId);
+    }
+
   } // end of namespace sim
 } // end of namespace mars
@@ -33,6 +33,8 @@
   #warning "JointManager.h"
 #endif
 
+#include "SimJoint.h"
+
 #include <mars/interfaces/sim/ControlCenter.h>
 #include <mars/interfaces/sim/JointManagerInterface.h>
 #include <mars/utils/Mutex.h>
@@ -93,15 +95,26 @@ namespace mars {
       virtual void setHighStop2(unsigned long id, interfaces::sReal highStop2);
       virtual void edit(interfaces::JointId id, const std::string &key,
                         const std::string &value);
+      virtual void saveState(unsigned long snapshotId);
+      virtual bool restoreState(unsigned long snapshotId);
+      virtual void removeState(unsigned long snapshotId);
 
     private:
+      typedef std::vector<std::pair<interfaces::JointId, SimJoint::jointState> > JointStates;
       unsigned long next_joint_id;
       std::map<unsigned long, std::shared_ptr<SimJoint>> simJoints;
       std::list<interfaces::JointData> simJointsReload;
+      std::map<unsigned long, JointStates> snapshots;
+      // packed state of simJoints, read from the physics in one pass
+      // after every step; rebuilt if simJoints changes
+      interfaces::jointStateArrays jointStates;
+      std::vector<SimJoint*> stateJoints;
+      bool jointsChanged;
       interfaces::ControlCenter *control;
       mutable utils::Mutex iMutex;
       interfaces::JointManagerInterface* getJointInterface(unsigned long node_id);
       std::list<interfaces::JointData>::iterator getReloadJoint(unsigned long id);
+      void rebuildJointStates(void);
 
     };
 
@@ -60,6 +60,7 @@ namespace mars {
     {
       control = c;
       next_motor_id = 1;
+      motorsChanged = true;
     }
 
 
@@ -96,6 +97,7 @@ namespace mars {
       newMotor->setSMotor(*motorS);
       iMutex.lock();
       simMotors[newMotor->getIndex()] = newMotor;
+      motorsChanged = true;
       iMutex.unlock();
       control->sim->sceneHasChanged(false);
 
@@ -226,6 +228,7 @@ namespace mars {
       if (iter != simMotors.end()) {
         tmpMotor = iter->second;
         simMotors.erase(iter);
+        motorsChanged = true;
         if (tmpMotor)
           delete tmpMotor;
       }
@@ -432,7 +435,9 @@ namespace mars {
       for(iter = simMotors.begin(); iter != simMotors.end(); iter++)
         delete iter->second;
       simMotors.clear();
+      motorsChanged = true;
       mimicmotors.clear();
+      snapshots.clear();
       if(clear_all) simMotorsReload.clear();
       next_motor_id = 1;
     }
@@ -465,10 +470,18 @@ namespace mars {
      * \param calc_ms The timing value in miliseconds.
      */
     void MotorManager::updateMotors(double calc_ms) {
-      map<unsigned long, SimMotor*>::iterator iter;
       MutexLocker locker(&iMutex);
-      for(iter = simMotors.begin(); iter != simMotors.end(); iter++)
-        iter->second->update(calc_ms);
+      if(motorsChanged) {
+        map<unsigned long, SimMotor*>::iterator iter;
+        motorBank.clear();
+        for(iter = simMotors.begin(); iter != simMotors.end(); iter++)
+          motorBank.push_back(iter->second);
+        motorsChanged = false;
+      }
+      // the order of the map is kept, a mimic motor gets the value of its
+      // parent in the same step if it has a higher id
+      for(size_t i=0; i<motorBank.size(); ++i)
+        motorBank[i]->update(calc_ms);
     }
 
 
@@ -588,5 +601,41 @@ namespace mars {
       }
     }
 
+    void MotorManager::saveState(unsigned long snapshotId) {
+      MutexLocker locker(&iMutex);
+      MotorStates &states = snapshots[snapshotId];
+      states.resize(simMotors.size());
+      size_t i = 0;
+      map<unsigned long, SimMotor*>::const_iterator iter;
+      for(iter = simMotors.begin(); iter != simMotors.end(); ++iter, ++i) {
+        states[i].first = iter->first;
+        iter->second->saveState(&states[i].second);
+      }
+    }
+
+    /**
+     * \brief Sets the motors and their controllers back to the snapshot.
+     * The joints have to be restored before, since the motors pass their
+     * restored control values to the joints.
+     */
+    bool MotorManager::restoreState(unsigned long snapshotId) {
+      MutexLocker locker(&iMutex);
+      map<unsigned long, MotorStates>::const_iterator it;
+      it = snapshots.find(snapshotId);
+      if(it == snapshots.end()) return false;
+      map<unsigned long, SimMotor*>::const_iterator iter;
+      for(MotorStates::const_iterator state = it->second.begin();
+          state != it->second.end(); ++state) {
+        iter = simMotors.find(state->first);
+        if(iter != simMotors.end()) iter->second->restoreState(state->second);
+      }
+      return true;
+    }
+
+    void MotorManager::removeState(unsigned long snapshotId) {
+      MutexLocker locker(&iMutex);
+      snapshots.erase(snapshotId);
+    }
+
   } // end of namespace sim
 } // end of namespace mars
@@ -38,6 +38,8 @@
   #warning "MotorManager.h"
 #endif
 
+#include "SimMotor.h"
+
 #include <mars/interfaces/sim/ControlCenter.h>
 #include <mars/interfaces/sim/MotorManagerInterface.h>
 #include <mars/utils/Mutex.h>
@@ -318,17 +320,30 @@ namespace mars {
                                       interfaces::sReal pos);
       virtual void edit(interfaces::MotorId id, const std::string &key,
                         const std::string &value);
+      virtual void saveState(unsigned long snapshotId);
+      virtual bool restoreState(unsigned long snapshotId);
+      virtual void removeState(unsigned long snapshotId);
 
     private:
+      typedef std::vector<std::pair<interfaces::MotorId, SimMotor::motorState> > MotorStates;
+
       //! the id of the next motor that is added to the simulation
       unsigned long next_motor_id;
 
       //! a container for all motors currently present in the simulation
       std::map<unsigned long, SimMotor*> simMotors;
 
+      //! the motors of simMotors in the same order, walked in every update;
+      //! rebuilt if simMotors changes
+      std::vector<SimMotor*> motorBank;
+      bool motorsChanged;
+
       //! a containter for all motors that are reloaded after a reset of the simulation
       std::list<interfaces::MotorData> simMotorsReload;
 
+      //! the motor and controller states of the snapshots by snapshot id
+      std::map<unsigned long, MotorStates> snapshots;
+
       //! a pointer to the control center
       interfaces::ControlCenter *control;
 
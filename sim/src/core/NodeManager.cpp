@@ -36,6 +36,7 @@
 #include <mars/interfaces/graphics/GraphicsManagerInterface.h>
 #include <mars/interfaces/terrainStruct.h>
 #include <mars/interfaces/Logging.hpp>
+#include <mars/cfg_manager/CFGManagerInterface.h>
 
 #include <lib_manager/LibManager.hpp>
 
@@ -67,10 +68,21 @@ namespace mars {
                                                  next_node_id(1),
                                                  update_all_nodes(false),
                                                  visual_rep(1),
+                                                 dynNodesChanged(true),
+                                                 poseLayout(0),
+                                                 interpolatePoses(false),
+                                                 posesPending(false),
                                                  maxGroupID(0),
                                                  control(c),
                                                  libManager(theManager)
     {
+      if(control->cfg) {
+        // draw the poses between the last two steps, the graphics is one
+        // step behind the physics then
+        interpolatePoses = control->cfg->getOrCreateProperty("Graphics",
+                                                             "interpolate_poses",
+                                                             false).bValue;
+      }
       if(control->graphics) {
         GraphicsUpdateInterface *gui = static_cast<GraphicsUpdateInterface*>(this);
         control->graphics->addGraphicsUpdateInterface(gui);
@@ -107,6 +119,20 @@ namespace mars {
      */
     NodeId NodeManager::addNode(NodeData *nodeS, bool reload,
                                 bool loadGraphics) {
+      // tiled terrains are mapped instead of loaded into pixelData
+      if((nodeS->physicMode == NODE_TYPE_TERRAIN) && nodeS->terrain &&
+         !nodeS->terrain->tiles &&
+         TerrainTiles::isTileFile(nodeS->terrain->srcname)) {
+        std::shared_ptr<TerrainTiles> tiles(new TerrainTiles());
+        if(!tiles->open(nodeS->terrain->srcname)) {
+          LOG_ERROR("NodeManager::addNode: could not load tiled terrain");
+          return INVALID_ID;
+        }
+        nodeS->terrain->tiles = tiles;
+        nodeS->terrain->width = tiles->getWidth();
+        nodeS->terrain->height = tiles->getHeight();
+      }
+
       iMutex.lock();
       nodeS->index = next_node_id;
       next_node_id++;
@@ -115,7 +141,12 @@ namespace mars {
       if (!reload) {
         iMutex.lock();
         NodeData reloadNode = *nodeS;
-        if((nodeS->physicMode == NODE_TYPE_TERRAIN) && nodeS->terrain ) {
+        if((nodeS->physicMode == NODE_TYPE_TERRAIN) && nodeS->terrain &&
+           nodeS->terrain->tiles) {
+          // the reload node shares the mapping
+          reloadNode.terrain = new terrainStruct(*(nodeS->terrain));
+        }
+        else if((nodeS->physicMode == NODE_TYPE_TERRAIN) && nodeS->terrain ) {
           if(!control->loadCenter) {
             LOG_ERROR("NodeManager:: loadCenter is missing, can not create Node");
             iMutex.unlock();
@@ -187,7 +218,7 @@ namespace mars {
         control->loadCenter->loadMesh->getPhysicsFromMesh(nodeS);
       }
       if((nodeS->physicMode == NODE_TYPE_TERRAIN) && nodeS->terrain ) {
-        if(!nodeS->terrain->pixelData) {
+        if(!nodeS->terrain->pixelData && !nodeS->terrain->tiles) {
           if(!control->loadCenter) {
             LOG_ERROR("NodeManager:: loadCenter is missing, can not create Node");
             return INVALID_ID;
@@ -258,8 +289,10 @@ namespace mars {
         newNode->setInterface(newNodeInterface);
         iMutex.lock();
         simNodes[nodeS->index] = newNode;
-        if (nodeS->movable)
+        if (nodeS->movable) {
           simNodesDyn[nodeS->index] = newNode;
+          dynNodesChanged = true;
+        }
         iMutex.unlock();
         control->sim->sceneHasChanged(false);
         NodeId id;
@@ -326,6 +359,7 @@ namespace mars {
           simNodes[nodeS->index] = newNode;
           if (nodeS->movable) {
             simNodesDyn[nodeS->index] = newNode;
+            dynNodesChanged = true;
           }
           iMutex.unlock();
         }
@@ -691,6 +725,7 @@ namespace mars {
         iter = simNodesDyn.find(id);
         if (iter != simNodesDyn.end()) {
           simNodesDyn.erase(iter);
+          dynNodesChanged = true;
         }
       }
 
@@ -880,8 +915,10 @@ namespace mars {
       if (iter != simNodes.end()) {
         iter->second->addSensor(sensor);
         NodeMap::iterator kter = simNodesDyn.find(sensor->getAttachedNode());
-        if (kter == simNodesDyn.end())
+        if (kter == simNodesDyn.end()) {
           simNodesDyn[iter->first] = iter->second;
+          dynNodesChanged = true;
+        }
       }
       else
         {
@@ -1214,11 +1251,13 @@ namespace mars {
         if(tmp.terrain) {
           tmp.terrain = new(terrainStruct);
           *(tmp.terrain) = *(iter->terrain);
-          tmp.terrain->pixelData = (double*)calloc((tmp.terrain->width*
-                                                     tmp.terrain->height),
-                                                    sizeof(double));
-          memcpy(tmp.terrain->pixelData, iter->terrain->pixelData,
-                 (tmp.terrain->width*tmp.terrain->height)*sizeof(double));
+          if(iter->terrain->pixelData) {
+            tmp.terrain->pixelData = (double*)calloc((tmp.terrain->width*
+                                                       tmp.terrain->height),
+                                                      sizeof(double));
+            memcpy(tmp.terrain->pixelData, iter->terrain->pixelData,
+                   (tmp.terrain->width*tmp.terrain->height)*sizeof(double));
+          }
         }
         iMutex.unlock();
         addNode(&tmp, true, reloadGrahpics);
@@ -1284,10 +1323,69 @@ namespace mars {
      */
     void NodeManager::updateDynamicNodes(sReal calc_ms, bool physics_thread) {
       MutexLocker locker(&iMutex);
+      if(dynNodesChanged) {
+        rebuildDynamicStates();
+      }
+      // read the state of all nodes with one lock of the physics
+      control->sim->getPhysics()->getNodeStates(&dynStates);
+      for(size_t i=0; i<dynNodes.size(); ++i) {
+        dynNodes[i]->update(calc_ms, dynStates, i, physics_thread);
+        // the node may have corrected invalid values of the snapshot
+        dynNodes[i]->getDrawState(&dynDrawIDs[i], &dynDrawIDs2[i],
+                                  &dynStates.pos[i], &dynStates.rot[i],
+                                  &dynVisualPos[i], &dynVisualRot[i]);
+      }
+      publishPoses();
+    }
+
+    /**
+     *\brief Passes the draw poses of the dynamic nodes to the graphics.
+     *
+     * pre:
+     *     - the iMutex is locked
+     */
+    void NodeManager::publishPoses(void) {
+      pose_frame *frame = poseChannel.getWriteFrame();
+      size_t n = dynNodes.size();
+      frame->resize(2*n);
+      for(size_t i=0; i<n; ++i) {
+        frame->ids[2*i] = dynDrawIDs[i];
+        frame->pos[2*i] = dynVisualPos[i];
+        frame->rot[2*i] = dynVisualRot[i];
+        frame->ids[2*i+1] = dynDrawIDs2[i];
+        frame->pos[2*i+1] = dynStates.pos[i];
+        frame->rot[2*i+1] = dynStates.rot[i];
+      }
+      frame->layout = poseLayout;
+      frame->time = utils::getTime();
+      poseChannel.publish();
+    }
+
+    /**
+     *\brief Collects the dynamic nodes that have a physical representation
+     * into the packed state arrays.
+     *
+     * pre:
+     *     - the iMutex is locked
+     */
+    void NodeManager::rebuildDynamicStates(void) {
       NodeMap::iterator iter;
+      dynNodes.clear();
+      dynStates.nodes.clear();
       for(iter = simNodesDyn.begin(); iter != simNodesDyn.end(); iter++) {
-        iter->second->update(calc_ms, physics_thread);
+        NodeInterface *node = iter->second->getInterface().get();
+        // nodes without physics keep their pose
+        if(!node) continue;
+        dynNodes.push_back(iter->second.get());
+        dynStates.nodes.push_back(node);
       }
+      dynStates.resize();
+      dynDrawIDs.resize(dynNodes.size());
+      dynDrawIDs2.resize(dynNodes.size());
+      dynVisualPos.resize(dynNodes.size());
+      dynVisualRot.resize(dynNodes.size());
+      ++poseLayout;
+      dynNodesChanged = false;
     }
 
     void NodeManager::preGraphicsUpdate() {
@@ -1295,7 +1393,29 @@ namespace mars {
       if(!control->graphics)
         return;
 
-      iMutex.lock();
+      if(poseChannel.update()) {
+        if(interpolatePoses) {
+          prevPoses.ids.swap(curPoses.ids);
+          prevPoses.pos.swap(curPoses.pos);
+          prevPoses.rot.swap(curPoses.rot);
+          prevPoses.layout = curPoses.layout;
+          prevPoses.time = curPoses.time;
+          curPoses = poseChannel.getReadFrame();
+          posesPending = true;
+        }
+        else {
+          applyPoses(poseChannel.getReadFrame());
+        }
+      }
+      if(posesPending) {
+        interpolatePoseFrames();
+      }
+
+      // changes of the node set are applied with the next frame if the
+      // physics holds the lock
+      if(iMutex.tryLock() != utils::MUTEX_ERROR_NO_ERROR) {
+        return;
+      }
       if(update_all_nodes) {
         update_all_nodes = false;
         for(iter = simNodes.begin(); iter != simNodes.end(); iter++) {
@@ -1310,15 +1430,18 @@ namespace mars {
         }
       }
       else {
-        for(iter = simNodesDyn.begin(); iter != simNodesDyn.end(); iter++) {
-          control->graphics->setDrawObjectPos(iter->second->getGraphicsID(),
-                                              iter->second->getVisualPosition());
-          control->graphics->setDrawObjectRot(iter->second->getGraphicsID(),
-                                              iter->second->getVisualRotation());
-          control->graphics->setDrawObjectPos(iter->second->getGraphicsID2(),
-                                              iter->second->getPosition());
-          control->graphics->setDrawObjectRot(iter->second->getGraphicsID2(),
-                                              iter->second->getRotation());
+        if(dynNodesChanged) {
+          // the published poses are outdated until the next physics update
+          for(iter = simNodesDyn.begin(); iter != simNodesDyn.end(); iter++) {
+            control->graphics->setDrawObjectPos(iter->second->getGraphicsID(),
+                                                iter->second->getVisualPosition());
+            control->graphics->setDrawObjectRot(iter->second->getGraphicsID(),
+                                                iter->second->getVisualRotation());
+            control->graphics->setDrawObjectPos(iter->second->getGraphicsID2(),
+                                                iter->second->getPosition());
+            control->graphics->setDrawObjectRot(iter->second->getGraphicsID2(),
+                                                iter->second->getRotation());
+          }
         }
         for(iter = nodesToUpdate.begin(); iter != nodesToUpdate.end(); iter++) {
           control->graphics->setDrawObjectPos(iter->second->getGraphicsID(),
@@ -1335,6 +1458,39 @@ namespace mars {
       iMutex.unlock();
     }
 
+    void NodeManager::applyPoses(const pose_frame &frame) {
+      for(size_t i=0; i<frame.size(); ++i) {
+        control->graphics->setDrawObjectPos(frame.ids[i], frame.pos[i]);
+        control->graphics->setDrawObjectRot(frame.ids[i], frame.rot[i]);
+      }
+    }
+
+    /**
+     *\brief Draws the poses between prevPoses and curPoses. The interpolation
+     * takes as long as the time between the two steps and ends at curPoses.
+     */
+    void NodeManager::interpolatePoseFrames(void) {
+      long long dt = curPoses.time - prevPoses.time;
+      if(curPoses.layout != prevPoses.layout || dt <= 0) {
+        applyPoses(curPoses);
+        posesPending = false;
+        return;
+      }
+      double t = (double)(utils::getTime() - curPoses.time) / dt;
+      if(t >= 1.0) {
+        applyPoses(curPoses);
+        posesPending = false;
+        return;
+      }
+      if(t < 0.0) t = 0.0;
+      for(size_t i=0; i<curPoses.size(); ++i) {
+        Vector pos = prevPoses.pos[i] + (curPoses.pos[i] - prevPoses.pos[i]) * t;
+        Quaternion rot = prevPoses.rot[i].slerp(t, curPoses.rot[i]);
+        control->graphics->setDrawObjectPos(curPoses.ids[i], pos);
+        control->graphics->setDrawObjectRot(curPoses.ids[i], rot);
+      }
+    }
+
     /**
      *\brief Removes all nodes from the simulation to clear the world.
      */
@@ -1348,6 +1504,9 @@ namespace mars {
       simNodes.clear();
       vizNodes.clear();
       simNodesDyn.clear();
+      dynNodesChanged = true;
+      // the ids of the snapshots are reused by new nodes
+      snapshots.clear();
       if(clear_all) simNodesReload.clear();
       next_node_id = 1;
       iMutex.unlock();
@@ -2019,5 +2178,47 @@ namespace mars {
         iter->second->addContact(point, normal, depth, c_params_other);
     }
 
+    void NodeManager::saveState(unsigned long snapshotId) {
+      MutexLocker locker(&iMutex);
+      NodeStates &states = snapshots[snapshotId];
+      states.resize(simNodes.size());
+      size_t i = 0;
+      for(NodeMap::const_iterator iter = simNodes.begin();
+          iter != simNodes.end(); ++iter, ++i) {
+        states[i].first = iter->first;
+        iter->second->saveState(&states[i].second);
+      }
+    }
+
+    /**
+     * \brief Sets all nodes of the snapshot back in place. Nodes that were
+     * removed since are skipped, nodes that were added keep their state.
+     */
+    bool NodeManager::restoreState(unsigned long snapshotId) {
+      MutexLocker locker(&iMutex);
+      std::map<unsigned long, NodeStates>::const_iterator it;
+      it = snapshots.find(snapshotId);
+      if(it == snapshots.end()) return false;
+      NodeMap::const_iterator iter = simNodes.begin();
+      for(NodeStates::const_iterator state = it->second.begin();
+          state != it->second.end(); ++state) {
+        // both are sorted by the id, thus we mostly step forward
+        if(iter == simNodes.end() || iter->first != state->first) {
+          iter = simNodes.find(state->first);
+          if(iter == simNodes.end()) continue;
+        }
+        iter->second->restoreState(state->second);
+        ++iter;
+      }
+      // the packed states are out of date until the next step
+      dynNodesChanged = true;
+      return true;
+    }
+
+    void NodeManager::removeState(unsigned long snapshotId) {
+      MutexLocker locker(&iMutex);
+      snapshots.erase(snapshotId);
+    }
+
   } // end of namespace sim
 } // end of namespace mars
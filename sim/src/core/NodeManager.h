@@ -32,10 +32,14 @@
   #warning "NodeManager.h"
 #endif
 
+#include "SimNode.h"
+
 #include <mars/utils/Mutex.h>
 #include <mars/interfaces/graphics/GraphicsUpdateInterface.h>
+#include <mars/interfaces/graphics/PoseChannel.h>
 #include <mars/interfaces/sim/ControlCenter.h>
 #include <mars/interfaces/sim/NodeManagerInterface.h>
+#include <mars/interfaces/nodeStateArrays.h>
 
 namespace mars {
   namespace sim {
@@ -165,16 +169,36 @@ namespace mars {
                         const std::string &value);
       virtual void addContact(interfaces::NodeId id, utils::Vector &point, utils::Vector &normal,
                               interfaces::sReal depth, interfaces::contact_params &c_params_other);
+      virtual void saveState(unsigned long snapshotId);
+      virtual bool restoreState(unsigned long snapshotId);
+      virtual void removeState(unsigned long snapshotId);
 
     private:
+      typedef std::vector<std::pair<interfaces::NodeId, SimNode::nodeState> > NodeStates;
       interfaces::NodeId next_node_id;
       bool update_all_nodes;
       int visual_rep;
       NodeMap simNodes;
       NodeMap simNodesDyn;
+      // packed state of simNodesDyn, read from the physics in one pass
+      // after every step; rebuilt if simNodesDyn changes
+      interfaces::nodeStateArrays dynStates;
+      std::vector<SimNode*> dynNodes;
+      std::vector<unsigned long> dynDrawIDs, dynDrawIDs2;
+      std::vector<utils::Vector> dynVisualPos;
+      std::vector<utils::Quaternion> dynVisualRot;
+      bool dynNodesChanged;
+      // the draw poses of dynNodes are published after every step and read
+      // by preGraphicsUpdate without locking the iMutex
+      interfaces::PoseChannel poseChannel;
+      unsigned long poseLayout;
+      // read side of the channel, only used by the graphics thread
+      bool interpolatePoses, posesPending;
+      interfaces::pose_frame prevPoses, curPoses;
       NodeMap nodesToUpdate;
       NodeMap vizNodes;
       std::list<interfaces::NodeData> simNodesReload;
+      std::map<unsigned long, NodeStates> snapshots;
       unsigned long maxGroupID;
       lib_manager::LibManager *libManager;
       mutable utils::Mutex iMutex;
@@ -182,6 +206,10 @@ namespace mars {
       interfaces::ControlCenter *control;
 
       std::list<interfaces::NodeData>::iterator getReloadNode(interfaces::NodeId id);
+      void rebuildDynamicStates(void);
+      void publishPoses(void);
+      void applyPoses(const interfaces::pose_frame &frame);
+      void interpolatePoseFrames(void);
 
       // interfaces::NodeInterface* getNodeInterface(NodeId node_id);
       struct Params; // see below.
@@ -58,12 +58,19 @@
 #include "ScanningSonar.h"
 
 #include <mars/interfaces/sim/SimulatorInterface.h>
+#include <mars/data_broker/DataBrokerInterface.h>
 #include <mars/utils/MutexLocker.h>
+#include <mars/utils/Thread.h>
+#include <mars/utils/WaitCondition.h>
 #include <mars/interfaces/Logging.hpp>
 
+#include <chrono>
 #include <cstdio>
 #include <stdexcept>
 
+// the sensor costs are published once per simulated second
+#define SENSOR_COST_WINDOW 1000.0
+
 namespace mars {
   namespace sim {
 
@@ -71,6 +78,60 @@ namespace mars {
     using namespace utils;
     using namespace interfaces;
 
+    /**
+     * A thread that takes sensor updates of the current step until none is
+     * left. The updates are distributed by the atomic index of the manager,
+     * so that expensive sensors do not stall a fixed partition.
+     */
+    class SensorManager::Worker : public Thread {
+    public:
+      Worker(SensorManager *manager) : manager(manager), busy(false),
+                                       quit(false) {
+      }
+
+      void dispatch(void) {
+        mutex.lock();
+        busy = true;
+        condition.wakeAll();
+        mutex.unlock();
+      }
+
+      void waitDone(void) {
+        mutex.lock();
+        while(busy) condition.wait(&mutex);
+        mutex.unlock();
+      }
+
+      void stop(void) {
+        mutex.lock();
+        quit = true;
+        condition.wakeAll();
+        mutex.unlock();
+        wait();
+      }
+
+    protected:
+      void run(void) {
+        mutex.lock();
+        while(true) {
+          while(!busy && !quit) condition.wait(&mutex);
+          if(quit) break;
+          mutex.unlock();
+          manager->runUpdates();
+          mutex.lock();
+          busy = false;
+          condition.wakeAll();
+        }
+        mutex.unlock();
+      }
+
+    private:
+      SensorManager *manager;
+      bool busy, quit;
+      Mutex mutex;
+      WaitCondition condition;
+    };
+
     /**
      * \brief Constructor.
      *
@@ -80,6 +141,11 @@ namespace mars {
     {
       control = c;
       next_sensor_id = 1;
+      numSensorThreads = 0;
+      nextUpdate = 0;
+      costTime = 0.0;
+      costLayoutChanged = true;
+      costPackageId = 0;
       addSensorType("RaySensor",&RaySensor::instanciate);
       addSensorType("RotatingRaySensor",&RotatingRaySensor::instanciate);
       addSensorType("MultiLevelLaserRangeFinder",&MultiLevelLaserRangeFinder::instanciate);
@@ -128,6 +194,13 @@ namespace mars {
       //   RayGridSensor
     }
 
+    SensorManager::~SensorManager() {
+      for(size_t i=0; i<workers.size(); ++i) {
+        workers[i]->stop();
+        delete workers[i];
+      }
+    }
+
     /**
      *\brief Returns true, if the sensor with the given id exists.
      *
@@ -210,6 +283,7 @@ namespace mars {
         if (tmpSensor)
           delete tmpSensor;
       }
+      if (costs.erase(index)) costLayoutChanged = true;
       iMutex.unlock();
 
       control->sim->sceneHasChanged(false);
@@ -282,6 +356,9 @@ namespace mars {
         delete sensor;
       }
       simSensors.clear();
+      snapshots.clear();
+      costs.clear();
+      costLayoutChanged = true;
       if(clear_all) simSensorsReload.clear();
       next_sensor_id = 1;
     }
@@ -364,5 +441,165 @@ namespace mars {
       return createAndAddSensor(type, cfg);
     }
 
+    /**
+     * \brief Stores the internal state of all sensors that have one, e.g.
+     * the turning offset of a rotating laser scanner.
+     */
+    void SensorManager::saveState(unsigned long snapshotId) {
+      MutexLocker locker(&iMutex);
+      map<unsigned long, vector<double> > &states = snapshots[snapshotId];
+      states.clear();
+      map<unsigned long, BaseSensor*>::const_iterator iter;
+      for(iter = simSensors.begin(); iter != simSensors.end(); ++iter) {
+        vector<double> state;
+        iter->second->saveState(&state);
+        if(!state.empty()) states[iter->first].swap(state);
+      }
+    }
+
+    bool SensorManager::restoreState(unsigned long snapshotId) {
+      MutexLocker locker(&iMutex);
+      map<unsigned long, map<unsigned long, vector<double> > >::const_iterator it;
+      it = snapshots.find(snapshotId);
+      if(it == snapshots.end()) return false;
+      map<unsigned long, vector<double> >::const_iterator state;
+      map<unsigned long, BaseSensor*>::const_iterator iter;
+      for(state = it->second.begin(); state != it->second.end(); ++state) {
+        iter = simSensors.find(state->first);
+        if(iter != simSensors.end()) iter->second->restoreState(state->second);
+      }
+      return true;
+    }
+
+    void SensorManager::removeState(unsigned long snapshotId) {
+      MutexLocker locker(&iMutex);
+      snapshots.erase(snapshotId);
+    }
+
+    void SensorManager::setSensorThreads(int numThreads) {
+      MutexLocker locker(&iMutex);
+      numSensorThreads = numThreads < 0 ? 0 : numThreads;
+    }
+
+    /**
+     * \brief Runs the pending sensor updates of the step on the worker
+     * threads and the calling thread.
+     *
+     * pre:
+     *     - the physics step and the DataBroker timers of the step are done
+     *
+     * post:
+     *     - all pending updates are done when the function returns, thus the
+     *       next step sees consistent sensors
+     *     - the update costs are published as "mars_sim/sensorProfile"
+     *       once per simulated second
+     */
+    void SensorManager::updateSensors(sReal calc_ms) {
+      iMutex.lock();
+      // the thread count is only changed here to not stop a busy worker
+      while((int)workers.size() > numSensorThreads) {
+        workers.back()->stop();
+        delete workers.back();
+        workers.pop_back();
+      }
+      while((int)workers.size() < numSensorThreads) {
+        workers.push_back(new Worker(this));
+        workers.back()->start();
+      }
+
+      updates.clear();
+      map<unsigned long, BaseSensor*>::iterator iter;
+      for(iter = simSensors.begin(); iter != simSensors.end(); ++iter) {
+        if(iter->second->isUpdatePending()) {
+          sensor_update update = {iter->first, iter->second, 0.0};
+          updates.push_back(update);
+        }
+      }
+
+      if(!updates.empty()) {
+        size_t numThreads = workers.size();
+        if(numThreads > updates.size()-1) numThreads = updates.size()-1;
+        nextUpdate = 0;
+        for(size_t i=0; i<numThreads; ++i) workers[i]->dispatch();
+        runUpdates();
+        for(size_t i=0; i<numThreads; ++i) workers[i]->waitDone();
+
+        vector<sensor_update>::iterator it;
+        for(it = updates.begin(); it != updates.end(); ++it) {
+          map<unsigned long, sensor_cost>::iterator cost = costs.find(it->id);
+          if(cost == costs.end()) {
+            cost = costs.insert(make_pair(it->id, sensor_cost())).first;
+            cost->second.name = it->sensor->name;
+            costLayoutChanged = true;
+          }
+          cost->second.sum_ms += it->time_ms;
+          cost->second.count++;
+          if(it->time_ms > cost->second.max_ms) {
+            cost->second.max_ms = it->time_ms;
+          }
+        }
+      }
+
+      bool publish = false;
+      costTime += calc_ms;
+      if(costTime >= SENSOR_COST_WINDOW) {
+        costTime = 0.0;
+        publish = collectCosts();
+      }
+      iMutex.unlock();
+
+      // receivers of the package may call the SensorManager
+      if(publish) {
+        control->dataBroker->pushData(costPackageId, costPackage);
+      }
+    }
+
+    // takes updates of the current step until all are done
+    void SensorManager::runUpdates(void) {
+      size_t i;
+      chrono::steady_clock::time_point start;
+      while((i = nextUpdate.fetch_add(1)) < updates.size()) {
+        start = chrono::steady_clock::now();
+        updates[i].sensor->updateSensor();
+        updates[i].time_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+      }
+    }
+
+    /**
+     * \brief Writes the average and maximum update time of every sensor
+     * into the cost package and resets the window.
+     *
+     * pre:
+     *     - iMutex is locked
+     *
+     * post:
+     *     - returns true if the package has to be pushed
+     */
+    bool SensorManager::collectCosts(void) {
+      if(!control->dataBroker || costs.empty()) return false;
+      map<unsigned long, sensor_cost>::iterator iter;
+      if(costLayoutChanged) {
+        // added or removed sensors change the layout of the package
+        costPackage.clear();
+        for(iter = costs.begin(); iter != costs.end(); ++iter) {
+          costPackage.add(iter->second.name + "/avg", 0.0);
+          costPackage.add(iter->second.name + "/max", 0.0);
+        }
+        costPackageId = control->dataBroker->registerPackage("mars_sim", "sensorProfile",
+                                                             costPackage,
+                                                             data_broker::DATA_PACKAGE_READ_FLAG);
+        costLayoutChanged = false;
+      }
+      size_t i = 0;
+      for(iter = costs.begin(); iter != costs.end(); ++iter, i+=2) {
+        sensor_cost &cost = iter->second;
+        costPackage[i].d = cost.count ? cost.sum_ms / cost.count : 0.0;
+        costPackage[i+1].d = cost.max_ms;
+        cost.sum_ms = cost.max_ms = 0.0;
+        cost.count = 0;
+      }
+      return true;
+    }
+
   } // end of namespace sim
 } // end of namespace mars
@@ -41,8 +41,11 @@
 #include <mars/interfaces/sim/SensorManagerInterface.h>
 #include <mars/interfaces/sim/ControlCenter.h>
 #include <mars/utils/Mutex.h>
+#include <mars/data_broker/DataPackage.h>
 #include <configmaps/ConfigData.h>
 
+#include <atomic>
+
 namespace mars {
   namespace sim {
 
@@ -79,7 +82,7 @@ namespace mars {
       /**
        * \brief Destructor.
        */
-      virtual ~SensorManager(){}
+      virtual ~SensorManager();
 
       /**
        * \brief Add a sensor to the simulation.
@@ -215,8 +218,32 @@ namespace mars {
       virtual interfaces::BaseSensor* createAndAddSensor(configmaps::ConfigMap* config, bool reload=true);
       virtual interfaces::BaseSensor* createAndAddSensor(const std::string &type_name,interfaces::BaseConfig *config, bool reload=false);
 
+      virtual void saveState(unsigned long snapshotId);
+      virtual bool restoreState(unsigned long snapshotId);
+      virtual void removeState(unsigned long snapshotId);
+
+      virtual void updateSensors(interfaces::sReal calc_ms);
+      virtual void setSensorThreads(int numThreads);
 
     private:
+      class Worker;
+
+      // a pending sensor update of the current step
+      struct sensor_update {
+        unsigned long id;
+        interfaces::BaseSensor *sensor;
+        double time_ms;
+      };
+
+      // the accumulated update times of a sensor
+      struct sensor_cost {
+        std::string name;
+        double sum_ms, max_ms;
+        unsigned long count;
+      };
+
+      void runUpdates(void);
+      bool collectCosts(void);
 
       //! the id of the next sensor added to the simulation
       unsigned long next_sensor_id;
@@ -227,6 +254,9 @@ namespace mars {
       //! a containter for all sensors that are loaded after a reset of the simulation
       std::vector<SensorReloadHelper> simSensorsReload;
 
+      //! the internal states of the sensors by snapshot id
+      std::map<unsigned long, std::map<unsigned long, std::vector<double> > > snapshots;
+
 
       //! a pointer to the control center
       interfaces::ControlCenter *control;
@@ -234,6 +264,19 @@ namespace mars {
       //! a mutex fot the sensor containters
       mutable utils::Mutex iMutex;
 
+      //! the threads running the sensor updates, resized in updateSensors()
+      std::vector<Worker*> workers;
+      int numSensorThreads;
+      //! the updates of the current step, distributed by nextUpdate
+      std::vector<sensor_update> updates;
+      std::atomic<size_t> nextUpdate;
+      //! the update costs by sensor id, published once per simulated second
+      std::map<unsigned long, sensor_cost> costs;
+      double costTime;
+      bool costLayoutChanged;
+      unsigned long costPackageId;
+      data_broker::DataPackage costPackage;
+
       //std::map<const std::string,BaseSensor* (*)(interfaces::ControlCenter*,const unsigned long int,const std::string,QDomElement*)> availibleSensors;
       //std::map<const std::string,BaseSensor* (*)(interfaces::ControlCenter*,const unsigned long int, const std::string, mars::ConfigMap*)> availableSensors2;
       std::map<const std::string, interfaces::BaseSensor* (*)(interfaces::ControlCenter*, interfaces::BaseConfig*)> availableSensors;
@@ -38,13 +38,16 @@ namespace mars {
     using namespace interfaces;
 
     SimJoint::SimJoint(ControlCenter *c, const JointData &sJoint_)
-      : control(c) {
+      : control(c), feedbackUsed(false) {
 
       physical_joint = 0;
       setSJoint(sJoint_);
 
       pushToDataBroker = 2;
       configmaps::ConfigMap &map = sJoint.config;
+      if(map.hasKey("forceFeedback") && (bool)map["forceFeedback"] == true) {
+        feedbackUsed = true;
+      }
       if(map.hasKey("noDataPackage") && (bool)map["noDataPackage"] == true) {
         pushToDataBroker = 0;
       }
@@ -224,7 +227,6 @@ namespace mars {
     }
 
     void SimJoint::update(sReal calc_ms){
-      CPP_UNUSED(calc_ms);
       if (physical_joint) {
         // update the position and rotation of the node
         double ode_position1 = (sJoint.angle1_offset + invert*physical_joint->getPosition());
@@ -246,29 +248,64 @@ namespace mars {
         joint_load *= invert;
         velocity1 = invert*physical_joint->getVelocity();
         velocity2 = invert*physical_joint->getVelocity2();
-        if(sJoint.type == JOINT_TYPE_SLIDER) {
-          position1 = ode_position1;
-          position2 = ode_position2;
-        }
-        else {
-          position1 += velocity1*calc_ms*0.001;
-          position2 += velocity2*calc_ms*0.001;
-          double error;
-          if(position1 > 0) error = fmod(position1, M_PI) - fmod(ode_position1+M_PI, M_PI);
-          else error = fmod(position1, M_PI) - fmod(ode_position1-M_PI, M_PI);
-          if(fabs(error) < 0.1) position1 -= error;
-          if(position2 > 0) error = fmod(position2, M_PI) - fmod(ode_position2+M_PI, M_PI);
-          else error = fmod(position2, M_PI) - fmod(ode_position2-M_PI, M_PI);
-          if(fabs(error) < 0.1) position2 -= error;
-        }
         motor_torque = invert*physical_joint->getMotorTorque();
+        updateState(calc_ms, ode_position1, ode_position2);
+      }
+    }
 
-        // FIXME this should be set only for Spring-joints!
-        // HACK use setTorque2 which only acts on spring joints
-        physical_joint->setTorque2(motor_torque);
+    /**
+     * \brief Updates the joint from entry index of a state snapshot that was
+     * read by PhysicsInterface::getJointStates() after the last step. The
+     * forces and torques are only taken if the feedback was requested.
+     */
+    void SimJoint::update(sReal calc_ms, const jointStateArrays &states,
+                          size_t index) {
+      if (physical_joint) {
+        double ode_position1 = sJoint.angle1_offset + invert*states.position1[index];
+        double ode_position2 = sJoint.angle2_offset + invert*states.position2[index];
+
+        anchor = states.anchor[index];
+        axis1 = states.axis1[index];
+        axis2 = states.axis2[index];
+        if(states.feedback[index]) {
+          f1 = states.f1[index];
+          f2 = states.f2[index];
+          t1 = states.t1[index];
+          t2 = states.t2[index];
+          axis1_torque = states.axis1_torque[index] * invert;
+          axis2_torque = states.axis2_torque[index] * invert;
+          joint_load = states.joint_load[index] * invert;
+        }
+        velocity1 = invert*states.velocity1[index];
+        velocity2 = invert*states.velocity2[index];
+        motor_torque = invert*states.motor_torque[index];
+        updateState(calc_ms, ode_position1, ode_position2);
       }
     }
 
+    void SimJoint::updateState(sReal calc_ms, sReal ode_position1,
+                               sReal ode_position2) {
+      if(sJoint.type == JOINT_TYPE_SLIDER) {
+        position1 = ode_position1;
+        position2 = ode_position2;
+      }
+      else {
+        position1 += velocity1*calc_ms*0.001;
+        position2 += velocity2*calc_ms*0.001;
+        double error;
+        if(position1 > 0) error = fmod(position1, M_PI) - fmod(ode_position1+M_PI, M_PI);
+        else error = fmod(position1, M_PI) - fmod(ode_position1-M_PI, M_PI);
+        if(fabs(error) < 0.1) position1 -= error;
+        if(position2 > 0) error = fmod(position2, M_PI) - fmod(ode_position2+M_PI, M_PI);
+        else error = fmod(position2, M_PI) - fmod(ode_position2-M_PI, M_PI);
+        if(fabs(error) < 0.1) position2 -= error;
+      }
+
+      // FIXME this should be set only for Spring-joints!
+      // HACK use setTorque2 which only acts on spring joints
+      physical_joint->setTorque2(motor_torque);
+    }
+
     void SimJoint::setSJoint(const JointData &sJoint) {
       this->sJoint = sJoint;
       id = sJoint.index;
@@ -413,6 +450,7 @@ namespace mars {
     }
 
     const utils::Vector SimJoint::getForceVector(unsigned char axis_index) const {
+      feedbackUsed = true;
       return axis_index == 1 ? f1 : f2;
     }
 
@@ -425,6 +463,7 @@ namespace mars {
     }
 
     const Vector SimJoint::getTorqueVector(unsigned char axis_index) const {
+      feedbackUsed = true;
       return axis_index == 1 ? t1 : t2;
     }
 
@@ -441,6 +480,7 @@ namespace mars {
     }
 
     const Vector SimJoint::getTorqueVectorAroundAxis(unsigned char axis_index) const {
+      feedbackUsed = true;
       return axis_index == 1 ? axis1_torque : axis2_torque;
     }
 
@@ -453,6 +493,7 @@ namespace mars {
     }
 
     const Vector SimJoint::getJointLoad(void) const {
+      feedbackUsed = true;
       return joint_load;
     }
 
@@ -468,6 +509,40 @@ namespace mars {
       return getNodeId(2);
     }
 
+    void SimJoint::saveState(jointState *state) const {
+      state->position1 = position1;
+      state->position2 = position2;
+      state->velocity1 = velocity1;
+      state->velocity2 = velocity2;
+      state->motor_torque = motor_torque;
+      state->f1 = f1;
+      state->f2 = f2;
+      state->t1 = t1;
+      state->t2 = t2;
+      state->axis1_torque = axis1_torque;
+      state->axis2_torque = axis2_torque;
+      state->joint_load = joint_load;
+    }
+
+    /**
+     * \brief Sets the values of the joint back. The physical joint follows
+     * the bodies of the attached nodes, thus it is not changed.
+     */
+    void SimJoint::restoreState(const jointState &state) {
+      position1 = state.position1;
+      position2 = state.position2;
+      velocity1 = state.velocity1;
+      velocity2 = state.velocity2;
+      motor_torque = state.motor_torque;
+      f1 = state.f1;
+      f2 = state.f2;
+      t1 = state.t1;
+      t2 = state.t2;
+      axis1_torque = state.axis1_torque;
+      axis2_torque = state.axis2_torque;
+      joint_load = state.joint_load;
+    }
+
     void SimJoint::updateStepSize(void) {
         physical_joint->changeStepSize(sJoint);
       }
@@ -606,7 +681,16 @@ namespace mars {
     void SimJoint::produceData(const data_broker::DataInfo &info,
                                data_broker::DataPackage *dbPackage,
                                int callbackParam) {
+      produceChangedData(info, dbPackage, callbackParam);
+    }
+
+    bool SimJoint::produceChangedData(const data_broker::DataInfo &info,
+                                      data_broker::DataPackage *dbPackage,
+                                      int callbackParam) {
+      // only called if the package has receivers
+      feedbackUsed = true;
       dbPackageMapping.writePackage(dbPackage);
+      return dbPackageMapping.hasChanged();
     }
 
     void SimJoint::setupDataPackageMapping() {
@@ -26,10 +26,13 @@
 #endif
 
 #include <mars/interfaces/sim/JointInterface.h>
+#include <mars/interfaces/jointStateArrays.h>
 
 #include <mars/data_broker/ProducerInterface.h>
 #include <mars/data_broker/DataPackageMapping.h>
 
+#include <atomic>
+
 namespace mars {
   
   namespace interfaces {
@@ -106,11 +109,32 @@ namespace mars {
       // function members
       void rotateAxis(const utils::Quaternion &rotatem, unsigned char axis_index=1);
       void update(interfaces::sReal calc_ms);
+      void update(interfaces::sReal calc_ms,
+                  const interfaces::jointStateArrays &states, size_t index);
+      /**
+       * Returns true if the forces and torques of the joint are read by
+       * anyone. They are only taken from the physics for these joints.
+       */
+      bool needsFeedback(void) const {return feedbackUsed;}
       void reattachJoint(void);
       void attachMotor(unsigned char axis_index);
       void detachMotor(unsigned char axis_index);
       void updateStepSize(void);
 
+      /**
+       * The state of the joint that is derived from previous steps, e.g.
+       * the accumulated position of a hinge. Used for snapshots.
+       */
+      struct jointState {
+        interfaces::sReal position1, position2;
+        interfaces::sReal velocity1, velocity2;
+        interfaces::sReal motor_torque;
+        utils::Vector f1, f2, t1, t2;
+        utils::Vector axis1_torque, axis2_torque, joint_load;
+      };
+      void saveState(jointState *state) const;
+      void restoreState(const jointState &state);
+
       // getters
       const utils::Vector getAnchor(void) const;
       std::shared_ptr<SimNode> getAttachedNode(unsigned char axis_index=1) const;
@@ -127,6 +151,7 @@ namespace mars {
       interfaces::sReal getMotorTorque(void) const;  // FIXME: this should not be in the joint
       interfaces::NodeId getNodeId(unsigned char node_index=1) const;
       const interfaces::JointData getSJoint(void) const;
+      interfaces::JointInterface* getPhysicalJoint(void) const {return physical_joint.get();}
       interfaces::sReal getVelocity(unsigned char axis_index=1) const;
       interfaces::sReal getTorque(interfaces::sReal torque, unsigned char axis_index=1) const;
       const utils::Vector getTorqueVector(unsigned char axis_index=1) const;
@@ -154,6 +179,9 @@ namespace mars {
       virtual void produceData(const data_broker::DataInfo &info,
                                data_broker::DataPackage *package,
                                int callbackParam);
+      virtual bool produceChangedData(const data_broker::DataInfo &info,
+                                      data_broker::DataPackage *package,
+                                      int callbackParam);
 
       // the following functions are going to be deprecated in the coming releases of MARS
       void changeStepSize(void) __attribute__ ((deprecated("use updateStepSize")));
@@ -212,6 +240,13 @@ namespace mars {
       utils::Vector axis1InNode1;
       utils::Vector node1ToAnchor;
       int pushToDataBroker;
+      // set by the first read of a force or torque, or by the
+      // "forceFeedback" option of the joint config
+      mutable std::atomic<bool> feedbackUsed;
+
+      void updateState(interfaces::sReal calc_ms,
+                       interfaces::sReal ode_position1,
+                       interfaces::sReal ode_position2);
 
       // for dataBroker communication
       void setupDataPackageMapping();
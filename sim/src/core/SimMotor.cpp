@@ -98,19 +98,17 @@ namespace mars {
       }
       if(pushToDataBroker > 0) {
         cmdPackage.add("value", 0.0);
-        dbPackage.add("id", (long)sMotor.index);
-        dbPackage.add("value", controlValue);
-        dbPackage.add("position", getPosition());
-        dbPackage.add("current", getCurrent());
-        dbPackage.add("torque", getEffort());
-        dbPackage.add("maxtorque", sMotor.maxEffort);
-
-        dbIdIndex = dbPackage.getIndexByName("id");
-        dbControlParameterIndex = dbPackage.getIndexByName("value");
-        dbPositionIndex = dbPackage.getIndexByName("position");
-        dbCurrentIndex = dbPackage.getIndexByName("current");
-        dbEffortIndex = dbPackage.getIndexByName("torque");
-        dbMaxEffortIndex = dbPackage.getIndexByName("maxtorque");
+        dbPackageMapping.add("id", &dbId);
+        dbPackageMapping.add("value", &controlValue);
+        dbPackageMapping.add("position", &dbPosition);
+        dbPackageMapping.add("current", &dbCurrent);
+        dbPackageMapping.add("torque", &dbEffort);
+        dbPackageMapping.add("maxtorque", &sMotor.maxEffort);
+        dbId = sMotor.index;
+        dbPosition = getPosition();
+        dbCurrent = getCurrent();
+        dbEffort = getEffort();
+        dbPackageMapping.writePackage(&dbPackage);
 
         std::string groupName, dataName;
         getDataBrokerNames(&groupName, &dataName);
@@ -247,7 +245,19 @@ namespace mars {
       current_coefficients = coefficients;
     }
 
+    /**
+     * \brief Reads the options of the motor config that are used in every
+     * update, thus the update does not need to search the config map.
+     */
+    void SimMotor::readConfig() {
+      maxEffortControl = (sMotor.config.hasKey("maxEffortControl") and
+                          (bool)sMotor.config["maxEffortControl"] == true);
+      springControl = sMotor.config.hasKey("spring");
+      spring = springControl ? (double)sMotor.config["spring"] : 0.0;
+    }
+
     void SimMotor::updateController() {
+      readConfig();
       axis = (unsigned char) sMotor.axis;
       switch (sMotor.type) {
         case MOTOR_TYPE_POSITION:
@@ -277,8 +287,7 @@ namespace mars {
         case MOTOR_TYPE_DIRECT_EFFORT:
           controlValue = sMotor.value;
           controlLimit = &(sMotor.maxEffort);
-          if(sMotor.config.hasKey("maxEffortControl") and
-             (bool)(sMotor.config["maxEffortControl"]) == true) {
+          if(maxEffortControl) {
             controlParameter = &velocity;
             setJointControlParameter = &SimJoint::setVelocity;
           } else {
@@ -299,6 +308,63 @@ namespace mars {
       //TODO: update the remaining parameters
     }
 
+    void SimMotor::saveState(motorState *state) const {
+      state->active = active;
+      state->time = time;
+      state->controlValue = controlValue;
+      state->lastVelocity = lastVelocity;
+      state->velocity = velocity;
+      state->position1 = position1;
+      state->position2 = position2;
+      state->effort = effort;
+      state->sensedEffort = sensedEffort;
+      state->tmpmaxeffort = tmpmaxeffort;
+      state->tmpmaxspeed = tmpmaxspeed;
+      state->current = current;
+      state->temperature = temperature;
+      state->filterValue = filterValue;
+      state->last_error = last_error;
+      state->integ_error = integ_error;
+      state->joint_velocity = joint_velocity;
+      state->error = error;
+    }
+
+    /**
+     * \brief Sets the state of the motor and its controller back.
+     *
+     * post:
+     *     - the restored control parameter and effort limit are passed to
+     *       the joint, so the next physics step does not use the values of
+     *       the discarded steps
+     */
+    void SimMotor::restoreState(const motorState &state) {
+      active = state.active;
+      time = state.time;
+      controlValue = state.controlValue;
+      lastVelocity = state.lastVelocity;
+      velocity = state.velocity;
+      position1 = state.position1;
+      position2 = state.position2;
+      effort = state.effort;
+      sensedEffort = state.sensedEffort;
+      tmpmaxeffort = state.tmpmaxeffort;
+      tmpmaxspeed = state.tmpmaxspeed;
+      current = state.current;
+      temperature = state.temperature;
+      filterValue = state.filterValue;
+      last_error = state.last_error;
+      integ_error = state.integ_error;
+      joint_velocity = state.joint_velocity;
+      error = state.error;
+
+      if(active && myJoint) {
+        if(!effortMotor && sMotor.type != MOTOR_TYPE_DIRECT_EFFORT) {
+          myJoint->setEffortLimit(tmpmaxeffort, sMotor.axis);
+        }
+        (myJoint.get()->*setJointControlParameter)(*controlParameter, sMotor.axis);
+      }
+    }
+
     void SimMotor::runEffortController(sReal time) {
       // limit to range of motion
       controlValue = std::max(sMotor.minValue,
@@ -332,8 +398,7 @@ namespace mars {
       controlValue = std::max(-sMotor.maxEffort,
                               std::min(controlValue, sMotor.maxEffort));
 
-      if(sMotor.config.hasKey("maxEffortControl") and
-         (bool)sMotor.config["maxEffortControl"] == true) {
+      if(maxEffortControl) {
         if(controlValue >= 0) {
           velocity = 10000;
         } else {
@@ -406,8 +471,8 @@ namespace mars {
       lastVelocity = velocity;
       last_error = error;
 
-      if(sMotor.config.hasKey("spring")) {
-        myJoint->setEffortLimit(sMotor.maxEffort*error*(double)sMotor.config["spring"], sMotor.axis);
+      if(springControl) {
+        myJoint->setEffortLimit(sMotor.maxEffort*error*spring, sMotor.axis);
       }
     }
 
@@ -749,6 +814,7 @@ namespace mars {
     void SimMotor::setSMotor(const MotorData &sMotor) {
       // todo: handle name change correctly
       this->sMotor = sMotor;
+      readConfig();
       filterValue = 0.0;
       if(this->sMotor.config.hasKey("filterValue")) {
         filterValue = this->sMotor.config["filterValue"];
@@ -759,12 +825,7 @@ namespace mars {
         effortMotor = true;
       }
       else if(sMotor.type == MOTOR_TYPE_DIRECT_EFFORT) {
-        effortMotor = true;
-        ConfigMap map = sMotor.config;
-        if(map.hasKey("maxEffortControl") and
-           (bool)map["maxEffortControl"]) {
-          effortMotor = false;
-        }
+        effortMotor = !maxEffortControl;
       }
       if(myJoint) {
         if(!effortMotor) {
@@ -897,12 +958,18 @@ namespace mars {
       void SimMotor::produceData(const data_broker::DataInfo &info,
                                  data_broker::DataPackage *dbPackage,
                                  int callbackParam) {
-        dbPackage->set(dbIdIndex, (long)sMotor.index);
-        dbPackage->set(dbControlParameterIndex, controlValue);
-        dbPackage->set(dbPositionIndex, getPosition());
-        dbPackage->set(dbCurrentIndex, getCurrent());
-        dbPackage->set(dbEffortIndex, getEffort());
-        dbPackage->set(dbMaxEffortIndex, sMotor.maxEffort);
+        produceChangedData(info, dbPackage, callbackParam);
+      }
+
+      bool SimMotor::produceChangedData(const data_broker::DataInfo &info,
+                                        data_broker::DataPackage *dbPackage,
+                                        int callbackParam) {
+        dbId = sMotor.index;
+        dbPosition = getPosition();
+        dbCurrent = getCurrent();
+        dbEffort = getEffort();
+        dbPackageMapping.writePackage(dbPackage);
+        return dbPackageMapping.hasChanged();
       }
 
       void SimMotor::receiveData(const data_broker::DataInfo& info,
@@ -30,6 +30,7 @@
 #include <mars/data_broker/ProducerInterface.h>
 #include <mars/data_broker/ReceiverInterface.h>
 #include <mars/data_broker/DataPackage.h>
+#include <mars/data_broker/DataPackageMapping.h>
 #include <mars/interfaces/MotorData.h>
 #include <mars/utils/mathUtils.h>
 
@@ -70,6 +71,22 @@ namespace mars {
 
       void update(interfaces::sReal time_ms);
       void updateController();
+
+      /**
+       * The state of the motor and of its controller, e.g. the error
+       * integral of the PID controller. Used for snapshots.
+       */
+      struct motorState {
+        bool active;
+        interfaces::sReal time;
+        interfaces::sReal controlValue;
+        interfaces::sReal lastVelocity, velocity, position1, position2;
+        interfaces::sReal effort, sensedEffort, tmpmaxeffort, tmpmaxspeed;
+        interfaces::sReal current, temperature, filterValue;
+        interfaces::sReal last_error, integ_error, joint_velocity, error;
+      };
+      void saveState(motorState *state) const;
+      void restoreState(const motorState &state);
       void activate(void);
       void deactivate(void);
       void attachJoint(std::shared_ptr<SimJoint> joint);
@@ -142,6 +159,9 @@ namespace mars {
       virtual void produceData(const data_broker::DataInfo &info,
                                data_broker::DataPackage *package,
                                int callbackParam);
+      virtual bool produceChangedData(const data_broker::DataInfo &info,
+                                      data_broker::DataPackage *package,
+                                      int callbackParam);
       virtual void receiveData(const data_broker::DataInfo &info,
                                const data_broker::DataPackage &package,
                                int callbackParam);
@@ -199,6 +219,11 @@ namespace mars {
       interfaces::sReal joint_velocity;
       interfaces::sReal error;
 
+      // options of sMotor.config, read once in readConfig()
+      bool maxEffortControl, springControl;
+      interfaces::sReal spring;
+      void readConfig();
+
       // function approximation
       double * maxspeed_x;
       double * maxeffort_x;
@@ -227,7 +252,10 @@ namespace mars {
       // for dataBroker communication
       data_broker::DataPackage dbPackage, cmdPackage;
       unsigned long dbPushId, dbCmdId;
-      long dbIdIndex, dbControlParameterIndex, dbPositionIndex, dbCurrentIndex, dbEffortIndex, dbMaxEffortIndex;
+      data_broker::DataPackageMapping dbPackageMapping;
+      // the values of the package that are computed on demand
+      long dbId;
+      interfaces::sReal dbPosition, dbCurrent, dbEffort;
       bool effortMotor;
       int pushToDataBroker;
     };
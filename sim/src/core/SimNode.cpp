@@ -183,6 +183,14 @@ namespace mars {
       dbPackageMapping.writePackage(dbPackage);
     }
 
+    bool SimNode::produceChangedData(const data_broker::DataInfo &info,
+                                     data_broker::DataPackage *dbPackage,
+                                     int callbackParam) {
+      // resting nodes leave their package untouched
+      dbPackageMapping.writePackage(dbPackage);
+      return dbPackageMapping.hasChanged();
+    }
+
 
     void SimNode::setName(const std::string &objectname) {
       MutexLocker locker(&iMutex);
@@ -544,8 +552,6 @@ namespace mars {
     void SimNode::update(sReal calc_ms, bool physics_thread) {
       MutexLocker locker(&iMutex);
       if (my_interface) {
-        Vector damping;
-        sReal d;
         last_l_vel = l_vel;
         last_a_vel = a_vel;
         // update the position and rotation of the node
@@ -557,78 +563,170 @@ namespace mars {
         my_interface->getTorque(&t);
         ground_contact = my_interface->getGroundContact();
         ground_contact_force = my_interface->getGroundContactForce();
-        if(calc_ms > 0) {
-          l_acc = (l_vel - last_l_vel) / (calc_ms / 1000.);
-          a_acc = (a_vel - last_a_vel) / (calc_ms / 1000.);
-        } else {
-          l_acc = Vector(0, 0, 0);
-          a_acc = Vector(0, 0, 0);
-        }
-        //i_velocity_sum -= i_velocity[vel_ptr];
-        //i_velocity[vel_ptr] = fabs(a_vel.length());
-        //i_velocity_sum += i_velocity[vel_ptr];
-        //d = i_velocity_sum / BACK_VEL;
+        updateState(calc_ms, physics_thread);
+      }
+    }
 
-        //d = fabs(a_vel.length());
-        d = fabs(a_vel.norm());
+    /**
+     * \brief Updates the node from entry index of a state snapshot that was
+     * read by PhysicsInterface::getNodeStates() after the last step.
+     */
+    void SimNode::update(sReal calc_ms, const nodeStateArrays &states,
+                         size_t index, bool physics_thread) {
+      MutexLocker locker(&iMutex);
+      if (my_interface) {
+        last_l_vel = l_vel;
+        last_a_vel = a_vel;
+        sNode.pos = states.pos[index];
+        sNode.rot = states.rot[index];
+        l_vel = states.l_vel[index];
+        a_vel = states.a_vel[index];
+        f = states.f[index];
+        t = states.t[index];
+        ground_contact = states.ground_contact[index];
+        ground_contact_force = states.ground_contact_force[index];
+        updateState(calc_ms, physics_thread);
+      }
+    }
 
-        // here we can handle damping
-        if (sNode.linear_damping != 0) {
-          damping = l_vel;
-          damping *= 1-sNode.linear_damping;
-          my_interface->setLinearVelocity(damping);
-        }
-        if (sNode.angular_treshold && d < sNode.angular_treshold) {
-          damping = a_vel;
-          /*
-               damping.normalize();
-               damping *= ((i_velocity[1]-i_velocity[2])*(1-sNode.angular_low)+
-               i_velocity[1]);
-               //damping *= i_velocity[0];
-               */
-          damping *= 1-sNode.angular_low;
-          //i_velocity_sum -= i_velocity[vel_ptr];
-          //i_velocity[vel_ptr] = damping.length();
-          //i_velocity_sum += i_velocity[vel_ptr];
-          my_interface->setAngularVelocity(damping);
-        }
-        else if (sNode.angular_damping != 0) {
-          damping = a_vel;
-          /*damping.normalize();
-            damping *= ((i_velocity[1]-i_velocity[2])*(1-sNode.angular_damping)+
-            i_velocity[1]);
-            //damping *= i_velocity[0];
-            */
-          damping *= 1-sNode.angular_damping;
-          //i_velocity_sum -= i_velocity[vel_ptr];
-          //i_velocity[vel_ptr] = damping.length();
-          /*
-            if(i_velocity[vel_ptr] > sNode.angular_damping) {
-            damping.normalize();
-            damping *= i_velocity[0] - sNode.angular_damping;
-            }
-            else {
-            damping *= 0;
-            }*/
-          //i_velocity_sum += i_velocity[vel_ptr];
-          my_interface->setAngularVelocity(damping);
-        }
-        // handle friction direction by mirror node orientation
-        if(frictionDirNode && my_interface) {
-          Vector v = fRotation*fDirNode;
-          if(!sNode.c_params.friction_direction1) {
-            sNode.c_params.friction_direction1 = new Vector();
+    /**
+     * \brief Returns the draw object ids, the pose and the visual pose with
+     * one lock.
+     */
+    void SimNode::getDrawState(unsigned long *id, unsigned long *id2,
+                               Vector *pos, Quaternion *rot,
+                               Vector *visual_pos,
+                               Quaternion *visual_rot) const {
+      MutexLocker locker(&iMutex);
+      *id = graphics_id;
+      *id2 = graphics_id2;
+      *pos = sNode.pos;
+      *rot = sNode.rot;
+      *visual_pos = sNode.pos + sNode.rot * sNode.visual_offset_pos;
+      *visual_rot = sNode.rot * sNode.visual_offset_rot;
+    }
+
+    void SimNode::saveState(nodeState *state) const {
+      MutexLocker locker(&iMutex);
+      state->has_body = my_interface && my_interface->getBodyState(&state->body);
+      state->pos = sNode.pos;
+      state->rot = sNode.rot;
+      state->l_vel = l_vel;
+      state->last_l_vel = last_l_vel;
+      state->a_vel = a_vel;
+      state->last_a_vel = last_a_vel;
+      state->l_acc = l_acc;
+      state->a_acc = a_acc;
+      state->f = f;
+      state->t = t;
+      state->ground_contact = ground_contact;
+      state->ground_contact_force = ground_contact_force;
+    }
+
+    /**
+     * \brief Sets the node and its body back to a saved state. Nothing of
+     * the physical representation is recreated.
+     */
+    void SimNode::restoreState(const nodeState &state) {
+      MutexLocker locker(&iMutex);
+      if(state.has_body && my_interface) {
+        my_interface->setBodyState(state.body);
+      }
+      sNode.pos = state.pos;
+      sNode.rot = state.rot;
+      l_vel = state.l_vel;
+      last_l_vel = state.last_l_vel;
+      a_vel = state.a_vel;
+      last_a_vel = state.last_a_vel;
+      l_acc = state.l_acc;
+      a_acc = state.a_acc;
+      f = state.f;
+      t = state.t;
+      ground_contact = state.ground_contact;
+      ground_contact_force = state.ground_contact_force;
+    }
+
+    /**
+     * \brief Derives accelerations, applies damping and handles the sensors
+     * after the physical state of the node was updated.
+     *
+     * pre:
+     *     - the iMutex is locked and the node has a physical interface
+     */
+    void SimNode::updateState(sReal calc_ms, bool physics_thread) {
+      Vector damping;
+      sReal d;
+      if(calc_ms > 0) {
+        l_acc = (l_vel - last_l_vel) / (calc_ms / 1000.);
+        a_acc = (a_vel - last_a_vel) / (calc_ms / 1000.);
+      } else {
+        l_acc = Vector(0, 0, 0);
+        a_acc = Vector(0, 0, 0);
+      }
+      //i_velocity_sum -= i_velocity[vel_ptr];
+      //i_velocity[vel_ptr] = fabs(a_vel.length());
+      //i_velocity_sum += i_velocity[vel_ptr];
+      //d = i_velocity_sum / BACK_VEL;
+
+      //d = fabs(a_vel.length());
+      d = fabs(a_vel.norm());
+
+      // here we can handle damping
+      if (sNode.linear_damping != 0) {
+        damping = l_vel;
+        damping *= 1-sNode.linear_damping;
+        my_interface->setLinearVelocity(damping);
+      }
+      if (sNode.angular_treshold && d < sNode.angular_treshold) {
+        damping = a_vel;
+        /*
+             damping.normalize();
+             damping *= ((i_velocity[1]-i_velocity[2])*(1-sNode.angular_low)+
+             i_velocity[1]);
+             //damping *= i_velocity[0];
+             */
+        damping *= 1-sNode.angular_low;
+        //i_velocity_sum -= i_velocity[vel_ptr];
+        //i_velocity[vel_ptr] = damping.length();
+        //i_velocity_sum += i_velocity[vel_ptr];
+        my_interface->setAngularVelocity(damping);
+      }
+      else if (sNode.angular_damping != 0) {
+        damping = a_vel;
+        /*damping.normalize();
+          damping *= ((i_velocity[1]-i_velocity[2])*(1-sNode.angular_damping)+
+          i_velocity[1]);
+          //damping *= i_velocity[0];
+          */
+        damping *= 1-sNode.angular_damping;
+        //i_velocity_sum -= i_velocity[vel_ptr];
+        //i_velocity[vel_ptr] = damping.length();
+        /*
+          if(i_velocity[vel_ptr] > sNode.angular_damping) {
+          damping.normalize();
+          damping *= i_velocity[0] - sNode.angular_damping;
           }
-          *(sNode.c_params.friction_direction1) = v;
-          my_interface->setContactParams(sNode.c_params);
-        }
-        //vel_ptr = (vel_ptr+1)%BACK_VEL;
-        if(update_ray || true) {
-          my_interface->handleSensorData(physics_thread);
-          update_ray = false;
+          else {
+          damping *= 0;
+          }*/
+        //i_velocity_sum += i_velocity[vel_ptr];
+        my_interface->setAngularVelocity(damping);
+      }
+      // handle friction direction by mirror node orientation
+      if(frictionDirNode && my_interface) {
+        Vector v = fRotation*fDirNode;
+        if(!sNode.c_params.friction_direction1) {
+          sNode.c_params.friction_direction1 = new Vector();
         }
-        checkNodeState();
+        *(sNode.c_params.friction_direction1) = v;
+        my_interface->setContactParams(sNode.c_params);
+      }
+      //vel_ptr = (vel_ptr+1)%BACK_VEL;
+      if(update_ray || true) {
+        my_interface->handleSensorData(physics_thread);
+        update_ray = false;
       }
+      checkNodeState();
     }
 
     void SimNode::getCoreExchange(core_objects_exchange *obj) const {
@@ -32,6 +32,7 @@
 #include <mars/data_broker/DataPackageMapping.h>
 #include <mars/interfaces/sensor_bases.h>
 #include <mars/interfaces/nodeState.h>
+#include <mars/interfaces/nodeStateArrays.h>
 #include <mars/interfaces/sim/NodeInterface.h>
 
 namespace mars {
@@ -168,6 +169,30 @@ namespace mars {
       
       // manipulation
       void update(interfaces::sReal calc_ms, bool physics_thread = true); ///< Updates the values of the node from the physical layer.
+      void update(interfaces::sReal calc_ms,
+                  const interfaces::nodeStateArrays &states, size_t index,
+                  bool physics_thread = true); ///< Updates the values of the node from a state snapshot.
+      void getDrawState(unsigned long *id, unsigned long *id2,
+                        utils::Vector *pos, utils::Quaternion *rot,
+                        utils::Vector *visual_pos,
+                        utils::Quaternion *visual_rot) const;
+
+      /**
+       * The dynamic state of the node and of its body. Used for snapshots
+       * of the simulation.
+       */
+      struct nodeState {
+        bool has_body;
+        interfaces::bodyState body;
+        utils::Vector pos;
+        utils::Quaternion rot;
+        utils::Vector l_vel, last_l_vel, a_vel, last_a_vel, l_acc, a_acc;
+        utils::Vector f, t;
+        bool ground_contact;
+        interfaces::sReal ground_contact_force;
+      };
+      void saveState(nodeState *state) const;
+      void restoreState(const nodeState &state);
       void rotateAtPoint(const utils::Vector &rotation_point, const utils::Quaternion &rotation, bool move_group);
       void changeNode(interfaces::NodeData *node);
       void clearRelativePosition(void);
@@ -183,6 +208,9 @@ namespace mars {
       virtual void produceData(const data_broker::DataInfo &info,
                                data_broker::DataPackage *package,
                                int callbackParam);
+      virtual bool produceChangedData(const data_broker::DataInfo &info,
+                                      data_broker::DataPackage *package,
+                                      int callbackParam);
       virtual void receiveData(const data_broker::DataInfo &info,
                                const data_broker::DataPackage &package,
                                int callbackParam);
@@ -228,6 +256,7 @@ namespace mars {
 
       void addToDataBroker();
       void removeFromDataBroker();
+      void updateState(interfaces::sReal calc_ms, bool physics_thread);
 
     };
 
@@ -38,6 +38,7 @@
 #include "Controller.h"
 
 #include <mars/utils/misc.h>
+#include <mars/utils/MutexLocker.h>
 #include <mars/interfaces/SceneParseException.h>
 #include <mars/interfaces/graphics/GraphicsManagerInterface.h>
 #include <mars/interfaces/sim/LoadCenter.h>
@@ -51,6 +52,7 @@
 #include <stdexcept>
 #include <algorithm>
 #include <cctype> // for tolower()
+#include <cstdlib>
 
 #ifdef __linux__
 #include <time.h>
@@ -99,6 +101,9 @@ namespace mars {
       calc_ms      = 10; //defaultCFG->getInt("physics", "calc_ms", 10);
       avg_count_steps = 20;
       my_real_time = 0;
+      batch_mode = false;
+      requests_pending = false;
+      next_state_id = 1;
       // to synchronise drawing and physics
       sync_time = 40;
       sync_count = 0;
@@ -108,6 +113,8 @@ namespace mars {
       arg_run    = 0;
       arg_grid   = 0;
       arg_ortho  = 0;
+      arg_batch  = 0;
+      arg_seed   = -1;
 
       Simulator::activeSimulator = this; // set this Simulator object to the active one
       gravity = Vector(0.0, 0.0, -9.81); // set gravity to earth conditions
@@ -122,6 +129,18 @@ namespace mars {
       dbSimDebugPackage.add("simUpdate", 0.);
       dbSimDebugPackage.add("worldStep", 0.);
       dbSimDebugPackage.add("logStep", 0.);
+      profileStep = profiler.getPhase("step");
+      profilePrePhysics = profiler.getPhase("prePhysicsUpdate");
+      profileCollision = profiler.getPhase("collision");
+      profileSolver = profiler.getPhase("solver");
+      profileNodes = profiler.getPhase("updateNodes");
+      profileJoints = profiler.getPhase("updateJoints");
+      profileMotors = profiler.getPhase("updateMotors");
+      profileControllers = profiler.getPhase("updateControllers");
+      profileDataBroker = profiler.getPhase("dataBroker");
+      profileSensors = profiler.getPhase("updateSensors");
+      profilePostPhysics = profiler.getPhase("postPhysicsUpdate");
+      profileSettingsChanged = false;
 
       // load optional libs
       checkOptionalDependency("data_broker");
@@ -191,6 +210,7 @@ namespace mars {
                                                        data_broker::DATA_PACKAGE_READ_FLAG);
           getTimeMutex.unlock();
           control->dataBroker->createTimer("mars_sim/simTimer");
+          control->dataBroker->createTimer("mars_sim/sensorTimer");
           control->dataBroker->createTrigger("mars_sim/prePhysicsUpdate");
           control->dataBroker->createTrigger("mars_sim/postPhysicsUpdate");
           control->dataBroker->createTrigger("mars_sim/finishedDrawTrigger");
@@ -267,6 +287,9 @@ namespace mars {
       if(control->cfg) {
         configPath = control->cfg->getOrCreateProperty("Config", "config_path",
                                                          config_dir);
+        // the scene loaders store the parsed scenes here, empty disables it
+        control->cfg->getOrCreateProperty("Config", "scene_cache_path",
+                                          configPath.sValue + "/scene_cache/");
 
         //control->cfg->getOrCreateProperty("Preferences", "resources_path",
         //                                  std::string(MARS_PREFERENCES_DEFAULT_RESOURCES_PATH));
@@ -308,6 +331,7 @@ namespace mars {
 
       control->controllers->setDefaultPort(std_port);
       control->nodes->setVisualRep(0, cfgVisRep.iValue);
+      control->sensors->setSensorThreads(cfgSensorThreads.iValue);
 
       if (control->graphics) {
         control->graphics->addGraphicsUpdateInterface((GraphicsUpdateInterface*)this);
@@ -324,10 +348,20 @@ namespace mars {
       {
         physics -> setPhysicsPlugins(physicsPlugins); 
       }
+      // every world starts with the same random sequence
+      physics->random_seed = (unsigned long)cfgRandomSeed.iValue;
+      srand(cfgRandomSeed.iValue);
       physics->initTheWorld();
       // the physics step_size is in seconds
       physics->step_size = calc_ms/1000.;
       physics->fast_step = cfgFaststep.bValue;
+      physics->ray_cast_threads = cfgRayCastThreads.iValue;
+      physics->step_threads = cfgStepThreads.iValue;
+      physics->broadphase = cfgBroadphase.sValue;
+      physics->static_broadphase = cfgStaticBroadphase.sValue;
+      physics->hash_min_level = cfgHashMinLevel.iValue;
+      physics->hash_max_level = cfgHashMaxLevel.iValue;
+      physics->quadtree_depth = cfgQuadtreeDepth.iValue;
 
       physics->world_erp = cfgWorldErp.dValue;
       physics->world_cfm = cfgWorldCfm.dValue;
@@ -381,10 +415,12 @@ namespace mars {
 
       while (!kill_sim) {
         stepping_mutex.lock();
-        if(simulationStatus == STOPPING)
+        if(simulationStatus == STOPPING) {
           simulationStatus = STOPPED;
+          stopped_wc.wakeAll();
+        }
 
-        if(!isSimRunning()) {
+        if(!isSimRunning() && !(batch_mode && requests_pending)) {
           stepping_wc.wait(&stepping_mutex);
           if(kill_sim){
             stepping_mutex.unlock();
@@ -392,10 +428,29 @@ namespace mars {
           }
         }
 
-        if (sync_graphics && !sync_count) {
-            msleep(2);
-            stepping_mutex.unlock();
-            continue;
+        if(batch_mode && requests_pending) {
+          // without graphics synchronisation the requests are handled
+          // between two steps
+          requests_pending = false;
+          stepping_mutex.unlock();
+          processRequests();
+          continue;
+        }
+
+        if(!isSimRunning()) {
+          stepping_mutex.unlock();
+          continue;
+        }
+
+        if (sync_graphics && !sync_count && !batch_mode) {
+          // finishedDraw or stopAndWait wakes us up
+          stepping_wc.wait(&stepping_mutex);
+          if(simulationStatus == STOPPING) {
+            simulationStatus = STOPPED;
+            stopped_wc.wakeAll();
+          }
+          stepping_mutex.unlock();
+          continue;
         }
 
         if(simulationStatus == STEPPING){
@@ -403,17 +458,20 @@ namespace mars {
         }
         stepping_mutex.unlock();
 
-        if(my_real_time) {
+        if(my_real_time && !batch_mode) {
           myRealTime();
-        } else if(physics_mutex_count > 0) {
+        } else {
           // if not in realtime this thread would lock the physicsThread right
           // after releasing it. If an other thread is trying to lock
-          // it (physics_mutex_count > 0) we sleep so it has a chance.
-          msleep(1);
+          // it we wait until it had its chance.
+          waitForPhysicsLock();
         }
         step();
       }
+      stepping_mutex.lock();
       simulationStatus = STOPPED;
+      stopped_wc.wakeAll();
+      stepping_mutex.unlock();
       // here everything of the physical simulation can be closed
     }
 
@@ -421,8 +479,13 @@ namespace mars {
       std::vector<pluginStruct>::iterator p_iter;
       long time;
       Status oldState;
+      StepProfiler::Clock::time_point stepStart, physicsStart;
 
       physicsThreadLock();
+      applyProfileSettings();
+      if(profiler.isEnabled()) {
+        stepStart = StepProfiler::Clock::now();
+      }
 
       if(setState) {
         oldState = simulationStatus;
@@ -432,16 +495,38 @@ namespace mars {
       time = utils::getTime();
 
       if(control->dataBroker) {
+        StepProfiler::Scope scope(&profiler, profilePrePhysics);
         control->dataBroker->trigger("mars_sim/prePhysicsUpdate");
       }
+      if(profiler.isEnabled()) {
+        physicsStart = StepProfiler::Clock::now();
+      }
       physics->stepTheWorld();
+      if(profiler.isEnabled()) {
+        // the physics measures its phases itself
+        physicsStart = profiler.addSample(profileCollision, physicsStart,
+                                          physics->collision_time);
+        profiler.addSample(profileSolver, physicsStart, physics->solver_time);
+      }
 
       avg_step_time += getTimeDiff(time);
 
-      control->nodes->updateDynamicNodes(calc_ms); //Moved update to here, otherwise RaySensor is one step behind the world every time
-      control->joints->updateJoints(calc_ms);
-      control->motors->updateMotors(calc_ms);
-      control->controllers->updateControllers(calc_ms);
+      {
+        StepProfiler::Scope scope(&profiler, profileNodes);
+        control->nodes->updateDynamicNodes(calc_ms); //Moved update to here, otherwise RaySensor is one step behind the world every time
+      }
+      {
+        StepProfiler::Scope scope(&profiler, profileJoints);
+        control->joints->updateJoints(calc_ms);
+      }
+      {
+        StepProfiler::Scope scope(&profiler, profileMotors);
+        control->motors->updateMotors(calc_ms);
+      }
+      {
+        StepProfiler::Scope scope(&profiler, profileControllers);
+        control->controllers->updateControllers(calc_ms);
+      }
 
       time = utils::getTime();
 
@@ -449,10 +534,19 @@ namespace mars {
       dbSimTimePackage[0].d += calc_ms;
       getTimeMutex.unlock();
       if(control->dataBroker) {
+        StepProfiler::Scope scope(&profiler, profileDataBroker);
         control->dataBroker->pushData(dbSimTimeId,
                                       dbSimTimePackage);
         control->dataBroker->stepTimer("mars_sim/simTimer", calc_ms);
       }
+      {
+        StepProfiler::Scope scope(&profiler, profileSensors);
+        control->sensors->updateSensors(calc_ms);
+        // producers of the sensor updates publish the data of this step
+        if(control->dataBroker) {
+          control->dataBroker->stepTimer("mars_sim/sensorTimer", calc_ms);
+        }
+      }
 
       avg_log_time += getTimeDiff(time);
       if(++count > avg_count_steps) {
@@ -472,7 +566,14 @@ namespace mars {
         erased_active = false;
         time = utils::getTime();
 
-        activePlugins[i].p_interface->update(calc_ms);
+        if(profiler.isEnabled() && activePlugins[i].profile_phase < 0) {
+          // the phases are only created in the simulation thread
+          activePlugins[i].profile_phase = profiler.getPhase(activePlugins[i].name);
+        }
+        {
+          StepProfiler::Scope scope(&profiler, activePlugins[i].profile_phase);
+          activePlugins[i].p_interface->update(calc_ms);
+        }
 
         if(!erased_active) {
           time = getTimeDiff(time);
@@ -497,7 +598,7 @@ namespace mars {
         control->dataBroker->pushData(dbSimDebugId,
                                       dbSimDebugPackage);
       }
-      if (sync_graphics) {
+      if (sync_graphics && !batch_mode) {
         calc_time += calc_ms;
         if (calc_time >= sync_time) {
           sync_count = 0;
@@ -507,6 +608,7 @@ namespace mars {
         }
       }
       if(control->dataBroker) {
+        StepProfiler::Scope scope(&profiler, profilePostPhysics);
         control->dataBroker->trigger("mars_sim/postPhysicsUpdate");
       }
 
@@ -514,9 +616,35 @@ namespace mars {
         simulationStatus = oldState;
       }
 
+      if(profiler.isEnabled()) {
+        profiler.addSample(profileStep, stepStart, StepProfiler::Clock::now());
+        profiler.endStep(control->dataBroker);
+      }
       physicsThreadUnlock();
     }
 
+    /**
+     * \brief Applies changed profiler properties within the physics thread.
+     */
+    void Simulator::applyProfileSettings(void) {
+      MutexLocker locker(&profileMutex);
+      if(!profileSettingsChanged) return;
+      profileSettingsChanged = false;
+      profiler.setWindow(cfgProfileWindow.iValue);
+      // reopening would truncate the trace recorded so far
+      if(cfgProfileTrace.sValue != profileTraceFile) {
+        profileTraceFile = cfgProfileTrace.sValue;
+        if(profileTraceFile.empty()) {
+          profiler.closeTrace();
+        } else if(!profiler.openTrace(profileTraceFile)) {
+          LOG_ERROR("Simulator: could not open profile trace \"%s\"",
+                    profileTraceFile.c_str());
+          profileTraceFile.clear();
+        }
+      }
+      profiler.setEnabled(cfgProfile.bValue);
+    }
+
     /**
      * \return \c true if started, \c false if stopped
      */
@@ -656,11 +784,11 @@ namespace mars {
         lo.robotname = robotname;
         lo.zeroPose = true;
         filesToLoad.push_back(lo);
-        externalMutex.unlock();
-
+        notifyRequests();
         while(blocking && !filesToLoad.empty()){
-            msleep(10);
+            requests_wc.wait(&externalMutex);
         }
+        externalMutex.unlock();
         return 1;
     }
 
@@ -683,11 +811,11 @@ namespace mars {
       lo.pos = pos;
       lo.rot = rot;
       filesToLoad.push_back(lo);
-      externalMutex.unlock();
-
+      notifyRequests();
       while(blocking && !filesToLoad.empty()){
-          msleep(10);
+          requests_wc.wait(&externalMutex);
       }
+      externalMutex.unlock();
       return 1;  
 
     }
@@ -792,17 +920,11 @@ namespace mars {
 
     void Simulator::finishedDraw(void) {
       long time;
-      processRequests();
+      // in batch mode the simulation thread handles the requests itself
+      if(!batch_mode) processRequests();
 
       if (reloadSim) {
-        while (simulationStatus != STOPPED) {
-
-          if(simulationStatus == RUNNING) {
-            StopSimulation();
-          }
-
-          msleep(10);
-        }
+        stopAndWait();
         reloadSim = false;
         control->controllers->setLoadingAllowed(false);
 
@@ -819,7 +941,10 @@ namespace mars {
         reloadGraphics = true;
       }
       allow_draw = 0;
+      stepping_mutex.lock();
       sync_count = 1;
+      stepping_wc.wakeAll();
+      stepping_mutex.unlock();
 
       // Add plugins that have been added via Simulator::addPlugin
       if(haveNewPlugin) {
@@ -885,7 +1010,76 @@ namespace mars {
 
       sceneHasChanged(true);
       physics->freeTheWorld();
+      physics->random_seed = (unsigned long)cfgRandomSeed.iValue;
+      srand(cfgRandomSeed.iValue);
       physics->initTheWorld();
+      // the snapshots of the managers are cleared with the objects
+      stateSimTimes.clear();
+      physicsThreadUnlock();
+    }
+
+    /**
+     * \brief Saves the dynamic state of the current scene.
+     *
+     * pre:
+     *     - must not be called from within a simulation step, e.g. by a
+     *       plugin update, since the physics lock is acquired
+     *
+     * post:
+     *     - returns the id that is used to restore or remove the snapshot
+     */
+    unsigned long Simulator::saveState(void) {
+      physicsThreadLock();
+      unsigned long id = next_state_id++;
+      control->nodes->saveState(id);
+      control->joints->saveState(id);
+      control->motors->saveState(id);
+      control->sensors->saveState(id);
+      getTimeMutex.lock();
+      stateSimTimes[id] = dbSimTimePackage[0].d;
+      getTimeMutex.unlock();
+      physicsThreadUnlock();
+      return id;
+    }
+
+    /**
+     * \brief Sets the scene back to a snapshot without reloading it.
+     *
+     * post:
+     *     - the joints are restored before the motors, since the motors
+     *       pass their control values to the joints
+     *     - the simulation time is set back and published
+     */
+    bool Simulator::restoreState(unsigned long id) {
+      physicsThreadLock();
+      std::map<unsigned long, double>::iterator it = stateSimTimes.find(id);
+      if(it == stateSimTimes.end()) {
+        physicsThreadUnlock();
+        LOG_WARN("Simulator: snapshot %lu does not exist", id);
+        return false;
+      }
+      control->nodes->restoreState(id);
+      control->joints->restoreState(id);
+      control->motors->restoreState(id);
+      control->sensors->restoreState(id);
+      getTimeMutex.lock();
+      dbSimTimePackage[0].d = it->second;
+      getTimeMutex.unlock();
+      if(control->dataBroker) {
+        control->dataBroker->pushData(dbSimTimeId, dbSimTimePackage);
+      }
+      physicsThreadUnlock();
+      return true;
+    }
+
+    void Simulator::removeState(unsigned long id) {
+      physicsThreadLock();
+      if(stateSimTimes.erase(id)) {
+        control->nodes->removeState(id);
+        control->joints->removeState(id);
+        control->motors->removeState(id);
+        control->sensors->removeState(id);
+      }
       physicsThreadUnlock();
     }
 
@@ -932,6 +1126,8 @@ namespace mars {
         {"scenename", 1, 0, 's'},
         {"config_dir", required_argument, 0, 'C'},
         {"c_port",1,0,'c'},
+        {"batch",no_argument,0,'b'},
+        {"seed",required_argument,0,'S'},
         {0, 0, 0, 0}
       };
 
@@ -956,7 +1152,7 @@ namespace mars {
       }
 
       while (1) {
-        c = getopt_long(argc, argv, "hrgoGs:C:p:", long_options, &option_index);
+        c = getopt_long(argc, argv, "hrgoGbs:S:C:p:", long_options, &option_index);
         if (c == -1)
           break;
         switch (c) {
@@ -993,6 +1189,12 @@ namespace mars {
           break;
         case 'G':
           break;
+        case 'b':
+          arg_batch = 1;
+          break;
+        case 'S':
+          arg_seed = atol(optarg);
+          break;
         case 'h':
         default:
           printf("\naccepted parameters are:\n");
@@ -1004,6 +1206,8 @@ namespace mars {
           printf("-C             path to Configuration\n");
           printf("-g             show 3d grid\n");
           printf("-o             ortho perspective as standard\n");
+          printf("-b, --batch    step as fast as possible without graphics sync\n");
+          printf("-S <seed>      seed for reproducible runs (--seed)\n");
           printf("\n");
         }
       }
@@ -1024,11 +1228,25 @@ namespace mars {
       // physics_mutex_count is used to see how many threads are trying to
       // acquire the lock. Also see Simulator::run() on how this is used.
       physicsCountMutex.lock();
-      physics_mutex_count--;
+      if(--physics_mutex_count == 0) {
+        physics_wc.wakeAll();
+      }
       physicsCountMutex.unlock();
       physicsMutex.unlock();
     }
 
+    /**
+     * \brief Waits until no other thread holds or waits for the physics
+     * lock. Used by the simulation thread between two steps.
+     */
+    void Simulator::waitForPhysicsLock(void) {
+      physicsCountMutex.lock();
+      while(physics_mutex_count > 0 && !kill_sim) {
+        physics_wc.wait(&physicsCountMutex);
+      }
+      physicsCountMutex.unlock();
+    }
+
     std::shared_ptr<PhysicsInterface> Simulator::getPhysics(void) const {
       return physics;
     }
@@ -1217,6 +1435,7 @@ namespace mars {
     void Simulator::addPlugin(const pluginStruct& plugin) {
       pluginLocker.lockForWrite();
       newPlugins.push_back(plugin);
+      newPlugins.back().profile_phase = -1;
       haveNewPlugin = true;
       pluginLocker.unlock();
     }
@@ -1312,16 +1531,7 @@ namespace mars {
     void Simulator::processRequests() {
       externalMutex.lock();
       if(filesToLoad.size() > 0) {
-        bool wasrunning = false;
-        while (simulationStatus != STOPPED) {
-
-          if(simulationStatus == RUNNING) {
-            StopSimulation();
-            wasrunning = true;
-          }
-
-          msleep(10);
-        }
+        bool wasrunning = stopAndWait();
 
         for(unsigned int i=0;i<filesToLoad.size();i++){
           if (filesToLoad[i].zeroPose == true)
@@ -1337,6 +1547,7 @@ namespace mars {
           }
         }
         filesToLoad.clear();
+        requests_wc.wakeAll();
 
         if(wasrunning) {
           StartSimulation();
@@ -1345,6 +1556,47 @@ namespace mars {
       externalMutex.unlock();
     }
 
+    /**
+     * \brief Wakes up the simulation thread in batch mode to handle the
+     * requests. The caller holds the externalMutex.
+     */
+    void Simulator::notifyRequests() {
+      stepping_mutex.lock();
+      requests_pending = true;
+      if(batch_mode) stepping_wc.wakeAll();
+      stepping_mutex.unlock();
+    }
+
+    /**
+     * \brief Stops the simulation and waits until the simulation thread
+     * finished its current step.
+     *
+     * post:
+     *     - the simulation is stopped
+     *     - returns \c true if the simulation was running
+     */
+    bool Simulator::stopAndWait() {
+      bool wasRunning;
+      stepping_mutex.lock();
+      wasRunning = (simulationStatus == RUNNING);
+      if(simulationStatus != STOPPED) {
+        if(isRunning() && !isCurrentThread()) {
+          simulationStatus = STOPPING;
+          // the simulation thread may wait for the graphics synchronisation
+          stepping_wc.wakeAll();
+          while(simulationStatus != STOPPED) {
+            stopped_wc.wait(&stepping_mutex);
+          }
+        }
+        else {
+          // no step can be in progress
+          simulationStatus = STOPPED;
+        }
+      }
+      stepping_mutex.unlock();
+      return wasRunning;
+    }
+
 
     void Simulator::exportScene(void) const {
       if(control->graphics) {
@@ -1369,11 +1621,93 @@ namespace mars {
         return;
       }
 
+      if(_property.paramId == cfgRayCastThreads.paramId) {
+        if(physics) physics->ray_cast_threads = _property.iValue;
+        return;
+      }
+
+      if(_property.paramId == cfgStepThreads.paramId) {
+        if(physics) physics->step_threads = _property.iValue;
+        return;
+      }
+
+      if(_property.paramId == cfgSensorThreads.paramId) {
+        if(control->sensors) control->sensors->setSensorThreads(_property.iValue);
+        return;
+      }
+
+      if(_property.paramId == cfgBroadphase.paramId) {
+        if(physics) physics->broadphase = _property.sValue;
+        return;
+      }
+
+      if(_property.paramId == cfgStaticBroadphase.paramId) {
+        if(physics) physics->static_broadphase = _property.sValue;
+        return;
+      }
+
+      if(_property.paramId == cfgHashMinLevel.paramId) {
+        if(physics) physics->hash_min_level = _property.iValue;
+        return;
+      }
+
+      if(_property.paramId == cfgHashMaxLevel.paramId) {
+        if(physics) physics->hash_max_level = _property.iValue;
+        return;
+      }
+
+      if(_property.paramId == cfgQuadtreeDepth.paramId) {
+        if(physics) physics->quadtree_depth = _property.iValue;
+        return;
+      }
+
+      if(_property.paramId == cfgProfile.paramId ||
+         _property.paramId == cfgProfileWindow.paramId ||
+         _property.paramId == cfgProfileTrace.paramId) {
+        MutexLocker locker(&profileMutex);
+        if(_property.paramId == cfgProfile.paramId) {
+          cfgProfile.bValue = _property.bValue;
+        } else if(_property.paramId == cfgProfileWindow.paramId) {
+          cfgProfileWindow.iValue = _property.iValue;
+        } else {
+          cfgProfileTrace.sValue = _property.sValue;
+        }
+        profileSettingsChanged = true;
+        return;
+      }
+
+      if(_property.paramId == cfgDispatchWindow.paramId) {
+        cfgDispatchWindow.iValue = _property.iValue;
+        updateDispatchOptions();
+        return;
+      }
+
+      if(_property.paramId == cfgDispatchThreads.paramId) {
+        cfgDispatchThreads.iValue = _property.iValue;
+        updateDispatchOptions();
+        return;
+      }
+
       if(_property.paramId == cfgRealtime.paramId) {
         my_real_time = _property.bValue;
         return;
       }
 
+      if(_property.paramId == cfgBatchMode.paramId) {
+        stepping_mutex.lock();
+        batch_mode = _property.bValue;
+        // pending requests are handled by the simulation thread now
+        stepping_wc.wakeAll();
+        stepping_mutex.unlock();
+        return;
+      }
+
+      if(_property.paramId == cfgRandomSeed.paramId) {
+        cfgRandomSeed.iValue = _property.iValue;
+        // used from the next world on
+        return;
+      }
+
       if(_property.paramId == cfgSyncGui.paramId) {
         this->setSyncThreads(_property.bValue);
         return;
@@ -1429,6 +1763,13 @@ namespace mars {
 
     }
 
+    void Simulator::updateDispatchOptions(void) {
+      if(control->dataBroker) {
+        control->dataBroker->setDispatchOptions(cfgDispatchWindow.iValue,
+                                                cfgDispatchThreads.iValue);
+      }
+    }
+
     void Simulator::initCfgParams(void) {
       if(!control->cfg)
         return;
@@ -1437,9 +1778,53 @@ namespace mars {
       calc_ms = cfgCalcMs.dValue;
       cfgFaststep = control->cfg->getOrCreateProperty("Simulator", "faststep",
                                                       false, this);
+      cfgRayCastThreads = control->cfg->getOrCreateProperty("Simulator", "ray cast threads",
+                                                            (int)0, this);
+      cfgStepThreads = control->cfg->getOrCreateProperty("Simulator", "step threads",
+                                                         (int)0, this);
+      cfgSensorThreads = control->cfg->getOrCreateProperty("Simulator", "sensor threads",
+                                                           (int)0, this);
+      cfgBroadphase = control->cfg->getOrCreateProperty("Simulator", "broadphase",
+                                                        std::string("hash"), this);
+      cfgStaticBroadphase = control->cfg->getOrCreateProperty("Simulator", "static broadphase",
+                                                              std::string("hash"), this);
+      cfgHashMinLevel = control->cfg->getOrCreateProperty("Simulator", "hash min level",
+                                                          (int)-3, this);
+      cfgHashMaxLevel = control->cfg->getOrCreateProperty("Simulator", "hash max level",
+                                                          (int)10, this);
+      cfgQuadtreeDepth = control->cfg->getOrCreateProperty("Simulator", "quadtree depth",
+                                                           (int)6, this);
+      cfgDispatchWindow = control->cfg->getOrCreateProperty("Simulator", "data broker dispatch window",
+                                                            (int)0, this);
+      cfgDispatchThreads = control->cfg->getOrCreateProperty("Simulator", "data broker dispatch threads",
+                                                             (int)0, this);
+      updateDispatchOptions();
+      cfgProfile = control->cfg->getOrCreateProperty("Simulator", "profile step",
+                                                     false, this);
+      cfgProfileWindow = control->cfg->getOrCreateProperty("Simulator", "profile window",
+                                                           (int)1000, this);
+      cfgProfileTrace = control->cfg->getOrCreateProperty("Simulator", "profile trace file",
+                                                          std::string(""), this);
+      profileMutex.lock();
+      profileSettingsChanged = true;
+      profileMutex.unlock();
       cfgRealtime = control->cfg->getOrCreateProperty("Simulator", "realtime calc",
                                                       true, this);
       my_real_time = cfgRealtime.bValue;
+      cfgBatchMode = control->cfg->getOrCreateProperty("Simulator", "batch mode",
+                                                       false, this);
+      cfgRandomSeed = control->cfg->getOrCreateProperty("Simulator", "random seed",
+                                                        (int)0, this);
+      if(arg_batch) {
+        control->cfg->setPropertyValue("Simulator", "batch mode", "value", true);
+        cfgBatchMode.bValue = true;
+      }
+      if(arg_seed >= 0) {
+        control->cfg->setPropertyValue("Simulator", "random seed", "value",
+                                       (int)arg_seed);
+        cfgRandomSeed.iValue = (int)arg_seed;
+      }
+      batch_mode = cfgBatchMode.bValue;
 
       cfgDebugTime = control->cfg->getOrCreateProperty("Simulator", "debug time",
                                                        false, this);
@@ -46,7 +46,10 @@
 #include <mars/interfaces/graphics/GraphicsUpdateInterface.h>
 #include <mars/utils/Vector.h>
 
+#include "StepProfiler.h"
+
 #include <iostream>
+#include <map>
 
 
 namespace mars {
@@ -131,6 +134,9 @@ namespace mars {
       bool startStopTrigger(); ///< Starts and pauses the simulation.
       virtual void singleStep(void);
       virtual void newWorld(bool clear_all = false);
+      virtual unsigned long saveState(void);
+      virtual bool restoreState(unsigned long id);
+      virtual void removeState(unsigned long id);
       virtual void exitMars(void);
       void readArguments(int argc, char **argv);
       virtual interfaces::ControlCenter* getControlCenter(void) const;
@@ -232,8 +238,12 @@ namespace mars {
       // simulation control
       void processRequests();
       void reloadWorld(void);      
+      void notifyRequests(void);
+      bool stopAndWait(void);
+      void waitForPhysicsLock(void);
 
-      int arg_no_gui, arg_run, arg_grid, arg_ortho;
+      int arg_no_gui, arg_run, arg_grid, arg_ortho, arg_batch;
+      long arg_seed;
       bool reloadSim, reloadGraphics;
       short running;
       char was_running;
@@ -246,6 +256,8 @@ namespace mars {
       interfaces::sReal sync_time;
       bool my_real_time;
       bool fast_step;      
+      // steps as fast as possible without waiting for the graphics
+      bool batch_mode;
 
       // graphics
       bool allow_draw;
@@ -262,15 +274,34 @@ namespace mars {
       utils::Mutex physicsCountMutex;
       utils::Mutex stepping_mutex; ///< Used for preventing active waiting for a single step or start event.
       utils::WaitCondition stepping_wc; ///< Used for preventing active waiting for a single step or start event.
+      utils::WaitCondition stopped_wc; ///< Signaled with the stepping_mutex when the simulation thread stopped.
+      utils::WaitCondition requests_wc; ///< Signaled with the externalMutex when all requests are handled.
+      utils::WaitCondition physics_wc; ///< Signaled with the physicsCountMutex when no other thread wants the physics lock.
+      bool requests_pending;
       utils::Mutex getTimeMutex;
       int physics_mutex_count;
       double avg_log_time, avg_step_time;
       int count, avg_count_steps;
+
+      // profiling of the simulation step, the settings are applied by the
+      // physics thread
+      StepProfiler profiler;
+      int profileStep, profilePrePhysics, profileCollision, profileSolver;
+      int profileNodes, profileJoints, profileMotors, profileControllers;
+      int profileDataBroker, profileSensors, profilePostPhysics;
+      utils::Mutex profileMutex;
+      bool profileSettingsChanged;
+      // the name of the open trace file
+      std::string profileTraceFile;
+      void applyProfileSettings(void);
       interfaces::sReal calc_time;
       
       // physics
       std::shared_ptr<interfaces::PhysicsInterface> physics;
       double calc_ms;
+      // the simulation time of the snapshots, guarded by the physics lock
+      std::map<unsigned long, double> stateSimTimes;
+      unsigned long next_state_id;
       int load_option;
       int std_port; ///< Controller port (default value: 1600)
       utils::Vector gravity;
@@ -297,9 +328,18 @@ namespace mars {
 
       // configuration
       void initCfgParams(void);
+      void updateDispatchOptions(void);
       std::string config_dir;
       cfg_manager::cfgPropertyStruct cfgCalcMs, cfgFaststep;
+      cfg_manager::cfgPropertyStruct cfgRayCastThreads, cfgStepThreads;
+      cfg_manager::cfgPropertyStruct cfgSensorThreads;
+      cfg_manager::cfgPropertyStruct cfgBroadphase, cfgStaticBroadphase;
+      cfg_manager::cfgPropertyStruct cfgHashMinLevel, cfgHashMaxLevel;
+      cfg_manager::cfgPropertyStruct cfgQuadtreeDepth;
+      cfg_manager::cfgPropertyStruct cfgDispatchWindow, cfgDispatchThreads;
+      cfg_manager::cfgPropertyStruct cfgProfile, cfgProfileWindow, cfgProfileTrace;
       cfg_manager::cfgPropertyStruct cfgRealtime, cfgDebugTime;
+      cfg_manager::cfgPropertyStruct cfgBatchMode, cfgRandomSeed;
       cfg_manager::cfgPropertyStruct cfgSyncGui, cfgDrawContact;
       cfg_manager::cfgPropertyStruct cfgGX, cfgGY, cfgGZ;
       cfg_manager::cfgPropertyStruct cfgWorldErp, cfgWorldCfm;
@@ -0,0 +1,244 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file StepProfiler.cpp
+ * \brief "StepProfiler" measures the duration of the phases of a
+ * simulation step.
+ *
+ */
+
+#include "StepProfiler.h"
+
+#include <mars/data_broker/DataBrokerInterface.h>
+
+#include <algorithm>
+#include <cmath>
+
+// the trace events are written to the file after this number of events
+#define MAX_TRACE_EVENTS 65536
+
+namespace mars {
+  namespace sim {
+
+    using namespace std::chrono;
+
+    StepProfiler::StepProfiler(void) : enabled(false), window(1000),
+                                       numSteps(0), origin(Clock::now()),
+                                       traceFile(NULL),
+                                       firstTraceEvent(true), packageId(0),
+                                       packagePhases(0) {
+    }
+
+    StepProfiler::~StepProfiler(void) {
+      closeTrace();
+    }
+
+    void StepProfiler::setEnabled(bool enabled) {
+      if(enabled && !this->enabled) reset();
+      this->enabled = enabled;
+    }
+
+    void StepProfiler::setWindow(int steps) {
+      window = steps > 0 ? steps : 1;
+    }
+
+    /**
+     * \brief Starts writing all samples into the given Chrome trace file.
+     *
+     * post:
+     *     - an already opened trace is closed
+     *     - returns false if the file could not be created
+     */
+    bool StepProfiler::openTrace(const std::string &filename) {
+      closeTrace();
+      traceFile = fopen(filename.c_str(), "w");
+      if(!traceFile) return false;
+      fprintf(traceFile, "{\"traceEvents\":[");
+      firstTraceEvent = true;
+      traceEvents.reserve(MAX_TRACE_EVENTS);
+      return true;
+    }
+
+    void StepProfiler::closeTrace(void) {
+      if(!traceFile) return;
+      writeTrace();
+      fprintf(traceFile, "\n],\"displayTimeUnit\":\"ms\"}\n");
+      fclose(traceFile);
+      traceFile = NULL;
+    }
+
+    int StepProfiler::getPhase(const std::string &name) {
+      std::map<std::string, int>::iterator it = phaseIds.find(name);
+      if(it != phaseIds.end()) return it->second;
+
+      phase p;
+      p.name = name;
+      p.histogram.resize(NUM_BUCKETS, 0);
+      p.count = 0;
+      p.max = 0;
+      phases.push_back(p);
+      phaseIds[name] = (int)phases.size()-1;
+      return (int)phases.size()-1;
+    }
+
+    void StepProfiler::addSample(int phase, Clock::time_point start,
+                                 Clock::time_point end) {
+      if(!enabled || phase < 0 || phase >= (int)phases.size()) return;
+      long long ns = duration_cast<nanoseconds>(end - start).count();
+      if(ns < 0) ns = 0;
+
+      StepProfiler::phase &p = phases[phase];
+      p.histogram[getBucket(ns)]++;
+      p.count++;
+      if(ns > p.max) p.max = ns;
+
+      if(traceFile) {
+        trace_event event;
+        event.phase = phase;
+        event.start = duration_cast<nanoseconds>(start - origin).count();
+        event.duration = ns;
+        traceEvents.push_back(event);
+        if(traceEvents.size() >= MAX_TRACE_EVENTS) writeTrace();
+      }
+    }
+
+    /**
+     * \brief Adds a sample that was measured by somebody else, e.g. the
+     * duration of the collision detection within the physics step.
+     *
+     * post:
+     *     - returns the end of the sample
+     */
+    StepProfiler::Clock::time_point StepProfiler::addSample(int phase,
+                                                            Clock::time_point start,
+                                                            double seconds) {
+      Clock::time_point end = start + duration_cast<Clock::duration>(duration<double>(seconds));
+      addSample(phase, start, end);
+      return end;
+    }
+
+    void StepProfiler::endStep(data_broker::DataBrokerInterface *dataBroker) {
+      if(!enabled) return;
+      if(++numSteps >= window) {
+        if(dataBroker) publish(dataBroker);
+        if(traceFile) {
+          writeTrace();
+          fflush(traceFile);
+        }
+        reset();
+      }
+    }
+
+    /**
+     * \brief Returns the bucket of a duration.
+     *
+     * Durations below 2^SUB_BUCKET_BITS ns have their own bucket, above
+     * every power of two is split into 2^SUB_BUCKET_BITS buckets. Thus the
+     * relative error of a percentile is below 2^-SUB_BUCKET_BITS.
+     */
+    int StepProfiler::getBucket(long long ns) {
+      if(ns < (1 << SUB_BUCKET_BITS)) return (int)ns;
+      int msb = 0;
+#ifdef __GNUC__
+      msb = 63 - __builtin_clzll((unsigned long long)ns);
+#else
+      for(long long v=ns; v>1; v>>=1) ++msb;
+#endif
+      int shift = msb - SUB_BUCKET_BITS;
+      int sub = (int)(ns >> shift) & ((1 << SUB_BUCKET_BITS) - 1);
+      return ((shift + 1) << SUB_BUCKET_BITS) + sub;
+    }
+
+    // returns the largest duration that falls into the bucket
+    long long StepProfiler::getBucketLimit(int bucket) {
+      if(bucket < (1 << SUB_BUCKET_BITS)) return bucket;
+      int shift = (bucket >> SUB_BUCKET_BITS) - 1;
+      long long sub = bucket & ((1 << SUB_BUCKET_BITS) - 1);
+      long long lower = ((1LL << SUB_BUCKET_BITS) + sub) << shift;
+      return lower + (1LL << shift) - 1;
+    }
+
+    long long StepProfiler::getPercentile(const phase &p,
+                                          double percentile) const {
+      if(p.count == 0) return 0;
+      unsigned int target = (unsigned int)ceil(percentile*p.count);
+      unsigned int sum = 0;
+      if(target < 1) target = 1;
+      for(int i=0; i<NUM_BUCKETS; ++i) {
+        sum += p.histogram[i];
+        if(sum >= target) return std::min(getBucketLimit(i), p.max);
+      }
+      return p.max;
+    }
+
+    /**
+     * \brief Publishes the median, the 99th percentile and the maximum of
+     * every phase in ms.
+     */
+    void StepProfiler::publish(data_broker::DataBrokerInterface *dataBroker) {
+      if(packagePhases != phases.size()) {
+        // new phases change the layout of the package
+        package.clear();
+        package.add("steps", (int)numSteps);
+        for(size_t i=0; i<phases.size(); ++i) {
+          package.add(phases[i].name + "/p50", 0.0);
+          package.add(phases[i].name + "/p99", 0.0);
+          package.add(phases[i].name + "/max", 0.0);
+        }
+        packageId = dataBroker->registerPackage("mars_sim", "stepProfile",
+                                                package,
+                                                data_broker::DATA_PACKAGE_READ_FLAG);
+        packagePhases = phases.size();
+      }
+      package[0].i = numSteps;
+      for(size_t i=0; i<phases.size(); ++i) {
+        package[i*3+1].d = getPercentile(phases[i], 0.5) * 1e-6;
+        package[i*3+2].d = getPercentile(phases[i], 0.99) * 1e-6;
+        package[i*3+3].d = phases[i].max * 1e-6;
+      }
+      dataBroker->pushData(packageId, package);
+    }
+
+    // writes the buffered events as complete events with times in us
+    void StepProfiler::writeTrace(void) {
+      std::vector<trace_event>::iterator it;
+      for(it=traceEvents.begin(); it!=traceEvents.end(); ++it) {
+        fprintf(traceFile, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,"
+                "\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                firstTraceEvent ? "" : ",", phases[it->phase].name.c_str(),
+                it->start*1e-3, it->duration*1e-3);
+        firstTraceEvent = false;
+      }
+      traceEvents.clear();
+    }
+
+    void StepProfiler::reset(void) {
+      std::vector<phase>::iterator it;
+      for(it=phases.begin(); it!=phases.end(); ++it) {
+        std::fill(it->histogram.begin(), it->histogram.end(), 0);
+        it->count = 0;
+        it->max = 0;
+      }
+      numSteps = 0;
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
@@ -0,0 +1,146 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+ /**
+ * \file StepProfiler.h
+ * \brief "StepProfiler" measures the duration of the phases of a
+ * simulation step.
+ *
+ */
+
+#ifndef STEP_PROFILER_H
+#define STEP_PROFILER_H
+
+#ifdef _PRINT_HEADER_
+  #warning "StepProfiler.h"
+#endif
+
+#include <mars/data_broker/DataPackage.h>
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mars {
+
+  namespace data_broker {
+    class DataBrokerInterface;
+  }
+
+  namespace sim {
+
+    /**
+     * The profiler records the duration of named phases with a monotonic
+     * high resolution clock. Every phase has a histogram with logarithmic
+     * buckets, so recording a sample is constant time and never allocates.
+     * After a window of steps the median, the 99th percentile and the
+     * maximum of every phase are published on the DataBroker under
+     * "mars_sim/stepProfile" and the histograms are reset.
+     * Optionally all samples are written as complete events in the Chrome
+     * trace format (chrome://tracing or https://ui.perfetto.dev).
+     * The profiler is not thread safe, it is used by the physics thread.
+     */
+    class StepProfiler {
+    public:
+      typedef std::chrono::steady_clock Clock;
+
+      /**
+       * Measures the lifetime of the object as one sample of a phase.
+       */
+      class Scope {
+      public:
+        Scope(StepProfiler *profiler, int phase) : profiler(profiler),
+                                                   phase(phase) {
+          if(profiler->isEnabled()) start = Clock::now();
+          else this->profiler = 0;
+        }
+        ~Scope() {
+          if(profiler) profiler->addSample(phase, start, Clock::now());
+        }
+      private:
+        StepProfiler *profiler;
+        int phase;
+        Clock::time_point start;
+      };
+
+      StepProfiler(void);
+      ~StepProfiler(void);
+
+      void setEnabled(bool enabled);
+      bool isEnabled(void) const {return enabled;}
+      // number of steps that are summarized in one published package
+      void setWindow(int steps);
+      bool openTrace(const std::string &filename);
+      void closeTrace(void);
+
+      /**
+       * Returns the id of the phase with the given name. The phase is
+       * created if it does not exist yet.
+       */
+      int getPhase(const std::string &name);
+      void addSample(int phase, Clock::time_point start, Clock::time_point end);
+      Clock::time_point addSample(int phase, Clock::time_point start,
+                                  double seconds);
+      // ends a step and publishes the statistics at the end of a window
+      void endStep(data_broker::DataBrokerInterface *dataBroker);
+
+    private:
+      // each power of two is divided into 2^SUB_BUCKET_BITS buckets
+      static const int SUB_BUCKET_BITS = 3;
+      static const int NUM_BUCKETS = 64 << SUB_BUCKET_BITS;
+
+      struct phase {
+        std::string name;
+        std::vector<unsigned int> histogram;
+        unsigned int count;
+        long long max;
+      };
+
+      struct trace_event {
+        int phase;
+        long long start, duration;
+      };
+
+      bool enabled;
+      int window, numSteps;
+      Clock::time_point origin;
+      std::vector<phase> phases;
+      std::map<std::string, int> phaseIds;
+      std::vector<trace_event> traceEvents;
+      FILE *traceFile;
+      bool firstTraceEvent;
+      data_broker::DataPackage package;
+      unsigned long packageId;
+      size_t packagePhases;
+
+      static int getBucket(long long ns);
+      static long long getBucketLimit(int bucket);
+      long long getPercentile(const phase &p, double percentile) const;
+      void publish(data_broker::DataBrokerInterface *dataBroker);
+      void writeTrace(void);
+      void reset(void);
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif  // STEP_PROFILER_H
@@ -911,11 +911,8 @@ namespace mars {
      *
      */
     void JointPhysics::update(void) {
-      const dReal *b1_pos, *b2_pos;
       dReal anchor[4], axis[4], axis2[4];
       int calc1 = 0, calc2 = 0;
-      dReal radius, dot, torque;
-      dReal v1[3], normal[3], load[3], tmp1[3], axis_force[3];
       MutexLocker locker(&(theWorld->iMutex));
 
       switch(joint_type) {
@@ -950,9 +947,33 @@ namespace mars {
         break;
       }
       motor_torque = feedback.lambda;
-      axis1_torque.x() = axis1_torque.y() = axis1_torque.z() = 0;
-      axis2_torque.x() = axis2_torque.y() = axis2_torque.z() = 0;
-      joint_load.x() = joint_load.y() = joint_load.z() = 0;
+      calculateAxisTorques(anchor, axis, axis2, calc1, calc2,
+                           &axis1_torque, &axis2_torque, &joint_load);
+    }
+
+    /**
+     * \brief Splits the feedback of the joint into the torques around the
+     * axes and the remaining load. calc1 and calc2 select the calculation
+     * for the first and second axis: 1 for a rotational axis, 2 for a
+     * slider and 0 for none.
+     *
+     * pre:
+     *     - the iMutex of the world is locked
+     */
+    void JointPhysics::calculateAxisTorques(const dReal *anchor,
+                                            const dReal *axis,
+                                            const dReal *axis2,
+                                            int calc1, int calc2,
+                                            Vector *axis1_torque,
+                                            Vector *axis2_torque,
+                                            Vector *joint_load) const {
+      const dReal *b1_pos, *b2_pos;
+      dReal radius, dot, torque;
+      dReal v1[3], normal[3], load[3], tmp1[3], axis_force[3];
+
+      axis1_torque->x() = axis1_torque->y() = axis1_torque->z() = 0;
+      axis2_torque->x() = axis2_torque->y() = axis2_torque->z() = 0;
+      joint_load->x() = joint_load->y() = joint_load->z() = 0;
       if(calc1 == 1) {
         if(body1) {
           b1_pos = dBodyGetPosition(body1);
@@ -963,23 +984,23 @@ namespace mars {
           dOPEC(normal, *=, dot);
           dOP(load, -, feedback.f1, normal);
           dCROSS(tmp1, =, v1, normal);
-          axis1_torque.x() = (sReal)tmp1[0];
-          axis1_torque.y() = (sReal)tmp1[1];
-          axis1_torque.z() = (sReal)tmp1[2];
+          axis1_torque->x() = (sReal)tmp1[0];
+          axis1_torque->y() = (sReal)tmp1[1];
+          axis1_torque->z() = (sReal)tmp1[2];
           dCROSS(tmp1, =, v1, load);
-          joint_load.x() = (sReal)tmp1[0];
-          joint_load.y() = (sReal)tmp1[1];
-          joint_load.z() = (sReal)tmp1[2];
+          joint_load->x() = (sReal)tmp1[0];
+          joint_load->y() = (sReal)tmp1[1];
+          joint_load->z() = (sReal)tmp1[2];
           // now nearly the same for the torque
           dot = dDOT(axis, feedback.t1);
           dOPC(tmp1, *, axis, dot);
           dOP(load, -, feedback.t1, tmp1);
-          axis1_torque.x() += (sReal)tmp1[0];
-          axis1_torque.y() += (sReal)tmp1[1];
-          axis1_torque.z() += (sReal)tmp1[2];
-          joint_load.x() += (sReal)load[0];
-          joint_load.y() += (sReal)load[1];
-          joint_load.z() += (sReal)load[2];
+          axis1_torque->x() += (sReal)tmp1[0];
+          axis1_torque->y() += (sReal)tmp1[1];
+          axis1_torque->z() += (sReal)tmp1[2];
+          joint_load->x() += (sReal)load[0];
+          joint_load->y() += (sReal)load[1];
+          joint_load->z() += (sReal)load[2];
         }
         else if(body2) {
           // now we do it correct
@@ -1006,23 +1027,23 @@ namespace mars {
           dOPC(tmp1, *, axis, dot);
           dOP(load, -, normal, tmp1);
           //dCROSS(tmp1, =, v1, normal);
-          axis1_torque.x() = (sReal)tmp1[0];
-          axis1_torque.y() = (sReal)tmp1[1];
-          axis1_torque.z() = (sReal)tmp1[2];
+          axis1_torque->x() = (sReal)tmp1[0];
+          axis1_torque->y() = (sReal)tmp1[1];
+          axis1_torque->z() = (sReal)tmp1[2];
           //dCROSS(tmp1, =, v1, load);
-          joint_load.x() = (sReal)load[0];
-          joint_load.y() = (sReal)load[1];
-          joint_load.z() = (sReal)load[2];
+          joint_load->x() = (sReal)load[0];
+          joint_load->y() = (sReal)load[1];
+          joint_load->z() = (sReal)load[2];
           // now nearly the same for the torque
           dot = dDOT(feedback.t2, axis);
           dOPC(tmp1, *, axis, dot);
           dOP(load, -, feedback.t2, tmp1);
-          //axis1_torque.x() += (sReal)tmp1[0];
-          //axis1_torque.y() += (sReal)tmp1[1];
-          //axis1_torque.z() += (sReal)tmp1[2];
-          joint_load.x() += (sReal)load[0];
-          joint_load.y() += (sReal)load[1];
-          joint_load.z() += (sReal)load[2];
+          //axis1_torque->x() += (sReal)tmp1[0];
+          //axis1_torque->y() += (sReal)tmp1[1];
+          //axis1_torque->z() += (sReal)tmp1[2];
+          joint_load->x() += (sReal)load[0];
+          joint_load->y() += (sReal)load[1];
+          joint_load->z() += (sReal)load[2];
         }
       }
       else if(calc1 == 2) {
@@ -1036,14 +1057,14 @@ namespace mars {
           dCROSS(normal, =, axis2, v1);
           dot = dDOT(normal, feedback.f1);
           dOPEC(normal, *=, dot*radius);
-          axis2_torque.x() = (sReal)normal[0];
-          axis2_torque.y() = (sReal)normal[1];
-          axis2_torque.z() = (sReal)normal[2];
+          axis2_torque->x() = (sReal)normal[0];
+          axis2_torque->y() = (sReal)normal[1];
+          axis2_torque->z() = (sReal)normal[2];
           // now nearly the same for the torque
           dot = dDOT(axis2, feedback.t1);
-          axis2_torque.x() += (sReal)(axis2[0]*dot);
-          axis2_torque.y() += (sReal)(axis2[1]*dot);
-          axis2_torque.z() += (sReal)(axis2[2]*dot);
+          axis2_torque->x() += (sReal)(axis2[0]*dot);
+          axis2_torque->y() += (sReal)(axis2[1]*dot);
+          axis2_torque->z() += (sReal)(axis2[2]*dot);
         }
         if(body2) {
           b2_pos = dBodyGetPosition(body2);
@@ -1052,14 +1073,14 @@ namespace mars {
           dCROSS(normal, =, axis2, v1);
           dot = dDOT(normal, feedback.f2);
           dOPEC(normal, *=, dot*radius);
-          axis2_torque.x() += (sReal)normal[0];
-          axis2_torque.y() += (sReal)normal[1];
-          axis2_torque.z() += (sReal)normal[2];
+          axis2_torque->x() += (sReal)normal[0];
+          axis2_torque->y() += (sReal)normal[1];
+          axis2_torque->z() += (sReal)normal[2];
           // now nearly the same for the torque
           dot = dDOT(axis2, feedback.t2);
-          axis2_torque.x() += (sReal)(axis2[0]*dot);
-          axis2_torque.y() += (sReal)(axis2[1]*dot);
-          axis2_torque.z() += (sReal)(axis2[2]*dot);
+          axis2_torque->x() += (sReal)(axis2[0]*dot);
+          axis2_torque->y() += (sReal)(axis2[1]*dot);
+          axis2_torque->z() += (sReal)(axis2[2]*dot);
         }
       }
     }
@@ -1070,6 +1091,80 @@ namespace mars {
       t->z() = joint_load.z();
     }
 
+    /**
+     * \brief Writes the state of the joint into entry index of the state
+     * arrays. The joint feedback is only evaluated if it is requested for
+     * the entry.
+     *
+     * pre:
+     *     - the iMutex of the world is locked
+     */
+    void JointPhysics::getState(interfaces::jointStateArrays *states,
+                                size_t index) const {
+      dReal anchor[4] = {0,0,0,0}, axis[4] = {0,0,0,0}, axis2[4] = {0,0,0,0};
+      dReal position1 = 0, position2 = 0, velocity1 = 0, velocity2 = 0;
+      int calc1 = 0, calc2 = 0;
+
+      switch(joint_type) {
+      case  JOINT_TYPE_HINGE:
+        dJointGetHingeAnchor(jointId, anchor);
+        dJointGetHingeAxis(jointId, axis);
+        position1 = dJointGetHingeAngle(jointId);
+        velocity1 = dJointGetHingeAngleRate(jointId);
+        calc1 = 1;
+        break;
+      case JOINT_TYPE_HINGE2:
+        dJointGetHinge2Anchor(jointId, anchor);
+        dJointGetHinge2Axis1(jointId, axis);
+        dJointGetHinge2Axis2(jointId, axis2);
+        position1 = dJointGetHinge2Angle1(jointId);
+        velocity1 = dJointGetHinge2Angle1Rate(jointId);
+        velocity2 = dJointGetHinge2Angle2Rate(jointId);
+        calc1 = 1;
+        break;
+      case JOINT_TYPE_SLIDER:
+        dJointGetSliderAxis(jointId, axis);
+        position1 = dJointGetSliderPosition(jointId);
+        velocity1 = dJointGetSliderPositionRate(jointId);
+        calc1 = 2;
+        break;
+      case JOINT_TYPE_BALL:
+        dJointGetBallAnchor(jointId, anchor);
+        break;
+      case JOINT_TYPE_UNIVERSAL:
+        dJointGetUniversalAnchor(jointId, anchor);
+        dJointGetUniversalAxis1(jointId, axis);
+        dJointGetUniversalAxis2(jointId, axis2);
+        position1 = dJointGetUniversalAngle1(jointId);
+        position2 = dJointGetUniversalAngle2(jointId);
+        velocity1 = dJointGetUniversalAngle1Rate(jointId);
+        velocity2 = dJointGetUniversalAngle2Rate(jointId);
+        calc1 = 1;
+        break;
+      default:
+        break;
+      }
+      states->anchor[index] = Vector(anchor[0], anchor[1], anchor[2]);
+      states->axis1[index] = Vector(axis[0], axis[1], axis[2]);
+      states->axis2[index] = Vector(axis2[0], axis2[1], axis2[2]);
+      states->position1[index] = (sReal)position1;
+      states->position2[index] = (sReal)position2;
+      states->velocity1[index] = (sReal)velocity1;
+      states->velocity2[index] = (sReal)velocity2;
+      states->motor_torque[index] = (sReal)feedback.lambda;
+
+      if(states->feedback[index]) {
+        states->f1[index] = Vector(feedback.f1[0], feedback.f1[1], feedback.f1[2]);
+        states->f2[index] = Vector(feedback.f2[0], feedback.f2[1], feedback.f2[2]);
+        states->t1[index] = Vector(feedback.t1[0], feedback.t1[1], feedback.t1[2]);
+        states->t2[index] = Vector(feedback.t2[0], feedback.t2[1], feedback.t2[2]);
+        calculateAxisTorques(anchor, axis, axis2, calc1, calc2,
+                             &states->axis1_torque[index],
+                             &states->axis2_torque[index],
+                             &states->joint_load[index]);
+      }
+    }
+
 
     /**
      * \brief Creates a fixed joint in the physical environment. For
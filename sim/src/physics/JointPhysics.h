@@ -29,6 +29,7 @@
 
 #include <mars/interfaces/sim/JointInterface.h>
 #include <mars/interfaces/sim/NodeInterface.h>
+#include <mars/interfaces/jointStateArrays.h>
 
 namespace mars {
   namespace sim {
@@ -88,6 +89,7 @@ namespace mars {
       virtual void setLowStop2(interfaces::sReal lowStop2);
       virtual void setHighStop2(interfaces::sReal highStop2);
       virtual void setCFM(interfaces::sReal cfm);
+      void getState(interfaces::jointStateArrays *states, size_t index) const;
 
     private:
       std::shared_ptr<WorldPhysics> theWorld;
@@ -102,6 +104,11 @@ namespace mars {
       dReal motor_torque;
 
       void calculateCfmErp(const interfaces::JointData *jointS);
+      void calculateAxisTorques(const dReal *anchor, const dReal *axis,
+                                const dReal *axis2, int calc1, int calc2,
+                                utils::Vector *axis1_torque,
+                                utils::Vector *axis2_torque,
+                                utils::Vector *joint_load) const;
 
       ///create a joint from type Hing
       void createHinge(interfaces::JointData* jointS,
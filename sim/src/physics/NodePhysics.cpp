@@ -43,13 +43,16 @@
 #include <mars/utils/mathUtils.h>
 #include <mars/interfaces/sensor_bases.h>
 #include <mars/interfaces/terrainStruct.h>
+#include <algorithm>
 #include <cmath>
-#include <set>
 
 #include <mars/interfaces/Logging.hpp>
 
 #include <ode/odemath.h>
 
+// the samples around a bounding box that are kept loaded of a tiled terrain
+#define TERRAIN_TILE_MARGIN 2
+
 
 namespace mars {
   namespace sim {
@@ -76,12 +79,12 @@ namespace mars {
       theWorld = std::dynamic_pointer_cast<WorldPhysics>(world);
       nBody = 0;
       nGeom = 0;
-      myVertices = 0;
-      myIndices = 0;
       myTriMeshData = 0;
+      myTriMeshKey = 0;
       composite = false;
       //node_data.num_ground_collisions = 0;
       node_data.setZero();
+      terrain = 0;
       height_data = 0;
       dMassSetZero(&nMass);
     }
@@ -104,9 +107,10 @@ namespace mars {
       if(nBody) theWorld->destroyBody(nBody, this);
 
       if(nGeom) dGeomDestroy(nGeom);
+      if(terrain && terrain->tiles) theWorld->removeTiledTerrain(this);
+      theWorld->releaseContactMaterial(node_data.contact_material);
 
-      if(myVertices) free(myVertices);
-      if(myIndices) free(myIndices);
+      theWorld->releaseTriMeshData(myTriMeshData, myTriMeshKey);
       if(height_data) free(height_data);
 
       // TODO: how does this loop work? why doesn't it run forever?
@@ -118,7 +122,6 @@ namespace mars {
         dGeomDestroy((*iter).geom);
         sensor_list.erase(iter);
       }
-      if(myTriMeshData) dGeomTriMeshDataDestroy(myTriMeshData);
     }
 
     dReal heightfield_callback(void* pUserData, int x, int z ) {
@@ -216,6 +219,8 @@ namespace mars {
           node_data.filter_sphere.z() = 0.0;//node->map["c_filter_sphere"][2];
           node_data.filter_radius = node->map["c_filter_sphere"][3];
         }
+        // geoms without body are collided from the static space
+        theWorld->updateGeomSpace(nGeom);
         dGeomSetData(nGeom, &node_data);
         locker.unlock();
         setContactParams(node->c_params);
@@ -633,31 +638,31 @@ namespace mars {
         return false;
       }
 
-      myVertices = (dVector3*)calloc(node->mesh.vertexcount, sizeof(dVector3));
-      myIndices = (dTriIndex*)calloc(node->mesh.indexcount, sizeof(dTriIndex));
+      dVector3 *vertices = (dVector3*)calloc(node->mesh.vertexcount, sizeof(dVector3));
+      dTriIndex *indices = (dTriIndex*)calloc(node->mesh.indexcount, sizeof(dTriIndex));
       //LOG_DEBUG("%d %d", node->mesh.vertexcount, node->mesh.indexcount);
       // first we have to copy the mesh data to prevent errors in case
       // of double to float conversion
       dReal minx, miny, minz, maxx, maxy, maxz;
       for(i=0; i<node->mesh.vertexcount; i++) {
-        myVertices[i][0] = (dReal)node->mesh.vertices[i][0];
-        myVertices[i][1] = (dReal)node->mesh.vertices[i][1];
-        myVertices[i][2] = (dReal)node->mesh.vertices[i][2];
+        vertices[i][0] = (dReal)node->mesh.vertices[i][0];
+        vertices[i][1] = (dReal)node->mesh.vertices[i][1];
+        vertices[i][2] = (dReal)node->mesh.vertices[i][2];
         if(i==0) {
-          minx = myVertices[i][0];
-          maxx = myVertices[i][0];
-          miny = myVertices[i][1];
-          maxy = myVertices[i][1];
-          minz = myVertices[i][2];
-          maxz = myVertices[i][2];
+          minx = vertices[i][0];
+          maxx = vertices[i][0];
+          miny = vertices[i][1];
+          maxy = vertices[i][1];
+          minz = vertices[i][2];
+          maxz = vertices[i][2];
         }
         else {
-          if(minx > myVertices[i][0]) minx = myVertices[i][0];
-          if(maxx < myVertices[i][0]) maxx = myVertices[i][0];
-          if(miny > myVertices[i][1]) miny = myVertices[i][1];
-          if(maxy < myVertices[i][1]) maxy = myVertices[i][1];
-          if(minz > myVertices[i][2]) minz = myVertices[i][2];
-          if(maxz < myVertices[i][2]) maxz = myVertices[i][2];
+          if(minx > vertices[i][0]) minx = vertices[i][0];
+          if(maxx < vertices[i][0]) maxx = vertices[i][0];
+          if(miny > vertices[i][1]) miny = vertices[i][1];
+          if(maxy < vertices[i][1]) maxy = vertices[i][1];
+          if(minz > vertices[i][2]) minz = vertices[i][2];
+          if(maxz < vertices[i][2]) maxz = vertices[i][2];
         }
       }
       // rescale
@@ -665,19 +670,21 @@ namespace mars {
       dReal sy = node->ext.y()/(maxy-miny);
       dReal sz = node->ext.z()/(maxz-minz);
       for(i=0; i<node->mesh.vertexcount; i++) {
-        myVertices[i][0] *= sx;
-        myVertices[i][1] *= sy;
-        myVertices[i][2] *= sz;
+        vertices[i][0] *= sx;
+        vertices[i][1] *= sy;
+        vertices[i][2] *= sz;
       }
       for(i=0; i<node->mesh.indexcount; i++) {
-        myIndices[i] = (dTriIndex)node->mesh.indices[i];
+        indices[i] = (dTriIndex)node->mesh.indices[i];
       }
 
-      // then we can build the ode representation
-      myTriMeshData = dGeomTriMeshDataCreate();
-      dGeomTriMeshDataBuildSimple(myTriMeshData, (dReal*)myVertices,
-                                  node->mesh.vertexcount,
-                                  myIndices, node->mesh.indexcount);
+      // then we can build the ode representation, or reuse the one of
+      // another node with the same mesh
+      myTriMeshData = theWorld->acquireTriMeshData(vertices,
+                                                   node->mesh.vertexcount,
+                                                   indices,
+                                                   node->mesh.indexcount,
+                                                   &myTriMeshKey);
       nGeom = dCreateTriMesh(theWorld->getSpace(), myTriMeshData, 0, 0, 0);
 
       // at this moment we set the mass properties as the mass of the
@@ -842,11 +849,17 @@ namespace mars {
       unsigned long size;
       int x, y;
       terrain = node->terrain;
-      size = terrain->width*terrain->height;
-      if(!height_data) height_data = (dReal*)calloc(size, sizeof(dReal));
-      for(x=0; x<terrain->height; x++) {
-        for(y=0; y<terrain->width; y++) {
-          height_data[(terrain->height-(x+1))*terrain->width+y] = (dReal)terrain->pixelData[x*terrain->width+y];
+      if(terrain->tiles) {
+        // the callback reads the mapped tiles directly
+        theWorld->addTiledTerrain(this);
+      }
+      else {
+        size = terrain->width*terrain->height;
+        if(!height_data) height_data = (dReal*)calloc(size, sizeof(dReal));
+        for(x=0; x<terrain->height; x++) {
+          for(y=0; y<terrain->width; y++) {
+            height_data[(terrain->height-(x+1))*terrain->width+y] = (dReal)terrain->pixelData[x*terrain->width+y];
+          }
         }
       }
       // build the ode representation
@@ -1060,6 +1073,8 @@ namespace mars {
         // deferre destruction of geom until after the successful creation of 
         // a new geom
         dGeomID tmpGeomId = nGeom;
+        dTriMeshDataID tmpTriMeshData = myTriMeshData;
+        uint64_t tmpTriMeshKey = myTriMeshKey;
         // first we create a ode geometry for the node
         bool success = false;
         switch(node->physicMode) {
@@ -1095,6 +1110,14 @@ namespace mars {
           nBody = NULL;
         }
         dGeomDestroy(tmpGeomId);
+        if(tmpTriMeshData) {
+          // a new mesh was acquired by createMesh()
+          theWorld->releaseTriMeshData(tmpTriMeshData, tmpTriMeshKey);
+          if(node->physicMode != NODE_TYPE_MESH) {
+            myTriMeshData = 0;
+            myTriMeshKey = 0;
+          }
+        }
         // now the geom is rebuild and we have to reconnect it to the body
         // and reset the mass of the body
         if(!node->movable) {
@@ -1136,6 +1159,7 @@ namespace mars {
             }
           }
         }
+        theWorld->updateGeomSpace(nGeom);
         dGeomSetData(nGeom, &node_data);
         locker.unlock();
         setContactParams(node->c_params);
@@ -1284,7 +1308,7 @@ namespace mars {
     void NodePhysics::getContactIDs(std::list<interfaces::NodeId> *ids) const {
       ids->clear();
       if(nGeom) {
-        *ids = node_data.contact_ids;
+        ids->assign(node_data.contact_ids.begin(), node_data.contact_ids.end());
       }
     }
 
@@ -1311,6 +1335,97 @@ namespace mars {
       return dLENGTH(force);
     }
 
+    /**
+     * \brief Copies the position, rotation, velocities, forces and ground
+     * contact of the node into entry index of the state arrays.
+     *
+     * pre:
+     *     - the WorldPhysics::iMutex is locked
+     *     - the state arrays have at least index+1 entries
+     */
+    void NodePhysics::getState(interfaces::nodeStateArrays *states,
+                               size_t index) const {
+      const dReal *tmp;
+      dQuaternion q;
+
+      if(nGeom) {
+        tmp = dGeomGetPosition(nGeom);
+        states->pos[index] = Vector(tmp[0], tmp[1], tmp[2]);
+        dGeomGetQuaternion(nGeom, q);
+        states->rot[index] = Quaternion(q[0], q[1], q[2], q[3]);
+      }
+      else {
+        states->pos[index] = Vector(0, 0, 0);
+        states->rot[index] = Quaternion(1, 0, 0, 0);
+      }
+      if(nBody) {
+        tmp = dBodyGetLinearVel(nBody);
+        states->l_vel[index] = Vector(tmp[0], tmp[1], tmp[2]);
+        tmp = dBodyGetAngularVel(nBody);
+        states->a_vel[index] = Vector(tmp[0], tmp[1], tmp[2]);
+        tmp = dBodyGetForce(nBody);
+        states->f[index] = Vector(tmp[0], tmp[1], tmp[2]);
+        tmp = dBodyGetTorque(nBody);
+        states->t[index] = Vector(tmp[0], tmp[1], tmp[2]);
+      }
+      else {
+        states->l_vel[index] = Vector(0, 0, 0);
+        states->a_vel[index] = Vector(0, 0, 0);
+        states->f[index] = Vector(0, 0, 0);
+        states->t[index] = Vector(0, 0, 0);
+      }
+      states->ground_contact[index] = getGroundContact();
+      states->ground_contact_force[index] = getGroundContactForce();
+    }
+
+    bool NodePhysics::getBodyState(bodyState *state) const {
+      const dReal *tmp;
+      MutexLocker locker(&(theWorld->iMutex));
+      if(!nBody) return false;
+      tmp = dBodyGetPosition(nBody);
+      state->pos = Vector(tmp[0], tmp[1], tmp[2]);
+      tmp = dBodyGetQuaternion(nBody);
+      state->rot = Quaternion(tmp[0], tmp[1], tmp[2], tmp[3]);
+      tmp = dBodyGetLinearVel(nBody);
+      state->l_vel = Vector(tmp[0], tmp[1], tmp[2]);
+      tmp = dBodyGetAngularVel(nBody);
+      state->a_vel = Vector(tmp[0], tmp[1], tmp[2]);
+      tmp = dBodyGetForce(nBody);
+      state->f = Vector(tmp[0], tmp[1], tmp[2]);
+      tmp = dBodyGetTorque(nBody);
+      state->t = Vector(tmp[0], tmp[1], tmp[2]);
+      return true;
+    }
+
+    /**
+     * \brief Sets the state of the body. Composite nodes share their body,
+     * thus setting the state for every part of a composite is idempotent.
+     *
+     * pre:
+     *     - the state was read by getBodyState() of this node
+     */
+    void NodePhysics::setBodyState(const bodyState &state) {
+      MutexLocker locker(&(theWorld->iMutex));
+      if(!nBody) return;
+      dQuaternion q;
+      q[0] = (dReal)state.rot.w();
+      q[1] = (dReal)state.rot.x();
+      q[2] = (dReal)state.rot.y();
+      q[3] = (dReal)state.rot.z();
+      dBodySetPosition(nBody, (dReal)state.pos.x(), (dReal)state.pos.y(),
+                       (dReal)state.pos.z());
+      dBodySetQuaternion(nBody, q);
+      dBodySetLinearVel(nBody, (dReal)state.l_vel.x(), (dReal)state.l_vel.y(),
+                        (dReal)state.l_vel.z());
+      dBodySetAngularVel(nBody, (dReal)state.a_vel.x(), (dReal)state.a_vel.y(),
+                         (dReal)state.a_vel.z());
+      dBodySetForce(nBody, (dReal)state.f.x(), (dReal)state.f.y(),
+                    (dReal)state.f.z());
+      dBodySetTorque(nBody, (dReal)state.t.x(), (dReal)state.t.y(),
+                     (dReal)state.t.z());
+      dBodyEnable(nBody);
+    }
+
     const Vector NodePhysics::getContactForce(void) const {
       std::vector<dJointFeedback*>::const_iterator iter;
       dReal force[3] = {0,0,0};
@@ -1378,12 +1493,68 @@ namespace mars {
     }
 
     dReal NodePhysics::heightCallback(int x, int y) {
-
+      if(terrain->tiles) {
+        // the rows of the tiles are flipped like the pixelData
+        return (dReal)terrain->tiles->getSample(x, terrain->height-1-y)*terrain->scale;
+      }
       return (dReal)height_data[(y*terrain->width)+x]*terrain->scale;
     }
 
+    static int terrainSampleIndex(double v, int size) {
+      if(!(v > -TERRAIN_TILE_MARGIN)) return -TERRAIN_TILE_MARGIN;
+      if(v > size + TERRAIN_TILE_MARGIN) return size + TERRAIN_TILE_MARGIN;
+      return (int)floor(v);
+    }
+
+    /**
+     * \brief Requests the tiles of a tiled terrain below the given bounding
+     * boxes and releases all others.
+     *
+     * pre:
+     *     - the world mutex is locked
+     *     - aabbs holds six values per box in the layout of dGeomGetAABB
+     */
+    void NodePhysics::updateTerrainTiles(const std::vector<dReal> &aabbs) {
+      if(!nGeom || !terrain || !terrain->tiles) return;
+      const dReal *pos = dGeomGetPosition(nGeom);
+      const dReal *R = dGeomGetRotation(nGeom);
+      double cellX = terrain->targetWidth / (terrain->width-1);
+      double cellZ = terrain->targetHeight / (terrain->height-1);
+      double p[3], lx, lz, minX, maxX, minZ, maxZ;
+
+      for(size_t i=0; i+5<aabbs.size(); i+=6) {
+        minX = minZ = dInfinity;
+        maxX = maxZ = -dInfinity;
+        // the heightfield spans the local x and z axis of the geom
+        for(int c=0; c<8; ++c) {
+          p[0] = aabbs[i+(c&1)] - pos[0];
+          p[1] = aabbs[i+2+((c>>1)&1)] - pos[1];
+          p[2] = aabbs[i+4+((c>>2)&1)] - pos[2];
+          lx = R[0]*p[0] + R[4]*p[1] + R[8]*p[2];
+          lz = R[2]*p[0] + R[6]*p[1] + R[10]*p[2];
+          minX = std::min(minX, lx);
+          maxX = std::max(maxX, lx);
+          minZ = std::min(minZ, lz);
+          maxZ = std::max(maxZ, lz);
+        }
+        int x0 = terrainSampleIndex((minX + 0.5*terrain->targetWidth) / cellX, terrain->width);
+        int x1 = terrainSampleIndex((maxX + 0.5*terrain->targetWidth) / cellX, terrain->width)+1;
+        int z0 = terrainSampleIndex((minZ + 0.5*terrain->targetHeight) / cellZ, terrain->height);
+        int z1 = terrainSampleIndex((maxZ + 0.5*terrain->targetHeight) / cellZ, terrain->height)+1;
+        terrain->tiles->requestRegion(x0 - TERRAIN_TILE_MARGIN,
+                                      terrain->height-1-z1 - TERRAIN_TILE_MARGIN,
+                                      x1 + TERRAIN_TILE_MARGIN,
+                                      terrain->height-1-z0 + TERRAIN_TILE_MARGIN);
+      }
+      terrain->tiles->releaseTiles();
+    }
+
     void NodePhysics::setContactParams(contact_params& c_params) {
       MutexLocker locker(&(theWorld->iMutex));
+      // equal parameters keep their material, a new one extends the table
+      unsigned int material = theWorld->internContactMaterial(c_params);
+      theWorld->releaseContactMaterial(node_data.contact_material);
+      node_data.contact_material = material;
       node_data.c_params = c_params;
       if(nGeom) {
         dGeomSetCollideBits(nGeom, c_params.coll_bitmask);
@@ -1614,118 +1785,101 @@ namespace mars {
       std::vector<sensor_list_element>::iterator iter;
       const dReal* pos = dGeomGetPosition(nGeom);
       const dReal* rot = dGeomGetRotation(nGeom);
-      dVector3 dest, tmp, posOffset;
-      dReal steps_size = 1.0, length = 0.0;
-      bool done = false;
-      int steps = 0;
+      dVector3 tmp, posOffset;
       dReal worldStep = theWorld->getWorldStep();
+      ray_query query;
+      BaseSensor *batchSensor = 0;
+      double maxDistance = 0.0;
+      bool grid = false;
       // RotatingRaySensor
       utils::Vector tmpV;
       utils::Quaternion turnrotation;
       turnrotation.setIdentity();
-      std::set<unsigned long> ids_rotating_ray_sensors;
 
-      //New Code
-      int i=0;
+      // the rays of one sensor are stored consecutively in the sensor_list,
+      // all rays of a sensor that is due are collected into one batch
+      ray_batch.clear();
+      ray_batch_elements.clear();
       for(iter = sensor_list.begin(); iter != sensor_list.end(); iter++) {
-        i+=1;
         if((double)iter->sensor->updateRate * 0.001 > worldStep) {
           iter->updateTime += worldStep;
           if(iter->updateTime < 0.001*iter->sensor->updateRate) continue;
           iter->updateTime -= 0.001*iter->sensor->updateRate;
         }
-        BasePolarIntersectionSensor *polarSensor = dynamic_cast<BasePolarIntersectionSensor*>((*iter).sensor);
-        if(polarSensor){
-          sensor_list_element elem = *iter;
-
-          tmpV[0] = elem.ray_direction.x();
-          tmpV[1] = elem.ray_direction.y();
-          tmpV[2] = elem.ray_direction.z();
-          
-          // Applies orientation_offset (z-Rotation) to the laser rays.
-          mars::sim::RotatingRaySensor *rotRaySensor = dynamic_cast<RotatingRaySensor*>((*iter).sensor);
-          if(rotRaySensor){
-              std::set<unsigned long>::iterator it = ids_rotating_ray_sensors.find(rotRaySensor->id);
-              // Takes care that each rotating ray sensor is only turned once (sensor_list contains each ray independently).
-              if(it == ids_rotating_ray_sensors.end()) {
-                  //turnrotation.setIdentity(); // If we set it to identity first, receiveSensorData will not be called anymore.. wtf!?
-                  turnrotation = rotRaySensor->turn();
-                  ids_rotating_ray_sensors.insert(rotRaySensor->id);
-              }
-              //fprintf(stderr, "tmp[%i]: %f, %f, %f\n", i, tmpV.x(), tmpV.y(), tmpV.z());
-              tmpV = turnrotation * tmpV;
-              //fprintf(stderr, "tmp[%i]: %f, %f, %f\n", i, tmpV.x(), tmpV.y(), tmpV.z());
-          }
-          tmp[0] = tmpV.x();//elem.ray_direction.x();
-          tmp[1] = tmpV.y();//elem.ray_direction.y();
-          tmp[2] = tmpV.z();//elem.ray_direction.z();
-          dMULTIPLY0_331(dest, rot, tmp);
-
-          if(physics_thread) {
-            steps = 0;
-            length = 0.0;
-            done = false;
-            dGeomEnable(elem.geom);
-            // make here the collision check
-            while (!done) {
-              dGeomRaySet(elem.geom,
-                          pos[0] + dest[0]*steps_size*steps,
-                          pos[1] + dest[1]*steps_size*steps,
-                          pos[2] + dest[2]*steps_size*steps,
-                          dest[0], dest[1], dest[2]);
-              if(length + steps_size < polarSensor->maxDistance) {
-                steps++;
-                dGeomRaySetLength(elem.geom, steps_size);
-              }
-              else {
-                dGeomRaySetLength(elem.geom, polarSensor->maxDistance- length);
-                done = true;
-              }
-              if(theWorld->handleCollision(elem.geom)) {
-                elem.gd->value += length;
-                done = true;
-              }
-              if(!done) length = steps_size*steps;
+
+        if(iter->sensor != batchSensor) {
+          castSensorRays();
+          batchSensor = iter->sensor;
+          turnrotation.setIdentity();
+          BasePolarIntersectionSensor *polarSensor = dynamic_cast<BasePolarIntersectionSensor*>(batchSensor);
+          BaseGridIntersectionSensor *polarGridSensor = dynamic_cast<BaseGridIntersectionSensor*>(batchSensor);
+          if(polarSensor) {
+            maxDistance = polarSensor->maxDistance;
+            grid = false;
+            // Applies orientation_offset (z-Rotation) to the laser rays.
+            // Each rotating ray sensor is only turned once per update.
+            mars::sim::RotatingRaySensor *rotRaySensor = dynamic_cast<RotatingRaySensor*>(batchSensor);
+            if(rotRaySensor) {
+              turnrotation = rotRaySensor->turn();
             }
-            dGeomDisable(elem.geom);
           }
-          (*polarSensor)[elem.index] = elem.gd->value;
-          elem.gd->value = polarSensor->maxDistance;
+          else if(polarGridSensor) {
+            maxDistance = polarGridSensor->maxDistance;
+            grid = true;
+          }
         }
-    
-        BaseGridIntersectionSensor *polarGridSensor;
-        polarGridSensor = dynamic_cast<BaseGridIntersectionSensor*>(iter->sensor);
 
-        if(polarGridSensor) {
-          sensor_list_element elem = *iter;
-
-          if(physics_thread) {
-        
-            tmp[0] = elem.ray_direction.x();
-            tmp[1] = elem.ray_direction.y();
-            tmp[2] = elem.ray_direction.z();
-            dMULTIPLY0_331(dest, rot, tmp);
-
-            tmp[0] = elem.ray_pos_offset.x();
-            tmp[1] = elem.ray_pos_offset.y();
-            tmp[2] = elem.ray_pos_offset.z();
-            dMULTIPLY0_331(posOffset, rot, tmp);
-
-            dGeomEnable(elem.geom);
-
-            dGeomRaySet(elem.geom, pos[0] + posOffset[0],
-                        pos[1] + posOffset[1],
-                        pos[2] + posOffset[2],
-                        dest[0], dest[1], dest[2]);
-
-            dGeomRaySetLength(elem.geom, polarGridSensor->maxDistance);
-            theWorld->handleCollision(elem.geom);
-            dGeomDisable(elem.geom);        
-          }
-          (*polarGridSensor)[elem.index] = elem.gd->value;
-          elem.gd->value = polarGridSensor->maxDistance;      
+        tmpV = turnrotation * iter->ray_direction;
+        tmp[0] = tmpV.x();
+        tmp[1] = tmpV.y();
+        tmp[2] = tmpV.z();
+        dMULTIPLY0_331(query.dir, rot, tmp);
+
+        query.pos[0] = pos[0];
+        query.pos[1] = pos[1];
+        query.pos[2] = pos[2];
+        if(grid) {
+          tmp[0] = iter->ray_pos_offset.x();
+          tmp[1] = iter->ray_pos_offset.y();
+          tmp[2] = iter->ray_pos_offset.z();
+          dMULTIPLY0_331(posOffset, rot, tmp);
+          query.pos[0] += posOffset[0];
+          query.pos[1] += posOffset[1];
+          query.pos[2] += posOffset[2];
         }
+        query.length = maxDistance;
+        query.geom = iter->geom;
+        query.parent_geom = nGeom;
+        query.parent_body = nBody;
+        ray_batch.push_back(query);
+        ray_batch_elements.push_back(&(*iter));
       } // end for loop.
+      castSensorRays();
+    }
+
+    /**
+     * \brief Casts the collected rays of one sensor as a single batch and
+     *  copies the distances into the sensor.
+     *
+     * pre:
+     *     - the world mutex is locked
+     *     - all rays in the batch belong to the same sensor
+     *
+     * post:
+     *     - the batch is empty
+     */
+    void NodePhysics::castSensorRays(void) {
+      if(ray_batch.empty()) return;
+
+      theWorld->castRays(ray_batch);
+      BaseArraySensor<double> *arraySensor = dynamic_cast<BaseArraySensor<double>*>(ray_batch_elements.front()->sensor);
+      if(arraySensor) {
+        for(size_t i=0; i<ray_batch.size(); ++i) {
+          (*arraySensor)[ray_batch_elements[i]->index] = ray_batch[i].value;
+        }
+      }
+      ray_batch.clear();
+      ray_batch_elements.clear();
     }
 
     /**
@@ -1740,19 +1894,19 @@ namespace mars {
       if(nBody) theWorld->destroyBody(nBody, this);
 
       if(nGeom) dGeomDestroy(nGeom);
+      if(terrain && terrain->tiles) theWorld->removeTiledTerrain(this);
+      theWorld->releaseContactMaterial(node_data.contact_material);
 
-      if(myVertices) free(myVertices);
-      if(myIndices) free(myIndices);
-      if(myTriMeshData) dGeomTriMeshDataDestroy(myTriMeshData);
+      theWorld->releaseTriMeshData(myTriMeshData, myTriMeshKey);
 
       nBody = 0;
       nGeom = 0;
-      myVertices = 0;
-      myIndices = 0;
       myTriMeshData = 0;
+      myTriMeshKey = 0;
       composite = false;
       //node_data.num_ground_collisions = 0;
       node_data.setZero();
+      terrain = 0;
       height_data = 0;
     }
 
@@ -1833,7 +1987,7 @@ namespace mars {
         //if(contactsPtr->operator[](0).geom.depth < 0.0) contactsPtr->operator[](0).geom.depth = 0.0; // Why 0 and not i ?
         dJointID c=dJointCreateContact(world, contactgroup, &contactsPtr->operator[](i));
         dJointFeedback *fb;
-        fb = (dJointFeedback*)malloc(sizeof(dJointFeedback));
+        fb = theWorld->createContactFeedback();
         dJointSetFeedback(c, fb); // ODE
         #ifdef DEBUG_ADD_CONTACTS
           if (isnan(abs(fb->f1[0]))||isnan(abs(fb->f1[1]))||isnan(abs(fb->f1[2])) || isnan(abs(fb->f1[3])) ||
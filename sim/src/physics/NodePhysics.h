@@ -58,6 +58,7 @@ namespace mars {
         filter_depth = -1.;
         filter_angle = -1.;
         filter_radius = -1.0;
+        contact_material = 0;
       }
 
       geom_data(){
@@ -66,10 +67,13 @@ namespace mars {
       unsigned long id;
       int num_ground_collisions;
       std::vector<utils::Vector> contact_points;
-      std::list<unsigned long> contact_ids;
+      std::vector<unsigned long> contact_ids;
       std::vector<dJointFeedback*> ground_feedbacks;
       bool node1;
       interfaces::contact_params c_params;
+      // the interned c_params, selects the mixed contact surface of two
+      // geoms from the material table of the world
+      unsigned int contact_material;
       bool ray_sensor;
       bool sense_contact_force;
       interfaces::sReal value;
@@ -132,6 +136,9 @@ namespace mars {
       virtual void addContact(dJointID contactJointId, dContact contact, dJointFeedback* fb);
       virtual std::vector<dJointFeedback*> addContacts(ContactsPhysics contacts, dWorldID world, dJointGroupID contactgroup);
       virtual interfaces::sReal getCollisionDepth(void) const;
+      void getState(interfaces::nodeStateArrays *states, size_t index) const;
+      virtual bool getBodyState(interfaces::bodyState *state) const;
+      virtual void setBodyState(const interfaces::bodyState &state);
       void addCompositeOffset(dReal x, dReal y, dReal z);
       ///return the body; this function is created to make it possible to get the 
       ///body from joint physics s
@@ -140,6 +147,7 @@ namespace mars {
       void addMassToCompositeBody(dBodyID theBody, dMass *bodyMass);
       void getAbsMass(dMass *pMass) const;
       dReal heightCallback(int x, int y);
+      void updateTerrainTiles(const std::vector<dReal> &aabbs);
       virtual void addContact(utils::Vector &point, utils::Vector &normal,
                               interfaces::sReal depth, interfaces::contact_params &c_params_other);
 
@@ -148,14 +156,17 @@ namespace mars {
       dBodyID nBody;
       dGeomID nGeom;
       dMass nMass;
-      dVector3 *myVertices;
-      dTriIndex *myIndices;
+      // the mesh is shared with other nodes, see
+      // WorldPhysics::acquireTriMeshData()
       dTriMeshDataID myTriMeshData;
+      uint64_t myTriMeshKey;
       bool composite;
       geom_data node_data;
       interfaces::terrainStruct *terrain;
       dReal *height_data;
       std::vector<sensor_list_element> sensor_list;
+      std::vector<ray_query> ray_batch;
+      std::vector<sensor_list_element*> ray_batch_elements;
       bool createMesh(interfaces::NodeData *node);
       bool createBox(interfaces::NodeData *node);
       bool createSphere(interfaces::NodeData *node);
@@ -165,6 +176,7 @@ namespace mars {
       bool createHeightfield(interfaces::NodeData *node);
       void setProperties(interfaces::NodeData *node);
       void setInertiaMass(interfaces::NodeData *node);
+      void castSensorRays(void);
     };
 
   } // end of namespace sim
@@ -0,0 +1,356 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file RayCastPhysics.cpp
+ * \brief "RayCastPhysics" casts batches of rays and spheres against an ode
+ * space.
+ *
+ */
+
+#include "RayCastPhysics.h"
+#include "NodePhysics.h"
+
+#include <mars/utils/Thread.h>
+#include <mars/utils/Mutex.h>
+#include <mars/utils/WaitCondition.h>
+
+#include <algorithm>
+#include <cmath>
+
+// a worker thread is only used if it gets at least this number of queries
+#define MIN_QUERIES_PER_THREAD 32
+
+namespace mars {
+  namespace sim {
+
+    using namespace utils;
+
+    /**
+     * Worker thread that processes a range of queries of the current batch.
+     */
+    class RayCastPhysics::Worker : public Thread {
+    public:
+      Worker(RayCastPhysics *caster) : caster(caster), job(0), first(0),
+                                       last(0), busy(false), quit(false) {
+      }
+
+      void dispatch(Job job, size_t start, size_t end) {
+        mutex.lock();
+        this->job = job;
+        first = start;
+        last = end;
+        busy = true;
+        condition.wakeAll();
+        mutex.unlock();
+      }
+
+      void waitDone(void) {
+        mutex.lock();
+        while(busy) condition.wait(&mutex);
+        mutex.unlock();
+      }
+
+      void stop(void) {
+        mutex.lock();
+        quit = true;
+        condition.wakeAll();
+        mutex.unlock();
+        wait();
+      }
+
+    protected:
+      void run(void) {
+        // ode needs thread local data for the collision detection
+        dAllocateODEDataForThread(dAllocateMaskAll);
+        mutex.lock();
+        while(true) {
+          while(!busy && !quit) condition.wait(&mutex);
+          if(quit) break;
+          mutex.unlock();
+          (caster->*job)(first, last);
+          mutex.lock();
+          busy = false;
+          condition.wakeAll();
+        }
+        mutex.unlock();
+        dCleanupODEAllDataForThread();
+      }
+
+    private:
+      RayCastPhysics *caster;
+      Job job;
+      size_t first, last;
+      bool busy, quit;
+      Mutex mutex;
+      WaitCondition condition;
+    };
+
+    RayCastPhysics::RayCastPhysics(void) : batch_rays(0), batch_spheres(0) {
+    }
+
+    RayCastPhysics::~RayCastPhysics(void) {
+      setNumThreads(0);
+    }
+
+    void RayCastPhysics::setNumThreads(int numThreads) {
+      if(numThreads < 0) numThreads = 0;
+      while((int)workers.size() > numThreads) {
+        workers.back()->stop();
+        delete workers.back();
+        workers.pop_back();
+      }
+      while((int)workers.size() < numThreads) {
+        workers.push_back(new Worker(this));
+        workers.back()->start();
+      }
+    }
+
+    int RayCastPhysics::getNumThreads(void) const {
+      return (int)workers.size();
+    }
+
+    /**
+     * \brief Casts all rays of the batch against the spaces.
+     *
+     * pre:
+     *     - the WorldPhysics::iMutex is locked
+     *     - the ray directions are normalized
+     *
+     * post:
+     *     - the value of every ray is set to the closest hit or its length
+     */
+    void RayCastPhysics::castRays(dSpaceID space, dSpaceID static_space,
+                                  std::vector<ray_query> &rays) {
+      if(rays.empty()) return;
+
+      // the bounding box of all ray segments is used to cull the geoms once
+      // for the whole batch
+      dReal aabb[6] = {dInfinity, -dInfinity, dInfinity,
+                       -dInfinity, dInfinity, -dInfinity};
+      std::vector<ray_query>::iterator iter;
+      for(iter=rays.begin(); iter!=rays.end(); ++iter) {
+        iter->value = iter->length;
+        iter->hit = false;
+        for(int i=0; i<3; ++i) {
+          dReal p = iter->pos[i] + iter->dir[i]*iter->length;
+          aabb[i*2] = std::min(aabb[i*2], std::min(iter->pos[i], p));
+          aabb[i*2+1] = std::max(aabb[i*2+1], std::max(iter->pos[i], p));
+        }
+      }
+
+      candidates.clear();
+      collectCandidates(space, aabb);
+      if(static_space) collectCandidates(static_space, aabb);
+      if(candidates.empty()) return;
+
+      batch_rays = &rays;
+      runBatch(&RayCastPhysics::castRange, rays.size());
+      batch_rays = 0;
+    }
+
+    /**
+     * \brief Collides all spheres of the batch with the spaces.
+     *
+     * pre:
+     *     - the WorldPhysics::iMutex is locked
+     *
+     * post:
+     *     - the contacts of every sphere are replaced by the new ones
+     */
+    void RayCastPhysics::collideSpheres(dSpaceID space, dSpaceID static_space,
+                                        std::vector<sphere_query> &spheres) {
+      if(spheres.empty()) return;
+
+      dReal aabb[6] = {dInfinity, -dInfinity, dInfinity,
+                       -dInfinity, dInfinity, -dInfinity};
+      std::vector<sphere_query>::iterator iter;
+      for(iter=spheres.begin(); iter!=spheres.end(); ++iter) {
+        iter->contacts.clear();
+        dGeomSphereSetRadius(iter->geom, iter->radius);
+        dGeomSetPosition(iter->geom, iter->pos[0], iter->pos[1], iter->pos[2]);
+        for(int i=0; i<3; ++i) {
+          aabb[i*2] = std::min(aabb[i*2], iter->pos[i] - iter->radius);
+          aabb[i*2+1] = std::max(aabb[i*2+1], iter->pos[i] + iter->radius);
+        }
+      }
+
+      candidates.clear();
+      collectCandidates(space, aabb);
+      if(static_space) collectCandidates(static_space, aabb);
+      if(candidates.empty()) return;
+
+      batch_spheres = &spheres;
+      runBatch(&RayCastPhysics::collideRange, spheres.size());
+      batch_spheres = 0;
+    }
+
+    /**
+     * \brief Splits the range [0, size) of the current batch between the
+     * worker threads and the calling thread.
+     */
+    void RayCastPhysics::runBatch(Job job, size_t size) {
+      size_t numThreads = workers.size();
+      if(numThreads > size / MIN_QUERIES_PER_THREAD) {
+        numThreads = size / MIN_QUERIES_PER_THREAD;
+      }
+      if(numThreads == 0) {
+        (this->*job)(0, size);
+        return;
+      }
+
+      // the calling thread processes the last chunk itself
+      size_t chunk = size / (numThreads+1);
+      for(size_t i=0; i<numThreads; ++i) {
+        workers[i]->dispatch(job, i*chunk, (i+1)*chunk);
+      }
+      (this->*job)(numThreads*chunk, size);
+      for(size_t i=0; i<numThreads; ++i) {
+        workers[i]->waitDone();
+      }
+    }
+
+    /**
+     * \brief Gathers all enabled geoms of the space and its sub spaces that
+     * overlap the given bounding box.
+     *
+     * Reading the bounding box forces ode to update the cached geom pose.
+     * Afterwards the candidates are only read during the narrow phase,
+     * which allows to collide them from several threads.
+     */
+    void RayCastPhysics::collectCandidates(dSpaceID space, const dReal *aabb) {
+      ray_candidate candidate;
+      dGeomID geom;
+      geom_data *gd;
+      int num = dSpaceGetNumGeoms(space);
+
+      for(int i=0; i<num; ++i) {
+        geom = dSpaceGetGeom(space, i);
+        if(!dGeomIsEnabled(geom)) continue;
+        if(dGeomIsSpace(geom)) {
+          collectCandidates((dSpaceID)geom, aabb);
+          continue;
+        }
+        gd = (geom_data*)dGeomGetData(geom);
+        // ray sensors that live in the space are not collidable
+        if(gd && gd->ray_sensor) continue;
+
+        dGeomGetAABB(geom, candidate.aabb);
+        if(candidate.aabb[0] > aabb[1] || candidate.aabb[1] < aabb[0] ||
+           candidate.aabb[2] > aabb[3] || candidate.aabb[3] < aabb[2] ||
+           candidate.aabb[4] > aabb[5] || candidate.aabb[5] < aabb[4]) {
+          continue;
+        }
+        candidate.geom = geom;
+        candidate.body = dGeomGetBody(geom);
+        candidate.category = dGeomGetCategoryBits(geom);
+        candidate.collide = dGeomGetCollideBits(geom);
+        candidates.push_back(candidate);
+      }
+    }
+
+    void RayCastPhysics::castRange(size_t start, size_t end) {
+      dContactGeom contact;
+      unsigned long category, collide;
+      std::vector<ray_candidate>::const_iterator iter;
+
+      for(size_t i=start; i<end; ++i) {
+        ray_query &ray = (*batch_rays)[i];
+        dGeomRaySet(ray.geom, ray.pos[0], ray.pos[1], ray.pos[2],
+                    ray.dir[0], ray.dir[1], ray.dir[2]);
+        dGeomRaySetLength(ray.geom, ray.length);
+        category = dGeomGetCategoryBits(ray.geom);
+        collide = dGeomGetCollideBits(ray.geom);
+
+        for(iter=candidates.begin(); iter!=candidates.end(); ++iter) {
+          if(!((category & iter->collide) || (iter->category & collide))) {
+            continue;
+          }
+          if(iter->geom == ray.parent_geom) continue;
+          if(ray.parent_body && iter->body == ray.parent_body) continue;
+          // only geoms in front of the closest hit so far are of interest
+          if(!intersectAABB(ray, iter->aabb, ray.value)) continue;
+
+          if(dCollide(iter->geom, ray.geom, 1|CONTACTS_UNIMPORTANT,
+                      &contact, sizeof(dContactGeom))) {
+            if(contact.depth < ray.value) {
+              ray.value = contact.depth;
+              ray.hit = true;
+            }
+          }
+        }
+      }
+    }
+
+    void RayCastPhysics::collideRange(size_t start, size_t end) {
+      dContactGeom contact[MAX_SPHERE_CONTACTS];
+      dReal aabb[6];
+      unsigned long category, collide;
+      int numc;
+      std::vector<ray_candidate>::const_iterator iter;
+
+      for(size_t i=start; i<end; ++i) {
+        sphere_query &sphere = (*batch_spheres)[i];
+        dGeomGetAABB(sphere.geom, aabb);
+        category = dGeomGetCategoryBits(sphere.geom);
+        collide = dGeomGetCollideBits(sphere.geom);
+
+        for(iter=candidates.begin(); iter!=candidates.end(); ++iter) {
+          if(!((category & iter->collide) || (iter->category & collide))) {
+            continue;
+          }
+          if(iter->aabb[0] > aabb[1] || iter->aabb[1] < aabb[0] ||
+             iter->aabb[2] > aabb[3] || iter->aabb[3] < aabb[2] ||
+             iter->aabb[4] > aabb[5] || iter->aabb[5] < aabb[4]) {
+            continue;
+          }
+          numc = dCollide(sphere.geom, iter->geom, MAX_SPHERE_CONTACTS,
+                          contact, sizeof(dContactGeom));
+          sphere.contacts.insert(sphere.contacts.end(), contact, contact+numc);
+        }
+      }
+    }
+
+    /**
+     * \brief Slab test of the ray segment [0, length] against the box.
+     */
+    bool RayCastPhysics::intersectAABB(const ray_query &ray, const dReal *aabb,
+                                       dReal length) {
+      dReal tmin = 0.0, tmax = length;
+      dReal t1, t2, inv;
+
+      for(int i=0; i<3; ++i) {
+        if(fabs(ray.dir[i]) < 1e-12) {
+          if(ray.pos[i] < aabb[i*2] || ray.pos[i] > aabb[i*2+1]) return false;
+          continue;
+        }
+        inv = 1.0 / ray.dir[i];
+        t1 = (aabb[i*2] - ray.pos[i])*inv;
+        t2 = (aabb[i*2+1] - ray.pos[i])*inv;
+        if(t1 > t2) std::swap(t1, t2);
+        if(t1 > tmin) tmin = t1;
+        if(t2 < tmax) tmax = t2;
+        if(tmin > tmax) return false;
+      }
+      return true;
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
@@ -0,0 +1,145 @@
+/*
+ *  Copyright 2026, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+ /**
+ * \file RayCastPhysics.h
+ * \brief "RayCastPhysics" casts batches of rays and spheres against an ode
+ * space.
+ *
+ */
+
+#ifndef RAY_CAST_PHYSICS_H
+#define RAY_CAST_PHYSICS_H
+
+#ifdef _PRINT_HEADER_
+  #warning "RayCastPhysics.h"
+#endif
+
+#include <vector>
+
+#include <ode/ode.h>
+
+namespace mars {
+  namespace sim {
+
+    /**
+     * One ray of a batch query. Position and direction are given in world
+     * coordinates, the direction has to be normalized. The geom is the ray
+     * geom used for the narrow phase; it must not be shared between two
+     * rays of the same batch. Geoms that are equal to parent_geom or that
+     * are attached to parent_body are ignored.
+     * After the query value contains the distance to the closest hit or
+     * length if nothing was hit.
+     */
+    struct ray_query {
+      dVector3 pos;
+      dVector3 dir;
+      dReal length;
+      dGeomID geom;
+      dGeomID parent_geom;
+      dBodyID parent_body;
+      dReal value;
+      bool hit;
+    };
+
+    /**
+     * One sphere of a batch query in world coordinates. As for the rays the
+     * geom must not be shared within a batch. After the query contacts
+     * holds up to MAX_SPHERE_CONTACTS contacts with every geom the sphere
+     * touches. g2 of a contact is the geom of the space, the normal points
+     * out of it like for dCollide(sphere, geom).
+     */
+    struct sphere_query {
+      dVector3 pos;
+      dReal radius;
+      dGeomID geom;
+      std::vector<dContactGeom> contacts;
+    };
+
+    /**
+     * The class casts a batch of rays in one pass against an ode space.
+     * Instead of colliding every ray with the whole space, the geoms of the
+     * space are gathered once per batch and culled against the bounding box
+     * of all rays. Each ray then only runs the narrow phase against the
+     * remaining geoms whose bounding box it intersects.
+     * Batches of spheres are handled the same way.
+     * Optionally the rays of a batch are distributed over a pool of worker
+     * threads. This requires an ode build with thread local collision data
+     * (ode configured with --enable-ou), thus it is disabled by default.
+     */
+    class RayCastPhysics {
+    public:
+      RayCastPhysics(void);
+      ~RayCastPhysics(void);
+
+      /**
+       * Sets the number of additional worker threads used to cast the rays
+       * of one batch. With zero threads all rays are casted in the calling
+       * thread.
+       */
+      void setNumThreads(int numThreads);
+      int getNumThreads(void) const;
+
+      /**
+       * Casts all rays against the geoms of the given spaces. The second
+       * space is optional. The caller has to hold the WorldPhysics::iMutex.
+       */
+      void castRays(dSpaceID space, dSpaceID static_space,
+                    std::vector<ray_query> &rays);
+
+      /**
+       * Collides all spheres with the geoms of the given spaces. The caller
+       * has to hold the WorldPhysics::iMutex.
+       */
+      void collideSpheres(dSpaceID space, dSpaceID static_space,
+                          std::vector<sphere_query> &spheres);
+
+      // maximum number of contacts of a sphere with one geom
+      static const int MAX_SPHERE_CONTACTS = 4;
+
+    private:
+      class Worker;
+      typedef void (RayCastPhysics::*Job)(size_t start, size_t end);
+
+      struct ray_candidate {
+        dGeomID geom;
+        dBodyID body;
+        unsigned long category, collide;
+        dReal aabb[6];
+      };
+
+      std::vector<ray_candidate> candidates;
+      std::vector<Worker*> workers;
+      // the batch that is currently processed by the workers
+      std::vector<ray_query> *batch_rays;
+      std::vector<sphere_query> *batch_spheres;
+
+      void collectCandidates(dSpaceID space, const dReal *aabb);
+      void runBatch(Job job, size_t size);
+      void castRange(size_t start, size_t end);
+      void collideRange(size_t start, size_t end);
+      static bool intersectAABB(const ray_query &ray, const dReal *aabb,
+                                dReal length);
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif  // RAY_CAST_PHYSICS_H
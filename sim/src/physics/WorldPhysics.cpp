@@ -38,6 +38,7 @@
 
 #include "WorldPhysics.h"
 #include "NodePhysics.h"
+#include "JointPhysics.h"
 #include "SimNode.h"
 
 
@@ -47,10 +48,17 @@
 #include <mars/interfaces/sim/SimulatorInterface.h>
 #include <mars/interfaces/sim/NodeManagerInterface.h>
 #include <mars/interfaces/Logging.hpp>
+#include <mars/interfaces/SceneCache.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 
 
 
 #define EPSILON 1e-10
+// number of contact feedbacks allocated at once by the feedback pool
+#define FEEDBACK_BLOCK_SIZE 256
 
 //#define DRAW_MLS_CONTACTS 1
 //#define DEBUG_WORLD_PHYSICS 1
@@ -105,6 +113,15 @@ namespace mars {
       ground_erp = 0.1;
       world = 0;
       space = 0;
+      static_space = 0;
+      broadphase = "hash";
+      static_broadphase = "hash";
+      hash_min_level = -3;
+      hash_max_level = 10;
+      quadtree_depth = 6;
+      collision_time = solver_time = 0.0;
+      space_hash_min_level = space_hash_max_level = space_quadtree_depth = 0;
+      space_num_geoms = static_space_num_geoms = 0;
       contactgroup = 0;
       world_init = 0;
       num_contacts = 0;
@@ -112,6 +129,18 @@ namespace mars {
       log_contacts = 0;
       max_angular_speed = 10.0; // I guess this is rad/s
       max_correcting_vel = 5.0;
+      ray_cast_threads = 0;
+      random_seed = 0;
+      step_threads = 0;
+      step_threading = 0;
+      step_thread_pool = 0;
+      num_step_threads = 0;
+      num_feedbacks = 0;
+      contact_table_size = 0;
+      // id 0 marks geoms without material
+      contact_materials.resize(1);
+      contact_materials[0].friction_direction1 = false;
+      contact_materials[0].references = 0;
 
       // the step size in seconds
       step_size = 0.01;
@@ -151,6 +180,9 @@ namespace mars {
       {
         libManager -> releaseLibrary(it->name);
       }
+      for(size_t i=0; i<feedback_pool.size(); ++i) {
+        delete[] feedback_pool[i];
+      }
     }
 
     /**
@@ -185,7 +217,16 @@ namespace mars {
       if (!world_init) {
         //LOG_DEBUG("init physics world");
         world = dWorldCreate();
-        space = dHashSpaceCreate(0);
+        // the fast step reorders the constraints randomly
+        dRandSetSeed(random_seed);
+        space = createSpace(broadphase, 0, 0);
+        static_space = createSpace(static_broadphase, 0, 0);
+        space_broadphase = broadphase;
+        static_space_broadphase = static_broadphase;
+        space_hash_min_level = hash_min_level;
+        space_hash_max_level = hash_max_level;
+        space_quadtree_depth = quadtree_depth;
+        space_num_geoms = static_space_num_geoms = 0;
         contactgroup = dJointGroupCreate(0);
 
         old_gravity = world_gravity;
@@ -223,12 +264,26 @@ namespace mars {
       MutexLocker locker(&iMutex);
       if(world_init) {
         //LOG_DEBUG("free physics world");
+        freeStepThreading();
         dJointGroupDestroy(contactgroup);
+        dSpaceDestroy(static_space);
         dSpaceDestroy(space);
         dWorldDestroy(world);
         world_init = 0;
       }
       // else debug something
+      std::vector<dGeomID>::iterator it;
+      for(it=query_ray_geoms.begin(); it!=query_ray_geoms.end(); ++it) {
+        dGeomDestroy(*it);
+      }
+      for(it=query_sphere_geoms.begin(); it!=query_sphere_geoms.end(); ++it) {
+        dGeomDestroy(*it);
+      }
+      query_ray_geoms.clear();
+      query_sphere_geoms.clear();
+      tiled_terrains.clear();
+      query_rays.clear();
+      query_spheres.clear();
     }
 
     /**
@@ -270,6 +325,14 @@ namespace mars {
         dWorldSetERP(world, (dReal)world_erp);
       }
 
+      if(step_threads != num_step_threads) {
+        freeStepThreading();
+        if(step_threads > 0) initStepThreading();
+      }
+
+      updateBroadphase();
+      updateTerrainTiles();
+
       for (auto it = std::begin(physics_plugins); it !=std::end(physics_plugins); ++it)
       {
         it->p_interface->preStepChecks();
@@ -279,6 +342,189 @@ namespace mars {
       }
     }
 
+    /**
+     * \brief Creates a collision space of the given broadphase type.
+     *
+     * The bounds of a quadtree space are derived from the extent of the
+     * geoms in the given spaces.
+     */
+    dSpaceID WorldPhysics::createSpace(const std::string &type,
+                                       dSpaceID *spaces, int numSpaces) {
+      if(type == "sap") {
+        return dSweepAndPruneSpaceCreate(0, dSAP_AXES_XYZ);
+      }
+      else if(type == "simple") {
+        return dSimpleSpaceCreate(0);
+      }
+      else if(type == "quadtree") {
+        dReal aabb[6], extent[6] = {dInfinity, -dInfinity, dInfinity,
+                                    -dInfinity, dInfinity, -dInfinity};
+        dVector3 center, extents;
+        dGeomID geom;
+        for(int s=0; s<numSpaces; ++s) {
+          for(int i=0; i<dSpaceGetNumGeoms(spaces[s]); ++i) {
+            geom = dSpaceGetGeom(spaces[s], i);
+            // planes are infinite and don't tell anything about the scene
+            if(dGeomGetClass(geom) == dPlaneClass) continue;
+            dGeomGetAABB(geom, aabb);
+            for(int k=0; k<3; ++k) {
+              extent[k*2] = std::min(extent[k*2], aabb[k*2]);
+              extent[k*2+1] = std::max(extent[k*2+1], aabb[k*2+1]);
+            }
+          }
+        }
+        for(int k=0; k<3; ++k) {
+          if(extent[k*2] > extent[k*2+1]) {
+            // empty scene
+            center[k] = 0.0;
+            extents[k] = 100.0;
+          }
+          else {
+            center[k] = (extent[k*2] + extent[k*2+1])*0.5;
+            // leave some room for the dynamic geoms
+            extents[k] = (extent[k*2+1] - extent[k*2])*1.2 + 1.0;
+          }
+        }
+        return dQuadTreeSpaceCreate(0, center, extents, quadtree_depth);
+      }
+      if(type != "hash") {
+        LOG_WARN("WorldPhysics: unknown broadphase \"%s\"; using hash space",
+                 type.c_str());
+      }
+      dSpaceID hashSpace = dHashSpaceCreate(0);
+      dHashSpaceSetLevels(hashSpace, hash_min_level, hash_max_level);
+      return hashSpace;
+    }
+
+    /**
+     * \brief Creates a new space of the given type and moves all geoms of
+     * the old space into it.
+     *
+     * pre:
+     *     - the iMutex is locked
+     *
+     * post:
+     *     - the old space is destroyed
+     */
+    dSpaceID WorldPhysics::rebuildSpace(dSpaceID oldSpace,
+                                        const std::string &type,
+                                        dSpaceID *spaces, int numSpaces) {
+      dSpaceID newSpace = createSpace(type, spaces, numSpaces);
+      dGeomID geom;
+      while(dSpaceGetNumGeoms(oldSpace)) {
+        geom = dSpaceGetGeom(oldSpace, 0);
+        dSpaceRemove(oldSpace, geom);
+        dSpaceAdd(newSpace, geom);
+      }
+      dSpaceDestroy(oldSpace);
+      return newSpace;
+    }
+
+    /**
+     * \brief Whether a space of the given broadphase type uses the changed
+     * hash levels or quadtree depth. Unknown types are hash spaces.
+     */
+    static bool levelsChanged(const std::string &type,
+                              bool hashLevelsChanged, bool depthChanged) {
+      if(type == "quadtree") return depthChanged;
+      if(type == "sap" || type == "simple") return false;
+      return hashLevelsChanged;
+    }
+
+    /**
+     * \brief Recreates the collision spaces if the broadphase configuration
+     * changed.
+     *
+     * A quadtree is also rebuild if geoms were added or removed, to keep
+     * its bounds in line with the scene.
+     */
+    void WorldPhysics::updateBroadphase(void) {
+      bool hash_levels_changed = (space_hash_min_level != hash_min_level ||
+                                  space_hash_max_level != hash_max_level);
+      bool depth_changed = (space_quadtree_depth != quadtree_depth);
+      int numGeoms = dSpaceGetNumGeoms(space);
+      int numStaticGeoms = dSpaceGetNumGeoms(static_space);
+      dSpaceID spaces[2] = {space, static_space};
+
+      if(space_broadphase != broadphase ||
+         levelsChanged(broadphase, hash_levels_changed, depth_changed) ||
+         (broadphase == "quadtree" && (numGeoms != space_num_geoms ||
+                                       numStaticGeoms != static_space_num_geoms))) {
+        space = rebuildSpace(space, broadphase, spaces, 2);
+        space_broadphase = broadphase;
+      }
+      if(static_space_broadphase != static_broadphase ||
+         levelsChanged(static_broadphase, hash_levels_changed, depth_changed) ||
+         (static_broadphase == "quadtree" &&
+          numStaticGeoms != static_space_num_geoms)) {
+        static_space = rebuildSpace(static_space, static_broadphase,
+                                    &static_space, 1);
+        static_space_broadphase = static_broadphase;
+      }
+      space_hash_min_level = hash_min_level;
+      space_hash_max_level = hash_max_level;
+      space_quadtree_depth = quadtree_depth;
+      space_num_geoms = numGeoms;
+      static_space_num_geoms = numStaticGeoms;
+    }
+
+    /**
+     * \brief Creates a thread pool that is used by ode to step the
+     * independent islands of the world in parallel.
+     *
+     * Bodies that are not connected by joints or contacts form separate
+     * islands, thus robots that do not touch each other are solved on
+     * different threads. If ode is build without the builtin threading
+     * implementation the world is stepped single-threaded.
+     *
+     * pre:
+     *     - world_init = true
+     *     - no step threading is set
+     */
+    void WorldPhysics::initStepThreading(void) {
+      step_threading = dThreadingAllocateMultiThreadedImplementation();
+      if(!step_threading) {
+        LOG_WARN("WorldPhysics: ode has no builtin threading implementation; stepping single-threaded");
+        // don't try again until the configuration changes
+        num_step_threads = step_threads;
+        return;
+      }
+      step_thread_pool = dThreadingAllocateThreadPool(step_threads, 0,
+                                                      dAllocateFlagBasicData,
+                                                      NULL);
+      if(!step_thread_pool) {
+        LOG_ERROR("WorldPhysics: unable to create %d step threads", step_threads);
+        dThreadingFreeImplementation(step_threading);
+        step_threading = 0;
+        num_step_threads = step_threads;
+        return;
+      }
+      dThreadingThreadPoolServeMultiThreadedImplementation(step_thread_pool,
+                                                           step_threading);
+      dWorldSetStepThreadingImplementation(world,
+                                           dThreadingImplementationGetFunctions(step_threading),
+                                           step_threading);
+      dWorldSetStepIslandsProcessingMaxThreadCount(world, step_threads);
+      num_step_threads = step_threads;
+    }
+
+    /**
+     * \brief Stops the step threads and switches the world back to the
+     * single-threaded step.
+     */
+    void WorldPhysics::freeStepThreading(void) {
+      if(step_threading) {
+        dThreadingImplementationShutdownProcessing(step_threading);
+        dThreadingFreeThreadPool(step_thread_pool);
+        dWorldSetStepThreadingImplementation(world, NULL, NULL);
+        dThreadingFreeImplementation(step_threading);
+        dWorldSetStepIslandsProcessingMaxThreadCount(world, 1);
+        step_threading = 0;
+        step_thread_pool = 0;
+      }
+      num_step_threads = 0;
+    }
+
         /**
      *
      * \brief Auxiliar methof of step the world.
@@ -291,21 +537,19 @@ namespace mars {
       /// first clear the collision counters of all geoms
       int i;
       geom_data* data;
-      for(i=0; i<dSpaceGetNumGeoms(space); i++) {
-        data = (geom_data*)dGeomGetData(dSpaceGetGeom(space, i));
-        data->num_ground_collisions = 0;
-        data->contact_ids.clear();
-        data->contact_points.clear();
-        data->ground_feedbacks.clear();
+      dSpaceID spaces[2] = {space, static_space};
+      for(int s=0; s<2; s++) {
+        for(i=0; i<dSpaceGetNumGeoms(spaces[s]); i++) {
+          data = (geom_data*)dGeomGetData(dSpaceGetGeom(spaces[s], i));
+          data->num_ground_collisions = 0;
+          data->contact_ids.clear();
+          data->contact_points.clear();
+          data->ground_feedbacks.clear();
+        }
       }
 
-      std::vector<dJointFeedback*>::iterator iter;
       // Clear Previous Contact Feedback
-      for(iter = contact_feedback_list.begin();
-          iter != contact_feedback_list.end(); iter++) {
-        free((*iter));
-      }
-      contact_feedback_list.clear();
+      num_feedbacks = 0;
       // Clear draw_intern
       draw_intern.clear();
 
@@ -357,12 +601,6 @@ namespace mars {
         std::shared_ptr<NodePhysics> nodePhysPtr = std::dynamic_pointer_cast<NodePhysics>(nodeIfPtr);
         std::vector<dJointFeedback*> contactFeedbacks =
           nodePhysPtr->addContacts(colContacts, world, contactgroup);
-        std::vector<utils::Vector> * contactPoints = new std::vector<utils::Vector>();
-        nodePhysPtr->getContactPoints(contactPoints);
-        for (auto it = std::begin(contactFeedbacks); it !=std::end(contactFeedbacks); ++it)
-        {
-          contact_feedback_list.push_back(*it);
-        }
         // Some feedback joints might not be set even if contacts exists if
         // errors are detected.
         // Currently though all are used but for future potential fixes that do
@@ -415,10 +653,11 @@ namespace mars {
      */
     void WorldPhysics::stepTheWorld(void) {
       MutexLocker locker(&iMutex);
-      std::vector<dJointFeedback*>::iterator iter;
 
       // if world_init = false or step_size <= 0 debug something
       if(world_init && step_size > 0) {
+        std::chrono::steady_clock::time_point start, collided, stepped;
+        start = std::chrono::steady_clock::now();
         preStepChecks();
         clearPreviousStep();
         /// first check for collisions
@@ -435,10 +674,13 @@ namespace mars {
         externalContacts.clear();
 
         dSpaceCollide(space,this, &WorldPhysics::callbackForward);
+        dSpaceCollide2((dGeomID)space, (dGeomID)static_space, this,
+                       &WorldPhysics::callbackForward);
 
         drawLock.lock();
         draw_extern.swap(draw_intern);
         drawLock.unlock();
+        collided = std::chrono::steady_clock::now();
 
         /// then calculate the next state for a time of step_size seconds
         try {
@@ -451,6 +693,9 @@ namespace mars {
         } catch (...) {
           control->sim->handleError(PHYSICS_UNKNOWN);
         }
+        stepped = std::chrono::steady_clock::now();
+        collision_time = std::chrono::duration<double>(collided - start).count();
+        solver_time = std::chrono::duration<double>(stepped - collided).count();
         if(WorldPhysics::error) {
           control->sim->handleError(WorldPhysics::error);
           WorldPhysics::error = PHYSICS_NO_ERROR;
@@ -484,6 +729,30 @@ namespace mars {
       return space;
     }
 
+    /**
+     * \brief Returns the ode ID of the space that holds the geoms without
+     * a body.
+     */
+    dSpaceID WorldPhysics::getStaticSpace(void) const {
+      return static_space;
+    }
+
+    /**
+     * \brief Moves the geom into the static space if it has no body and
+     * into the main space otherwise.
+     *
+     * pre:
+     *     - the iMutex is locked
+     */
+    void WorldPhysics::updateGeomSpace(dGeomID geom) {
+      dSpaceID target = dGeomGetBody(geom) ? space : static_space;
+      dSpaceID current = dGeomGetSpace(geom);
+      if(current != target) {
+        if(current) dSpaceRemove(current, geom);
+        dSpaceAdd(target, geom);
+      }
+    }
+
     /**
      * \brief Sets the body pointer param to the body for the comp_group_id
      *
@@ -666,15 +935,13 @@ namespace mars {
 
       if(!b1 && !b2 && !geom_data1->ray_sensor && !geom_data2->ray_sensor) return;
 
-      int maxNumContacts = 0;
-      if(geom_data1->c_params.max_num_contacts <
-         geom_data2->c_params.max_num_contacts) {
-        maxNumContacts = geom_data1->c_params.max_num_contacts;
-      }
-      else {
-        maxNumContacts = geom_data2->c_params.max_num_contacts;
+      const contact_surface &cs = getContactSurface(geom_data1, geom_data2);
+      int maxNumContacts = cs.max_num_contacts;
+      if(maxNumContacts < 1) return;
+      if((int)contact_arena.size() < maxNumContacts) {
+        contact_arena.resize(maxNumContacts);
       }
-      dContact *contact = new dContact[maxNumContacts];
+      dContact *contact = &contact_arena[0];
 
       double filter_depth = -1.0;
       if(geom_data1->filter_depth > filter_depth) {
@@ -747,126 +1014,25 @@ namespace mars {
 
 
 
-      // frist we set the softness values:
-      contact[0].surface.mode = dContactSoftERP | dContactSoftCFM;
-      contact[0].surface.soft_cfm = (geom_data1->c_params.cfm +
-                                     geom_data2->c_params.cfm)/2;
-      contact[0].surface.soft_erp = (geom_data1->c_params.erp +
-                                     geom_data2->c_params.erp)/2;
-      // then check if one of the geoms want to use the pyramid approximation
-      if(geom_data1->c_params.approx_pyramid ||
-         geom_data2->c_params.approx_pyramid)
-        contact[0].surface.mode |= dContactApprox1;
-
-      // Then check the friction for both directions
-      contact[0].surface.mu = (geom_data1->c_params.friction1 +
-                               geom_data2->c_params.friction1)/2;
-      contact[0].surface.mu2 = (geom_data1->c_params.friction2 +
-                                geom_data2->c_params.friction2)/2;
-
-      if(contact[0].surface.mu != contact[0].surface.mu2)
-        contact[0].surface.mode |= dContactMu2;
-
-      if(geom_data1->c_params.rolling_friction > EPSILON ||
-         geom_data2->c_params.rolling_friction > EPSILON) {
-        contact[0].surface.mode |= dContactRolling;
-        contact[0].surface.rho = geom_data1->c_params.rolling_friction + geom_data2->c_params.rolling_friction;
-        // fprintf(stderr, "set rolling friction to: %g\n", contact[0].surface.rho);
-        if(geom_data1->c_params.rolling_friction2 > EPSILON ||
-           geom_data2->c_params.rolling_friction2 > EPSILON) {
-          contact[0].surface.rho2 = geom_data1->c_params.rolling_friction2 + geom_data2->c_params.rolling_friction2;
-        }
-        else {
-          contact[0].surface.rho2 = geom_data1->c_params.rolling_friction + geom_data2->c_params.rolling_friction;
-        }
-        if(geom_data1->c_params.spinning_friction > EPSILON ||
-           geom_data2->c_params.spinning_friction > EPSILON) {
-          contact[0].surface.rhoN = geom_data1->c_params.spinning_friction + geom_data2->c_params.spinning_friction;
-        }
-        else {
-          contact[0].surface.rhoN = 0.0;
-        }
-      }
-
-      // check if we have to calculate friction direction1
-      if(geom_data1->c_params.friction_direction1 ||
-         geom_data2->c_params.friction_direction1) {
-        // here the calculation becomes more complicated
-        // maybe we should make some restrictions
-        // so -> we only use friction motion in friction direction 1
+      // the mixed surface parameters are taken from the material table, only
+      // the friction direction has to be read from the geoms for every contact
+      contact[0].surface = cs.surface;
+      if(contact[0].surface.mode & dContactFDir1) {
         // the friction motion is only set if a local vector for friction
         // direction 1 is given
-        // the steps for the calculation:
-        // 1. rotate the local vectors to global coordinates
-        // 2. scale the vectors to the length of the motion if given
-        // 3. vector 3 =  vector 1 - vector 2
-        // 4. get the length of vector 3
-        // 5. set vector 3 as friction direction 1
-        // 6. set motion 1 to the length
-        contact[0].surface.mode |= dContactFDir1;
-        if(!geom_data2->c_params.friction_direction1) {
-          // get the orientation of the geom
-          //dGeomGetQuaternion(o1, v);
-          //dRfromQ(R, v);
-          // copy the friction direction
+        if(geom_data1->c_params.friction_direction1) {
           v1[0] = geom_data1->c_params.friction_direction1->x();
           v1[1] = geom_data1->c_params.friction_direction1->y();
           v1[2] = geom_data1->c_params.friction_direction1->z();
-          // translate the friction direction to global coordinates
-          // and set friction direction for contact
-          //dMULTIPLY0_331(contact[0].fdir1, R, v1);
-          contact[0].fdir1[0] = v1[0];
-          contact[0].fdir1[1] = v1[1];
-          contact[0].fdir1[2] = v1[2];
-          if(geom_data1->c_params.motion1) {
-            contact[0].surface.mode |= dContactMotion1;
-            contact[0].surface.motion1 = geom_data1->c_params.motion1;
-          }
         }
-        else if(!geom_data1->c_params.friction_direction1) {
-          // get the orientation of the geom
-          //dGeomGetQuaternion(o2, v);
-          //dRfromQ(R, v);
-          // copy the friction direction
+        else {
           v1[0] = geom_data2->c_params.friction_direction1->x();
           v1[1] = geom_data2->c_params.friction_direction1->y();
           v1[2] = geom_data2->c_params.friction_direction1->z();
-          // translate the friction direction to global coordinates
-          // and set friction direction for contact
-          //dMULTIPLY0_331(contact[0].fdir1, R, v1);
-          contact[0].fdir1[0] = v1[0];
-          contact[0].fdir1[1] = v1[1];
-          contact[0].fdir1[2] = v1[2];
-          if(geom_data2->c_params.motion1) {
-            contact[0].surface.mode |= dContactMotion1;
-            contact[0].surface.motion1 = geom_data2->c_params.motion1;
-          }
-        }
-        else {
-          // the calculation steps as mentioned above
-          fprintf(stderr, "the calculation for friction directen set for both nodes is not done yet.\n");
         }
-      }
-
-      // then check for fds
-      if(geom_data1->c_params.fds1 || geom_data2->c_params.fds1) {
-        contact[0].surface.mode |= dContactSlip1;
-        contact[0].surface.slip1 = (geom_data1->c_params.fds1 +
-                                    geom_data2->c_params.fds1);
-      }
-      if(geom_data1->c_params.fds2 || geom_data2->c_params.fds2) {
-        contact[0].surface.mode |= dContactSlip2;
-        contact[0].surface.slip2 = (geom_data1->c_params.fds2 +
-                                    geom_data2->c_params.fds2);
-      }
-      if(geom_data1->c_params.bounce || geom_data2->c_params.bounce) {
-        contact[0].surface.mode |= dContactBounce;
-        contact[0].surface.bounce = (geom_data1->c_params.bounce +
-                                     geom_data2->c_params.bounce);
-        if(geom_data1->c_params.bounce_vel > geom_data2->c_params.bounce_vel)
-          contact[0].surface.bounce_vel = geom_data1->c_params.bounce_vel;
-        else
-          contact[0].surface.bounce_vel = geom_data2->c_params.bounce_vel;
+        contact[0].fdir1[0] = v1[0];
+        contact[0].fdir1[1] = v1[1];
+        contact[0].fdir1[2] = v1[2];
       }
 
       for (i=1;i<maxNumContacts;i++){
@@ -906,18 +1072,20 @@ namespace mars {
         }
         if(create_contacts) {
           fb = 0;
-          item.id = 0;
-          item.type = DRAW_LINE;
-          item.draw_state = DRAW_STATE_CREATE;
-          item.point_size = 10;
-          item.myColor.r = 1;
-          item.myColor.g = 0;
-          item.myColor.b = 0;
-          item.myColor.a = 1;
-          item.label = "";
-          item.t_width = item.t_height = 0;
-          item.texture = "";
-          item.get_light = 0;
+          if(draw_contact_points) {
+            item.id = 0;
+            item.type = DRAW_LINE;
+            item.draw_state = DRAW_STATE_CREATE;
+            item.point_size = 10;
+            item.myColor.r = 1;
+            item.myColor.g = 0;
+            item.myColor.b = 0;
+            item.myColor.a = 1;
+            item.label = "";
+            item.t_width = item.t_height = 0;
+            item.texture = "";
+            item.get_light = 0;
+          }
 
           for(i=0;i<numc;i++) {
             // filter_depth is used to filter heightmaps contact under the surface
@@ -936,15 +1104,16 @@ namespace mars {
                 continue;
               }
             }
-            item.start.x() = contact[i].geom.pos[0];
-            item.start.y() = contact[i].geom.pos[1];
-            item.start.z() = contact[i].geom.pos[2];
-            item.end.x() = contact[i].geom.pos[0] + contact[i].geom.normal[0];
-            item.end.y() = contact[i].geom.pos[1] + contact[i].geom.normal[1];
-            item.end.z() = contact[i].geom.pos[2] + contact[i].geom.normal[2];
-            draw_intern.push_back(item);
-            if(geom_data1->c_params.friction_direction1 ||
-               geom_data2->c_params.friction_direction1) {
+            if(draw_contact_points) {
+              item.start.x() = contact[i].geom.pos[0];
+              item.start.y() = contact[i].geom.pos[1];
+              item.start.z() = contact[i].geom.pos[2];
+              item.end.x() = contact[i].geom.pos[0] + contact[i].geom.normal[0];
+              item.end.y() = contact[i].geom.pos[1] + contact[i].geom.normal[1];
+              item.end.z() = contact[i].geom.pos[2] + contact[i].geom.normal[2];
+              draw_intern.push_back(item);
+            }
+            if(contact[i].surface.mode & dContactFDir1) {
               v[0] = contact[i].geom.normal[0];
               v[1] = contact[i].geom.normal[1];
               v[2] = contact[i].geom.normal[2];
@@ -955,8 +1124,7 @@ namespace mars {
               contact[i].fdir1[2] -= v[2];
               dNormalize3(contact[0].fdir1);
             }
-            contact[i].geom.depth += (geom_data1->c_params.depth_correction +
-                                      geom_data2->c_params.depth_correction);
+            contact[i].geom.depth += cs.depth_correction;
 
             if(contact[i].geom.depth < 0.0) contact[i].geom.depth = 0.0;
             dJointID c=dJointCreateContact(world,contactgroup,contact+i);
@@ -976,18 +1144,16 @@ namespace mars {
             //if(dGeomGetClass(o1) == dPlaneClass) {
             fb = 0;
             if(geom_data2->sense_contact_force) {
-              fb = (dJointFeedback*)malloc(sizeof(dJointFeedback));
+              fb = createContactFeedback();
               dJointSetFeedback(c, fb);
-              contact_feedback_list.push_back(fb);
               geom_data2->ground_feedbacks.push_back(fb);
               geom_data2->node1 = false;
             }
             //else if(dGeomGetClass(o2) == dPlaneClass) {
             if(geom_data1->sense_contact_force) {
               if(!fb) {
-                fb = (dJointFeedback*)malloc(sizeof(dJointFeedback));
+                fb = createContactFeedback();
                 dJointSetFeedback(c, fb);
-                contact_feedback_list.push_back(fb);
               }
               geom_data1->ground_feedbacks.push_back(fb);
               geom_data1->node1 = true;
@@ -995,7 +1161,288 @@ namespace mars {
           }
         }
       }
-      delete[] contact;
+    }
+
+    /**
+     * \brief Returns true if both parameter sets result in the same contact
+     *  surface. The collision bitmask is set at the geom and the friction
+     *  direction is read on every contact, both are not compared.
+     */
+    static bool equalContactParams(const contact_params &a,
+                                   const contact_params &b) {
+      return (a.max_num_contacts == b.max_num_contacts &&
+              a.erp == b.erp && a.cfm == b.cfm &&
+              a.friction1 == b.friction1 && a.friction2 == b.friction2 &&
+              a.motion1 == b.motion1 && a.motion2 == b.motion2 &&
+              a.fds1 == b.fds1 && a.fds2 == b.fds2 &&
+              a.bounce == b.bounce && a.bounce_vel == b.bounce_vel &&
+              a.approx_pyramid == b.approx_pyramid &&
+              a.depth_correction == b.depth_correction &&
+              a.rolling_friction == b.rolling_friction &&
+              a.rolling_friction2 == b.rolling_friction2 &&
+              a.spinning_friction == b.spinning_friction);
+    }
+
+    /**
+     * \brief Returns the mixed contact surface of two geoms from the
+     *  material table.
+     *
+     * pre:
+     *     - the iMutex is locked
+     */
+    const contact_surface& WorldPhysics::getContactSurface(geom_data *gd1,
+                                                           geom_data *gd2) {
+      // geoms that never got contact parameters get their material here
+      if(!gd1->contact_material) {
+        gd1->contact_material = internContactMaterial(gd1->c_params);
+      }
+      if(!gd2->contact_material) {
+        gd2->contact_material = internContactMaterial(gd2->c_params);
+      }
+      return contact_table[gd1->contact_material*contact_table_size +
+                           gd2->contact_material];
+    }
+
+    /**
+     * \brief Returns the id of the material with the given contact
+     *  parameters and adds a reference to it. A new material is added to
+     *  the pair table.
+     *
+     * pre:
+     *     - the iMutex is locked
+     */
+    unsigned int WorldPhysics::internContactMaterial(const contact_params &params) {
+      bool friction_direction1 = params.friction_direction1 != 0;
+      for(size_t i=1; i<contact_materials.size(); ++i) {
+        contact_material &m = contact_materials[i];
+        if(m.references && m.friction_direction1 == friction_direction1 &&
+           equalContactParams(m.params, params)) {
+          ++m.references;
+          return i;
+        }
+      }
+
+      unsigned int id;
+      if(free_contact_materials.empty()) {
+        id = contact_materials.size();
+        contact_materials.resize(id+1);
+      }
+      else {
+        id = free_contact_materials.back();
+        free_contact_materials.pop_back();
+      }
+      contact_material &m = contact_materials[id];
+      m.params = params;
+      // the direction itself is read from the geom on every contact
+      m.params.friction_direction1 = 0;
+      m.friction_direction1 = friction_direction1;
+      m.references = 1;
+      updateContactTable(id);
+      return id;
+    }
+
+    void WorldPhysics::releaseContactMaterial(unsigned int material) {
+      if(!material || material >= contact_materials.size()) return;
+      if(--contact_materials[material].references == 0) {
+        free_contact_materials.push_back(material);
+      }
+    }
+
+    /**
+     * \brief Returns the ode mesh for the given vertices and indices. The
+     *  arrays are allocated with malloc, the world takes their ownership.
+     *
+     * pre:
+     *     - the iMutex is locked
+     *
+     * post:
+     *     - an existing mesh with the same content is shared and the given
+     *       arrays are freed
+     *     - key is set to the value needed by releaseTriMeshData()
+     */
+    dTriMeshDataID WorldPhysics::acquireTriMeshData(dVector3 *vertices,
+                                                    int vertexcount,
+                                                    dTriIndex *indices,
+                                                    int indexcount,
+                                                    uint64_t *key) {
+      size_t vertexBytes = vertexcount*sizeof(dVector3);
+      size_t indexBytes = indexcount*sizeof(dTriIndex);
+      *key = interfaces::SceneCache::hash(vertices, vertexBytes);
+      *key = interfaces::SceneCache::hash(indices, indexBytes, *key);
+
+      std::pair<std::unordered_multimap<uint64_t, trimesh_data>::iterator,
+                std::unordered_multimap<uint64_t, trimesh_data>::iterator> range;
+      range = trimesh_cache.equal_range(*key);
+      for(; range.first != range.second; ++range.first) {
+        trimesh_data &mesh = range.first->second;
+        if(mesh.vertexcount == vertexcount && mesh.indexcount == indexcount &&
+           memcmp(mesh.vertices, vertices, vertexBytes) == 0 &&
+           memcmp(mesh.indices, indices, indexBytes) == 0) {
+          free(vertices);
+          free(indices);
+          ++mesh.references;
+          return mesh.data;
+        }
+      }
+
+      trimesh_data mesh;
+      mesh.vertices = vertices;
+      mesh.indices = indices;
+      mesh.vertexcount = vertexcount;
+      mesh.indexcount = indexcount;
+      mesh.references = 1;
+      mesh.data = dGeomTriMeshDataCreate();
+      dGeomTriMeshDataBuildSimple(mesh.data, (dReal*)vertices, vertexcount,
+                                  indices, indexcount);
+      trimesh_cache.insert(std::make_pair(*key, mesh));
+      return mesh.data;
+    }
+
+    void WorldPhysics::releaseTriMeshData(dTriMeshDataID data, uint64_t key) {
+      if(!data) return;
+      std::pair<std::unordered_multimap<uint64_t, trimesh_data>::iterator,
+                std::unordered_multimap<uint64_t, trimesh_data>::iterator> range;
+      range = trimesh_cache.equal_range(key);
+      for(; range.first != range.second; ++range.first) {
+        trimesh_data &mesh = range.first->second;
+        if(mesh.data != data) continue;
+        if(--mesh.references == 0) {
+          dGeomTriMeshDataDestroy(mesh.data);
+          free(mesh.vertices);
+          free(mesh.indices);
+          trimesh_cache.erase(range.first);
+        }
+        return;
+      }
+    }
+
+    /**
+     * \brief Mixes the row and column of the given material. The table
+     *  grows by doubling, then all pairs are mixed again.
+     */
+    void WorldPhysics::updateContactTable(unsigned int material) {
+      size_t num = contact_materials.size();
+      if(num > contact_table_size) {
+        size_t size = contact_table_size ? contact_table_size : 16;
+        while(size < num) size *= 2;
+        std::vector<contact_surface> table(size*size);
+        for(size_t a=1; a<num; ++a) {
+          if(!contact_materials[a].references) continue;
+          for(size_t b=1; b<num; ++b) {
+            if(!contact_materials[b].references) continue;
+            mixContactSurface(contact_materials[a], contact_materials[b],
+                              &table[a*size+b]);
+          }
+        }
+        contact_table.swap(table);
+        contact_table_size = size;
+        return;
+      }
+      const contact_material &m = contact_materials[material];
+      for(size_t i=1; i<num; ++i) {
+        if(!contact_materials[i].references) continue;
+        mixContactSurface(m, contact_materials[i],
+                          &contact_table[material*contact_table_size+i]);
+        mixContactSurface(contact_materials[i], m,
+                          &contact_table[i*contact_table_size+material]);
+      }
+    }
+
+    void WorldPhysics::mixContactSurface(const contact_material &m1,
+                                         const contact_material &m2,
+                                         contact_surface *cs) {
+      const contact_params &cp1 = m1.params;
+      const contact_params &cp2 = m2.params;
+      dSurfaceParameters &surface = cs->surface;
+      memset(&surface, 0, sizeof(dSurfaceParameters));
+
+      cs->max_num_contacts = std::min(cp1.max_num_contacts, cp2.max_num_contacts);
+      cs->depth_correction = cp1.depth_correction + cp2.depth_correction;
+
+      // frist we set the softness values:
+      surface.mode = dContactSoftERP | dContactSoftCFM;
+      surface.soft_cfm = (cp1.cfm + cp2.cfm)/2;
+      surface.soft_erp = (cp1.erp + cp2.erp)/2;
+      // then check if one of the geoms want to use the pyramid approximation
+      if(cp1.approx_pyramid || cp2.approx_pyramid)
+        surface.mode |= dContactApprox1;
+
+      // Then check the friction for both directions
+      surface.mu = (cp1.friction1 + cp2.friction1)/2;
+      surface.mu2 = (cp1.friction2 + cp2.friction2)/2;
+
+      if(surface.mu != surface.mu2)
+        surface.mode |= dContactMu2;
+
+      if(cp1.rolling_friction > EPSILON || cp2.rolling_friction > EPSILON) {
+        surface.mode |= dContactRolling;
+        surface.rho = cp1.rolling_friction + cp2.rolling_friction;
+        if(cp1.rolling_friction2 > EPSILON || cp2.rolling_friction2 > EPSILON) {
+          surface.rho2 = cp1.rolling_friction2 + cp2.rolling_friction2;
+        }
+        else {
+          surface.rho2 = cp1.rolling_friction + cp2.rolling_friction;
+        }
+        if(cp1.spinning_friction > EPSILON || cp2.spinning_friction > EPSILON) {
+          surface.rhoN = cp1.spinning_friction + cp2.spinning_friction;
+        }
+        else {
+          surface.rhoN = 0.0;
+        }
+      }
+
+      // check if we have to calculate friction direction1
+      if(m1.friction_direction1 || m2.friction_direction1) {
+        // we only use friction motion in friction direction 1; the
+        // direction itself is set for every contact
+        surface.mode |= dContactFDir1;
+        if(m1.friction_direction1 && m2.friction_direction1) {
+          fprintf(stderr, "the calculation for friction directen set for both nodes is not done yet.\n");
+        }
+        else if(m1.friction_direction1 && cp1.motion1) {
+          surface.mode |= dContactMotion1;
+          surface.motion1 = cp1.motion1;
+        }
+        else if(m2.friction_direction1 && cp2.motion1) {
+          surface.mode |= dContactMotion1;
+          surface.motion1 = cp2.motion1;
+        }
+      }
+
+      // then check for fds
+      if(cp1.fds1 || cp2.fds1) {
+        surface.mode |= dContactSlip1;
+        surface.slip1 = (cp1.fds1 + cp2.fds1);
+      }
+      if(cp1.fds2 || cp2.fds2) {
+        surface.mode |= dContactSlip2;
+        surface.slip2 = (cp1.fds2 + cp2.fds2);
+      }
+      if(cp1.bounce || cp2.bounce) {
+        surface.mode |= dContactBounce;
+        surface.bounce = (cp1.bounce + cp2.bounce);
+        if(cp1.bounce_vel > cp2.bounce_vel)
+          surface.bounce_vel = cp1.bounce_vel;
+        else
+          surface.bounce_vel = cp2.bounce_vel;
+      }
+    }
+
+    /**
+     * \brief Returns a contact feedback that stays valid until the contacts
+     *  of the next step are created.
+     *
+     * pre:
+     *     - the iMutex is locked
+     */
+    dJointFeedback* WorldPhysics::createContactFeedback(void) {
+      if(num_feedbacks == feedback_pool.size()*FEEDBACK_BLOCK_SIZE) {
+        feedback_pool.push_back(new dJointFeedback[FEEDBACK_BLOCK_SIZE]);
+      }
+      dJointFeedback *fb = (feedback_pool[num_feedbacks/FEEDBACK_BLOCK_SIZE] +
+                            num_feedbacks%FEEDBACK_BLOCK_SIZE);
+      ++num_feedbacks;
+      return fb;
     }
 
     /**
@@ -1097,9 +1544,82 @@ namespace mars {
       ray_collision = 0;
       dSpaceCollide2(theGeom, (dGeomID)space, this,
                      &WorldPhysics::callbackForward);
+      dSpaceCollide2(theGeom, (dGeomID)static_space, this,
+                     &WorldPhysics::callbackForward);
       return ray_collision;
     }
 
+    /**
+     * \brief Casts a batch of rays against the whole world space.
+     *
+     * pre:
+     *     - the iMutex is locked
+     *
+     * post:
+     *     - the value of every ray is set to the closest hit or its length
+     */
+    void WorldPhysics::castRays(std::vector<ray_query> &rays) {
+      updateRayCastThreads();
+      ray_cast.castRays(space, static_space, rays);
+    }
+
+    /**
+     * \brief Registers a heightfield that reads a tiled terrain. The tiles
+     * of the terrain are loaded around the active bodies in every step.
+     *
+     * pre:
+     *     - the iMutex is locked
+     */
+    void WorldPhysics::addTiledTerrain(NodePhysics *node) {
+      if(std::find(tiled_terrains.begin(), tiled_terrains.end(), node) ==
+         tiled_terrains.end()) {
+        tiled_terrains.push_back(node);
+      }
+    }
+
+    void WorldPhysics::removeTiledTerrain(NodePhysics *node) {
+      tiled_terrains.erase(std::remove(tiled_terrains.begin(),
+                                       tiled_terrains.end(), node),
+                           tiled_terrains.end());
+    }
+
+    // requests the terrain tiles below all enabled bodies
+    void WorldPhysics::updateTerrainTiles(void) {
+      if(tiled_terrains.empty()) return;
+      terrain_aabbs.clear();
+      collectActiveAABBs(space);
+      std::vector<NodePhysics*>::iterator iter;
+      for(iter=tiled_terrains.begin(); iter!=tiled_terrains.end(); ++iter) {
+        (*iter)->updateTerrainTiles(terrain_aabbs);
+      }
+    }
+
+    void WorldPhysics::collectActiveAABBs(dSpaceID space) {
+      dReal aabb[6];
+      dGeomID geom;
+      dBodyID body;
+      int num = dSpaceGetNumGeoms(space);
+
+      for(int i=0; i<num; ++i) {
+        geom = dSpaceGetGeom(space, i);
+        if(dGeomIsSpace(geom)) {
+          collectActiveAABBs((dSpaceID)geom);
+          continue;
+        }
+        body = dGeomGetBody(geom);
+        if(!body || !dBodyIsEnabled(body) || !dGeomIsEnabled(geom)) continue;
+        dGeomGetAABB(geom, aabb);
+        terrain_aabbs.insert(terrain_aabbs.end(), aabb, aabb+6);
+      }
+    }
+
+    // applies the "ray cast threads" setting, the iMutex has to be locked
+    void WorldPhysics::updateRayCastThreads(void) const {
+      if(ray_cast.getNumThreads() != ray_cast_threads) {
+        ray_cast.setNumThreads(ray_cast_threads);
+      }
+    }
+
     double WorldPhysics::getCollisionDepth(dGeomID theGeom) {
       dGeomID otherGeom;
       dContact contact[1];
@@ -1108,25 +1628,28 @@ namespace mars {
       dBodyID b1;
       dBodyID b2;
 
-      for(int i=0; i<dSpaceGetNumGeoms(space); i++) {
-        otherGeom = dSpaceGetGeom(space, i);
+      dSpaceID spaces[2] = {space, static_space};
+      for(int s=0; s<2; s++) {
+        for(int i=0; i<dSpaceGetNumGeoms(spaces[s]); i++) {
+          otherGeom = dSpaceGetGeom(spaces[s], i);
 
-        if(!(dGeomGetCollideBits(theGeom) & dGeomGetCollideBits(otherGeom)))
-          continue;
+          if(!(dGeomGetCollideBits(theGeom) & dGeomGetCollideBits(otherGeom)))
+            continue;
 
-        b1 = dGeomGetBody(theGeom);
-        b2 = dGeomGetBody(otherGeom);
+          b1 = dGeomGetBody(theGeom);
+          b2 = dGeomGetBody(otherGeom);
 
-        if(b1 && b2 && dAreConnectedExcluding(b1,b2,dJointTypeContact))
-          continue;
+          if(b1 && b2 && dAreConnectedExcluding(b1,b2,dJointTypeContact))
+            continue;
 
-        numc = dCollide(theGeom, otherGeom, 1,
-                        &(contact[0].geom), sizeof(dContact));
-        // numc = dCollide(theGeom, otherGeom, 1 | CONTACTS_UNIMPORTANT,
-        //                 &(contact[0].geom), sizeof(dContact));
-        if(numc) {
-          if(contact[0].geom.depth > depth)
-            depth = contact[0].geom.depth;
+          numc = dCollide(theGeom, otherGeom, 1,
+                          &(contact[0].geom), sizeof(dContact));
+          // numc = dCollide(theGeom, otherGeom, 1 | CONTACTS_UNIMPORTANT,
+          //                 &(contact[0].geom), sizeof(dContact));
+          if(numc) {
+            if(contact[0].geom.depth > depth)
+              depth = contact[0].geom.depth;
+          }
         }
       }
 
@@ -1138,103 +1661,191 @@ namespace mars {
       num_contacts = log_contacts = 0;
       create_contacts = 0;
       dSpaceCollide(space,this, &WorldPhysics::callbackForward);
+      dSpaceCollide2((dGeomID)space, (dGeomID)static_space, this,
+                     &WorldPhysics::callbackForward);
       return num_contacts;
     }
 
     double WorldPhysics::getVectorCollision(const Vector &pos,
                                             const Vector &ray) const {
+      std::vector<Vector> positions(1, pos), rays(1, ray);
+      std::vector<sReal> depths;
+      getVectorCollisions(positions, rays, &depths);
+      return depths[0];
+    }
+
+    /**
+     * \brief Returns the distance to the closest hit of every ray.
+     *
+     * post:
+     *     - depths[i] is the length of rays[i] if the ray hits nothing
+     */
+    void WorldPhysics::getVectorCollisions(const std::vector<Vector> &pos,
+                                           const std::vector<Vector> &rays,
+                                           std::vector<sReal> *depths) const {
       MutexLocker locker(&iMutex);
-      dGeomID otherGeom;
-      dContact contact[1];
-      //double depth = ray.length();
-      double depth = ray.norm();
-      int numc;
+#ifdef ODE11
+      // the queries may come from the sensor threads
+      dAllocateODEDataForThread(dAllocateMaskAll);
+#endif
+      size_t num = std::min(pos.size(), rays.size());
+      depths->resize(num);
+      if(!world_init) {
+        for(size_t i=0; i<num; ++i) (*depths)[i] = rays[i].norm();
+        return;
+      }
 
-      dGeomID theGeom = dCreateRay(space, depth);
-      dGeomRaySetClosestHit( theGeom, 1 );
-      dGeomRaySet(theGeom, pos.x(), pos.y(), pos.z(), ray.x(), ray.y(), ray.z());
+      while(query_ray_geoms.size() < num) {
+        dGeomID geom = dCreateRay(0, 1.0);
+        dGeomRaySetClosestHit(geom, 1);
+        query_ray_geoms.push_back(geom);
+      }
+      query_rays.resize(num);
+      for(size_t i=0; i<num; ++i) {
+        ray_query &query = query_rays[i];
+        query.length = rays[i].norm();
+        Vector dir = query.length > 0 ? Vector(rays[i] / query.length) : Vector(0, 0, 1);
+        for(int k=0; k<3; ++k) {
+          query.pos[k] = pos[i][k];
+          query.dir[k] = dir[k];
+        }
+        query.geom = query_ray_geoms[i];
+        query.parent_geom = 0;
+        query.parent_body = 0;
+      }
 
-      for(int i=0; i<dSpaceGetNumGeoms(space); i++) {
-        otherGeom = dSpaceGetGeom(space, i);
+      updateRayCastThreads();
+      ray_cast.castRays(space, static_space, query_rays);
+      for(size_t i=0; i<num; ++i) (*depths)[i] = query_rays[i].value;
+    }
 
-        if(!(dGeomGetCollideBits(theGeom) & dGeomGetCollideBits(otherGeom)))
-          continue;
-        numc = dCollide(theGeom, otherGeom, 1 | CONTACTS_UNIMPORTANT,
-                        &(contact[0].geom), sizeof(dContact));
-        if(numc) {
-          if(contact[0].geom.depth < depth)
-            depth = contact[0].geom.depth;
-        }
+    /**
+     * \brief Reads the state of all given nodes under one lock.
+     *
+     * pre:
+     *     - all states->nodes are NodePhysics objects of this world
+     *
+     * post:
+     *     - the state arrays have the size of states->nodes
+     */
+    void WorldPhysics::getNodeStates(nodeStateArrays *states) const {
+      MutexLocker locker(&iMutex);
+      states->resize();
+      for(size_t i=0; i<states->nodes.size(); ++i) {
+        static_cast<NodePhysics*>(states->nodes[i])->getState(states, i);
       }
+    }
 
-      dGeomDestroy(theGeom);
-      return depth;
+    void WorldPhysics::getJointStates(jointStateArrays *states) const {
+      MutexLocker locker(&iMutex);
+      states->resize();
+      for(size_t i=0; i<states->joints.size(); ++i) {
+        static_cast<JointPhysics*>(states->joints[i])->getState(states, i);
+      }
     }
 
     void WorldPhysics::getSphereCollision(const Vector &pos,
                                           const double r,
                                           std::vector<utils::Vector> &contacts,
                                           std::vector<double> &depths) const {
+      std::vector<Vector> positions(1, pos);
+      std::vector<double> radii(1, r);
+      std::vector<std::vector<Vector> > sphereContacts;
+      std::vector<std::vector<double> > sphereDepths;
+      getSphereCollisions(positions, radii, &sphereContacts, &sphereDepths);
+      contacts.insert(contacts.end(), sphereContacts[0].begin(),
+                      sphereContacts[0].end());
+      depths.insert(depths.end(), sphereDepths[0].begin(),
+                    sphereDepths[0].end());
+    }
+
+    /**
+     * \brief Returns the contact points and depths of every sphere with the
+     * collision spaces.
+     *
+     * post:
+     *     - contacts and depths contain one vector per sphere
+     *     - contacts filtered by the geom_data of the hit geom are dropped
+     */
+    void WorldPhysics::getSphereCollisions(const std::vector<Vector> &pos,
+                                           const std::vector<double> &radii,
+                                           std::vector<std::vector<Vector> > *contacts,
+                                           std::vector<std::vector<double> > *depths) const {
       MutexLocker locker(&iMutex);
-      dGeomID otherGeom;
-      dContact contact[4];
-      //double depth = ray.length();
-      int numc;
-      Vector contactPos;
-      dGeomID theGeom = dCreateSphere(space, r);
-      dGeomSetPosition(theGeom, (dReal)pos.x(), (dReal)pos.y(), (dReal)pos.z());
+#ifdef ODE11
+      dAllocateODEDataForThread(dAllocateMaskAll);
+#endif
+      size_t num = std::min(pos.size(), radii.size());
+      contacts->resize(num);
+      depths->resize(num);
+      for(size_t i=0; i<num; ++i) {
+        (*contacts)[i].clear();
+        (*depths)[i].clear();
+      }
+      if(!world_init) return;
 
-      for(int k=0; k<dSpaceGetNumGeoms(space); k++) {
-        otherGeom = dSpaceGetGeom(space, k);
+      while(query_sphere_geoms.size() < num) {
+        query_sphere_geoms.push_back(dCreateSphere(0, 1.0));
+      }
+      query_spheres.resize(num);
+      for(size_t i=0; i<num; ++i) {
+        sphere_query &query = query_spheres[i];
+        for(int k=0; k<3; ++k) query.pos[k] = pos[i][k];
+        query.radius = radii[i];
+        query.geom = query_sphere_geoms[i];
+      }
 
-        if(!(dGeomGetCollideBits(theGeom) & dGeomGetCollideBits(otherGeom)))
-          continue;
-        numc = dCollide(theGeom, otherGeom, 4,
-                        &(contact[0].geom), sizeof(dContact));
-        for(int i=0; i<numc; ++i) {
-          geom_data* geom_data1 = (geom_data*)dGeomGetData(otherGeom);
-          double filter_depth = -1.0;
-          if(geom_data1->filter_depth > filter_depth) {
-            filter_depth = geom_data1->filter_depth;
-          }
-          double filter_angle = 0.5;
-          if(geom_data1->filter_angle > 0.0) {
-            filter_angle = geom_data1->filter_angle;
-          }
+      updateRayCastThreads();
+      ray_cast.collideSpheres(space, static_space, query_spheres);
+      std::vector<dContactGeom>::const_iterator it;
+      for(size_t i=0; i<num; ++i) {
+        const std::vector<dContactGeom> &result = query_spheres[i].contacts;
+        for(it=result.begin(); it!=result.end(); ++it) {
+          if(filterSphereContact(*it)) continue;
+          (*contacts)[i].push_back(Vector(it->pos[0], it->pos[1], it->pos[2]));
+          (*depths)[i].push_back(it->depth);
+        }
+      }
+    }
 
-          double filter_radius = -1.0;
-          Vector filter_sphere;
-          if(geom_data1->filter_radius > filter_radius) {
-            filter_radius = geom_data1->filter_radius;
-            filter_sphere = geom_data1->filter_sphere;
-          }
+    /**
+     * \brief Applies the contact filter of the hit geom to a contact of a
+     * sphere query.
+     *
+     * post:
+     *     - returns true if the contact has to be ignored
+     */
+    bool WorldPhysics::filterSphereContact(const dContactGeom &contact) {
+      geom_data* geom_data1 = (geom_data*)dGeomGetData(contact.g2);
+      if(!geom_data1) return false;
+      double filter_depth = -1.0;
+      if(geom_data1->filter_depth > filter_depth) {
+        filter_depth = geom_data1->filter_depth;
+      }
 
-          if(filter_depth > 0.0) {
-            if(contact[i].geom.normal[2] < 0.5 or filter_depth < contact[i].geom.depth) {
-              continue;
-            }
-          }
-          if(filter_radius > 0.0) {
-            Vector v;
-            v.x() = contact[i].geom.pos[0];
-            v.y() = contact[i].geom.pos[1];
-            v.z() = 0.0;//contact[i].geom.pos[2];
-            v -= filter_sphere;
-            if(v.norm() <= filter_radius) {
-              continue;
-            }
-          }
+      double filter_radius = -1.0;
+      Vector filter_sphere;
+      if(geom_data1->filter_radius > filter_radius) {
+        filter_radius = geom_data1->filter_radius;
+        filter_sphere = geom_data1->filter_sphere;
+      }
 
-          // todo: return contact position
-          contactPos.x() = contact[i].geom.pos[0];
-          contactPos.y() = contact[i].geom.pos[1];
-          contactPos.z() = contact[i].geom.pos[2];
-          contacts.push_back(contactPos);
-          depths.push_back(contact[i].geom.depth);
+      if(filter_depth > 0.0) {
+        if(contact.normal[2] < 0.5 or filter_depth < contact.depth) {
+          return true;
         }
       }
-
-      dGeomDestroy(theGeom);
+      if(filter_radius > 0.0) {
+        Vector v;
+        v.x() = contact.pos[0];
+        v.y() = contact.pos[1];
+        v.z() = 0.0;//contact.pos[2];
+        v -= filter_sphere;
+        if(v.norm() <= filter_radius) {
+          return true;
+        }
+      }
+      return false;
     }
 
     void WorldPhysics::addContact(dBodyID b1, Vector &point, Vector &normal, sReal depth,
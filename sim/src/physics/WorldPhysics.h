@@ -43,16 +43,20 @@
 #include <mars/interfaces/graphics/draw_structs.h>
 #include <mars/interfaces/sim/MarsPluginTemplate.h>
 
+#include <stdint.h>
+#include <unordered_map>
 #include <vector>
 
 #include <ode/ode.h>
 
 #include "ContactsPhysics.hpp"
+#include "RayCastPhysics.h"
 
 namespace mars {
   namespace sim {
 
     class NodePhysics;
+    struct geom_data;
 
     /**
      * The struct is used to handle some sensors in the physical
@@ -86,6 +90,41 @@ namespace mars {
           dContact contact;
       };
 
+    /**
+     * The contact surface mixed from the contact parameters of two geoms.
+     * The mixing only depends on the contact parameters, so it is done once
+     * for every pair of contact materials.
+     */
+    struct contact_surface {
+      dSurfaceParameters surface;
+      int max_num_contacts;
+      dReal depth_correction;
+    };
+
+    /**
+     * A distinct set of contact parameters shared by all geoms that use
+     * them. The friction direction of the geoms differs, thus only its
+     * existence is part of the material.
+     */
+    struct contact_material {
+      interfaces::contact_params params;
+      bool friction_direction1;
+      unsigned long references;
+    };
+
+    /**
+     * The ode representation of a mesh. It is shared by all geoms with the
+     * same scaled vertices and indices, thus identical meshes are only
+     * built once.
+     */
+    struct trimesh_data {
+      dTriMeshDataID data;
+      dVector3 *vertices;
+      dTriIndex *indices;
+      int vertexcount, indexcount;
+      unsigned long references;
+    };
+
     /**
      * Declaration of the physical class, that implements the
      * physics interface.
@@ -107,17 +146,38 @@ namespace mars {
                                       const double r,
                                       std::vector<utils::Vector> &contacts,
                                       std::vector<double> &depths) const;
+      virtual void getVectorCollisions(const std::vector<utils::Vector> &pos,
+                                       const std::vector<utils::Vector> &rays,
+                                       std::vector<interfaces::sReal> *depths) const;
+      virtual void getSphereCollisions(const std::vector<utils::Vector> &pos,
+                                       const std::vector<double> &radii,
+                                       std::vector<std::vector<utils::Vector> > *contacts,
+                                       std::vector<std::vector<double> > *depths) const;
+      virtual void getNodeStates(interfaces::nodeStateArrays *states) const;
+      virtual void getJointStates(interfaces::jointStateArrays *states) const;
       void addContact(dBodyID b1, utils::Vector &point, utils::Vector &normal, interfaces::sReal depth,
                       interfaces::contact_params &cp1, interfaces::contact_params &cp2);
       // this functions are used by the other physical classes
       dWorldID getWorld(void) const;
       dSpaceID getSpace(void) const;
+      dSpaceID getStaticSpace(void) const;
+      void updateGeomSpace(dGeomID geom);
       bool getCompositeBody(int comp_group, dBodyID *body, NodePhysics *node);
       void destroyBody(dBodyID theBody, NodePhysics *node);
       dReal getWorldStep(void);
       void resetCompositeMass(dBodyID theBody);
       void moveCompositeMassCenter(dBodyID theBody, dReal x, dReal y, dReal z);
+      dJointFeedback* createContactFeedback(void);
+      unsigned int internContactMaterial(const interfaces::contact_params &params);
+      void releaseContactMaterial(unsigned int material);
+      dTriMeshDataID acquireTriMeshData(dVector3 *vertices, int vertexcount,
+                                        dTriIndex *indices, int indexcount,
+                                        uint64_t *key);
+      void releaseTriMeshData(dTriMeshDataID data, uint64_t key);
       int handleCollision(dGeomID theGeom);
+      void castRays(std::vector<ray_query> &rays);
+      void addTiledTerrain(NodePhysics *node);
+      void removeTiledTerrain(NodePhysics *node);
       interfaces::sReal getCollisionDepth(dGeomID theGeom);
       mutable utils::Mutex iMutex;
       dReal max_angular_speed;
@@ -128,10 +188,21 @@ namespace mars {
     private:
       utils::Mutex drawLock;
       dSpaceID space;
+      // geoms without body are kept in their own space to never test
+      // static geoms against each other
+      dSpaceID static_space;
+      // broadphase settings the spaces are currently created with
+      std::string space_broadphase, static_space_broadphase;
+      int space_hash_min_level, space_hash_max_level, space_quadtree_depth;
+      int space_num_geoms, static_space_num_geoms;
       dWorldID world;
       dGeomID plane;
       dJointGroupID contactgroup;
       bool world_init;
+      // threading implementation used to step the islands of the world
+      dThreadingImplementationID step_threading;
+      dThreadingThreadPoolID step_thread_pool;
+      int num_step_threads;
       interfaces::ControlCenter *control;
       utils::Vector old_gravity;
       interfaces::sReal old_cfm, old_erp;
@@ -139,17 +210,55 @@ namespace mars {
       std::vector<body_nbr_tupel> comp_body_list;
       std::vector<interfaces::draw_item> draw_intern;
       std::vector<interfaces::draw_item> draw_extern;
-      std::vector<dJointFeedback*> contact_feedback_list;
+      // contacts and feedbacks are reused in every step to avoid
+      // allocations in the collision callback
+      std::vector<dContact> contact_arena;
+      std::vector<dJointFeedback*> feedback_pool;
+      size_t num_feedbacks;
+      // the contact materials by id, id 0 is not used
+      std::vector<contact_material> contact_materials;
+      std::vector<unsigned int> free_contact_materials;
+      // the mixed surfaces of all material pairs, the row of material a
+      // starts at a*contact_table_size
+      std::vector<contact_surface> contact_table;
+      size_t contact_table_size;
+      // the shared meshes by the hash of their vertices and indices
+      std::unordered_multimap<uint64_t, trimesh_data> trimesh_cache;
       std::vector<external_contact> externalContacts;
       bool create_contacts, log_contacts;
       int num_contacts;
       int ray_collision;
+      mutable RayCastPhysics ray_cast;
+      // the geoms of the collision queries are not part of a space and are
+      // reused by all queries
+      mutable std::vector<dGeomID> query_ray_geoms, query_sphere_geoms;
+      mutable std::vector<ray_query> query_rays;
+      mutable std::vector<sphere_query> query_spheres;
+      // the heightfields with a tiled terrain and the bounding boxes of the
+      // active bodies the tiles are loaded for
+      std::vector<NodePhysics*> tiled_terrains;
+      std::vector<dReal> terrain_aabbs;
       // this functions are for the collision implementation
       void nearCallback (dGeomID o1, dGeomID o2);
+      const contact_surface& getContactSurface(geom_data *gd1, geom_data *gd2);
+      void updateContactTable(unsigned int material);
+      static void mixContactSurface(const contact_material &m1,
+                                    const contact_material &m2,
+                                    contact_surface *cs);
       static void callbackForward(void *data, dGeomID o1, dGeomID o2);
+      void updateRayCastThreads(void) const;
+      void updateTerrainTiles(void);
+      void collectActiveAABBs(dSpaceID space);
+      static bool filterSphereContact(const dContactGeom &contact);
 
       // Step the World auxiliar methods
       void preStepChecks(void);
+      void updateBroadphase(void);
+      dSpaceID createSpace(const std::string &type, dSpaceID *spaces, int numSpaces);
+      dSpaceID rebuildSpace(dSpaceID oldSpace, const std::string &type,
+                            dSpaceID *spaces, int numSpaces);
+      void initStepThreading(void);
+      void freeStepThreading(void);
       void clearPreviousStep(void);
       void setContactsFromPlugins(void); 
       void createFeedbackJoints( const std::vector<mars::sim::ContactsPhysics> & contacts); 
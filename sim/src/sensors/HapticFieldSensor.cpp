@@ -92,7 +92,7 @@ namespace mars {
       if (control->dataBroker) {
         dbPushId = control->dataBroker->pushData("mars_sim", text, dbPackage, NULL,
             data_broker::DATA_PACKAGE_READ_FLAG);
-        control->dataBroker->registerTimedProducer(this, "mars_sim", text, "mars_sim/simTimer", 0);
+        control->dataBroker->registerTimedProducer(this, "mars_sim", text, "mars_sim/sensorTimer", 0);
       }
 
       position = control->nodes->getPosition(attached_node);
@@ -110,6 +110,7 @@ namespace mars {
       drawStruct draw;
       draw_item item;
       haveUpdate = false;
+      updatePending = false;
       for (int i = 0; i < 3; ++i)
         positionIndices[i] = -1;
       for (int i = 0; i < 4; ++i)
@@ -143,7 +144,7 @@ namespace mars {
       control->graphics->removeDrawItems((DrawInterface*) this);
       if (control->dataBroker) {
         control->dataBroker->unregisterTimedReceiver(this, "*", "*", "mars_sim/simTimer");
-        control->dataBroker->unregisterTimedProducer(this, "*", "*", "mars_sim/simTimer");
+        control->dataBroker->unregisterTimedProducer(this, "*", "*", "mars_sim/sensorTimer");
       }
     }
 
@@ -179,13 +180,6 @@ namespace mars {
       }
       package.get(contactForceIndex, &contactForce);
       package.get(contactIndex, &contact);
-      if (contact) {
-        computeForces();
-      } else {
-        for (std::vector<double>::iterator it = forces.begin(); it < forces.end(); ++it) {
-          *it = 0;
-        }
-      }
 
       if (positionIndices[0] == -1) {
         positionIndices[0] = package.getIndexByName("position/x");
@@ -205,9 +199,22 @@ namespace mars {
       package.get(rotationIndices[2], &orientation.z());
       package.get(rotationIndices[3], &orientation.w());
 
+      // the forces are computed by the SensorManager after the step
+      updatePending = true;
       haveUpdate = true;
     }
 
+    void HapticFieldSensor::updateSensor(void) {
+      if (contact) {
+        computeForces();
+      } else {
+        for (std::vector<double>::iterator it = forces.begin(); it < forces.end(); ++it) {
+          *it = 0;
+        }
+      }
+      updatePending = false;
+    }
+
     void HapticFieldSensor::produceData(const data_broker::DataInfo &info,
         data_broker::DataPackage *dbPackage, int callbackParam) {
       Vector tmp;
@@ -260,15 +267,21 @@ namespace mars {
       double weightSum = 0;
       double weight = 0;
       double distance = 0;
-      Vector pos, ray;
+      Vector ray = orientation*this->ray;
       int i = 0;
+      // all cells are queried in one batch
+      query_positions.resize(sensorpoints.size());
+      query_rays.assign(sensorpoints.size(), ray);
+      for (size_t k = 0; k < sensorpoints.size(); ++k) {
+        query_positions[k] = position + orientation*sensorpoints[k];
+      }
+      control->sim->getPhysics()->getVectorCollisions(query_positions,
+                                                      query_rays, &distances);
       //fprintf(stderr, "weights:\n");
       for (int c = 0; c < config.cols; ++c) {
         for (int r = 0; r < config.rows; ++r) {
           i = c*config.rows+r;
-          pos = position + orientation*(sensorpoints.at(i));
-          ray = orientation*this->ray;
-          distance = control->sim->getPhysics()->getVectorCollision(pos, ray);
+          distance = distances.at(i);
           weight = 1 - distance/maxDistance; // = (maxDistance-distance)/maxDistance
           weights.at(c*config.rows+r) = weight;
 //          fprintf(stderr, "%6g ", weight);
@@ -95,6 +95,8 @@ namespace mars {
       virtual void produceData(const data_broker::DataInfo &info,
                                      data_broker::DataPackage *package,
                                      int callbackParam);
+      virtual bool isUpdatePending() const {return updatePending;}
+      virtual void updateSensor(void);
 
       virtual void update(std::vector<interfaces::draw_item>* drawItems);
 
@@ -112,12 +114,16 @@ namespace mars {
       double contactForce;
       bool contact;
       bool haveUpdate;
+      bool updatePending;
       long positionIndices[3];
       long rotationIndices[4];
       std::vector<utils::Vector> sensorpoints;
       utils::Vector ray;
       std::vector<double> forces;
       std::vector<double> weights;
+      // the ray queries of all cells, reused in every update
+      std::vector<utils::Vector> query_positions, query_rays;
+      std::vector<interfaces::sReal> distances;
       double fieldwidth, fieldheight;
       HapticFieldConfig config;
       data_broker::DataPackage dbPackage;
@@ -82,6 +82,7 @@ namespace mars {
       draw_item item;
       Vector tmp;
       update_available = false;
+      updatePending = false;
 
       for(int i = 0; i < 3; ++i)
         positionIndices[i] = -1;
@@ -237,6 +238,11 @@ namespace mars {
       current_pose.translation() = position;
       poseMutex.unlock();
 
+      // the scan is added to the pointcloud by the SensorManager after the step
+      updatePending = true;
+    }
+
+    void RotatingRaySensor::updateSensor(void) {
       // data[] contains all the measured distances according to the define directions.
       assert((int)data.size() == config.bands * config.lasers);
 
@@ -264,6 +270,7 @@ namespace mars {
       num_points += data.size();
 
       update_available = true;
+      updatePending = false;
     }
 
     void RotatingRaySensor::update(std::vector<draw_item>* drawItems) {
@@ -306,7 +313,6 @@ namespace mars {
         }
         convertPointCloud = true;
         double vAngle = config.lasers <= 1 ? config.opening_height/2.0 : config.opening_height/(config.lasers-1);
-        double hAngle = config.bands <= 1 ? 0 : config.opening_width/config.bands;
         cloud_offset_h += config.cloud_offset;
         if(cloud_offset_h >= turning_step) {
           cloud_offset_h -= turning_step;
@@ -316,29 +322,57 @@ namespace mars {
           cloud_offset_v -= vAngle;
         }
         turning_offset = cloud_offset_h;
+        updateDirections();
+      }
+      orientation_offset = utils::angleAxisToQuaternion(turning_offset, utils::Vector(0.0, 0.0, 1.0));
+      mutex_pointcloud.unlock();
+
+      return orientation_offset;
+    }
 
-        double h_angle_cur = 0.0;
-        double v_angle_cur = 0.0;
-        Vector tmp;
-        directions.clear();
-        for(int b=0; b<config.bands; ++b) {
-          h_angle_cur = b*hAngle - config.opening_width / 2.0 + config.horizontal_offset;
+    void RotatingRaySensor::updateDirections() {
+      double vAngle = config.lasers <= 1 ? config.opening_height/2.0 : config.opening_height/(config.lasers-1);
+      double hAngle = config.bands <= 1 ? 0 : config.opening_width/config.bands;
+      double h_angle_cur = 0.0;
+      double v_angle_cur = 0.0;
+      Vector tmp;
+      directions.clear();
+      for(int b=0; b<config.bands; ++b) {
+        h_angle_cur = b*hAngle - config.opening_width / 2.0 + config.horizontal_offset;
 
-          for(int l=0; l<config.lasers; ++l) {
-            v_angle_cur = cloud_offset_v+l*vAngle - config.opening_height / 2.0 + config.vertical_offset;
+        for(int l=0; l<config.lasers; ++l) {
+          v_angle_cur = cloud_offset_v+l*vAngle - config.opening_height / 2.0 + config.vertical_offset;
 
-            tmp = Eigen::AngleAxisd(h_angle_cur, Eigen::Vector3d::UnitZ()) *
-              Eigen::AngleAxisd(v_angle_cur, Eigen::Vector3d::UnitY()) *
-              Vector(1,0,0);
+          tmp = Eigen::AngleAxisd(h_angle_cur, Eigen::Vector3d::UnitZ()) *
+            Eigen::AngleAxisd(v_angle_cur, Eigen::Vector3d::UnitY()) *
+            Vector(1,0,0);
 
-            directions.push_back(tmp);
-          }
+          directions.push_back(tmp);
         }
       }
-      orientation_offset = utils::angleAxisToQuaternion(turning_offset, utils::Vector(0.0, 0.0, 1.0));
-      mutex_pointcloud.unlock();
+    }
 
-      return orientation_offset;
+    void RotatingRaySensor::saveState(std::vector<double> *state) const {
+      MutexLocker locker(&mutex_pointcloud);
+      state->resize(3);
+      (*state)[0] = turning_offset;
+      (*state)[1] = cloud_offset_h;
+      (*state)[2] = cloud_offset_v;
+    }
+
+    void RotatingRaySensor::restoreState(const std::vector<double> &state) {
+      if(state.size() != 3) return;
+      MutexLocker locker(&mutex_pointcloud);
+      turning_offset = state[0];
+      cloud_offset_h = state[1];
+      if(cloud_offset_v != state[2]) {
+        cloud_offset_v = state[2];
+        updateDirections();
+      }
+      orientation_offset = utils::angleAxisToQuaternion(turning_offset, utils::Vector(0.0, 0.0, 1.0));
+      // the points of the partial scan belong to the discarded steps
+      toCloud->clear();
+      num_points = 0;
     }
 
     int RotatingRaySensor::getNumberRays() {
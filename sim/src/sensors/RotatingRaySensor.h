@@ -129,6 +129,8 @@ namespace mars {
       virtual void receiveData(const data_broker::DataInfo &info,
                                const data_broker::DataPackage &package,
                                int callbackParam);
+      virtual bool isUpdatePending() const {return updatePending;}
+      virtual void updateSensor(void);
       
       /**
        * Uses the current node pose and the current distances to draw 
@@ -147,6 +149,13 @@ namespace mars {
 
       const RotatingRayConfig& getConfig() const;
 
+      /**
+       * Saves and restores the turning and cloud offsets. The partial scan
+       * is discarded on restore.
+       */
+      virtual void saveState(std::vector<double> *state) const;
+      virtual void restoreState(const std::vector<double> &state);
+
       /**
        * Turns the sensor during each simulation step.
        * As soon as a full scan has been done (depends on the number of bands)
@@ -173,6 +182,9 @@ namespace mars {
       void run();
 
     private:
+      // recalculates the scan directions using the vertical cloud offset
+      void updateDirections();
+
       /** Contains the normalized scan directions. */ 
       std::vector<utils::Vector> directions;
       // TODO Storing the pointcloud four times is not very effective.
@@ -186,6 +198,7 @@ namespace mars {
       int nextCloud;
       double vertical_resolution;
       bool update_available;
+      bool updatePending;
       bool full_scan;
       double turning_offset, cloud_offset_v, cloud_offset_h;
       double turning_end_fullscan; // Defines the upper border for the turning_offset. 